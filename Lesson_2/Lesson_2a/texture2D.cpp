@@ -76,8 +76,10 @@ bool Texture2D::loadTexture(const QString & texFile, bool generateMipMaps)
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
+    // RGB32 is a 0xffRRGGBB value per pixel (B G R A bytes on little endian),
+    // GL_BGRA with GL_UNSIGNED_INT_8_8_8_8_REV takes it as it is - no channel swap
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, texData.width(), texData.height(),
-                 0, GL_RGBA, GL_UNSIGNED_BYTE, texData.bits());
+                 0, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, texData.constBits());
 
 	if (generateMipMaps)
 		glGenerateMipmap(GL_TEXTURE_2D);
@@ -13,13 +13,14 @@
 //-----------------------------------------------------------------------------
 
 in vec2 TexCoord;
+in vec4 Color;
 
-// Color of the fragment (texel)
 out vec4 frag_color;
 
-uniform sampler2D texSampler;
+// Coverage of the glyphs in the red channel, one texel is solid for the bars
+uniform sampler2D glyphs;
 
 void main()
 {
-    frag_color = texture(texSampler, TexCoord);
+    frag_color = vec4(Color.rgb, Color.a * texture(glyphs, TexCoord).r);
 }
@@ -12,22 +12,20 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 //-----------------------------------------------------------------------------
 
-// Vertex input depends on the attib parameter list.
-// 1st parameter is set with 3 x GL_FLOATS.
-layout (location = 0) in vec3 pos;
-
-// 2nd parameter is set with 2 x GL_FLOATS.
+// Statistics overlay (see StatsOverlay): quads in window pixels, top left origin
+layout (location = 0) in vec2 pos;
 layout (location = 1) in vec2 texCoord;
-out vec2 TexCoord;
+layout (location = 2) in vec4 vertexColor;
 
-// 3D MVP matrices
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+uniform vec2 viewportSize;
+
+out vec2 TexCoord;
+out vec4 Color;
 
 void main()
 {
-    // gl_Position is the OpenGL built in variable which is passed to the fragment shader
-    gl_Position = projection * view * model * vec4(pos, 1.0);
+    vec2 ndc = pos / viewportSize * 2.0 - 1.0;
+    gl_Position = vec4(ndc.x, -ndc.y, 0.0, 1.0);
     TexCoord = texCoord;
+    Color = vertexColor;
 }
@@ -0,0 +1,37 @@
+#version 330 core
+
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "uber_common.glsl"
+
+in vec3 TexCoord;
+in vec4 Color;
+
+// Color of the fragment (texel)
+out vec4 frag_color;
+
+// All object textures are layers of one array texture
+uniform sampler2DArray texSampler;
+
+void main()
+{
+    vec4 color = Color;
+    if (HAS_FEATURE(FEATURE_TEXTURED))
+        color *= texture(texSampler, TexCoord);
+
+    // Drawn with glPolygonMode GL_LINE, the lines get one flat color
+    if (HAS_FEATURE(FEATURE_WIREFRAME))
+        color = vec4(1.0, 1.0, 0.0, 1.0);
+
+    frag_color = color;
+}
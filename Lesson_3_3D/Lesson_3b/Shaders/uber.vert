@@ -0,0 +1,70 @@
+#version 330 core
+
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "uber_common.glsl"
+
+// Vertex input depends on the attib parameter list.
+// 1st parameter is set with 3 x GL_FLOATS.
+layout (location = 0) in vec3 pos;
+
+// 2nd parameter is set with 2 x GL_FLOATS.
+layout (location = 1) in vec2 texCoord;
+
+// 3rd parameter is the per instance draw id (see DrawBatch), instance i of
+// a draw gets the draw id baseInstance + i, the index of its object data
+layout (location = 2) in uint drawId;
+
+// 4th parameter, only with FEATURE_VERTEX_COLOR
+layout (location = 3) in vec4 vertexColor;
+
+// Texture coordinate in the array texture, z is the layer
+out vec3 TexCoord;
+out vec4 Color;
+
+// 3D MVP matrices, streamed by the application every frame
+// (std140 layout, see StreamBuffer)
+layout (std140) uniform FrameBlock
+{
+    mat4 view;
+    mat4 projection;
+};
+
+// FEATURE_INSTANCED: per object data, TEXELS_PER_OBJECT (5) RGBA32F texels per object:
+// model matrix columns and the layer (x = array texture layer, yz = texture coordinate scale)
+uniform samplerBuffer objectData;
+uniform int objectDataOffset;
+
+// Otherwise the same per object data as uniforms
+uniform mat4 model;
+uniform vec4 objectParameters;
+
+void main()
+{
+    mat4 objectModel = model;
+    vec4 layer = objectParameters;
+    if (HAS_FEATURE(FEATURE_INSTANCED))
+    {
+        int texel = objectDataOffset + int(drawId) * 5;
+        objectModel = mat4(texelFetch(objectData, texel),
+                           texelFetch(objectData, texel + 1),
+                           texelFetch(objectData, texel + 2),
+                           texelFetch(objectData, texel + 3));
+        layer = texelFetch(objectData, texel + 4);
+    }
+
+    // gl_Position is the OpenGL built in variable which is passed to the fragment shader
+    gl_Position = projection * view * objectModel * vec4(pos, 1.0);
+    TexCoord = vec3(texCoord * layer.yz, layer.x);
+    Color = HAS_FEATURE(FEATURE_VERTEX_COLOR) ? vertexColor : vec4(1.0);
+}
@@ -0,0 +1,33 @@
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+// Shared by uber.vert and uber.frag (#include is resolved by ShaderProgram::readSource)
+
+// Feature bits of a permutation, same values as ShaderPermutations::Feature
+#define FEATURE_TEXTURED     1
+#define FEATURE_INSTANCED    2
+#define FEATURE_VERTEX_COLOR 4
+#define FEATURE_WIREFRAME    8
+
+// FEATURES is defined by the application for every permutation, the feature
+// tests are then constant and the compiler strips the unused branches.
+// RUNTIME_FEATURES keeps the branches and reads the bits from a uniform
+// (only to compare the cost).
+#ifdef RUNTIME_FEATURES
+uniform int features;
+#define HAS_FEATURE(bit) ((features & (bit)) != 0)
+#else
+#ifndef FEATURES
+#define FEATURES (FEATURE_TEXTURED | FEATURE_INSTANCED)
+#endif
+#define HAS_FEATURE(bit) ((FEATURES & (bit)) != 0)
+#endif
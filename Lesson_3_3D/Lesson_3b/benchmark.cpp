@@ -0,0 +1,92 @@
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "benchmark.h"
+
+#include <QDebug>
+
+quint32 Benchmark::s_seed = 1;
+QString Benchmark::s_resultsFile;
+BenchmarkResults Benchmark::s_results;
+
+void Benchmark::setSeed(quint32 seed)
+{
+    s_seed = seed;
+}
+
+void Benchmark::setResultsFile(const QString & fileName)
+{
+    s_resultsFile = fileName;
+}
+
+QStringList Benchmark::names()
+{
+    return { "ecs", "jobs", "stream", "arraytexture", "drawbatch", "lod", "occlusion", "queries", "shaders", "permutations", "texturestream", "gpumemory", "widgets", "mipmaps", "pixels", "readback", "capture", "scenes" };
+}
+
+int Benchmark::run(const QString & name)
+{
+    qInfo() << "Benchmark :" << name;
+    s_results.clear();
+    int result = runBenchmark(name);
+    if (result == 0 && !s_resultsFile.isEmpty())
+    {
+        if (s_results.isEmpty())
+            qWarning() << "Benchmark :" << name << "has no samples for the results file";
+        else if (!s_results.save(s_resultsFile))
+            result = 1;
+    }
+    return result;
+}
+
+int Benchmark::runBenchmark(const QString & name)
+{
+    if (name == "ecs")
+        return entityRegistry(100000);
+    if (name == "jobs")
+        return jobSystem(1000000);
+    if (name == "stream")
+        return streamBuffer(4 * 1024 * 1024);
+    if (name == "arraytexture")
+        return textureArray(4096);
+    if (name == "drawbatch")
+        return drawBatch();
+    if (name == "lod")
+        return levelOfDetail();
+    if (name == "occlusion")
+        return occlusionCulling(10000);
+    if (name == "queries")
+        return occlusionQueries(4096);
+    if (name == "shaders")
+        return shaderCompile(48);
+    if (name == "permutations")
+        return shaderPermutations();
+    if (name == "texturestream")
+        return textureStreaming(8);
+    if (name == "gpumemory")
+        return gpuMemoryBudget(48);
+    if (name == "widgets")
+        return sharedWidgets(6);
+    if (name == "mipmaps")
+        return mipmapGeneration();
+    if (name == "pixels")
+        return pixelConversion(4096);
+    if (name == "readback")
+        return frameReadback(120);
+    if (name == "capture")
+        return frameCapture(180);
+    if (name == "scenes")
+        return scenes(600);
+
+    qWarning() << "Benchmark : unknown name" << name << "- use one of" << names();
+    return 1;
+}
@@ -0,0 +1,73 @@
+#pragma once
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "benchmarkresults.h"
+
+#include <QString>
+#include <QStringList>
+
+///
+/// \brief The Benchmark class runs the named performance measurement instead
+/// of the normal application (see the --benchmark command line option in main.cpp).
+/// Results are written with qInfo, the samples of some benchmarks also into the
+/// results file (see BenchmarkResults) to compare them with a baseline.
+///
+class Benchmark
+{
+public:
+    // Names accepted by run()
+    static QStringList names();
+
+    // Returns the process exit code (0 = ok)
+    static int run(const QString & name);
+
+    // Seed of the generated benchmark scenes (see BenchmarkScene)
+    static void setSeed(quint32 seed);
+
+    // JSON file of the measured samples, written after the benchmark
+    static void setResultsFile(const QString & fileName);
+
+private:
+    static int runBenchmark(const QString & name);
+
+    // One source file per subsystem
+    // benchmarkcpu.cpp
+    static int entityRegistry(int entityCount);
+    static int jobSystem(int itemCount);
+    // benchmarkdraw.cpp
+    static int streamBuffer(int bytesPerFrame);
+    static int textureArray(int objectCount);
+    static int drawBatch();
+    static int levelOfDetail();
+    // benchmarkocclusion.cpp
+    static int occlusionCulling(int boxCount);
+    static int occlusionQueries(int cubeCount);
+    // benchmarkshaders.cpp
+    static int shaderCompile(int programCount);
+    static int shaderPermutations();
+    // benchmarktextures.cpp
+    static int textureStreaming(int textureCount);
+    static int gpuMemoryBudget(int textureCount);
+    static int sharedWidgets(int widgetCount);
+    static int mipmapGeneration();
+    static int pixelConversion(int size);
+    // benchmarkreadback.cpp
+    static int frameReadback(int frameCount);
+    static int frameCapture(int frameCount);
+    // benchmarkscenes.cpp
+    static int scenes(int frameCount);
+
+    static quint32 s_seed;
+    static QString s_resultsFile;
+    static BenchmarkResults s_results;
+};
@@ -0,0 +1,184 @@
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "benchmark.h"
+#include "entityregistry.h"
+#include "components.h"
+#include "jobsystem.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+
+#include <thread>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+/// Entity registry - add, iterate and remove
+///////////////////////////////////////////////////////////////////////////////
+
+int Benchmark::entityRegistry(int entityCount)
+{
+    // Report the average cost per entity of one operation
+    auto report = [entityCount](const char * what, qint64 nsecs, int repeats = 1) {
+        double perEntity = double(nsecs) / double(repeats) / double(entityCount);
+        qInfo().noquote() << QString("Benchmark : ecs %1 - %2 ms total, %3 ns/entity")
+                                 .arg(QLatin1String(what), -28).arg(double(nsecs) / 1e6, 0, 'f', 3).arg(perEntity, 0, 'f', 2);
+    };
+
+    QRandomGenerator random(1234);
+    EntityRegistry registry;
+    std::vector<Entity> entities;
+    entities.reserve(entityCount);
+
+    QElapsedTimer timer;
+
+    // Create entities, all with a transform and velocity, half with bounds
+    timer.start();
+    for (int ii = 0; ii < entityCount; ++ii)
+    {
+        Entity entity = registry.create();
+        Transform transform;
+        transform.position = QVector3D(float(ii % 100), 0.0f, float(ii / 100));
+        registry.add<Transform>(entity, transform);
+        registry.add<Velocity>(entity, Velocity{QVector3D(random.bounded(1.0), 0.0f, random.bounded(1.0))});
+        if (ii % 2 == 0)
+            registry.add<Bounds>(entity);
+        entities.push_back(entity);
+    }
+    report("add", timer.nsecsElapsed());
+
+    // Movement system, two components per entity
+    const int repeats = 100;
+    timer.restart();
+    for (int rr = 0; rr < repeats; ++rr)
+    {
+        registry.each<Velocity, Transform>([](Entity, const Velocity & velocity, Transform & transform) {
+            transform.position += velocity.linear * 0.016f;
+        });
+    }
+    report("iterate velocity+transform", timer.nsecsElapsed(), repeats);
+
+    // Model matrices, a single dense pool
+    float checksum = 0.0f;
+    timer.restart();
+    for (int rr = 0; rr < repeats; ++rr)
+    {
+        registry.each<Transform>([&checksum](Entity, const Transform & transform) {
+            checksum += transform.modelMatrix()(0, 3);
+        });
+    }
+    report("iterate transform matrix", timer.nsecsElapsed(), repeats);
+
+    // Sparse join (only half the entities have bounds)
+    int boundsCount = 0;
+    timer.restart();
+    for (int rr = 0; rr < repeats; ++rr)
+    {
+        registry.each<Transform, Bounds>([&boundsCount](Entity, const Transform &, const Bounds &) {
+            boundsCount++;
+        });
+    }
+    report("iterate transform+bounds", timer.nsecsElapsed(), repeats);
+
+    // Remove every second entity (swap and pop keeps the pools dense)
+    timer.restart();
+    for (int ii = 0; ii < entityCount; ii += 2)
+        registry.destroy(entities[ii]);
+    report("remove half", timer.nsecsElapsed());
+
+    // Reuse the free slots
+    timer.restart();
+    for (int ii = 0; ii < entityCount; ii += 2)
+    {
+        Entity entity = registry.create();
+        registry.add<Transform>(entity);
+        registry.add<Velocity>(entity);
+        entities[ii] = entity;
+    }
+    report("re-add half", timer.nsecsElapsed());
+
+    qInfo() << "Benchmark : ecs alive" << registry.aliveCount() << "checksum" << checksum << boundsCount;
+    return registry.aliveCount() == size_t(entityCount) ? 0 : 1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Job system - scaling from 1 to N threads and scheduler contention
+///////////////////////////////////////////////////////////////////////////////
+
+int Benchmark::jobSystem(int itemCount)
+{
+    // The per frame work of the draw list: model matrix and a world space box per transform
+    std::vector<Transform> transforms(itemCount);
+    std::vector<QMatrix4x4> matrices(itemCount);
+    for (int ii = 0; ii < itemCount; ++ii)
+        transforms[ii].position = QVector3D(float(ii % 1000), 0.0f, float(ii / 1000));
+
+    auto work = [&transforms, &matrices](int begin, int end) {
+        for (int ii = begin; ii < end; ++ii)
+        {
+            transforms[ii].rotation = QQuaternion::fromAxisAndAngle(QVector3D(0.0f, 1.0f, 0.0f), float(ii % 360));
+            matrices[ii] = transforms[ii].modelMatrix();
+        }
+    };
+
+    const int repeats = 20;
+    const int hardwareThreads = qMax(1, int(std::thread::hardware_concurrency()));
+    qInfo() << "Benchmark : jobs" << itemCount << "items," << hardwareThreads << "hardware threads";
+
+    // Serial reference without any scheduler
+    QElapsedTimer timer;
+    timer.start();
+    for (int rr = 0; rr < repeats; ++rr)
+        work(0, itemCount);
+    const double serialMs = double(timer.nsecsElapsed()) / 1e6 / repeats;
+    qInfo().noquote() << QString("Benchmark : jobs serial          %1 ms/frame").arg(serialMs, 0, 'f', 3);
+
+    // The calling thread helps in wait(), so N threads are N-1 workers + caller.
+    // 1 thread is the same chunks inline, without a scheduler.
+    for (int threads = 1; threads <= hardwareThreads; ++threads)
+    {
+        for (int grain : { 256, 4096 })
+        {
+            if (threads == 1)
+            {
+                timer.restart();
+                for (int rr = 0; rr < repeats; ++rr)
+                {
+                    for (int begin = 0; begin < itemCount; begin += grain)
+                        work(begin, qMin(itemCount, begin + grain));
+                }
+                const double ms = double(timer.nsecsElapsed()) / 1e6 / repeats;
+                qInfo().noquote() << QString("Benchmark : jobs threads %1 grain %2 - %3 ms/frame, speedup %4, inline")
+                                         .arg(threads, 2).arg(grain, 5).arg(ms, 0, 'f', 3).arg(serialMs / ms, 0, 'f', 2);
+                continue;
+            }
+
+            JobSystem jobs(threads - 1);
+            jobs.parallelFor(itemCount, grain, work); // warm up
+            jobs.resetStatistics();
+
+            timer.restart();
+            for (int rr = 0; rr < repeats; ++rr)
+                jobs.parallelFor(itemCount, grain, work);
+            const double ms = double(timer.nsecsElapsed()) / 1e6 / repeats;
+
+            const JobSystem::Statistics stats = jobs.statistics();
+            const double stealRate = stats.stealAttempts ? 100.0 * double(stats.jobsStolen) / double(stats.stealAttempts) : 0.0;
+            qInfo().noquote() << QString("Benchmark : jobs threads %1 grain %2 - %3 ms/frame, speedup %4, jobs %5, stolen %6 (%7% of attempts), lock contended %8, inline %9")
+                                     .arg(threads, 2).arg(grain, 5).arg(ms, 0, 'f', 3).arg(serialMs / ms, 0, 'f', 2)
+                                     .arg(stats.jobsExecuted).arg(stats.jobsStolen).arg(stealRate, 0, 'f', 1)
+                                     .arg(stats.lockContended).arg(stats.inlineExecuted);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,569 @@
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "benchmark.h"
+#include "offscreencontext.h"
+#include "components.h"
+#include "streambuffer.h"
+#include "texture2D.h"
+#include "drawbatch.h"
+#include "meshsimplifier.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QOpenGLFunctions_3_3_Core>
+#include <QOpenGLShaderProgram>
+#include <QImage>
+#include <QColor>
+#include <QtMath>
+#include <Qt3DCore/QAttribute>
+#include <Qt3DCore/QBuffer>
+#include <Qt3DExtras/QSphereGeometry>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+/// Stream buffer - MB/s and stalls compared to glBufferData every frame
+///////////////////////////////////////////////////////////////////////////////
+
+int Benchmark::streamBuffer(int bytesPerFrame)
+{
+    OffscreenContext offscreen;
+    if (!offscreen.create())
+        return 1;
+
+    QOpenGLFunctions_3_3_Core gl;
+    gl.initializeOpenGLFunctions();
+
+    // The GPU has to read the streamed data, copy it into a scratch buffer
+    GLuint scratch = 0;
+    gl.glGenBuffers(1, &scratch);
+    gl.glBindBuffer(GL_COPY_WRITE_BUFFER, scratch);
+    gl.glBufferData(GL_COPY_WRITE_BUFFER, bytesPerFrame, nullptr, GL_STATIC_COPY);
+
+    const int frames = 300;
+    const int chunkSize = 256; // like a per object uniform block
+    auto report = [bytesPerFrame, frames](const char * what, qint64 nsecs, quint64 stalls, qint64 stallNsecs) {
+        const double megaBytes = double(bytesPerFrame) * frames / (1024.0 * 1024.0);
+        qInfo().noquote() << QString("Benchmark : stream %1 - %2 MB/s, %3 ms/frame, stalls %4 (%5 ms)")
+                                 .arg(QLatin1String(what), -20).arg(megaBytes / (double(nsecs) / 1e9), 0, 'f', 1)
+                                 .arg(double(nsecs) / 1e6 / frames, 0, 'f', 3).arg(stalls).arg(double(stallNsecs) / 1e6, 0, 'f', 2);
+    };
+
+    QElapsedTimer timer;
+    for (StreamBuffer::Mode mode : { StreamBuffer::Mode::PersistentMapped, StreamBuffer::Mode::MapUnsynchronized, StreamBuffer::Mode::Orphaning })
+    {
+        StreamBuffer stream;
+        if (!stream.create(bytesPerFrame, 3, mode) || stream.mode() != mode)
+        {
+            qInfo() << "Benchmark : stream" << StreamBuffer::modeName(mode) << "not supported";
+            continue;
+        }
+
+        gl.glFinish();
+        timer.restart();
+        for (int ff = 0; ff < frames; ++ff)
+        {
+            stream.beginFrame();
+            GLintptr firstOffset = -1;
+            for (int written = 0; written + chunkSize <= bytesPerFrame; written += chunkSize)
+            {
+                StreamBuffer::Allocation chunk = stream.allocate(chunkSize, chunkSize);
+                if (!chunk.isValid())
+                    break;
+                if (firstOffset < 0)
+                    firstOffset = chunk.offset;
+                memset(chunk.data, ff & 0xFF, chunkSize);
+            }
+            stream.flush();
+
+            gl.glBindBuffer(GL_COPY_READ_BUFFER, stream.bufferId());
+            gl.glBindBuffer(GL_COPY_WRITE_BUFFER, scratch);
+            gl.glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, qMax<GLintptr>(0, firstOffset), 0, bytesPerFrame);
+            stream.endFrame();
+        }
+        gl.glFinish();
+        report(StreamBuffer::modeName(mode), timer.nsecsElapsed(), stream.statistics().stalls, stream.statistics().stallNanoseconds);
+    }
+
+    // Reference: respecify the whole buffer with glBufferData every frame
+    std::vector<char> staging(bytesPerFrame);
+    GLuint buffer = 0;
+    gl.glGenBuffers(1, &buffer);
+    gl.glFinish();
+    timer.restart();
+    for (int ff = 0; ff < frames; ++ff)
+    {
+        for (int written = 0; written + chunkSize <= bytesPerFrame; written += chunkSize)
+            memset(staging.data() + written, ff & 0xFF, chunkSize);
+        gl.glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+        gl.glBufferData(GL_COPY_READ_BUFFER, bytesPerFrame, staging.data(), GL_STREAM_DRAW);
+        gl.glBindBuffer(GL_COPY_WRITE_BUFFER, scratch);
+        gl.glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, bytesPerFrame);
+    }
+    gl.glFinish();
+    report("glBufferData", timer.nsecsElapsed(), 0, 0);
+
+    gl.glDeleteBuffers(1, &buffer);
+    gl.glDeleteBuffers(1, &scratch);
+    return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Texture array - draw calls, binds and frame time: one texture per object
+/// compared to one array texture with instanced draws
+///////////////////////////////////////////////////////////////////////////////
+
+int Benchmark::textureArray(int objectCount)
+{
+    OffscreenContext offscreen;
+    if (!offscreen.create(512))
+        return 1;
+
+    QOpenGLFunctions_3_3_Core gl;
+    gl.initializeOpenGLFunctions();
+
+    // Small quads (triangle strip, no buffers needed), one uniform vec4 per object:
+    // xy = position, z = layer. Instanced draws index the array with gl_InstanceID.
+    const int maxInstances = 128;
+    const QByteArray vertexSource =
+        "#version 330 core\n"
+        "uniform vec4 objects[128];\n"
+        "out vec3 TexCoord;\n"
+        "void main()\n"
+        "{\n"
+        "    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);\n"
+        "    vec4 object = objects[gl_InstanceID];\n"
+        "    gl_Position = vec4(object.xy + corner * 0.05, 0.0, 1.0);\n"
+        "    TexCoord = vec3(corner, object.z);\n"
+        "}\n";
+    auto fragmentSource = [](const char * sampler, const char * coordinate) {
+        return QByteArray("#version 330 core\n"
+                          "in vec3 TexCoord;\n"
+                          "out vec4 frag_color;\n"
+                          "uniform ") + sampler + " texSampler;\n"
+                          "void main() { frag_color = texture(texSampler, " + coordinate + "); }\n";
+    };
+    QOpenGLShaderProgram singleProgram;
+    QOpenGLShaderProgram arrayProgram;
+    singleProgram.addShaderFromSourceCode(QOpenGLShader::Vertex, vertexSource);
+    singleProgram.addShaderFromSourceCode(QOpenGLShader::Fragment, fragmentSource("sampler2D", "TexCoord.xy"));
+    arrayProgram.addShaderFromSourceCode(QOpenGLShader::Vertex, vertexSource);
+    arrayProgram.addShaderFromSourceCode(QOpenGLShader::Fragment, fragmentSource("sampler2DArray", "TexCoord"));
+    if (!singleProgram.link() || !arrayProgram.link())
+    {
+        qWarning() << "Benchmark : shader link FAILED" << singleProgram.log() << arrayProgram.log();
+        return 1;
+    }
+
+    // Same images as single textures and as array layers
+    const int textureCount = 8;
+    QList<QImage> images;
+    for (int ii = 0; ii < textureCount; ++ii)
+    {
+        QImage image(256, 256, QImage::Format_RGBA8888);
+        image.fill(QColor::fromHsv(ii * 360 / textureCount, 200, 200));
+        images.append(image);
+    }
+    std::vector<std::unique_ptr<Texture2D>> textures;
+    for (const QImage & image : images)
+    {
+        textures.push_back(std::make_unique<Texture2D>());
+        textures.back()->loadTexture(image, true);
+    }
+    Texture2D arrayTexture(QOpenGLTexture::Target2DArray);
+    arrayTexture.loadTextureArray(images);
+
+    // Random positions and textures
+    struct Object
+    {
+        float data[4];
+        int texture;
+    };
+    std::vector<Object> objects(objectCount);
+    QRandomGenerator random(42);
+    for (Object & object : objects)
+    {
+        object.texture = int(random.bounded(textureCount));
+        object.data[0] = float(random.bounded(1.9)) - 1.0f;
+        object.data[1] = float(random.bounded(1.9)) - 1.0f;
+        object.data[2] = float(object.texture);
+        object.data[3] = 0.0f;
+    }
+    std::vector<Object> sortedObjects = objects;
+    std::sort(sortedObjects.begin(), sortedObjects.end(), [](const Object & a, const Object & b) {
+        return a.texture < b.texture;
+    });
+
+    GLuint vao = 0;
+    gl.glGenVertexArrays(1, &vao);
+    gl.glBindVertexArray(vao);
+
+    const int frames = 200;
+    QElapsedTimer timer;
+    auto report = [frames](const char * what, qint64 nsecs, int draws, int binds) {
+        qInfo().noquote() << QString("Benchmark : %1 - %2 ms/frame, %3 draws/frame, %4 binds/frame")
+                                 .arg(QLatin1String(what), -26).arg(double(nsecs) / 1e6 / frames, 0, 'f', 3).arg(draws).arg(binds);
+    };
+
+    // One draw per object, bind the texture when it changes
+    auto drawSingle = [&](const std::vector<Object> & list, const char * what) {
+        singleProgram.bind();
+        const int objectsLocation = singleProgram.uniformLocation("objects");
+        int draws = 0;
+        int binds = 0;
+        gl.glFinish();
+        timer.restart();
+        for (int ff = 0; ff < frames; ++ff)
+        {
+            draws = 0;
+            binds = 0;
+            gl.glClear(GL_COLOR_BUFFER_BIT);
+            int boundTexture = -1;
+            for (const Object & object : list)
+            {
+                if (object.texture != boundTexture)
+                {
+                    textures[object.texture]->bind();
+                    boundTexture = object.texture;
+                    binds++;
+                }
+                gl.glUniform4fv(objectsLocation, 1, object.data);
+                gl.glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+                draws++;
+            }
+        }
+        gl.glFinish();
+        report(what, timer.nsecsElapsed(), draws, binds);
+    };
+    drawSingle(objects, "texture per object");
+    drawSingle(sortedObjects, "texture per object sorted");
+
+    // One array texture bind, instanced draws of up to maxInstances objects
+    {
+        arrayProgram.bind();
+        const int objectsLocation = arrayProgram.uniformLocation("objects");
+        std::vector<float> batch(maxInstances * 4);
+        int draws = 0;
+        gl.glFinish();
+        timer.restart();
+        for (int ff = 0; ff < frames; ++ff)
+        {
+            draws = 0;
+            gl.glClear(GL_COLOR_BUFFER_BIT);
+            arrayTexture.bind();
+            for (int first = 0; first < objectCount; first += maxInstances)
+            {
+                const int count = qMin(maxInstances, objectCount - first);
+                for (int ii = 0; ii < count; ++ii)
+                    memcpy(&batch[ii * 4], objects[first + ii].data, 4 * sizeof(float));
+                gl.glUniform4fv(objectsLocation, count, batch.data());
+                gl.glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, count);
+                draws++;
+            }
+        }
+        gl.glFinish();
+        report("array texture instanced", timer.nsecsElapsed(), draws, 1);
+    }
+
+    gl.glBindVertexArray(0);
+    gl.glDeleteVertexArrays(1, &vao);
+    for (auto & texture : textures)
+        texture->destroy();
+    arrayTexture.destroy();
+    return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Draw batch - CPU submission time of 10k / 100k draws with multi draw
+/// indirect compared to the GL 3.3 draw loop
+///////////////////////////////////////////////////////////////////////////////
+
+int Benchmark::drawBatch()
+{
+    // Small render target, the GPU side should not dominate
+    OffscreenContext offscreen;
+    if (!offscreen.create(256))
+        return 1;
+
+    QOpenGLFunctions_3_3_Core gl;
+    gl.initializeOpenGLFunctions();
+
+    // Object data read like uber.vert (FEATURE_INSTANCED) does
+    QOpenGLShaderProgram program;
+    program.addShaderFromSourceCode(QOpenGLShader::Vertex,
+        "#version 330 core\n"
+        "layout (location = 0) in vec2 pos;\n"
+        "layout (location = 2) in uint drawId;\n"
+        "uniform samplerBuffer objectData;\n"
+        "uniform int objectDataOffset;\n"
+        "out vec4 color;\n"
+        "void main()\n"
+        "{\n"
+        "    int texel = objectDataOffset + int(drawId) * 5;\n"
+        "    mat4 model = mat4(texelFetch(objectData, texel), texelFetch(objectData, texel + 1),\n"
+        "                      texelFetch(objectData, texel + 2), texelFetch(objectData, texel + 3));\n"
+        "    gl_Position = model * vec4(pos, 0.0, 1.0);\n"
+        "    color = texelFetch(objectData, texel + 4);\n"
+        "}\n");
+    program.addShaderFromSourceCode(QOpenGLShader::Fragment,
+        "#version 330 core\n"
+        "in vec4 color;\n"
+        "out vec4 frag_color;\n"
+        "void main() { frag_color = color; }\n");
+    if (!program.link())
+    {
+        qWarning() << "Benchmark : shader link FAILED" << program.log();
+        return 1;
+    }
+
+    // Two meshes (the same quad twice in the index buffer), alternated so no
+    // two neighbouring objects can share a command
+    const float vertices[] = { 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f };
+    const quint16 indices[] = { 0, 1, 2, 2, 1, 3, 0, 1, 2, 2, 1, 3 };
+    GLuint vao = 0;
+    GLuint vbo = 0;
+    GLuint ibo = 0;
+    gl.glGenVertexArrays(1, &vao);
+    gl.glBindVertexArray(vao);
+    gl.glGenBuffers(1, &vbo);
+    gl.glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    gl.glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    gl.glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), nullptr);
+    gl.glEnableVertexAttribArray(0);
+    gl.glGenBuffers(1, &ibo);
+    gl.glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+    gl.glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+    MeshComponent meshes[2];
+    meshes[0].indexCount = 6;
+    meshes[1].indexCount = 6;
+    meshes[1].firstIndex = 6;
+
+    const int frames = 30;
+    for (int objectCount : { 10000, 100000 })
+    {
+        // Random small quads in clip space
+        std::vector<QMatrix4x4> models(objectCount);
+        QRandomGenerator random(42);
+        for (QMatrix4x4 & model : models)
+        {
+            model.translate(float(random.bounded(1.9)) - 1.0f, float(random.bounded(1.9)) - 1.0f, 0.0f);
+            model.scale(0.01f);
+        }
+
+        for (DrawBatch::Mode mode : { DrawBatch::Mode::MultiDrawIndirect, DrawBatch::Mode::DrawLoop })
+        {
+            gl.glBindVertexArray(vao);
+            DrawBatch batch;
+            if (!batch.create(2, objectCount, mode) || batch.mode() != mode || batch.maxObjects() < objectCount)
+            {
+                qInfo() << "Benchmark : draw batch" << DrawBatch::modeName(mode) << "not supported for" << objectCount << "objects";
+                continue;
+            }
+
+            program.bind();
+            program.setUniformValue("objectData", GLint(0));
+            qint64 buildNanoseconds = 0;
+            qint64 submitNanoseconds = 0;
+            QElapsedTimer frameTimer;
+            QElapsedTimer timer;
+            gl.glFinish();
+            frameTimer.start();
+            for (int ff = 0; ff < frames; ++ff)
+            {
+                gl.glClear(GL_COLOR_BUFFER_BIT);
+                timer.restart();
+                batch.begin();
+                for (int ii = 0; ii < objectCount; ++ii)
+                    batch.add(meshes[ii & 1], models[ii], QVector4D(1.0f, float(ii & 1), 0.0f, 1.0f));
+                batch.end();
+                buildNanoseconds += timer.nsecsElapsed();
+
+                program.setUniformValue("objectDataOffset", batch.objectDataOffset());
+                batch.bindObjectData(0);
+                batch.draw();
+                submitNanoseconds += batch.statistics().submitNanoseconds;
+                batch.finish();
+            }
+            gl.glFinish();
+            const qint64 frameNanoseconds = frameTimer.nsecsElapsed();
+
+            qInfo().noquote() << QString("Benchmark : draw batch %1 %2 draws - build %3 ms, submit %4 ms, frame %5 ms, %6 draw calls")
+                                     .arg(QLatin1String(DrawBatch::modeName(mode)), -20).arg(objectCount, 6)
+                                     .arg(double(buildNanoseconds) / 1e6 / frames, 0, 'f', 3)
+                                     .arg(double(submitNanoseconds) / 1e6 / frames, 0, 'f', 3)
+                                     .arg(double(frameNanoseconds) / 1e6 / frames, 0, 'f', 3)
+                                     .arg(batch.statistics().drawCalls);
+            batch.destroy();
+        }
+    }
+
+    gl.glBindVertexArray(0);
+    gl.glDeleteVertexArrays(1, &vao);
+    gl.glDeleteBuffers(1, &vbo);
+    gl.glDeleteBuffers(1, &ibo);
+    return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Level of detail - triangles and frame time of a field of spheres with the
+/// LOD selection on and off
+///////////////////////////////////////////////////////////////////////////////
+
+int Benchmark::levelOfDetail()
+{
+    const int targetSize = 512;
+    OffscreenContext offscreen;
+    if (!offscreen.create(targetSize))
+        return 1;
+
+    QOpenGLFunctions_3_3_Core gl;
+    gl.initializeOpenGLFunctions();
+
+    // Same sphere and LOD chain as the GLWidget scene
+    Qt3DExtras::QSphereGeometry sphereGeometry;
+    sphereGeometry.setRings(48);
+    sphereGeometry.setSlices(48);
+    sphereGeometry.setRadius(1.0f);
+    const int byteStride = int(sphereGeometry.positionAttribute()->byteStride());
+    const QByteArray vertexData = sphereGeometry.positionAttribute()->buffer()->data();
+    const QByteArray sphereIndexData = sphereGeometry.indexAttribute()->buffer()->data();
+    const quint16 * sphereIndexPointer = reinterpret_cast<const quint16 *>(sphereIndexData.constData());
+
+    QElapsedTimer timer;
+    timer.start();
+    MeshSimplifier::Options options;
+    options.texCoordOffset = int(sphereGeometry.texCoordAttribute()->byteOffset() / 4);
+    MeshSimplifier simplifier(reinterpret_cast<const float *>(vertexData.constData()), int(vertexData.size() / byteStride), byteStride / 4, options);
+    const std::vector<MeshSimplifier::Level> levels =
+        simplifier.buildLodChain(std::vector<quint16>(sphereIndexPointer, sphereIndexPointer + sphereIndexData.size() / 2), MeshLods::MAX_LEVELS);
+    qInfo() << "Benchmark : LOD chain built in" << double(timer.nsecsElapsed()) / 1e6 << "ms";
+
+    std::vector<quint16> indexData;
+    MeshLods lods;
+    for (const MeshSimplifier::Level & level : levels)
+    {
+        MeshLods::Level & lod = lods.levels[lods.count++];
+        lod.indexCount = GLsizei(level.indices.size());
+        lod.firstIndex = GLuint(indexData.size());
+        lod.error = level.error;
+        indexData.insert(indexData.end(), level.indices.begin(), level.indices.end());
+        qInfo() << "Benchmark : LOD" << lods.count - 1 << level.indices.size() / 3 << "triangles, error" << level.error;
+    }
+
+    QOpenGLShaderProgram program;
+    program.addShaderFromSourceCode(QOpenGLShader::Vertex,
+        "#version 330 core\n"
+        "layout (location = 0) in vec3 pos;\n"
+        "layout (location = 2) in uint drawId;\n"
+        "uniform samplerBuffer objectData;\n"
+        "uniform int objectDataOffset;\n"
+        "uniform mat4 viewProjection;\n"
+        "out vec3 color;\n"
+        "void main()\n"
+        "{\n"
+        "    int texel = objectDataOffset + int(drawId) * 5;\n"
+        "    mat4 model = mat4(texelFetch(objectData, texel), texelFetch(objectData, texel + 1),\n"
+        "                      texelFetch(objectData, texel + 2), texelFetch(objectData, texel + 3));\n"
+        "    gl_Position = viewProjection * model * vec4(pos, 1.0);\n"
+        "    color = pos * 0.5 + 0.5;\n"
+        "}\n");
+    program.addShaderFromSourceCode(QOpenGLShader::Fragment,
+        "#version 330 core\n"
+        "in vec3 color;\n"
+        "out vec4 frag_color;\n"
+        "void main() { frag_color = vec4(color, 1.0); }\n");
+    if (!program.link())
+    {
+        qWarning() << "Benchmark : shader link FAILED" << program.log();
+        return 1;
+    }
+
+    GLuint vao = 0;
+    GLuint buffers[2] = {};
+    gl.glGenVertexArrays(1, &vao);
+    gl.glBindVertexArray(vao);
+    gl.glGenBuffers(2, buffers);
+    gl.glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+    gl.glBufferData(GL_ARRAY_BUFFER, vertexData.size(), vertexData.constData(), GL_STATIC_DRAW);
+    gl.glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, byteStride, nullptr);
+    gl.glEnableVertexAttribArray(0);
+    gl.glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers[1]);
+    gl.glBufferData(GL_ELEMENT_ARRAY_BUFFER, GLsizeiptr(indexData.size() * sizeof(quint16)), indexData.data(), GL_STATIC_DRAW);
+
+    const int objectCount = 32 * 32;
+    DrawBatch batch;
+    if (!batch.create(2, objectCount))
+        return 1;
+
+    // A field of spheres from near to far in front of the camera
+    const float fovDegrees = 45.0f;
+    QMatrix4x4 viewProjection;
+    viewProjection.perspective(fovDegrees, 1.0f, 0.1f, 200.0f);
+    viewProjection.lookAt(QVector3D(0.0f, 3.0f, 0.0f), QVector3D(0.0f, 0.0f, -20.0f), QVector3D(0.0f, 1.0f, 0.0f));
+    const float pixelsPerUnit = float(targetSize) / (2.0f * tanf(qDegreesToRadians(fovDegrees) * 0.5f));
+    std::vector<QMatrix4x4> models(objectCount);
+    std::vector<float> distances(objectCount);
+    for (int ii = 0; ii < objectCount; ++ii)
+    {
+        const QVector3D position(float(ii % 32 - 16) * 3.0f, 0.0f, -2.0f - float(ii / 32) * 3.0f);
+        models[ii].translate(position);
+        distances[ii] = (position - QVector3D(0.0f, 3.0f, 0.0f)).length() - 1.0f;
+    }
+
+    program.bind();
+    program.setUniformValue("objectData", GLint(0));
+    program.setUniformValue(program.uniformLocation("viewProjection"), viewProjection);
+    gl.glEnable(GL_DEPTH_TEST);
+
+    const int frames = 100;
+    for (bool lodEnabled : { false, true })
+    {
+        gl.glFinish();
+        timer.restart();
+        quint64 triangles = 0;
+        for (int ff = 0; ff < frames; ++ff)
+        {
+            gl.glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            batch.begin();
+            for (int ii = 0; ii < objectCount; ++ii)
+            {
+                const int level = lodEnabled ? lods.select(distances[ii], 1.0f, pixelsPerUnit, 1.0f) : 0;
+                MeshComponent mesh;
+                mesh.indexCount = lods.levels[level].indexCount;
+                mesh.firstIndex = lods.levels[level].firstIndex;
+                batch.add(mesh, models[ii], QVector4D());
+            }
+            batch.end();
+            program.setUniformValue("objectDataOffset", batch.objectDataOffset());
+            batch.bindObjectData(0);
+            batch.draw();
+            batch.finish();
+            triangles = batch.statistics().triangles;
+        }
+        gl.glFinish();
+        qInfo().noquote() << QString("Benchmark : LOD %1 - %2 triangles/frame, %3 ms/frame")
+                                 .arg(QLatin1String(lodEnabled ? "on " : "off")).arg(triangles)
+                                 .arg(double(timer.nsecsElapsed()) / 1e6 / frames, 0, 'f', 3);
+    }
+
+    batch.destroy();
+    gl.glBindVertexArray(0);
+    gl.glDeleteVertexArrays(1, &vao);
+    gl.glDeleteBuffers(2, buffers);
+    return 0;
+}
@@ -0,0 +1,268 @@
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "benchmark.h"
+#include "offscreencontext.h"
+#include "jobsystem.h"
+#include "occlusionculler.h"
+#include "occlusionqueries.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QOpenGLFunctions_3_3_Core>
+#include <QOpenGLShaderProgram>
+#include <QSize>
+#include <Qt3DCore/QAttribute>
+#include <Qt3DCore/QBuffer>
+#include <Qt3DExtras/QCuboidGeometry>
+
+#include <cmath>
+#include <thread>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+/// Occlusion culling - software depth buffer cost and culled boxes (CPU only)
+///////////////////////////////////////////////////////////////////////////////
+
+int Benchmark::occlusionCulling(int boxCount)
+{
+    // Unit cube, 8 corners and 12 counter clockwise triangles
+    const float cubeVertices[] = {
+        -1.0f, -1.0f, -1.0f,   1.0f, -1.0f, -1.0f,   1.0f, 1.0f, -1.0f,   -1.0f, 1.0f, -1.0f,
+        -1.0f, -1.0f,  1.0f,   1.0f, -1.0f,  1.0f,   1.0f, 1.0f,  1.0f,   -1.0f, 1.0f,  1.0f };
+    const quint16 cubeIndices[] = {
+        4, 5, 6,  4, 6, 7,      // +z
+        1, 0, 3,  1, 3, 2,      // -z
+        5, 1, 2,  5, 2, 6,      // +x
+        0, 4, 7,  0, 7, 3,      // -x
+        7, 6, 2,  7, 2, 3,      // +y
+        0, 1, 5,  0, 5, 4 };    // -y
+    OccluderMesh cube;
+    cube.vertices = cubeVertices;
+    cube.vertexCount = 8;
+    cube.indices = cubeIndices;
+    cube.indexCount = 36;
+
+    // A few walls between the camera and a field of boxes
+    QMatrix4x4 viewProjection;
+    viewProjection.perspective(60.0f, 2.0f, 0.1f, 200.0f);
+    viewProjection.lookAt(QVector3D(0.0f, 2.0f, 10.0f), QVector3D(0.0f, 0.0f, 0.0f), QVector3D(0.0f, 1.0f, 0.0f));
+    std::vector<QMatrix4x4> walls(4);
+    for (int ii = 0; ii < int(walls.size()); ++ii)
+    {
+        walls[ii].translate(float(ii) * 8.0f - 12.0f, 0.0f, 2.0f);
+        walls[ii].scale(3.0f, 3.0f, 0.2f);
+    }
+
+    QRandomGenerator random(1234);
+    std::vector<QVector3D> centers(boxCount);
+    for (QVector3D & center : centers)
+        center = QVector3D(float(random.bounded(60.0) - 30.0), float(random.bounded(4.0) - 2.0), float(-random.bounded(60.0)));
+    const QVector3D extents(0.5f, 0.5f, 0.5f);
+
+    const int hardwareThreads = qMax(1, int(std::thread::hardware_concurrency()));
+    JobSystem jobs(qMax(1, hardwareThreads - 1));
+
+    const int frames = 200;
+    for (QSize size : { QSize(256, 128), QSize(512, 256) })
+    {
+        OcclusionCuller culler(size.width(), size.height());
+        for (bool parallel : { false, true })
+        {
+            qint64 binNanoseconds = 0;
+            qint64 rasterNanoseconds = 0;
+            qint64 testNanoseconds = 0;
+            int occluded = 0;
+            QElapsedTimer timer;
+            for (int ff = 0; ff < frames; ++ff)
+            {
+                culler.beginFrame(viewProjection);
+                for (const QMatrix4x4 & wall : walls)
+                    culler.addOccluder(cube, wall);
+
+                timer.restart();
+                if (parallel)
+                {
+                    JobCounter rasterized;
+                    culler.rasterize(jobs, rasterized);
+                    jobs.wait(rasterized);
+                }
+                else
+                {
+                    culler.rasterizeTiles(0, culler.tileCount());
+                }
+                rasterNanoseconds += timer.nsecsElapsed();
+                binNanoseconds += culler.statistics().binNanoseconds;
+
+                timer.restart();
+                occluded = 0;
+                for (const QVector3D & center : centers)
+                    occluded += culler.isVisible(center, extents) ? 0 : 1;
+                testNanoseconds += timer.nsecsElapsed();
+            }
+            qInfo().noquote() << QString("Benchmark : occlusion %1x%2 %3 - bin %4 ms, raster %5 ms, test %6 ms/frame, %7 of %8 boxes occluded")
+                                     .arg(culler.width()).arg(culler.height()).arg(QLatin1String(parallel ? "jobs  " : "serial"))
+                                     .arg(double(binNanoseconds) / 1e6 / frames, 0, 'f', 3)
+                                     .arg(double(rasterNanoseconds) / 1e6 / frames, 0, 'f', 3)
+                                     .arg(double(testNanoseconds) / 1e6 / frames, 0, 'f', 3)
+                                     .arg(occluded).arg(boxCount);
+        }
+    }
+    return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Occlusion queries - cubes hidden behind a wall, drawn with and without queries
+///////////////////////////////////////////////////////////////////////////////
+
+int Benchmark::occlusionQueries(int cubeCount)
+{
+    const int targetSize = 512;
+    OffscreenContext offscreen;
+    if (!offscreen.create(targetSize))
+        return 1;
+
+    QOpenGLFunctions_3_3_Core gl;
+    gl.initializeOpenGLFunctions();
+
+    // Finely tessellated cubes, so every hidden one costs real vertex work
+    Qt3DExtras::QCuboidGeometry cubeGeometry;
+    cubeGeometry.setXExtent(2.0f);
+    cubeGeometry.setYExtent(2.0f);
+    cubeGeometry.setZExtent(2.0f);
+    cubeGeometry.setXYMeshResolution(QSize(16, 16));
+    cubeGeometry.setXZMeshResolution(QSize(16, 16));
+    cubeGeometry.setYZMeshResolution(QSize(16, 16));
+    const int byteStride = int(cubeGeometry.positionAttribute()->byteStride());
+    const QByteArray vertexData = cubeGeometry.positionAttribute()->buffer()->data();
+    const QByteArray indexData = cubeGeometry.indexAttribute()->buffer()->data();
+    const GLsizei indexCount = GLsizei(indexData.size() / 2);
+
+    QOpenGLShaderProgram program;
+    program.addShaderFromSourceCode(QOpenGLShader::Vertex,
+        "#version 330 core\n"
+        "layout (location = 0) in vec3 pos;\n"
+        "uniform mat4 mvp;\n"
+        "out vec3 color;\n"
+        "void main()\n"
+        "{\n"
+        "    gl_Position = mvp * vec4(pos, 1.0);\n"
+        "    color = pos * 0.5 + 0.5;\n"
+        "}\n");
+    program.addShaderFromSourceCode(QOpenGLShader::Fragment,
+        "#version 330 core\n"
+        "in vec3 color;\n"
+        "out vec4 frag_color;\n"
+        "void main() { frag_color = vec4(color, 1.0); }\n");
+    if (!program.link())
+    {
+        qWarning() << "Benchmark : shader link FAILED" << program.log();
+        return 1;
+    }
+    const int mvpLocation = program.uniformLocation("mvp");
+
+    GLuint vao = 0;
+    GLuint buffers[2] = {};
+    gl.glGenVertexArrays(1, &vao);
+    gl.glBindVertexArray(vao);
+    gl.glGenBuffers(2, buffers);
+    gl.glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+    gl.glBufferData(GL_ARRAY_BUFFER, vertexData.size(), vertexData.constData(), GL_STATIC_DRAW);
+    gl.glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, byteStride, nullptr);
+    gl.glEnableVertexAttribArray(0);
+    gl.glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers[1]);
+    gl.glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexData.size(), indexData.constData(), GL_STATIC_DRAW);
+    gl.glBindVertexArray(0);
+
+    OcclusionQueries queries;
+    if (!queries.create())
+        return 1;
+
+    // A wall right in front of the camera, a block of cubes behind it.
+    // The outer columns stick out at the sides, so a few cubes stay visible.
+    const QVector3D cameraPosition(0.0f, 0.0f, 10.0f);
+    QMatrix4x4 viewProjection;
+    viewProjection.perspective(60.0f, 1.0f, 0.1f, 200.0f);
+    viewProjection.lookAt(cameraPosition, QVector3D(0.0f, 0.0f, 0.0f), QVector3D(0.0f, 1.0f, 0.0f));
+    QMatrix4x4 wall;
+    wall.translate(0.0f, 0.0f, 5.0f);
+    wall.scale(2.0f, 2.0f, 0.1f);
+
+    const QVector3D cubeExtents(0.25f, 0.25f, 0.25f);
+    const int side = qMax(1, int(std::sqrt(double(cubeCount) / 4.0)));
+    std::vector<QVector3D> centers;
+    centers.reserve(cubeCount);
+    for (int ii = 0; ii < cubeCount; ++ii)
+    {
+        const int column = ii % side;
+        const int row = (ii / side) % side;
+        const int layer = ii / (side * side);
+        centers.push_back(QVector3D((float(column) / float(side) - 0.5f) * 10.0f, (float(row) / float(side) - 0.5f) * 6.0f, -float(layer) * 2.0f));
+    }
+
+    gl.glEnable(GL_DEPTH_TEST);
+    const int frames = 100;
+    for (bool useQueries : { false, true })
+    {
+        OcclusionQueries::Statistics statistics;
+        gl.glFinish();
+        QElapsedTimer timer;
+        timer.start();
+        for (int ff = 0; ff < frames; ++ff)
+        {
+            gl.glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            queries.beginFrame(viewProjection, cameraPosition);
+
+            program.bind();
+            gl.glBindVertexArray(vao);
+            const QMatrix4x4 wallMvp = viewProjection * wall;
+            gl.glUniformMatrix4fv(mvpLocation, 1, GL_FALSE, wallMvp.constData());
+            gl.glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_SHORT, nullptr);
+
+            for (int ii = 0; ii < cubeCount; ++ii)
+            {
+                bool conditional = false;
+                if (useQueries)
+                {
+                    const OcclusionQueries::Result result = queries.result(quint32(ii), centers[ii], cubeExtents);
+                    queries.add(quint32(ii), centers[ii], cubeExtents);
+                    if (result == OcclusionQueries::Result::Occluded)
+                        continue;
+                    conditional = result == OcclusionQueries::Result::Pending;
+                }
+
+                QMatrix4x4 mvp = viewProjection;
+                mvp.translate(centers[ii]);
+                mvp.scale(cubeExtents);
+                gl.glUniformMatrix4fv(mvpLocation, 1, GL_FALSE, mvp.constData());
+                if (conditional)
+                    queries.beginConditionalRender(quint32(ii));
+                gl.glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_SHORT, nullptr);
+                if (conditional)
+                    queries.endConditionalRender();
+            }
+            gl.glBindVertexArray(0);
+            queries.end();
+            statistics = queries.statistics();
+        }
+        gl.glFinish();
+        qInfo().noquote() << QString("Benchmark : queries %1 - %2 ms/frame, %3 cubes, %4 occluded, %5 pending (conditional)")
+                                 .arg(QLatin1String(useQueries ? "on " : "off")).arg(double(timer.nsecsElapsed()) / 1e6 / frames, 0, 'f', 3)
+                                 .arg(cubeCount).arg(statistics.occluded).arg(statistics.pending);
+    }
+
+    queries.destroy();
+    gl.glDeleteVertexArrays(1, &vao);
+    gl.glDeleteBuffers(2, buffers);
+    return 0;
+}
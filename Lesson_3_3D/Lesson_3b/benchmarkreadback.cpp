@@ -0,0 +1,290 @@
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "benchmark.h"
+#include "offscreencontext.h"
+#include "framereadback.h"
+#include "framecapture.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QOpenGLFunctions_3_3_Core>
+#include <QColor>
+#include <QDir>
+#include <QSize>
+#include <QTemporaryDir>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+/// Frame readback - render time and delivered frames of the pixel pack
+/// buffer ring against glReadPixels every frame
+///////////////////////////////////////////////////////////////////////////////
+
+int Benchmark::frameReadback(int frameCount)
+{
+    OffscreenContext offscreen;
+    if (!offscreen.create())
+        return 1;
+
+    QOpenGLFunctions_3_3_Core gl;
+    gl.initializeOpenGLFunctions();
+
+    // Every frame has its own clear color, the delivered pixels show if they belong to the frame
+    auto frameColor = [](quint64 number) {
+        return QColor(int(number * 37 % 256), int(number * 91 % 256), int(number * 13 % 256));
+    };
+
+    ///
+    /// \brief Receives the frames like a video encoder would: one copy per frame
+    ///
+    struct Consumer
+    {
+        std::function<QColor(quint64)> color;
+        std::vector<uchar> pixels;
+        quint64 frames {0};
+        quint64 framesLater {0};
+        quint64 wrong {0};
+
+        static void receive(void * user, const FrameReadback::Frame & frame)
+        {
+            Consumer * consumer = static_cast<Consumer *>(user);
+            const size_t bytes = size_t(frame.bytesPerLine) * frame.height;
+            consumer->pixels.resize(bytes);
+            memcpy(consumer->pixels.data(), frame.data, bytes);
+            const QColor expected = consumer->color(frame.number);
+            const uchar * bgra = consumer->pixels.data();
+            if (bgra[0] != expected.blue() || bgra[1] != expected.green() || bgra[2] != expected.red())
+                consumer->wrong++;
+            consumer->frames++;
+            consumer->framesLater += quint64(frame.framesLater);
+        }
+    };
+
+    const QSize sizes[] = { QSize(1920, 1080), QSize(3840, 2160) };
+    for (const QSize & size : sizes)
+    {
+        GLuint framebuffer = 0;
+        GLuint renderbuffer = 0;
+        gl.glGenFramebuffers(1, &framebuffer);
+        gl.glGenRenderbuffers(1, &renderbuffer);
+        gl.glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
+        gl.glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, size.width(), size.height());
+        gl.glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        gl.glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffer);
+        gl.glViewport(0, 0, size.width(), size.height());
+
+        const double frameMegabytes = double(size.width()) * size.height() * 4 / (1024.0 * 1024.0);
+        auto render = [&](quint64 number) {
+            const QColor color = frameColor(number);
+            gl.glClearColor(float(color.redF()), float(color.greenF()), float(color.blueF()), 1.0f);
+            gl.glClear(GL_COLOR_BUFFER_BIT);
+        };
+        auto report = [&](const char * what, qint64 nsecs, const Consumer & consumer, quint64 dropped) {
+            const double frameMs = double(nsecs) / 1e6 / frameCount;
+            qInfo().noquote() << QString("Benchmark : readback %1x%2 %3 - %4 ms/frame, %5 MB/s, %6 frames later, %7 dropped, %8 wrong")
+                                     .arg(size.width()).arg(size.height())
+                                     .arg(QLatin1String(what), -14)
+                                     .arg(frameMs, 0, 'f', 3)
+                                     .arg(frameMegabytes * double(consumer.frames) / (double(nsecs) / 1e9), 0, 'f', 0)
+                                     .arg(consumer.frames ? double(consumer.framesLater) / double(consumer.frames) : 0.0, 0, 'f', 1)
+                                     .arg(dropped)
+                                     .arg(consumer.wrong);
+        };
+
+        // Synchronous: glReadPixels into memory waits until the frame is rendered
+        {
+            Consumer consumer;
+            consumer.color = frameColor;
+            std::vector<uchar> pixels(static_cast<size_t>(frameMegabytes * 1024.0 * 1024.0));
+            gl.glPixelStorei(GL_PACK_ALIGNMENT, 4);
+            gl.glFinish();
+            QElapsedTimer timer;
+            timer.start();
+            for (int ii = 1; ii <= frameCount; ++ii)
+            {
+                render(quint64(ii));
+                gl.glReadPixels(0, 0, size.width(), size.height(), GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, pixels.data());
+                FrameReadback::Frame frame;
+                frame.data = pixels.data();
+                frame.width = size.width();
+                frame.height = size.height();
+                frame.bytesPerLine = size.width() * 4;
+                frame.number = quint64(ii);
+                Consumer::receive(&consumer, frame);
+            }
+            report("glReadPixels", timer.nsecsElapsed(), consumer, 0);
+        }
+
+        // Asynchronous: ring of pixel pack buffers, the frames arrive later
+        for (int bufferCount : { 2, 3, 4 })
+        {
+            Consumer consumer;
+            consumer.color = frameColor;
+            FrameReadback readback;
+            readback.create(bufferCount);
+            gl.glFinish();
+            QElapsedTimer timer;
+            timer.start();
+            for (int ii = 1; ii <= frameCount; ++ii)
+            {
+                render(quint64(ii));
+                readback.capture(framebuffer, size.width(), size.height(), &Consumer::receive, &consumer);
+                // A frame boundary, like the buffer swap of the widget
+                gl.glFlush();
+                readback.poll();
+            }
+            readback.finish();
+            const qint64 nsecs = timer.nsecsElapsed();
+            const QString what = QString("PBO ring x%1").arg(bufferCount);
+            report(what.toLatin1().constData(), nsecs, consumer, readback.statistics().dropped);
+            readback.destroy();
+        }
+
+        gl.glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        gl.glDeleteRenderbuffers(1, &renderbuffer);
+        gl.glDeleteFramebuffers(1, &framebuffer);
+    }
+    return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Frame capture - render time and dropped frames with the capture off,
+/// only the readback and every format (1080p)
+///////////////////////////////////////////////////////////////////////////////
+
+int Benchmark::frameCapture(int frameCount)
+{
+    OffscreenContext offscreen;
+    if (!offscreen.create())
+        return 1;
+
+    QOpenGLFunctions_3_3_Core gl;
+    gl.initializeOpenGLFunctions();
+
+    QTemporaryDir directory;
+    if (!directory.isValid())
+    {
+        qWarning() << "Benchmark : no temporary directory";
+        return 1;
+    }
+
+    const QSize size(1920, 1080);
+    GLuint framebuffer = 0;
+    GLuint renderbuffer = 0;
+    gl.glGenFramebuffers(1, &framebuffer);
+    gl.glGenRenderbuffers(1, &renderbuffer);
+    gl.glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
+    gl.glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, size.width(), size.height());
+    gl.glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    gl.glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffer);
+    gl.glViewport(0, 0, size.width(), size.height());
+    gl.glEnable(GL_SCISSOR_TEST);
+
+    // Rendered at 60 fps like the widget with vsync, the render time is the frame
+    // time without the wait for the next frame
+    const qint64 frameNanoseconds = 1000000000 / 60;
+    const FrameReadback::Callback discard = [](void *, const FrameReadback::Frame &) {};
+    auto renderFrames = [&](FrameReadback * readback, FrameCapture * capture) {
+        std::vector<qint64> renderTimes;
+        renderTimes.reserve(size_t(frameCount));
+        QElapsedTimer clock;
+        clock.start();
+        for (int ii = 0; ii < frameCount; ++ii)
+        {
+            QElapsedTimer timer;
+            timer.start();
+            // Some stripes that move, so every frame differs
+            for (int stripe = 0; stripe < 16; ++stripe)
+            {
+                const int xx = (stripe * 120 + ii * 8) % size.width();
+                gl.glScissor(xx, 0, 120, size.height());
+                gl.glClearColor(float(stripe) / 16.0f, float(ii % 60) / 60.0f, 0.5f, 1.0f);
+                gl.glClear(GL_COLOR_BUFFER_BIT);
+            }
+            if (readback)
+            {
+                readback->capture(framebuffer, size.width(), size.height(),
+                                  capture ? &FrameCapture::receive : discard, capture);
+                gl.glFlush();
+                readback->poll();
+            }
+            else
+            {
+                gl.glFlush();
+            }
+            renderTimes.push_back(timer.nsecsElapsed());
+
+            const qint64 next = frameNanoseconds * (ii + 1);
+            const qint64 wait = next - clock.nsecsElapsed();
+            if (wait > 0)
+                std::this_thread::sleep_for(std::chrono::nanoseconds(wait));
+        }
+        gl.glScissor(0, 0, size.width(), size.height());
+        gl.glFinish();
+        return renderTimes;
+    };
+    auto report = [frameCount](const QString & what, std::vector<qint64> renderTimes, quint64 written, quint64 dropped, qint64 writeNanoseconds, quint64 bytes) {
+        std::sort(renderTimes.begin(), renderTimes.end());
+        qint64 total = 0;
+        for (qint64 nsecs : renderTimes)
+            total += nsecs;
+        qInfo().noquote() << QString("Benchmark : capture %1 - render %2 ms/frame (p95 %3 ms), %4 / %5 written, %6 dropped, writer %7 ms/frame, %8 MB")
+                                 .arg(what, -10)
+                                 .arg(double(total) / 1e6 / double(renderTimes.size()), 0, 'f', 3)
+                                 .arg(double(renderTimes[renderTimes.size() * 95 / 100]) / 1e6, 0, 'f', 3)
+                                 .arg(written).arg(frameCount).arg(dropped)
+                                 .arg(written ? double(writeNanoseconds) / 1e6 / double(written) : 0.0, 0, 'f', 2)
+                                 .arg(double(bytes) / (1024.0 * 1024.0), 0, 'f', 1);
+    };
+
+    report("off", renderFrames(nullptr, nullptr), 0, 0, 0, 0);
+
+    FrameReadback readback;
+    readback.create();
+    {
+        const std::vector<qint64> renderTimes = renderFrames(&readback, nullptr);
+        readback.finish();
+        report("readback", renderTimes, readback.statistics().delivered, readback.statistics().dropped, 0, 0);
+    }
+
+    const std::pair<FrameCapture::Format, QString> formats[] = {
+        { FrameCapture::Format::Y4m, "y4m" }, { FrameCapture::Format::Raw, "raw" }, { FrameCapture::Format::Png, "png" } };
+    for (const auto & format : formats)
+    {
+        FrameCapture capture;
+        FrameCapture::Options options;
+        options.format = format.first;
+        if (!capture.start(QDir(directory.path()).filePath(format.second), size.width(), size.height(), options))
+            return 1;
+        readback.resetStatistics();
+        const std::vector<qint64> renderTimes = renderFrames(&readback, &capture);
+        readback.finish();
+        capture.stop();
+        const FrameCapture::Statistics stats = capture.statistics();
+        report(format.second, renderTimes, stats.written, stats.dropped + readback.statistics().dropped,
+               stats.writeNanoseconds, stats.bytesWritten);
+    }
+    readback.destroy();
+
+    gl.glDisable(GL_SCISSOR_TEST);
+    gl.glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    gl.glDeleteRenderbuffers(1, &renderbuffer);
+    gl.glDeleteFramebuffers(1, &framebuffer);
+    return 0;
+}
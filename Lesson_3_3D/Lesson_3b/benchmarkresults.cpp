@@ -0,0 +1,265 @@
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "benchmarkresults.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QSaveFile>
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace
+{
+    const int FILE_VERSION = 1;
+
+    // Below this many samples on a side the test has no power, only the threshold counts
+    const size_t MIN_TEST_SAMPLES = 5;
+}
+
+double BenchmarkResults::Thresholds::percentFor(const QString & name) const
+{
+    const auto found = metricPercent.find(name);
+    return found != metricPercent.end() ? found->second : percent;
+}
+
+void BenchmarkResults::add(const QString & name, const QString & unit, const std::vector<double> & samples)
+{
+    Metric & metric = m_metrics[name];
+    metric.unit = unit;
+    metric.samples.insert(metric.samples.end(), samples.begin(), samples.end());
+}
+
+void BenchmarkResults::add(const QString & name, const QString & unit, double sample)
+{
+    add(name, unit, std::vector<double>{sample});
+}
+
+void BenchmarkResults::merge(const BenchmarkResults & other)
+{
+    for (const auto & entry : other.m_metrics)
+        add(entry.first, entry.second.unit, entry.second.samples);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// File
+///////////////////////////////////////////////////////////////////////////////
+
+bool BenchmarkResults::save(const QString & fileName) const
+{
+    QJsonObject metrics;
+    for (const auto & entry : m_metrics)
+    {
+        QJsonArray samples;
+        for (double sample : entry.second.samples)
+            samples.append(sample);
+        QJsonObject metric;
+        metric.insert("unit", entry.second.unit);
+        metric.insert("samples", samples);
+        metrics.insert(entry.first, metric);
+    }
+    QJsonObject root;
+    root.insert("version", FILE_VERSION);
+    root.insert("metrics", metrics);
+
+    const QByteArray text = QJsonDocument(root).toJson(QJsonDocument::Compact);
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly) || file.write(text) != text.size() || !file.commit())
+    {
+        qWarning() << "Benchmark results : writing" << fileName << "FAILED";
+        return false;
+    }
+    qInfo() << "Benchmark results :" << m_metrics.size() << "metrics written to" << fileName;
+    return true;
+}
+
+bool BenchmarkResults::load(const QString & fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        qWarning() << "Benchmark results : opening" << fileName << "FAILED";
+        return false;
+    }
+    QJsonParseError error;
+    const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &error);
+    if (error.error != QJsonParseError::NoError || !document.isObject()
+        || document.object().value("version").toInt() != FILE_VERSION)
+    {
+        qWarning() << "Benchmark results :" << fileName << "is not a results file" << error.errorString();
+        return false;
+    }
+
+    m_metrics.clear();
+    const QJsonObject metrics = document.object().value("metrics").toObject();
+    for (const QString & name : metrics.keys())
+    {
+        const QJsonObject metric = metrics.value(name).toObject();
+        std::vector<double> samples;
+        for (const QJsonValue & sample : metric.value("samples").toArray())
+            samples.push_back(sample.toDouble());
+        add(name, metric.value("unit").toString(), samples);
+    }
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Statistics
+///////////////////////////////////////////////////////////////////////////////
+
+double BenchmarkResults::median(std::vector<double> samples)
+{
+    if (samples.empty())
+        return 0.0;
+    const size_t middle = samples.size() / 2;
+    std::nth_element(samples.begin(), samples.begin() + middle, samples.end());
+    if (samples.size() & 1)
+        return samples[middle];
+    const double upper = samples[middle];
+    return 0.5 * (upper + *std::max_element(samples.begin(), samples.begin() + middle));
+}
+
+double BenchmarkResults::mannWhitneyPValue(const std::vector<double> & a, const std::vector<double> & b)
+{
+    const double n1 = double(a.size());
+    const double n2 = double(b.size());
+    if (a.empty() || b.empty())
+        return 1.0;
+
+    // Ranks of the pooled samples, ties get their average rank
+    std::vector<std::pair<double, int>> pooled;
+    pooled.reserve(a.size() + b.size());
+    for (double value : a)
+        pooled.emplace_back(value, 0);
+    for (double value : b)
+        pooled.emplace_back(value, 1);
+    std::sort(pooled.begin(), pooled.end());
+
+    const double n = n1 + n2;
+    double rankSumA = 0.0;
+    double tieSum = 0.0;
+    for (size_t first = 0; first < pooled.size();)
+    {
+        size_t last = first;
+        while (last + 1 < pooled.size() && pooled[last + 1].first == pooled[first].first)
+            ++last;
+        const double ties = double(last - first + 1);
+        const double rank = 0.5 * (double(first + 1) + double(last + 1));
+        for (size_t ii = first; ii <= last; ++ii)
+        {
+            if (pooled[ii].second == 0)
+                rankSumA += rank;
+        }
+        tieSum += ties * ties * ties - ties;
+        first = last + 1;
+    }
+
+    const double u = rankSumA - n1 * (n1 + 1.0) / 2.0;
+    const double mean = n1 * n2 / 2.0;
+    const double variance = n1 * n2 / 12.0 * ((n + 1.0) - tieSum / (n * (n - 1.0)));
+    if (variance <= 0.0)
+        return 1.0;     // all samples equal
+
+    // Continuity correction towards the mean
+    const double difference = std::abs(u - mean);
+    const double z = std::max(0.0, difference - 0.5) / std::sqrt(variance);
+    return std::erfc(z / std::sqrt(2.0));
+}
+
+std::vector<BenchmarkResults::Comparison> BenchmarkResults::compare(const BenchmarkResults & baseline, const BenchmarkResults & current,
+                                                                    const Thresholds & thresholds)
+{
+    std::vector<Comparison> comparisons;
+    for (const auto & entry : current.m_metrics)
+    {
+        const auto found = baseline.m_metrics.find(entry.first);
+        if (found == baseline.m_metrics.end() || found->second.samples.empty() || entry.second.samples.empty())
+            continue;
+
+        const std::vector<double> & before = found->second.samples;
+        const std::vector<double> & after = entry.second.samples;
+        Comparison comparison;
+        comparison.name = entry.first;
+        comparison.unit = entry.second.unit;
+        comparison.baselineCount = int(before.size());
+        comparison.currentCount = int(after.size());
+        comparison.baselineMedian = median(before);
+        comparison.currentMedian = median(after);
+        comparison.changePercent = comparison.baselineMedian != 0.0
+                                       ? 100.0 * (comparison.currentMedian - comparison.baselineMedian) / std::abs(comparison.baselineMedian)
+                                       : 0.0;
+
+        const bool testable = before.size() >= MIN_TEST_SAMPLES && after.size() >= MIN_TEST_SAMPLES;
+        comparison.pValue = testable ? mannWhitneyPValue(before, after) : -1.0;
+        const bool significant = !testable || comparison.pValue < thresholds.alpha;
+        const double percent = thresholds.percentFor(entry.first);
+        comparison.regression = significant && comparison.changePercent > percent;
+        comparison.improvement = significant && comparison.changePercent < -percent;
+        comparisons.push_back(comparison);
+    }
+    return comparisons;
+}
+
+int BenchmarkResults::compareFiles(const QString & baselineFile, const QStringList & currentFiles, const Thresholds & thresholds)
+{
+    BenchmarkResults baseline;
+    if (!baseline.load(baselineFile))
+        return 2;
+    BenchmarkResults current;
+    for (const QString & fileName : currentFiles)
+    {
+        BenchmarkResults run;
+        if (!run.load(fileName))
+            return 2;
+        current.merge(run);
+    }
+
+    qInfo().noquote() << QString("Compare : %1 against %2 run(s), threshold %3 %, alpha %4")
+                             .arg(baselineFile).arg(currentFiles.size()).arg(thresholds.percent).arg(thresholds.alpha);
+    int regressions = 0;
+    for (const Comparison & comparison : compare(baseline, current, thresholds))
+    {
+        const char * verdict = comparison.regression ? "REGRESSION" : comparison.improvement ? "improved" : "ok";
+        const QString pValue = comparison.pValue < 0.0 ? QString("n/a") : QString::number(comparison.pValue, 'g', 3);
+        qInfo().noquote() << QString("Compare : %1 %2 -> %3 %4 (%5%6 %, p %7, n %8/%9) %10")
+                                 .arg(comparison.name, -28)
+                                 .arg(comparison.baselineMedian, 10, 'f', 3).arg(comparison.currentMedian, 10, 'f', 3)
+                                 .arg(comparison.unit, -3)
+                                 .arg(comparison.changePercent >= 0.0 ? QString("+") : QString()).arg(comparison.changePercent, 0, 'f', 1)
+                                 .arg(pValue)
+                                 .arg(comparison.baselineCount).arg(comparison.currentCount)
+                                 .arg(QLatin1String(verdict));
+        if (comparison.regression)
+            regressions++;
+    }
+
+    // Renamed or new benchmarks are not compared, say so instead of passing silently
+    for (const auto & entry : baseline.m_metrics)
+    {
+        if (current.m_metrics.find(entry.first) == current.m_metrics.end())
+            qInfo().noquote() << "Compare :" << entry.first << "missing in the current run(s)";
+    }
+    for (const auto & entry : current.m_metrics)
+    {
+        if (baseline.m_metrics.find(entry.first) == baseline.m_metrics.end())
+            qInfo().noquote() << "Compare :" << entry.first << "not in the baseline";
+    }
+
+    qInfo().noquote() << QString("Compare : %1 regression(s)").arg(regressions);
+    return regressions > 0 ? 1 : 0;
+}
@@ -0,0 +1,86 @@
+#pragma once
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include <QString>
+#include <QStringList>
+
+#include <map>
+#include <vector>
+
+///
+/// \brief The BenchmarkResults are the measured samples of a run by metric
+/// name (e.g. "scenes/grid/gpu_ms": the GPU time of every frame), saved as
+/// JSON. A saved run is the baseline that later runs are compared with.
+/// Lower values are better for all metrics (times, memory).
+///
+/// A metric regresses when its median grew by more than the threshold and
+/// the Mann-Whitney U test says the samples differ (p < alpha), so noise
+/// alone does not fail the comparison. Files of repeated runs are merged
+/// (their samples added) before comparing.
+///
+class BenchmarkResults
+{
+public:
+    struct Metric
+    {
+        QString unit;
+        std::vector<double> samples;
+    };
+
+    struct Thresholds
+    {
+        double percent {5.0};           // allowed growth of the median
+        double alpha {0.01};            // significance level of the test
+        std::map<QString, double> metricPercent;   // per metric name
+
+        double percentFor(const QString & name) const;
+    };
+
+    struct Comparison
+    {
+        QString name;
+        QString unit;
+        int baselineCount {0};
+        int currentCount {0};
+        double baselineMedian {0.0};
+        double currentMedian {0.0};
+        double changePercent {0.0};
+        double pValue {1.0};           // < 0: too few samples, threshold only
+        bool regression {false};
+        bool improvement {false};
+    };
+
+    void add(const QString & name, const QString & unit, const std::vector<double> & samples);
+    void add(const QString & name, const QString & unit, double sample);
+    void merge(const BenchmarkResults & other);
+    void clear() { m_metrics.clear(); }
+    bool isEmpty() const { return m_metrics.empty(); }
+    const std::map<QString, Metric> & metrics() const { return m_metrics; }
+
+    bool save(const QString & fileName) const;
+    bool load(const QString & fileName);
+
+    // Metrics in both results (the others are listed by compareFiles)
+    static std::vector<Comparison> compare(const BenchmarkResults & baseline, const BenchmarkResults & current,
+                                           const Thresholds & thresholds);
+
+    // Writes the comparison with qInfo, returns the exit code: 0 ok, 1 regression, 2 bad files
+    static int compareFiles(const QString & baselineFile, const QStringList & currentFiles, const Thresholds & thresholds);
+
+    // Two sided p value (normal approximation with tie correction)
+    static double mannWhitneyPValue(const std::vector<double> & a, const std::vector<double> & b);
+    static double median(std::vector<double> samples);
+
+private:
+    std::map<QString, Metric> m_metrics;
+};
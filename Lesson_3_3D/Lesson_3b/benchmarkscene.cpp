@@ -0,0 +1,384 @@
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "benchmarkscene.h"
+
+#include <QRandomGenerator>
+#include <QtMath>
+
+#include <cmath>
+
+///////////////////////////////////////////////////////////////////////////////
+/// Camera path
+///////////////////////////////////////////////////////////////////////////////
+
+CameraPath::CameraPath(Mode mode, const std::vector<QVector3D> & keys, const std::vector<QVector3D> & targets)
+    : m_mode(mode)
+    , m_keys(keys)
+    , m_targets(targets)
+{
+}
+
+QVector3D CameraPath::spline(const std::vector<QVector3D> & keys, float t)
+{
+    if (keys.empty())
+        return QVector3D();
+    const int count = int(keys.size());
+    const float position = (t - std::floor(t)) * float(count);
+    const int segment = qMin(int(position), count - 1);
+    const float s = position - float(segment);
+
+    // Catmull-Rom through key[segment] and key[segment + 1], closed loop
+    const QVector3D & p0 = keys[size_t((segment + count - 1) % count)];
+    const QVector3D & p1 = keys[size_t(segment)];
+    const QVector3D & p2 = keys[size_t((segment + 1) % count)];
+    const QVector3D & p3 = keys[size_t((segment + 2) % count)];
+    const float s2 = s * s;
+    const float s3 = s2 * s;
+    return 0.5f * ((2.0f * p1) + (p2 - p0) * s + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * s2 + (3.0f * p1 - p0 - 3.0f * p2 + p3) * s3);
+}
+
+QVector3D CameraPath::key(float t) const
+{
+    return spline(m_keys, t);
+}
+
+QVector3D CameraPath::target(float t) const
+{
+    return m_targets.empty() ? m_center : spline(m_targets, t);
+}
+
+void CameraPath::apply(float t, PlayerCamera & camera) const
+{
+    // Same angles as ICamera::setLookAt, which skips an unchanged target
+    const QVector3D position = key(t);
+    const QVector3D lookDir = target(t) - position;
+    const float pitchDeg = qRadiansToDegrees(-std::atan2(lookDir.y(), std::sqrt(lookDir.x() * lookDir.x() + lookDir.z() * lookDir.z())));
+    const float yawDeg = qRadiansToDegrees(std::atan2(lookDir.x(), lookDir.z())) + 180.0f;
+    camera.setPosition(position);
+    camera.setRotation(yawDeg, pitchDeg);
+}
+
+void CameraPath::apply(float t, OrbitCamera & camera) const
+{
+    const QVector3D orbit = key(t);
+    camera.setOrbitCenter(target(t));
+    camera.setRadius(orbit.z());
+    // One lap per t = 0..1, the keys only add to the yaw (no jump at the wrap around)
+    const float t01 = t - std::floor(t);
+    camera.setRotation(360.0f * t01 + orbit.x(), orbit.y());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Scenes
+///////////////////////////////////////////////////////////////////////////////
+
+QStringList BenchmarkScene::names()
+{
+    return { "grid", "field", "overdraw", "textures", "mesh" };
+}
+
+const char * BenchmarkScene::kindName(Kind kind)
+{
+    switch (kind)
+    {
+    case Kind::Grid:
+        return "grid";
+    case Kind::Field:
+        return "field";
+    case Kind::Overdraw:
+        return "overdraw";
+    case Kind::Textures:
+        return "textures";
+    case Kind::Mesh:
+        return "mesh";
+    }
+    return "";
+}
+
+BenchmarkScene::Kind BenchmarkScene::kindFromName(const QString & name, bool * ok)
+{
+    const int index = names().indexOf(name.toLower());
+    if (ok)
+        *ok = index >= 0;
+    return index >= 0 ? Kind(index) : Kind::Grid;
+}
+
+BenchmarkScene BenchmarkScene::generate(Kind kind, quint32 seed)
+{
+    BenchmarkScene scene;
+    scene.kind = kind;
+    scene.m_seed = seed;
+    // Every scene has its own sequence, adding a scene does not change the others
+    QRandomGenerator random(seed * 31u + quint32(kind));
+    auto uniform = [&random](float low, float high) { return low + float(random.generateDouble()) * (high - low); };
+    auto vector = [&uniform](const QVector3D & low, const QVector3D & high) {
+        // One after the other, the order of function arguments is unspecified
+        const float x = uniform(low.x(), high.x());
+        const float y = uniform(low.y(), high.y());
+        const float z = uniform(low.z(), high.z());
+        return QVector3D(x, y, z);
+    };
+
+    switch (kind)
+    {
+    case Kind::Grid:
+    {
+        // 32 x 32 x 8 cubes, four copies of the cube mesh alternate so
+        // neighbours can not be merged into one instanced draw
+        int cubes[4];
+        for (int & cube : cubes)
+            cube = scene.addCube();
+        scene.textureLayers = 8;
+        for (int yy = 0; yy < 8; ++yy)
+        {
+            for (int zz = 0; zz < 32; ++zz)
+            {
+                for (int xx = 0; xx < 32; ++xx)
+                {
+                    Object object;
+                    object.mesh = cubes[(xx + zz + yy) & 3];
+                    object.model.translate(float(xx - 16) * 2.5f, float(yy) * 2.5f, float(zz - 16) * 2.5f);
+                    object.model.rotate(uniform(0.0f, 360.0f), QVector3D(0.0f, 1.0f, 0.0f));
+                    object.layer = int(random.bounded(scene.textureLayers));
+                    scene.objects.push_back(object);
+                }
+            }
+        }
+        std::vector<QVector3D> keys;
+        for (int ii = 0; ii < 6; ++ii)
+            keys.push_back(vector(QVector3D(-15.0f, 15.0f, 40.0f), QVector3D(15.0f, 45.0f, 80.0f)));
+        scene.camera = CameraPath(CameraPath::Mode::Orbit, keys);
+        scene.camera.setOrbitCenter(QVector3D(0.0f, 8.0f, 0.0f));
+        break;
+    }
+    case Kind::Field:
+    {
+        // 50000 small cubes at random in a 100 unit box, the camera flies through
+        const int cube = scene.addCube();
+        scene.textureLayers = 8;
+        for (int ii = 0; ii < 50000; ++ii)
+        {
+            Object object;
+            object.mesh = cube;
+            object.model.translate(vector(QVector3D(-50.0f, -50.0f, -50.0f), QVector3D(50.0f, 50.0f, 50.0f)));
+            const float angle = uniform(0.0f, 360.0f);
+            object.model.rotate(angle, vector(QVector3D(-1.0f, -1.0f, 1.0f), QVector3D(1.0f, 1.0f, 1.0f)).normalized());
+            object.model.scale(uniform(0.1f, 0.6f));
+            object.layer = int(random.bounded(scene.textureLayers));
+            scene.objects.push_back(object);
+        }
+        std::vector<QVector3D> keys;
+        std::vector<QVector3D> targets;
+        for (int ii = 0; ii < 8; ++ii)
+        {
+            keys.push_back(vector(QVector3D(-40.0f, -40.0f, -40.0f), QVector3D(40.0f, 40.0f, 40.0f)));
+            targets.push_back(vector(QVector3D(-20.0f, -20.0f, -20.0f), QVector3D(20.0f, 20.0f, 20.0f)));
+        }
+        scene.camera = CameraPath(CameraPath::Mode::Player, keys, targets);
+        break;
+    }
+    case Kind::Overdraw:
+    {
+        // 64 screen filling transparent quads, back to front (-z first)
+        const int quad = scene.addQuad();
+        scene.textureLayers = 4;
+        scene.blended = true;
+        for (int ii = 0; ii < 64; ++ii)
+        {
+            Object object;
+            object.mesh = quad;
+            const float depth = -float(64 - ii) * 0.25f;
+            object.model.translate(vector(QVector3D(-1.0f, -1.0f, depth), QVector3D(1.0f, 1.0f, depth)));
+            object.model.scale(40.0f);
+            object.layer = ii % scene.textureLayers;
+            object.alpha = uniform(0.05f, 0.2f);
+            scene.objects.push_back(object);
+        }
+        // In front of the stack, swaying a little
+        std::vector<QVector3D> keys;
+        std::vector<QVector3D> targets;
+        for (int ii = 0; ii < 4; ++ii)
+        {
+            keys.push_back(vector(QVector3D(-2.0f, -2.0f, 4.0f), QVector3D(2.0f, 2.0f, 8.0f)));
+            targets.push_back(vector(QVector3D(-1.0f, -1.0f, -8.0f), QVector3D(1.0f, 1.0f, -8.0f)));
+        }
+        scene.camera = CameraPath(CameraPath::Mode::Player, keys, targets);
+        break;
+    }
+    case Kind::Textures:
+    {
+        // 128 layers of 512 x 512 (170 MB with the mipmaps), large cubes close
+        // to the camera sample the finest levels
+        const int cube = scene.addCube();
+        scene.textureLayers = 128;
+        scene.textureSize = 512;
+        for (int ii = 0; ii < 1024; ++ii)
+        {
+            Object object;
+            object.mesh = cube;
+            const float angle = uniform(0.0f, 2.0f * float(M_PI));
+            const float distance = uniform(6.0f, 40.0f);
+            object.model.translate(distance * std::cos(angle), uniform(-4.0f, 4.0f), distance * std::sin(angle));
+            object.model.rotate(uniform(0.0f, 360.0f), QVector3D(0.0f, 1.0f, 0.0f));
+            object.model.scale(uniform(1.0f, 3.0f));
+            object.layer = ii % scene.textureLayers;
+            scene.objects.push_back(object);
+        }
+        std::vector<QVector3D> keys;
+        for (int ii = 0; ii < 8; ++ii)
+            keys.push_back(vector(QVector3D(-20.0f, -10.0f, 8.0f), QVector3D(20.0f, 20.0f, 30.0f)));
+        scene.camera = CameraPath(CameraPath::Mode::Orbit, keys);
+        break;
+    }
+    case Kind::Mesh:
+    {
+        // One 1024 x 1024 vertex heightfield (2 million triangles), one draw
+        const int mesh = scene.addHeightfield(1024, 200.0f, 20.0f);
+        scene.textureLayers = 4;
+        Object object;
+        object.mesh = mesh;
+        scene.objects.push_back(object);
+        std::vector<QVector3D> keys;
+        std::vector<QVector3D> targets;
+        for (int ii = 0; ii < 6; ++ii)
+        {
+            const float angle = float(ii) * 2.0f * float(M_PI) / 6.0f;
+            keys.push_back(QVector3D(70.0f * std::cos(angle), uniform(25.0f, 50.0f), 70.0f * std::sin(angle)));
+            targets.push_back(vector(QVector3D(-30.0f, 0.0f, -30.0f), QVector3D(30.0f, 0.0f, 30.0f)));
+        }
+        scene.camera = CameraPath(CameraPath::Mode::Player, keys, targets);
+        break;
+    }
+    }
+    return scene;
+}
+
+void BenchmarkScene::textureLayer(int layer, uchar * rgba) const
+{
+    // Checker board in two colors of the layer with noise, no flat areas
+    // that a texture cache or compression would make cheap
+    QRandomGenerator random(m_seed * 7919u + quint32(layer));
+    const quint32 colors[2] = { random.generate() | 0xff000000u, random.generate() | 0xff000000u };
+    const int cell = qMax(1, textureSize / 8);
+    for (int yy = 0; yy < textureSize; ++yy)
+    {
+        for (int xx = 0; xx < textureSize; ++xx, rgba += 4)
+        {
+            const quint32 color = colors[((xx / cell) + (yy / cell)) & 1];
+            const quint32 noise = random.generate();
+            for (int cc = 0; cc < 3; ++cc)
+                rgba[cc] = uchar(qBound(0, int((color >> (8 * cc)) & 0xff) + int((noise >> (8 * cc)) & 0x1f) - 16, 255));
+            rgba[3] = 255;
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Meshes
+///////////////////////////////////////////////////////////////////////////////
+
+int BenchmarkScene::addCube()
+{
+    MeshComponent mesh;
+    mesh.firstIndex = GLuint(indices.size());
+    mesh.baseVertex = GLint(vertices.size());
+
+    // Four vertices per face (own texture coordinates), unit cube around 0
+    static const float faces[6][4][3] = {
+        { {-1, -1,  1}, { 1, -1,  1}, { 1,  1,  1}, {-1,  1,  1} },
+        { { 1, -1, -1}, {-1, -1, -1}, {-1,  1, -1}, { 1,  1, -1} },
+        { {-1, -1, -1}, {-1, -1,  1}, {-1,  1,  1}, {-1,  1, -1} },
+        { { 1, -1,  1}, { 1, -1, -1}, { 1,  1, -1}, { 1,  1,  1} },
+        { {-1,  1,  1}, { 1,  1,  1}, { 1,  1, -1}, {-1,  1, -1} },
+        { {-1, -1, -1}, { 1, -1, -1}, { 1, -1,  1}, {-1, -1,  1} },
+    };
+    static const float uvs[4][2] = { {0, 0}, {1, 0}, {1, 1}, {0, 1} };
+    for (int face = 0; face < 6; ++face)
+    {
+        const quint32 first = quint32(face * 4);
+        for (int corner = 0; corner < 4; ++corner)
+            vertices.push_back(Vertex{0.5f * faces[face][corner][0], 0.5f * faces[face][corner][1], 0.5f * faces[face][corner][2], uvs[corner][0], uvs[corner][1]});
+        for (quint32 index : { first, first + 1, first + 2, first, first + 2, first + 3 })
+            indices.push_back(index);
+    }
+
+    mesh.indexCount = GLsizei(indices.size() - mesh.firstIndex);
+    meshes.push_back(mesh);
+    return int(meshes.size()) - 1;
+}
+
+int BenchmarkScene::addQuad()
+{
+    MeshComponent mesh;
+    mesh.firstIndex = GLuint(indices.size());
+    mesh.baseVertex = GLint(vertices.size());
+    vertices.push_back(Vertex{-0.5f, -0.5f, 0.0f, 0.0f, 0.0f});
+    vertices.push_back(Vertex{ 0.5f, -0.5f, 0.0f, 1.0f, 0.0f});
+    vertices.push_back(Vertex{ 0.5f,  0.5f, 0.0f, 1.0f, 1.0f});
+    vertices.push_back(Vertex{-0.5f,  0.5f, 0.0f, 0.0f, 1.0f});
+    for (quint32 index : { 0u, 1u, 2u, 0u, 2u, 3u })
+        indices.push_back(index);
+    mesh.indexCount = 6;
+    meshes.push_back(mesh);
+    return int(meshes.size()) - 1;
+}
+
+int BenchmarkScene::addHeightfield(int resolution, float size, float height)
+{
+    MeshComponent mesh;
+    mesh.firstIndex = GLuint(indices.size());
+    mesh.baseVertex = GLint(vertices.size());
+
+    // Sum of a few random waves, smooth enough to look like terrain
+    QRandomGenerator random(m_seed * 104729u);
+    float waves[4][4];
+    for (auto & wave : waves)
+    {
+        wave[0] = float(random.generateDouble()) * 0.1f + 0.01f;  // frequency x
+        wave[1] = float(random.generateDouble()) * 0.1f + 0.01f;  // frequency z
+        wave[2] = float(random.generateDouble()) * 2.0f * float(M_PI);
+        wave[3] = float(random.generateDouble()) * 0.5f + 0.1f;   // amplitude
+    }
+
+    vertices.reserve(vertices.size() + size_t(resolution) * size_t(resolution));
+    for (int zz = 0; zz < resolution; ++zz)
+    {
+        for (int xx = 0; xx < resolution; ++xx)
+        {
+            const float u = float(xx) / float(resolution - 1);
+            const float v = float(zz) / float(resolution - 1);
+            const float x = (u - 0.5f) * size;
+            const float z = (v - 0.5f) * size;
+            float y = 0.0f;
+            for (const auto & wave : waves)
+                y += wave[3] * std::sin(x * wave[0] + z * wave[1] + wave[2]);
+            vertices.push_back(Vertex{x, y * height * 0.5f, z, u * 16.0f, v * 16.0f});
+        }
+    }
+
+    indices.reserve(indices.size() + size_t(resolution - 1) * size_t(resolution - 1) * 6);
+    for (int zz = 0; zz + 1 < resolution; ++zz)
+    {
+        for (int xx = 0; xx + 1 < resolution; ++xx)
+        {
+            const quint32 corner = quint32(zz * resolution + xx);
+            const quint32 below = corner + quint32(resolution);
+            for (quint32 index : { corner, below, corner + 1, corner + 1, below, below + 1 })
+                indices.push_back(index);
+        }
+    }
+
+    mesh.indexCount = GLsizei(indices.size() - mesh.firstIndex);
+    meshes.push_back(mesh);
+    return int(meshes.size()) - 1;
+}
@@ -0,0 +1,129 @@
+#pragma once
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "camera.h"
+#include "components.h"
+
+#include <QMatrix4x4>
+#include <QString>
+#include <QStringList>
+#include <QVector3D>
+#include <QVector4D>
+
+#include <vector>
+
+///
+/// \brief The CameraPath moves a camera along a closed Catmull-Rom spline,
+/// t = 0..1 is one lap. A PlayerCamera follows the position keys and looks at
+/// the target keys, an OrbitCamera does one lap around the center and reads
+/// the keys as (yaw offset, pitch, radius).
+///
+class CameraPath
+{
+public:
+    enum class Mode
+    {
+        Player,
+        Orbit
+    };
+
+    CameraPath() = default;
+    CameraPath(Mode mode, const std::vector<QVector3D> & keys, const std::vector<QVector3D> & targets = {});
+
+    Mode mode() const { return m_mode; }
+    void setOrbitCenter(const QVector3D & center) { m_center = center; }
+
+    // Key and target interpolation at t (wraps around)
+    QVector3D key(float t) const;
+    QVector3D target(float t) const;
+
+    void apply(float t, PlayerCamera & camera) const;
+    void apply(float t, OrbitCamera & camera) const;
+
+private:
+    static QVector3D spline(const std::vector<QVector3D> & keys, float t);
+
+    Mode m_mode {Mode::Player};
+    std::vector<QVector3D> m_keys;
+    std::vector<QVector3D> m_targets;
+    QVector3D m_center;
+};
+
+///
+/// \brief The BenchmarkScene is one of the standard workloads of the scene
+/// benchmark (see Benchmark::scenes), generated from a seed so every run and
+/// every machine renders exactly the same objects along the same camera path.
+/// - grid : many small cubes with distinct meshes, draw call bound
+/// - field : a dense random field of cubes, vertex and triangle setup bound
+/// - overdraw : a stack of large blended quads, fill rate bound
+/// - textures : cubes over many large texture layers, texture bandwidth bound
+/// - mesh : one large heightfield mesh, vertex bound
+///
+/// Vertices are position and texture coordinate, indices are 32 bit. Every
+/// object has a mesh (index range), a model matrix and a texture layer.
+///
+class BenchmarkScene
+{
+public:
+    enum class Kind
+    {
+        Grid,
+        Field,
+        Overdraw,
+        Textures,
+        Mesh
+    };
+
+    struct Vertex
+    {
+        float x, y, z;
+        float u, v;
+    };
+
+    struct Object
+    {
+        int mesh {0};
+        QMatrix4x4 model;
+        int layer {0};
+        float alpha {1.0f};
+    };
+
+    static BenchmarkScene generate(Kind kind, quint32 seed);
+
+    static QStringList names();
+    static const char * kindName(Kind kind);
+    static Kind kindFromName(const QString & name, bool * ok = nullptr);
+
+    Kind kind {Kind::Grid};
+    std::vector<Vertex> vertices;
+    std::vector<quint32> indices;
+    std::vector<MeshComponent> meshes;
+    std::vector<Object> objects;
+
+    // Texture array, every layer a different pattern (RGBA8, size * size * 4 bytes)
+    int textureLayers {1};
+    int textureSize {64};
+    void textureLayer(int layer, uchar * rgba) const;
+
+    // Transparent objects are blended without depth test (back to front as generated)
+    bool blended {false};
+
+    CameraPath camera;
+
+private:
+    int addCube();
+    int addQuad();
+    int addHeightfield(int resolution, float size, float height);
+
+    quint32 m_seed {0};
+};
@@ -0,0 +1,278 @@
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "benchmark.h"
+#include "offscreencontext.h"
+#include "drawbatch.h"
+#include "benchmarkscene.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QOpenGLFunctions_3_3_Core>
+#include <QOpenGLShaderProgram>
+
+#include <algorithm>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+/// Scenes - the standard workloads of BenchmarkScene (draw calls, triangles,
+/// fill rate, texture bandwidth, vertices) along their camera paths, CPU
+/// submission and GPU time of every frame
+///////////////////////////////////////////////////////////////////////////////
+
+int Benchmark::scenes(int frameCount)
+{
+    const int targetSize = 1024;
+    OffscreenContext offscreen;
+    if (!offscreen.create(targetSize))
+        return 1;
+
+    QOpenGLFunctions_3_3_Core gl;
+    gl.initializeOpenGLFunctions();
+
+    // Object data like uber.vert (FEATURE_INSTANCED), parameters = (layer, alpha)
+    const GLuint drawIdLocation = 2;
+    QOpenGLShaderProgram program;
+    program.addShaderFromSourceCode(QOpenGLShader::Vertex,
+        "#version 330 core\n"
+        "layout (location = 0) in vec3 pos;\n"
+        "layout (location = 1) in vec2 texPos;\n"
+        "layout (location = 2) in uint drawId;\n"
+        "uniform samplerBuffer objectData;\n"
+        "uniform int objectDataOffset;\n"
+        "uniform mat4 viewProjection;\n"
+        "out vec3 texCoord;\n"
+        "out float alpha;\n"
+        "void main()\n"
+        "{\n"
+        "    int texel = objectDataOffset + int(drawId) * 5;\n"
+        "    mat4 model = mat4(texelFetch(objectData, texel), texelFetch(objectData, texel + 1),\n"
+        "                      texelFetch(objectData, texel + 2), texelFetch(objectData, texel + 3));\n"
+        "    vec4 parameters = texelFetch(objectData, texel + 4);\n"
+        "    gl_Position = viewProjection * model * vec4(pos, 1.0);\n"
+        "    texCoord = vec3(texPos, parameters.x);\n"
+        "    alpha = parameters.y;\n"
+        "}\n");
+    program.addShaderFromSourceCode(QOpenGLShader::Fragment,
+        "#version 330 core\n"
+        "in vec3 texCoord;\n"
+        "in float alpha;\n"
+        "uniform sampler2DArray textures;\n"
+        "out vec4 frag_color;\n"
+        "void main() { frag_color = vec4(texture(textures, texCoord).rgb, alpha); }\n");
+    if (!program.link())
+    {
+        qWarning() << "Benchmark : shader link FAILED" << program.log();
+        return 1;
+    }
+
+    auto percentile = [](std::vector<qint64> samples, double fraction) {
+        samples.erase(std::remove(samples.begin(), samples.end(), qint64(-1)), samples.end());
+        if (samples.empty())
+            return 0.0;
+        std::sort(samples.begin(), samples.end());
+        return double(samples[size_t(fraction * double(samples.size() - 1))]) / 1e6;
+    };
+
+    // GPU time of the frames, read QUERY_FRAMES later (bounds the frames in flight)
+    const int QUERY_FRAMES = 4;
+    GLuint queries[QUERY_FRAMES] {};
+    gl.glGenQueries(QUERY_FRAMES, queries);
+
+    qInfo().noquote() << QString("Benchmark : seed %1, %2 frames per scene at %3 x %3").arg(s_seed).arg(frameCount).arg(targetSize);
+    int result = 0;
+    for (const QString & name : BenchmarkScene::names())
+    {
+        QElapsedTimer loadTimer;
+        loadTimer.start();
+        const BenchmarkScene scene = BenchmarkScene::generate(BenchmarkScene::kindFromName(name), s_seed);
+        const qint64 generateNanoseconds = loadTimer.nsecsElapsed();
+        loadTimer.restart();
+
+        GLuint vao = 0;
+        GLuint buffers[2] {};
+        gl.glGenVertexArrays(1, &vao);
+        gl.glBindVertexArray(vao);
+        gl.glGenBuffers(2, buffers);
+        gl.glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+        gl.glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(scene.vertices.size() * sizeof(BenchmarkScene::Vertex)), scene.vertices.data(), GL_STATIC_DRAW);
+        gl.glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(BenchmarkScene::Vertex), nullptr);
+        gl.glEnableVertexAttribArray(0);
+        gl.glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(BenchmarkScene::Vertex), reinterpret_cast<void *>(3 * sizeof(float)));
+        gl.glEnableVertexAttribArray(1);
+        gl.glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers[1]);
+        gl.glBufferData(GL_ELEMENT_ARRAY_BUFFER, GLsizeiptr(scene.indices.size() * sizeof(quint32)), scene.indices.data(), GL_STATIC_DRAW);
+
+        GLuint texture = 0;
+        gl.glGenTextures(1, &texture);
+        gl.glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+        gl.glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, scene.textureSize, scene.textureSize, scene.textureLayers, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        {
+            std::vector<uchar> pixels(size_t(scene.textureSize) * size_t(scene.textureSize) * 4);
+            for (int layer = 0; layer < scene.textureLayers; ++layer)
+            {
+                scene.textureLayer(layer, pixels.data());
+                gl.glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, scene.textureSize, scene.textureSize, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+            }
+        }
+        gl.glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+        gl.glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        gl.glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        gl.glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        gl.glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        gl.glFinish();
+        const qint64 uploadNanoseconds = loadTimer.nsecsElapsed();
+        const qint64 sceneBytes = qint64(scene.vertices.size() * sizeof(BenchmarkScene::Vertex) + scene.indices.size() * sizeof(quint32))
+                                  + qint64(scene.textureSize) * scene.textureSize * scene.textureLayers * 4 * 4 / 3;
+
+        DrawBatch batch;
+        if (!batch.create(drawIdLocation, int(scene.objects.size())))
+        {
+            qWarning() << "Benchmark : scene" << name << "draw batch FAILED";
+            result = 1;
+        }
+        else
+        {
+            if (scene.blended)
+            {
+                gl.glDisable(GL_DEPTH_TEST);
+                gl.glEnable(GL_BLEND);
+                gl.glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            }
+            else
+            {
+                gl.glEnable(GL_DEPTH_TEST);
+                gl.glDisable(GL_BLEND);
+            }
+
+            PlayerCamera playerCamera;
+            OrbitCamera orbitCamera(10.0f, 0.0f, 0.0f);
+            QMatrix4x4 projection;
+            projection.perspective(45.0f, 1.0f, 0.1f, 500.0f);
+
+            // A few unmeasured frames first (driver shader compiles, first texture use)
+            const int warmUpFrames = 10;
+            std::vector<qint64> cpuNanoseconds(size_t(frameCount), -1);
+            std::vector<qint64> gpuNanoseconds(size_t(frameCount), -1);
+            int queryFrame[QUERY_FRAMES];
+            std::fill(std::begin(queryFrame), std::end(queryFrame), -1 - warmUpFrames);
+            quint64 triangles = 0;
+            int drawCalls = 0;
+            QElapsedTimer wallTimer;
+            QElapsedTimer timer;
+            for (int ff = -warmUpFrames; ff < frameCount; ++ff)
+            {
+                if (ff == 0)
+                    wallTimer.start();
+                const float t = float(qMax(ff, 0)) / float(frameCount);
+                QMatrix4x4 view;
+                if (scene.camera.mode() == CameraPath::Mode::Orbit)
+                {
+                    scene.camera.apply(t, orbitCamera);
+                    view = orbitCamera.viewMatrix();
+                }
+                else
+                {
+                    scene.camera.apply(t, playerCamera);
+                    view = playerCamera.viewMatrix();
+                }
+
+                // The query of this slot is QUERY_FRAMES old, its result is (nearly) there
+                const int slot = (ff + warmUpFrames) % QUERY_FRAMES;
+                if (queryFrame[slot] > -1 - warmUpFrames)
+                {
+                    GLuint64 elapsed = 0;
+                    gl.glGetQueryObjectui64v(queries[slot], GL_QUERY_RESULT, &elapsed);
+                    if (queryFrame[slot] >= 0)
+                        gpuNanoseconds[size_t(queryFrame[slot])] = qint64(elapsed);
+                }
+
+                timer.restart();
+                gl.glBeginQuery(GL_TIME_ELAPSED, queries[slot]);
+                queryFrame[slot] = ff;
+                gl.glClearColor(0.2f, 0.2f, 0.3f, 1.0f);
+                gl.glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+                batch.begin();
+                for (const BenchmarkScene::Object & object : scene.objects)
+                    batch.add(scene.meshes[size_t(object.mesh)], object.model, QVector4D(float(object.layer), object.alpha, 0.0f, 0.0f));
+                batch.end();
+
+                program.bind();
+                program.setUniformValue("viewProjection", projection * view);
+                program.setUniformValue("objectDataOffset", batch.objectDataOffset());
+                program.setUniformValue("objectData", GLint(1));
+                program.setUniformValue("textures", GLint(0));
+                batch.bindObjectData(1);
+                gl.glActiveTexture(GL_TEXTURE0);
+                gl.glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+                batch.draw(GL_UNSIGNED_INT);
+                batch.finish();
+                gl.glEndQuery(GL_TIME_ELAPSED);
+                gl.glFlush();
+                if (ff >= 0)
+                    cpuNanoseconds[size_t(ff)] = timer.nsecsElapsed();
+                triangles = batch.statistics().triangles;
+                drawCalls = batch.statistics().drawCalls;
+            }
+
+            // The last frames
+            gl.glFinish();
+            const qint64 wallNanoseconds = wallTimer.nsecsElapsed();
+            for (int slot = 0; slot < QUERY_FRAMES; ++slot)
+            {
+                if (queryFrame[slot] < 0)
+                    continue;
+                GLuint64 elapsed = 0;
+                gl.glGetQueryObjectui64v(queries[slot], GL_QUERY_RESULT, &elapsed);
+                gpuNanoseconds[size_t(queryFrame[slot])] = qint64(elapsed);
+            }
+
+            qInfo().noquote() << QString("Benchmark : scene %1 %2 objects, %3 triangles, %4 draw calls, generated in %5 ms")
+                                     .arg(name, -8).arg(scene.objects.size(), 6).arg(triangles, 8).arg(drawCalls, 5)
+                                     .arg(double(generateNanoseconds) / 1e6, 0, 'f', 1);
+            qInfo().noquote() << QString("Benchmark : scene %1 CPU p50 %2 p95 %3 p99 %4 ms, GPU p50 %5 p95 %6 p99 %7 max %8 ms, %9 fps")
+                                     .arg(name, -8)
+                                     .arg(percentile(cpuNanoseconds, 0.50), 0, 'f', 3).arg(percentile(cpuNanoseconds, 0.95), 0, 'f', 3)
+                                     .arg(percentile(cpuNanoseconds, 0.99), 0, 'f', 3)
+                                     .arg(percentile(gpuNanoseconds, 0.50), 0, 'f', 3).arg(percentile(gpuNanoseconds, 0.95), 0, 'f', 3)
+                                     .arg(percentile(gpuNanoseconds, 0.99), 0, 'f', 3).arg(percentile(gpuNanoseconds, 1.0), 0, 'f', 3)
+                                     .arg(double(frameCount) * 1e9 / double(qMax(wallNanoseconds, qint64(1))), 0, 'f', 1);
+
+            auto milliseconds = [](const std::vector<qint64> & nanoseconds) {
+                std::vector<double> samples;
+                for (qint64 value : nanoseconds)
+                {
+                    if (value >= 0)
+                        samples.push_back(double(value) / 1e6);
+                }
+                return samples;
+            };
+            const QString metric = "scenes/" + name + "/";
+            s_results.add(metric + "cpu_ms", "ms", milliseconds(cpuNanoseconds));
+            s_results.add(metric + "gpu_ms", "ms", milliseconds(gpuNanoseconds));
+            s_results.add(metric + "generate_ms", "ms", double(generateNanoseconds) / 1e6);
+            s_results.add(metric + "upload_ms", "ms", double(uploadNanoseconds) / 1e6);
+            s_results.add(metric + "gpu_memory_mb", "MB", double(sceneBytes + batch.memoryBytes()) / (1024.0 * 1024.0));
+            batch.destroy();
+        }
+
+        gl.glDisable(GL_BLEND);
+        gl.glBindVertexArray(0);
+        gl.glDeleteVertexArrays(1, &vao);
+        gl.glDeleteBuffers(2, buffers);
+        gl.glDeleteTextures(1, &texture);
+    }
+
+    gl.glDeleteQueries(QUERY_FRAMES, queries);
+    return result;
+}
@@ -0,0 +1,223 @@
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "benchmark.h"
+#include "offscreencontext.h"
+#include "texture2D.h"
+#include "shaderprogram.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QOpenGLFunctions_3_3_Core>
+#include <QImage>
+#include <QColor>
+
+#include <memory>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+/// Shader compile - one after the other compared to a batch started up front
+///////////////////////////////////////////////////////////////////////////////
+
+int Benchmark::shaderCompile(int programCount)
+{
+    OffscreenContext offscreen;
+    if (!offscreen.create())
+        return 1;
+
+    const QByteArray vsSource = ShaderProgram::readSource(":/Shaders/uber.vert");
+    const QByteArray fsSource = ShaderProgram::readSource(":/Shaders/uber.frag");
+    if (vsSource.isEmpty() || fsSource.isEmpty())
+    {
+        qWarning() << "Benchmark : shader files not found";
+        return 1;
+    }
+
+    // Every program gets a different source, so the driver's shader cache does not help
+    int variant = 0;
+    auto makeSource = [&variant](const QByteArray & source) {
+        return ShaderProgram::insertDefines(source, "#define BENCHMARK_VARIANT " + QByteArray::number(variant) + "\n");
+    };
+
+    for (bool batched : { false, true })
+    {
+        std::vector<std::unique_ptr<ShaderProgram>> programs;
+        for (int ii = 0; ii < programCount; ++ii)
+            programs.push_back(std::make_unique<ShaderProgram>());
+
+        QElapsedTimer timer;
+        timer.start();
+        qint64 startedNanoseconds = 0;
+        int polls = 0;
+        bool ok = true;
+        if (batched)
+        {
+            ShaderLoadBatch batch;
+            for (auto & program : programs)
+            {
+                variant++;
+                batch.addFromSource(*program, makeSource(vsSource), makeSource(fsSource));
+            }
+            startedNanoseconds = timer.nsecsElapsed();
+
+            // The application would do other work here, we just poll
+            while (programs.front()->hasParallelCompile() && batch.pendingCount() > 0)
+                polls++;
+            ok = batch.finish();
+        }
+        else
+        {
+            for (auto & program : programs)
+            {
+                variant++;
+                program->beginLoadFromSource(makeSource(vsSource), makeSource(fsSource));
+                ok = program->finishLoad() && ok;
+            }
+            startedNanoseconds = timer.nsecsElapsed();
+        }
+        const qint64 totalNanoseconds = timer.nsecsElapsed();
+
+        qInfo().noquote() << QString("Benchmark : shaders %1 - %2 programs, %3 ms total, %4 ms until all started, %5 polls, parallel compile %6%7")
+                                 .arg(QLatin1String(batched ? "batch     " : "one by one")).arg(programCount)
+                                 .arg(double(totalNanoseconds) / 1e6, 0, 'f', 2).arg(double(startedNanoseconds) / 1e6, 0, 'f', 2)
+                                 .arg(polls).arg(QLatin1String(programs.front()->hasParallelCompile() ? "yes" : "no"))
+                                 .arg(QLatin1String(ok ? "" : " (FAILED)"));
+        for (auto & program : programs)
+            program->unloadShaders();
+    }
+    return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Shader permutations - compile cost of all of them, runtime cost of branching
+///////////////////////////////////////////////////////////////////////////////
+
+int Benchmark::shaderPermutations()
+{
+    const int targetSize = 1024;
+    OffscreenContext offscreen;
+    if (!offscreen.create(targetSize))
+        return 1;
+
+    QOpenGLFunctions_3_3_Core gl;
+    gl.initializeOpenGLFunctions();
+
+    // Every combination of the features
+    ShaderPermutations permutations;
+    if (!permutations.setSources(":/Shaders/uber.vert", ":/Shaders/uber.frag"))
+        return 1;
+    const quint32 permutationCount = 1u << ShaderPermutations::FEATURE_COUNT;
+    for (quint32 features = 0; features < permutationCount; ++features)
+    {
+        if (!permutations.program(features))
+            qWarning() << "Benchmark : permutation" << features << "FAILED";
+    }
+    const ShaderPermutations::Statistics statistics = permutations.statistics();
+    qInfo().noquote() << QString("Benchmark : permutations - %1 compiled in %2 ms, %3 ms each")
+                             .arg(statistics.permutations).arg(double(statistics.compileNanoseconds) / 1e6, 0, 'f', 2)
+                             .arg(double(statistics.compileNanoseconds) / 1e6 / qMax(1, statistics.permutations), 0, 'f', 2);
+
+    // One program for all, the features are a uniform and the branches stay
+    QElapsedTimer timer;
+    timer.start();
+    ShaderProgram runtimeProgram;
+    runtimeProgram.beginLoad(":/Shaders/uber.vert", ":/Shaders/uber.frag", "#define RUNTIME_FEATURES\n");
+    if (!runtimeProgram.finishLoad())
+        return 1;
+    qInfo().noquote() << QString("Benchmark : permutations - runtime branching program compiled in %1 ms")
+                             .arg(double(timer.nsecsElapsed()) / 1e6, 0, 'f', 2);
+
+    // Full screen quads, textured, drawn on top of each other (fragment bound)
+    const float quad[] = {
+        -1.0f, -1.0f, 0.0f,  0.0f, 0.0f,
+         1.0f, -1.0f, 0.0f,  1.0f, 0.0f,
+         1.0f,  1.0f, 0.0f,  1.0f, 1.0f,
+        -1.0f,  1.0f, 0.0f,  0.0f, 1.0f };
+    const quint16 quadIndices[] = { 0, 1, 2, 0, 2, 3 };
+    GLuint vao = 0;
+    GLuint buffers[3] = {};
+    gl.glGenVertexArrays(1, &vao);
+    gl.glBindVertexArray(vao);
+    gl.glGenBuffers(3, buffers);
+    gl.glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+    gl.glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+    gl.glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), nullptr);
+    gl.glEnableVertexAttribArray(0);
+    gl.glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), reinterpret_cast<void *>(3 * sizeof(float)));
+    gl.glEnableVertexAttribArray(1);
+    gl.glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers[1]);
+    gl.glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(quadIndices), quadIndices, GL_STATIC_DRAW);
+    gl.glBindVertexArray(0);
+
+    // Identity view and projection in the frame block
+    const QMatrix4x4 identity;
+    QByteArray frameBlock;
+    frameBlock.append(reinterpret_cast<const char *>(identity.constData()), 16 * sizeof(float));
+    frameBlock.append(reinterpret_cast<const char *>(identity.constData()), 16 * sizeof(float));
+    gl.glBindBuffer(GL_UNIFORM_BUFFER, buffers[2]);
+    gl.glBufferData(GL_UNIFORM_BUFFER, frameBlock.size(), frameBlock.constData(), GL_STATIC_DRAW);
+    gl.glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    gl.glBindBufferBase(GL_UNIFORM_BUFFER, 0, buffers[2]);
+
+    QImage image(256, 256, QImage::Format_RGBA8888);
+    image.fill(QColor(200, 120, 40));
+    Texture2D texture(QOpenGLTexture::Target2DArray);
+    texture.loadTextureArray({ image }, Texture2D::LayerFit::Scale, true);
+
+    const quint32 features = ShaderPermutations::Textured;
+    ShaderProgram * specializedProgram = permutations.program(features);
+    struct Candidate
+    {
+        const char * name;
+        ShaderProgram * program;
+    };
+    const Candidate candidates[] = { { "specialized", specializedProgram }, { "runtime    ", &runtimeProgram } };
+
+    const int frames = 50;
+    const int layers = 16;
+    for (const Candidate & candidate : candidates)
+    {
+        ShaderProgram * program = candidate.program;
+        if (!program)
+            continue;
+        program->use();
+        program->setUniformBlockBinding("FrameBlock", 0);
+        program->setUniform("texSampler", 0);
+        program->setUniform("model", identity);
+        program->setUniform("objectParameters", QVector4D(0.0f, 1.0f, 1.0f, 0.0f));
+        if (program == &runtimeProgram)
+            program->setUniform("features", GLint(features));
+        texture.bind();
+        gl.glBindVertexArray(vao);
+
+        gl.glFinish();
+        timer.restart();
+        for (int ff = 0; ff < frames; ++ff)
+        {
+            gl.glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            for (int ll = 0; ll < layers; ++ll)
+                gl.glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, nullptr);
+        }
+        gl.glFinish();
+        qInfo().noquote() << QString("Benchmark : permutations - %1 %2 ms/frame (%3 full screen layers of %4x%4)")
+                                 .arg(QLatin1String(candidate.name)).arg(double(timer.nsecsElapsed()) / 1e6 / frames, 0, 'f', 3)
+                                 .arg(layers).arg(targetSize);
+    }
+
+    gl.glBindVertexArray(0);
+    texture.destroy();
+    runtimeProgram.unloadShaders();
+    permutations.clear();
+    gl.glDeleteVertexArrays(1, &vao);
+    gl.glDeleteBuffers(3, buffers);
+    return 0;
+}
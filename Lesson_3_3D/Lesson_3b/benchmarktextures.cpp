@@ -0,0 +1,451 @@
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "benchmark.h"
+#include "offscreencontext.h"
+#include "jobsystem.h"
+#include "texture2D.h"
+#include "texturestreamer.h"
+#include "gpumemory.h"
+#include "texturecache.h"
+#include "mipmapbuilder.h"
+#include "pixelconversion.h"
+#include "resourcemanager.h"
+#include "glwidget.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QOpenGLFunctions_3_3_Core>
+#include <QImage>
+#include <QColor>
+#include <QTemporaryDir>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+/// Texture streaming - textures coming close and going away again, resident
+/// memory against the budget and the time until a requested level is used
+///////////////////////////////////////////////////////////////////////////////
+
+int Benchmark::textureStreaming(int textureCount)
+{
+    OffscreenContext offscreen;
+    if (!offscreen.create())
+        return 1;
+
+    QOpenGLFunctions_3_3_Core gl;
+    gl.initializeOpenGLFunctions();
+
+    const int hardwareThreads = qMax(1, int(std::thread::hardware_concurrency()));
+    JobSystem jobs(qMax(1, hardwareThreads - 1));
+
+    // Together the full mip chains need several times the budget
+    const qint64 budget = 32 * 1024 * 1024;
+    TextureStreamer streamer;
+    streamer.create(jobs, budget);
+    std::vector<std::unique_ptr<Texture2D>> textures;
+    for (int ii = 0; ii < textureCount; ++ii)
+    {
+        textures.push_back(std::make_unique<Texture2D>(QOpenGLTexture::Target2DArray));
+        if (!streamer.add(textures.back().get(), { ":/Images/funpic.jpg", ":/Images/grid.jpg" }))
+            return 1;
+    }
+    streamer.waitForLoads();
+    const qint64 tailBytes = streamer.statistics().residentBytes;
+
+    // Sixty frames per second, the uploads of a frame are done before the next
+    auto runFrames = [&](const char * what, int frames, const auto & screenPixels) {
+        const TextureStreamer::Statistics before = streamer.statistics();
+        qint64 maxResident = 0;
+        QElapsedTimer timer;
+        qint64 updateNanoseconds = 0;
+        for (int ff = 0; ff < frames; ++ff)
+        {
+            timer.restart();
+            streamer.beginFrame();
+            for (int ii = 0; ii < textureCount; ++ii)
+                streamer.request(textures[ii].get(), screenPixels(ii, ff));
+            streamer.update();
+            gl.glFinish();
+            updateNanoseconds += timer.nsecsElapsed();
+            maxResident = qMax(maxResident, streamer.statistics().residentBytes);
+            std::this_thread::sleep_for(std::chrono::milliseconds(16));
+        }
+        const TextureStreamer::Statistics after = streamer.statistics();
+        const quint64 loads = after.loads - before.loads;
+        const qint64 latency = after.totalLatencyNanoseconds - before.totalLatencyNanoseconds;
+        qInfo().noquote() << QString("Benchmark : texture stream %1 - resident %2 MB (max %3 MB, budget %4 MB), %5 levels in, %6 out, "
+                                     "%7 loads, latency %8 ms avg %9 ms max, update %10 ms/frame")
+                                 .arg(QLatin1String(what), -10)
+                                 .arg(double(after.residentBytes) / (1024.0 * 1024.0), 0, 'f', 1)
+                                 .arg(double(maxResident) / (1024.0 * 1024.0), 0, 'f', 1)
+                                 .arg(double(budget) / (1024.0 * 1024.0), 0, 'f', 1)
+                                 .arg(after.levelsStreamedIn - before.levelsStreamedIn)
+                                 .arg(after.levelsStreamedOut - before.levelsStreamedOut)
+                                 .arg(loads)
+                                 .arg(loads ? double(latency) / 1e6 / loads : 0.0, 0, 'f', 2)
+                                 .arg(double(after.maxLatencyNanoseconds) / 1e6, 0, 'f', 2)
+                                 .arg(double(updateNanoseconds) / 1e6 / frames, 0, 'f', 3);
+    };
+
+    qInfo().noquote() << QString("Benchmark : texture stream %1 textures, tails %2 MB")
+                             .arg(textureCount).arg(double(tailBytes) / (1024.0 * 1024.0), 0, 'f', 2);
+
+    // All textures come closer from 16 to 2048 pixels on screen
+    const int frames = 180;
+    runFrames("approach", frames, [frames](int, int frame) {
+        return 16.0f * std::pow(128.0f, float(frame) / float(frames - 1));
+    });
+    // Only the first one stays close, the others are kept for a while and then streamed out
+    runFrames("one close", frames, [](int texture, int) {
+        return texture == 0 ? 2048.0f : 16.0f;
+    });
+    // The close texture changes every 30 frames
+    runFrames("switching", frames, [textureCount](int texture, int frame) {
+        return texture == (frame / 30) % textureCount ? 2048.0f : 16.0f;
+    });
+
+    streamer.destroy();
+    for (auto & texture : textures)
+        texture->destroy();
+    return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// GPU memory - stress test with more textures than the budget allows, the
+/// least recently used ones are evicted and loaded again when needed
+///////////////////////////////////////////////////////////////////////////////
+
+int Benchmark::gpuMemoryBudget(int textureCount)
+{
+    OffscreenContext offscreen;
+    if (!offscreen.create())
+        return 1;
+
+    // The textures must be loadable again, so they are files
+    QTemporaryDir directory;
+    if (!directory.isValid())
+    {
+        qWarning() << "Benchmark : no temporary directory";
+        return 1;
+    }
+    QStringList fileNames;
+    for (int ii = 0; ii < textureCount; ++ii)
+    {
+        QImage image(512, 512, QImage::Format_RGBA8888);
+        image.fill(QColor::fromHsv(ii * 360 / textureCount, 200, 200));
+        fileNames.append(directory.filePath(QString("texture%1.png").arg(ii)));
+        if (!image.save(fileNames.back()))
+            return 1;
+    }
+
+    // About a quarter of the textures fit (512x512 RGBA with mip levels is 1.33 MB)
+    const qint64 budget = 16 * 1024 * 1024;
+    GpuMemory memory(budget);
+    TextureCache cache(memory);
+
+    QRandomGenerator random(7);
+    auto runFrames = [&](const char * what, int frames, int windowSize, int randomCount) {
+        const TextureCache::Statistics before = cache.statistics();
+        const GpuMemory::Statistics memoryBefore = memory.statistics();
+        qint64 maxTotal = 0;
+        QElapsedTimer timer;
+        timer.start();
+        for (int ff = 0; ff < frames; ++ff)
+        {
+            memory.beginFrame();
+            // A window moving slowly over the textures (like walking through a level) and a few random ones
+            for (int ii = 0; ii < windowSize; ++ii)
+                cache.texture(fileNames[(ff / 20 + ii) % textureCount]);
+            for (int ii = 0; ii < randomCount; ++ii)
+                cache.texture(fileNames[int(random.bounded(textureCount))]);
+            memory.enforceBudget();
+            maxTotal = qMax(maxTotal, memory.statistics().totalBytes);
+        }
+        const qint64 nsecs = timer.nsecsElapsed();
+        const TextureCache::Statistics after = cache.statistics();
+        const GpuMemory::Statistics memoryAfter = memory.statistics();
+        const quint64 misses = after.misses - before.misses;
+        qInfo().noquote() << QString("Benchmark : gpu memory %1 - %2 hits, %3 misses (%4 ms per load), %5 evicted, "
+                                     "%6 resident, max %7 MB of %8 MB, %9 frames over budget, %10 ms/frame")
+                                 .arg(QLatin1String(what), -12)
+                                 .arg(after.hits - before.hits).arg(misses)
+                                 .arg(misses ? double(after.loadNanoseconds - before.loadNanoseconds) / 1e6 / misses : 0.0, 0, 'f', 2)
+                                 .arg(memoryAfter.evictions - memoryBefore.evictions)
+                                 .arg(after.resident)
+                                 .arg(double(maxTotal) / (1024.0 * 1024.0), 0, 'f', 1)
+                                 .arg(double(budget) / (1024.0 * 1024.0), 0, 'f', 1)
+                                 .arg(memoryAfter.overBudgetFrames - memoryBefore.overBudgetFrames)
+                                 .arg(double(nsecs) / 1e6 / frames, 0, 'f', 3);
+    };
+
+    // Fits: the window and the random ones mostly hit
+    runFrames("window 6", 400, 6, 2);
+    // All at random, most uses are misses
+    runFrames("random 8", 200, 0, 8);
+    // A frame needs more than the budget, its textures are never evicted
+    runFrames("window 16", 100, 16, 0);
+
+    memory.dump();
+    cache.clear();
+    return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Shared resources - open several widgets on the same assets, with and
+/// without the ResourceManager sharing the textures and programs
+///////////////////////////////////////////////////////////////////////////////
+
+int Benchmark::sharedWidgets(int widgetCount)
+{
+    ResourceManager & resources = ResourceManager::instance();
+
+    auto openWidgets = [&](const char * what, bool sharing) {
+        resources.setSharingEnabled(sharing);
+        const ResourceManager::Statistics before = resources.statistics();
+        std::vector<std::unique_ptr<GLWidget>> widgets;
+        std::vector<int> frames(size_t(widgetCount), 0);
+
+        QElapsedTimer timer;
+        timer.start();
+        for (int ii = 0; ii < widgetCount; ++ii)
+        {
+            widgets.push_back(std::make_unique<GLWidget>(nullptr));
+            QObject::connect(widgets.back().get(), &QOpenGLWidget::frameSwapped, [&frames, ii]() { frames[size_t(ii)]++; });
+            widgets.back()->show();
+        }
+
+        // Until every widget has shown its first frame (initializeGL with all the loads)
+        while (std::count(frames.begin(), frames.end(), 0) > 0 && timer.elapsed() < 60000)
+            QCoreApplication::processEvents();
+        const qint64 nsecs = timer.nsecsElapsed();
+        const int ready = widgetCount - int(std::count(frames.begin(), frames.end(), 0));
+        const ResourceManager::Statistics opened = resources.statistics();
+
+        widgets.clear();
+        const ResourceManager::Statistics closed = resources.statistics();
+        qInfo().noquote() << QString("Benchmark : widgets %1 - %2 of %3 ready in %4 ms, %5 texture and %6 program loads, "
+                                     "%7 shared, %8 textures %9 programs (%10 MB), %11 left after closing")
+                                 .arg(QLatin1String(what), -10)
+                                 .arg(ready).arg(widgetCount)
+                                 .arg(double(nsecs) / 1e6, 0, 'f', 1)
+                                 .arg(opened.textureLoads - before.textureLoads)
+                                 .arg(opened.programLoads - before.programLoads)
+                                 .arg(opened.hits - before.hits)
+                                 .arg(opened.textures).arg(opened.programs)
+                                 .arg(double(opened.textureBytes) / (1024.0 * 1024.0), 0, 'f', 1)
+                                 .arg(closed.textures + closed.programs);
+        return ready == widgetCount;
+    };
+
+    // Every widget loads (and compiles) its own copy, then all use the first one's
+    const bool unshared = openWidgets("unshared", false);
+    const bool shared = openWidgets("shared", true);
+    return unshared && shared ? 0 : 1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Mipmaps - glGenerateMipmap against the chain built on the CPU (box and
+/// Kaiser filter, with and without the jobs). Run with
+/// LIBGL_ALWAYS_SOFTWARE=1 (Mesa llvmpipe) to compare with a software driver.
+///////////////////////////////////////////////////////////////////////////////
+
+int Benchmark::mipmapGeneration()
+{
+    OffscreenContext offscreen;
+    if (!offscreen.create())
+        return 1;
+
+    QOpenGLFunctions_3_3_Core gl;
+    gl.initializeOpenGLFunctions();
+    qInfo() << "Benchmark : mipmaps on" << reinterpret_cast<const char *>(gl.glGetString(GL_RENDERER));
+
+    JobSystem jobs;
+    for (int size : { 4096, 8192 })
+    {
+        // Fine detail (a checker pattern with a gradient), where the filters differ
+        QImage image(size, size, QImage::Format_RGBA8888);
+        for (int yy = 0; yy < size; ++yy)
+        {
+            quint8 * texels = image.scanLine(yy);
+            for (int xx = 0; xx < size; ++xx)
+            {
+                const bool odd = ((xx >> 2) ^ (yy >> 2)) & 1;
+                texels[xx * 4 + 0] = odd ? quint8(xx * 255 / size) : 0;
+                texels[xx * 4 + 1] = odd ? quint8(yy * 255 / size) : 0;
+                texels[xx * 4 + 2] = odd ? 255 : 32;
+                texels[xx * 4 + 3] = 255;
+            }
+        }
+
+        auto report = [size](const char * what, qint64 buildNanoseconds, qint64 totalNanoseconds) {
+            qInfo().noquote() << QString("Benchmark : mipmaps %1 %2 - build %3 ms, with upload %4 ms")
+                                     .arg(size).arg(QLatin1String(what), -16)
+                                     .arg(double(buildNanoseconds) / 1e6, 0, 'f', 1)
+                                     .arg(double(totalNanoseconds) / 1e6, 0, 'f', 1);
+        };
+
+        // Driver: upload level 0, then glGenerateMipmap (box filter, not gamma correct)
+        {
+            QElapsedTimer timer;
+            timer.start();
+            Texture2D texture;
+            texture.setSize(size, size);
+            texture.setFormat(QOpenGLTexture::RGBA8_UNorm);
+            texture.setMipLevels(texture.maximumMipLevels());
+            texture.allocateStorage(QOpenGLTexture::RGBA, QOpenGLTexture::UInt8);
+            texture.setData(0, QOpenGLTexture::RGBA, QOpenGLTexture::UInt8, image.constBits());
+            gl.glFinish();
+            const qint64 uploaded = timer.nsecsElapsed();
+            texture.generateMipMaps();
+            gl.glFinish();
+            const qint64 total = timer.nsecsElapsed();
+            report("glGenerateMipmap", total - uploaded, total);
+        }
+
+        // CPU: all levels built, then uploaded one by one
+        auto cpu = [&](const char * what, MipmapBuilder::Filter filter, bool srgb, JobSystem * jobSystem) {
+            MipmapBuilder::Options options;
+            options.filter = filter;
+            options.srgb = srgb;
+            QElapsedTimer timer;
+            timer.start();
+            const std::vector<QImage> levels = MipmapBuilder::build(image, options, jobSystem);
+            const qint64 built = timer.nsecsElapsed();
+            Texture2D texture;
+            texture.loadTextureLevels(levels);
+            gl.glFinish();
+            report(what, built, timer.nsecsElapsed());
+        };
+        cpu("box linear", MipmapBuilder::Filter::Box, false, &jobs);
+        cpu("box sRGB", MipmapBuilder::Filter::Box, true, &jobs);
+        cpu("kaiser sRGB", MipmapBuilder::Filter::Kaiser, true, &jobs);
+        cpu("kaiser sRGB 1T", MipmapBuilder::Filter::Kaiser, true, nullptr);
+    }
+    return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Pixel conversion - the conversion kernels against QImage and the upload
+/// of a decoded image (RGB32) with mirrored() + convert against in place
+///////////////////////////////////////////////////////////////////////////////
+
+int Benchmark::pixelConversion(int size)
+{
+    OffscreenContext offscreen;
+    if (!offscreen.create())
+        return 1;
+
+    QOpenGLFunctions_3_3_Core gl;
+    gl.initializeOpenGLFunctions();
+
+    // What QImage decodes a JPEG into
+    QImage decoded(size, size, QImage::Format_ARGB32);
+    QRandomGenerator random(11);
+    for (int yy = 0; yy < size; ++yy)
+    {
+        quint32 * texels = reinterpret_cast<quint32 *>(decoded.scanLine(yy));
+        for (int xx = 0; xx < size; ++xx)
+            texels[xx] = random.generate();
+    }
+    const double megapixels = double(size) * size / 1e6;
+    const int repeats = 5;
+
+    auto report = [megapixels](const char * what, qint64 nsecs, qint64 bytesCopied) {
+        qInfo().noquote() << QString("Benchmark : pixels %1 - %2 ms/MP, %3 GB/s, %4 MB copied")
+                                 .arg(QLatin1String(what), -26)
+                                 .arg(double(nsecs) / 1e6 / megapixels, 0, 'f', 3)
+                                 .arg(megapixels * 4e6 / double(qMax<qint64>(nsecs, 1)), 0, 'f', 2)
+                                 .arg(double(bytesCopied) / (1024.0 * 1024.0), 0, 'f', 1);
+    };
+    // Best of a few runs, a fresh (unshared) copy of the input each time
+    auto measure = [&](const char * what, const QImage & input, const std::function<qint64(QImage &)> & run) {
+        qint64 best = std::numeric_limits<qint64>::max();
+        qint64 bytes = 0;
+        for (int ii = 0; ii < repeats; ++ii)
+        {
+            QImage image = input.copy();
+            QElapsedTimer timer;
+            timer.start();
+            bytes = run(image);
+            best = qMin(best, timer.nsecsElapsed());
+        }
+        report(what, best, bytes);
+    };
+
+    // Kernels
+    const QImage rgb = decoded.convertToFormat(QImage::Format_RGB888);
+    measure("BGRA->RGBA QImage", decoded, [](QImage & image) {
+        image = image.convertToFormat(QImage::Format_RGBA8888);
+        return image.sizeInBytes();
+    });
+    measure("BGRA->RGBA in place", decoded, [](QImage & image) {
+        PixelConversion::bgraToRgba(image.bits(), image.bits(), image.width() * image.height());
+        return image.sizeInBytes();
+    });
+    measure("RGB->RGBA QImage", rgb, [](QImage & image) {
+        image = image.convertToFormat(QImage::Format_RGBA8888);
+        return image.sizeInBytes();
+    });
+    measure("RGB->RGBA", rgb, [](QImage & image) {
+        qint64 bytes = 0;
+        image = PixelConversion::toRgba8888(std::move(image), &bytes);
+        return bytes;
+    });
+    measure("premultiply QImage", decoded, [](QImage & image) {
+        image.convertTo(QImage::Format_ARGB32_Premultiplied);
+        return image.sizeInBytes();
+    });
+    measure("premultiply in place", decoded, [](QImage & image) {
+        PixelConversion::premultiply(image.bits(), image.width() * image.height());
+        return image.sizeInBytes();
+    });
+    measure("flip mirrored()", decoded, [](QImage & image) {
+        image = image.mirrored();
+        return image.sizeInBytes();
+    });
+    measure("flip in place", decoded, [](QImage & image) {
+        PixelConversion::flipVertical(image);
+        return image.sizeInBytes();
+    });
+
+    // Upload: before (mirrored copy, setData(QImage) converts to RGBA) and now
+    measure("upload mirrored + convert", decoded, [&gl](QImage & image) {
+        const QImage mirrored = image.mirrored();
+        Texture2D texture;
+        texture.setData(mirrored, QOpenGLTexture::DontGenerateMipMaps);
+        gl.glFinish();
+        return 2 * mirrored.sizeInBytes();
+    });
+    measure("upload in place (BGRA)", decoded, [&gl](QImage & image) {
+        PixelConversion::Options options;
+        const PixelConversion::Upload upload = PixelConversion::prepareUpload(std::move(image), options);
+        Texture2D texture;
+        texture.setSize(upload.image.width(), upload.image.height());
+        texture.setFormat(QOpenGLTexture::RGBA8_UNorm);
+        texture.allocateStorage(upload.pixelFormat, upload.pixelType);
+        texture.setData(0, upload.pixelFormat, upload.pixelType, upload.image.constBits());
+        gl.glFinish();
+        return upload.bytesCopied;
+    });
+    return 0;
+}
@@ -10,6 +10,7 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 //-----------------------------------------------------------------------------
 #include "camera.h"
+#include "profiler.h"
 
 #include <QtMath>
 #include <QDebug>
@@ -142,6 +143,7 @@ PlayerCamera::PlayerCamera(QVector3D position, QVector3D target)
 
 void PlayerCamera::updateCameraVectors()
 {
+    PROFILE_SCOPE("PlayerCamera::updateCameraVectors");
 	// Spherical to Cartesian coordinates
     // https://en.wikipedia.org/wiki/Spherical_coordinate_system
     QVector3D look;
@@ -200,6 +202,7 @@ void OrbitCamera::setRadius(float radius)
 
 void OrbitCamera::updateCameraVectors()
 {
+    PROFILE_SCOPE("OrbitCamera::updateCameraVectors");
     // Spherical to Cartesian coordinates from the Euler angles pitch and yaw
     // https://en.wikipedia.org/wiki/Spherical_coordinate_system
     m_Position.setX(m_Radius * cosf(qDegreesToRadians(m_PitchDeg)) * sinf(qDegreesToRadians(m_YawDeg)));
@@ -0,0 +1,121 @@
+#pragma once
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include <QVector3D>
+#include <QQuaternion>
+#include <QMatrix4x4>
+#include <QOpenGLFunctions_3_3_Core>
+
+class Texture2D;
+struct OccluderMesh;
+
+// Components are plain data, the systems in GLWidget work on them.
+// Keep them small, they are stored in contiguous arrays (see EntityRegistry).
+
+///
+/// \brief Position, orientation and size in world space.
+/// The model matrix is T * R * S (scale, then rotate, then translate).
+///
+struct Transform
+{
+    QVector3D position {0.0f, 0.0f, 0.0f};
+    QQuaternion rotation;
+    QVector3D scale {1.0f, 1.0f, 1.0f};
+
+    QMatrix4x4 modelMatrix() const
+    {
+        QMatrix4x4 model;
+        model.translate(position);
+        model.rotate(rotation);
+        model.scale(scale);
+        return model;
+    }
+};
+
+///
+/// \brief Range of the shared index buffer to draw (glDrawElements parameters)
+///
+struct MeshComponent
+{
+    GLsizei indexCount {0};
+    GLuint firstIndex {0};
+    GLint baseVertex {0};
+};
+
+///
+/// \brief Levels of detail of the mesh, index ranges in the shared index buffer
+/// for the same vertices (see MeshSimplifier). Level 0 is the full mesh.
+/// error is the max. distance to the full mesh surface in model units.
+///
+struct MeshLods
+{
+    static constexpr int MAX_LEVELS = 4;
+
+    struct Level
+    {
+        GLsizei indexCount {0};
+        GLuint firstIndex {0};
+        float error {0.0f};
+    };
+    Level levels[MAX_LEVELS];
+    int count {0};
+
+    // Coarsest level whose error is at most maxPixelError on screen.
+    // pixelsPerUnit: pixels of one world unit at distance 1 (viewport height / (2 tan(fov / 2)))
+    int select(float distance, float worldScale, float pixelsPerUnit, float maxPixelError) const
+    {
+        const float pixelsPerModelUnit = worldScale * pixelsPerUnit / qMax(distance, 0.001f);
+        int level = 0;
+        while (level + 1 < count && levels[level + 1].error * pixelsPerModelUnit <= maxPixelError)
+            level++;
+        return level;
+    }
+};
+
+///
+/// \brief The surface look, for now just the texture to bind and the layer
+/// in it (array textures, objects with the same texture can be drawn together).
+/// The texture is owned by the GLWidget, not the component.
+///
+struct Material
+{
+    Texture2D * texture {nullptr};
+    int layer {0};
+};
+
+///
+/// \brief Axis aligned bounding box in model (local) space
+///
+struct Bounds
+{
+    QVector3D min {-1.0f, -1.0f, -1.0f};
+    QVector3D max {1.0f, 1.0f, 1.0f};
+};
+
+///
+/// \brief Large, solid objects that hide others. Their (simple) mesh is
+/// rendered into the software depth buffer of the OcclusionCuller.
+/// The mesh is owned by the GLWidget, not the component.
+///
+struct Occluder
+{
+    const OccluderMesh * mesh {nullptr};
+};
+
+///
+/// \brief Linear movement in world units per second
+///
+struct Velocity
+{
+    QVector3D linear {0.0f, 0.0f, 0.0f};
+};
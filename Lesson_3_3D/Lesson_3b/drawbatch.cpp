@@ -0,0 +1,237 @@
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "drawbatch.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QOpenGLContext>
+
+#include <cstring>
+
+// GL 4.0 / 4.3, not part of the 3.3 function set
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+
+DrawBatch::~DrawBatch()
+{
+    destroy();
+}
+
+const char * DrawBatch::modeName(Mode mode)
+{
+    switch (mode)
+    {
+    case Mode::Auto: return "auto";
+    case Mode::MultiDrawIndirect: return "multi draw indirect";
+    case Mode::DrawLoop: return "draw loop";
+    }
+    return "";
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Create
+///////////////////////////////////////////////////////////////////////////////
+
+bool DrawBatch::create(GLuint drawIdLocation, int maxObjects, Mode mode)
+{
+    destroy();
+    initializeOpenGLFunctions();
+
+    QOpenGLContext * context = QOpenGLContext::currentContext();
+    Q_ASSERT(context);
+
+    // The command's baseInstance needs GL 4.2 / ARB_base_instance as well
+    const bool indirectAvailable = context->format().version() >= qMakePair(4, 3) ||
+                                   (context->hasExtension("GL_ARB_multi_draw_indirect") && context->hasExtension("GL_ARB_base_instance"));
+    if (indirectAvailable)
+        m_multiDrawElementsIndirect = reinterpret_cast<MultiDrawElementsIndirectFunction>(context->getProcAddress("glMultiDrawElementsIndirect"));
+
+    if (mode == Mode::Auto)
+        mode = m_multiDrawElementsIndirect ? Mode::MultiDrawIndirect : Mode::DrawLoop;
+    if (mode == Mode::MultiDrawIndirect && !m_multiDrawElementsIndirect)
+    {
+        qWarning() << "Draw batch : multi draw indirect not available, using the draw loop";
+        mode = Mode::DrawLoop;
+    }
+    m_mode = mode;
+
+    // The texture buffer covers the whole stream buffer (all frames in flight)
+    const int framesInFlight = 3;
+    const GLsizeiptr commandSize = m_mode == Mode::MultiDrawIndirect ? GLsizeiptr(sizeof(Command)) : 0;
+    GLint maxTexels = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+    const qint64 maxObjectsForTexture = qint64(maxTexels) * 16 / ((OBJECT_SIZE + commandSize) * framesInFlight) - 1;
+    if (maxObjects > maxObjectsForTexture)
+    {
+        qWarning() << "Draw batch : max. objects limited to" << maxObjectsForTexture << "by GL_MAX_TEXTURE_BUFFER_SIZE";
+        maxObjects = int(maxObjectsForTexture);
+    }
+    m_maxObjects = maxObjects;
+
+    const GLsizeiptr segmentSize = m_maxObjects * (OBJECT_SIZE + commandSize) + 2 * 256;
+    if (!m_stream.create(segmentSize, framesInFlight))
+        return false;
+
+    // Draw id per instance: 0, 1, 2 ... the command's baseInstance selects the start
+    std::vector<GLuint> drawIds(m_maxObjects);
+    for (int ii = 0; ii < m_maxObjects; ++ii)
+        drawIds[ii] = GLuint(ii);
+    m_drawIdLocation = drawIdLocation;
+    glGenBuffers(1, &m_drawIdBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_drawIdBuffer);
+    glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(drawIds.size() * sizeof(GLuint)), drawIds.data(), GL_STATIC_DRAW);
+    glVertexAttribIPointer(m_drawIdLocation, 1, GL_UNSIGNED_INT, 0, nullptr);
+    glEnableVertexAttribArray(m_drawIdLocation);
+    glVertexAttribDivisor(m_drawIdLocation, 1);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glGenTextures(1, &m_objectTexture);
+    glBindTexture(GL_TEXTURE_BUFFER, m_objectTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_stream.bufferId());
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+    m_commands.reserve(m_maxObjects);
+
+    qInfo() << "Draw batch : created" << modeName(m_mode) << "for" << m_maxObjects << "objects";
+    return true;
+}
+
+void DrawBatch::destroy()
+{
+    if (!m_drawIdBuffer)
+        return;
+
+    glDeleteTextures(1, &m_objectTexture);
+    glDeleteBuffers(1, &m_drawIdBuffer);
+    m_objectTexture = 0;
+    m_drawIdBuffer = 0;
+    m_stream.destroy();
+    m_commands.clear();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Per frame
+///////////////////////////////////////////////////////////////////////////////
+
+void DrawBatch::begin()
+{
+    m_commands.clear();
+    m_objectCount = 0;
+    m_split = true;
+    m_statistics = Statistics();
+
+    // Object data is read in texels, so 16 byte aligned
+    m_stream.beginFrame();
+    m_objectData = m_stream.allocate(m_maxObjects * OBJECT_SIZE, 16);
+    if (m_mode == Mode::MultiDrawIndirect)
+        m_commandData = m_stream.allocate(m_maxObjects * GLsizeiptr(sizeof(Command)), 16);
+}
+
+bool DrawBatch::add(const MeshComponent & mesh, const QMatrix4x4 & model, const QVector4D & parameters)
+{
+    if (m_objectCount >= m_maxObjects || !m_objectData.isValid())
+        return false;
+
+    // Write only, this is mapped GPU memory
+    char * object = static_cast<char *>(m_objectData.data) + m_objectCount * OBJECT_SIZE;
+    const float parameterData[4] = { parameters.x(), parameters.y(), parameters.z(), parameters.w() };
+    memcpy(object, model.constData(), 16 * sizeof(float));
+    memcpy(object + 16 * sizeof(float), parameterData, sizeof(parameterData));
+
+    // Same mesh as the previous object, one more instance
+    if (!m_split)
+    {
+        Command & last = m_commands.back();
+        if (last.count == GLuint(mesh.indexCount) && last.firstIndex == mesh.firstIndex && last.baseVertex == mesh.baseVertex)
+        {
+            last.instanceCount++;
+            m_objectCount++;
+            return true;
+        }
+    }
+
+    m_commands.push_back(Command{ GLuint(mesh.indexCount), 1, mesh.firstIndex, mesh.baseVertex, GLuint(m_objectCount) });
+    m_objectCount++;
+    m_split = false;
+    return true;
+}
+
+void DrawBatch::end()
+{
+    if (m_mode == Mode::MultiDrawIndirect && m_commandData.isValid())
+        memcpy(m_commandData.data, m_commands.data(), m_commands.size() * sizeof(Command));
+    m_stream.flush();
+
+    m_statistics.commands = int(m_commands.size());
+    m_statistics.objects = m_objectCount;
+    for (const Command & command : m_commands)
+        m_statistics.triangles += quint64(command.count / 3) * command.instanceCount;
+}
+
+void DrawBatch::bindObjectData(GLuint textureUnit)
+{
+    glActiveTexture(GL_TEXTURE0 + textureUnit);
+    glBindTexture(GL_TEXTURE_BUFFER, m_objectTexture);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+GLint DrawBatch::objectDataOffset() const
+{
+    return GLint(m_objectData.offset / 16);
+}
+
+void DrawBatch::draw(int firstCommand, int count, GLenum indexType)
+{
+    if (count <= 0 || !m_objectData.isValid())
+        return;
+    Q_ASSERT(firstCommand >= 0 && firstCommand + count <= commandCount());
+
+    QElapsedTimer timer;
+    timer.start();
+
+    if (m_mode == Mode::MultiDrawIndirect && m_commandData.isValid())
+    {
+        // One call, the commands are already in the buffer
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_stream.bufferId());
+        m_multiDrawElementsIndirect(GL_TRIANGLES, indexType,
+                                    (GLvoid*)(m_commandData.offset + GLintptr(firstCommand) * GLintptr(sizeof(Command))),
+                                    count, sizeof(Command));
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        m_statistics.drawCalls++;
+    }
+    else
+    {
+        // No baseInstance in GL 3.3, move the draw id attribute to it instead
+        const GLsizeiptr indexSize = indexType == GL_UNSIGNED_INT ? 4 : (indexType == GL_UNSIGNED_BYTE ? 1 : 2);
+        glBindBuffer(GL_ARRAY_BUFFER, m_drawIdBuffer);
+        for (int ii = firstCommand; ii < firstCommand + count; ++ii)
+        {
+            const Command & command = m_commands[ii];
+            glVertexAttribIPointer(m_drawIdLocation, 1, GL_UNSIGNED_INT, 0, (GLvoid*)(GLintptr(command.baseInstance) * GLintptr(sizeof(GLuint))));
+            glDrawElementsInstancedBaseVertex(GL_TRIANGLES, GLsizei(command.count), indexType,
+                                              (GLvoid*)(GLintptr(command.firstIndex) * indexSize),
+                                              GLsizei(command.instanceCount), command.baseVertex);
+        }
+        glVertexAttribIPointer(m_drawIdLocation, 1, GL_UNSIGNED_INT, 0, nullptr);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        m_statistics.drawCalls += count;
+    }
+
+    m_statistics.submitNanoseconds += timer.nsecsElapsed();
+}
+
+void DrawBatch::finish()
+{
+    m_stream.endFrame();
+}
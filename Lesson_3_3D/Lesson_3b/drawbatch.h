@@ -0,0 +1,126 @@
+#pragma once
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "components.h"
+#include "streambuffer.h"
+
+#include <QOpenGLFunctions_3_3_Core>
+#include <QMatrix4x4>
+#include <QVector4D>
+
+#include <vector>
+
+///
+/// \brief The DrawBatch class submits many draws of the shared vertex and index
+/// buffers with as few OpenGL calls as possible.
+/// Every frame the draw commands and the per object data (model matrix and
+/// material parameters) are streamed. Consecutive objects with the same mesh
+/// become instances of one command. The shader finds its object with the per
+/// instance draw id attribute: instance i of a command reads the object
+/// baseInstance + i from the object data texture buffer (TEXELS_PER_OBJECT
+/// RGBA32F texels per object, starting at objectDataOffset()).
+/// - MultiDrawIndirect : GL 4.3 / ARB_multi_draw_indirect, one glMultiDrawElementsIndirect
+/// - DrawLoop : GL 3.3 fallback, one glDrawElementsInstancedBaseVertex per command
+///
+/// Per frame: begin(), add()..., end(), draw() with the VAO bound, finish() after
+/// the draws. Only call from the OpenGL thread with the context current.
+///
+class DrawBatch : public QOpenGLFunctions_3_3_Core
+{
+public:
+    enum class Mode
+    {
+        Auto,               // best available
+        MultiDrawIndirect,
+        DrawLoop
+    };
+
+    // Object data layout: model matrix (4 columns) and the parameters vec4
+    static constexpr int TEXELS_PER_OBJECT = 5;
+
+    struct Statistics
+    {
+        int commands {0};           // last frame
+        int objects {0};
+        int drawCalls {0};
+        quint64 triangles {0};
+        qint64 submitNanoseconds {0};  // CPU time spent in draw()
+    };
+
+    DrawBatch() = default;
+    ~DrawBatch();
+
+    DrawBatch(const DrawBatch &) = delete;
+    DrawBatch & operator=(const DrawBatch &) = delete;
+
+    // The VAO used for the draws must be bound, the draw id attribute is added to it
+    bool create(GLuint drawIdLocation, int maxObjects = 65536, Mode mode = Mode::Auto);
+    void destroy();
+    bool isCreated() const { return m_drawIdBuffer != 0; }
+
+    void begin();
+    // False if the frame is full (maxObjects)
+    bool add(const MeshComponent & mesh, const QMatrix4x4 & model, const QVector4D & parameters);
+    // The next add() starts a new command, e.g. before the texture changes
+    void split() { m_split = true; }
+    int commandCount() const { return int(m_commands.size()); }
+    void end();
+
+    // Bind the object data texture buffer, the shader reads it from objectDataOffset()
+    void bindObjectData(GLuint textureUnit);
+    GLint objectDataOffset() const;
+
+    // All commands or a range of them (e.g. the commands of one texture)
+    void draw(GLenum indexType = GL_UNSIGNED_SHORT) { draw(0, commandCount(), indexType); }
+    void draw(int firstCommand, int count, GLenum indexType = GL_UNSIGNED_SHORT);
+
+    void finish();
+
+    Mode mode() const { return m_mode; }
+    int maxObjects() const { return m_maxObjects; }
+    // GPU memory of the draw id buffer and the stream buffer
+    qint64 memoryBytes() const { return isCreated() ? qint64(m_maxObjects) * qint64(sizeof(GLuint)) + m_stream.memoryBytes() : 0; }
+    const Statistics & statistics() const { return m_statistics; }
+
+    static const char * modeName(Mode mode);
+
+private:
+    // Same layout as the DrawElementsIndirectCommand of glMultiDrawElementsIndirect
+    struct Command
+    {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint baseVertex;
+        GLuint baseInstance;
+    };
+    static constexpr GLsizeiptr OBJECT_SIZE = TEXELS_PER_OBJECT * 4 * sizeof(float);
+
+    using MultiDrawElementsIndirectFunction = void (QOPENGLF_APIENTRYP)(GLenum mode, GLenum type, const void * indirect, GLsizei drawcount, GLsizei stride);
+
+    Mode m_mode {Mode::Auto};
+    GLuint m_drawIdLocation {0};
+    int m_maxObjects {0};
+    GLuint m_drawIdBuffer {0};
+    GLuint m_objectTexture {0};
+    MultiDrawElementsIndirectFunction m_multiDrawElementsIndirect {nullptr};
+
+    // Commands and object data of the frame
+    StreamBuffer m_stream;
+    StreamBuffer::Allocation m_objectData;
+    StreamBuffer::Allocation m_commandData;
+    std::vector<Command> m_commands;
+    int m_objectCount {0};
+    bool m_split {false};
+    Statistics m_statistics;
+};
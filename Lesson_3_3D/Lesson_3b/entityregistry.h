@@ -0,0 +1,298 @@
+#pragma once
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include <QtGlobal>
+
+#include <atomic>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+///
+/// \brief An entity is only an id. The lower 24 bits are the slot index and the
+/// upper 8 bits a generation counter, so a stale id of a destroyed entity is
+/// never mistaken for a new entity reusing the same slot. The generation
+/// never wraps: a slot is retired after its last generation (see destroy).
+///
+using Entity = quint32;
+
+constexpr Entity INVALID_ENTITY = 0xFFFFFFFFu;
+constexpr quint32 ENTITY_INDEX_BITS = 24;
+constexpr quint32 ENTITY_INDEX_MASK = (1u << ENTITY_INDEX_BITS) - 1u;
+// Generation of a retired slot, no entity has it (also keeps INVALID_ENTITY unused)
+constexpr quint32 ENTITY_RETIRED_GENERATION = 0xFFu;
+
+inline quint32 entityIndex(Entity entity) { return entity & ENTITY_INDEX_MASK; }
+inline quint32 entityGeneration(Entity entity) { return entity >> ENTITY_INDEX_BITS; }
+
+///
+/// \brief Type erased base of the component pools so the registry can remove
+/// all components of a destroyed entity without knowing their types.
+///
+class IComponentPool
+{
+public:
+    virtual ~IComponentPool() = default;
+    virtual bool contains(Entity entity) const = 0;
+    virtual void remove(Entity entity) = 0;
+    virtual size_t size() const = 0;
+};
+
+///
+/// \brief Sparse set storage of one component type.
+/// The components (and their owning entities) are packed without holes in
+/// dense arrays, so iterating a pool is a linear walk through memory.
+/// The sparse array maps the entity slot index to the dense position.
+/// Removal swaps the last element into the hole (order is not preserved).
+///
+template<typename T>
+class ComponentPool : public IComponentPool
+{
+public:
+    static constexpr quint32 INVALID_INDEX = 0xFFFFFFFFu;
+
+    T & add(Entity entity, const T & component)
+    {
+        const quint32 index = entityIndex(entity);
+        if (index >= m_sparse.size())
+            m_sparse.resize(index + 1, INVALID_INDEX);
+
+        if (m_sparse[index] != INVALID_INDEX)
+        {
+            // Replace the existing component
+            T & existing = m_components[m_sparse[index]];
+            existing = component;
+            return existing;
+        }
+
+        m_sparse[index] = quint32(m_components.size());
+        m_entities.push_back(entity);
+        m_components.push_back(component);
+        return m_components.back();
+    }
+
+    void remove(Entity entity) override
+    {
+        if (!contains(entity))
+            return;
+
+        const quint32 index = entityIndex(entity);
+        const quint32 hole = m_sparse[index];
+        const quint32 last = quint32(m_components.size() - 1);
+        if (hole != last)
+        {
+            // Keep the dense arrays packed
+            m_components[hole] = std::move(m_components[last]);
+            m_entities[hole] = m_entities[last];
+            m_sparse[entityIndex(m_entities[hole])] = hole;
+        }
+        m_components.pop_back();
+        m_entities.pop_back();
+        m_sparse[index] = INVALID_INDEX;
+    }
+
+    bool contains(Entity entity) const override
+    {
+        const quint32 index = entityIndex(entity);
+        return index < m_sparse.size()
+               && m_sparse[index] != INVALID_INDEX
+               && m_entities[m_sparse[index]] == entity;
+    }
+
+    size_t size() const override { return m_components.size(); }
+
+    void reserve(size_t count)
+    {
+        m_entities.reserve(count);
+        m_components.reserve(count);
+    }
+
+    // Only valid if contains(entity)
+    T & get(Entity entity) { return m_components[m_sparse[entityIndex(entity)]]; }
+    const T & get(Entity entity) const { return m_components[m_sparse[entityIndex(entity)]]; }
+
+    T * tryGet(Entity entity) { return contains(entity) ? &get(entity) : nullptr; }
+
+    // Dense (contiguous) access
+    T * data() { return m_components.data(); }
+    const T * data() const { return m_components.data(); }
+    const Entity * entities() const { return m_entities.data(); }
+
+private:
+    std::vector<quint32> m_sparse;
+    std::vector<Entity> m_entities;
+    std::vector<T> m_components;
+};
+
+///
+/// \brief The EntityRegistry creates and destroys entities and owns one
+/// ComponentPool per component type. Systems iterate the pools with each().
+///
+class EntityRegistry
+{
+public:
+    EntityRegistry() = default;
+    EntityRegistry(const EntityRegistry &) = delete;
+    EntityRegistry & operator=(const EntityRegistry &) = delete;
+
+    Entity create()
+    {
+        quint32 index;
+        if (!m_freeSlots.empty())
+        {
+            index = m_freeSlots.back();
+            m_freeSlots.pop_back();
+        }
+        else
+        {
+            index = quint32(m_generations.size());
+            Q_ASSERT(index <= ENTITY_INDEX_MASK);
+            m_generations.push_back(0);
+        }
+        m_alive++;
+        return (Entity(m_generations[index]) << ENTITY_INDEX_BITS) | index;
+    }
+
+    void destroy(Entity entity)
+    {
+        if (!isValid(entity))
+            return;
+
+        for (auto & pool : m_pools)
+        {
+            if (pool)
+                pool->remove(entity);
+        }
+
+        // Bump the generation so old ids become invalid. Wrapping around would
+        // make the ids of the first generation valid again, so the slot is
+        // retired instead (one slot per 255 reuses, the index space is large).
+        const quint32 index = entityIndex(entity);
+        m_generations[index] = quint8(m_generations[index] + 1);
+        if (m_generations[index] != ENTITY_RETIRED_GENERATION)
+            m_freeSlots.push_back(index);
+        m_alive--;
+    }
+
+    bool isValid(Entity entity) const
+    {
+        const quint32 index = entityIndex(entity);
+        return entityGeneration(entity) != ENTITY_RETIRED_GENERATION
+               && index < m_generations.size()
+               && m_generations[index] == entityGeneration(entity);
+    }
+
+    // Remove all entities and components
+    void clear()
+    {
+        m_pools.clear();
+        m_generations.clear();
+        m_freeSlots.clear();
+        m_alive = 0;
+    }
+
+    size_t aliveCount() const { return m_alive; }
+
+    template<typename T>
+    T & add(Entity entity, const T & component = T())
+    {
+        Q_ASSERT(isValid(entity));
+        return pool<T>().add(entity, component);
+    }
+
+    template<typename T>
+    void remove(Entity entity) { pool<T>().remove(entity); }
+
+    template<typename T>
+    bool has(Entity entity) const
+    {
+        const ComponentPool<T> * p = findPool<T>();
+        return p && p->contains(entity);
+    }
+
+    template<typename T>
+    T & get(Entity entity)
+    {
+        Q_ASSERT(has<T>(entity));
+        return pool<T>().get(entity);
+    }
+
+    template<typename T>
+    ComponentPool<T> & pool()
+    {
+        const size_t id = componentTypeId<T>();
+        if (id >= m_pools.size())
+            m_pools.resize(id + 1);
+        if (!m_pools[id])
+            m_pools[id] = std::make_unique<ComponentPool<T>>();
+        return static_cast<ComponentPool<T> &>(*m_pools[id]);
+    }
+
+    ///
+    /// \brief Call func(entity, first, others...) for every entity owning all
+    /// requested components. The first component type drives the iteration,
+    /// so put the rarest (or the one you write to most) first.
+    ///
+    template<typename First, typename... Others, typename Func>
+    void each(Func func)
+    {
+        ComponentPool<First> & primary = pool<First>();
+        std::tuple<ComponentPool<Others> &...> others(pool<Others>()...);
+
+        const Entity * entities = primary.entities();
+        First * components = primary.data();
+        const size_t count = primary.size();
+        for (size_t ii = 0; ii < count; ++ii)
+        {
+            const Entity entity = entities[ii];
+            const bool hasAll = std::apply([entity](auto &... pools) {
+                return (pools.contains(entity) && ...);
+            }, others);
+            if (!hasAll)
+                continue;
+            std::apply([&](auto &... pools) {
+                func(entity, components[ii], pools.get(entity)...);
+            }, others);
+        }
+    }
+
+private:
+    template<typename T>
+    const ComponentPool<T> * findPool() const
+    {
+        const size_t id = componentTypeId<T>();
+        if (id >= m_pools.size() || !m_pools[id])
+            return nullptr;
+        return static_cast<const ComponentPool<T> *>(m_pools[id].get());
+    }
+
+    // Each component type gets a small sequential id on first use (registries
+    // of other threads, e.g. a benchmark, may ask at the same time)
+    static size_t nextComponentTypeId()
+    {
+        static std::atomic<size_t> counter {0};
+        return counter.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    template<typename T>
+    static size_t componentTypeId()
+    {
+        static const size_t id = nextComponentTypeId();
+        return id;
+    }
+
+    std::vector<std::unique_ptr<IComponentPool>> m_pools;
+    std::vector<quint8> m_generations;
+    std::vector<quint32> m_freeSlots;
+    size_t m_alive {0};
+};
@@ -0,0 +1,228 @@
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "framearena.h"
+
+#include <QDebug>
+
+#include <new>
+
+namespace
+{
+    constexpr size_t ARENA_ALIGNMENT = 64; // cache line
+
+    // Which arena slot the current thread uses in each allocator
+    // (a few allocators per thread, e.g. several widgets on the GUI thread).
+    // Slot -1 records a thread without an arena, so it is looked up only once.
+    struct ThreadSlot
+    {
+        quint64 owner {0};
+        int slot {-1};
+    };
+    constexpr int MAX_ALLOCATORS_PER_THREAD = 8;
+    thread_local ThreadSlot t_threadSlots[MAX_ALLOCATORS_PER_THREAD];
+    // Entry replaced when the table is full (entries of destroyed allocators
+    // on other threads are never cleared, they just no longer match). The
+    // allocator of a replaced entry still knows the slot of the thread.
+    thread_local int t_nextEviction = 0;
+
+    std::atomic<quint64> s_nextAllocatorId {1};
+
+    char * allocateBlock(size_t size, size_t alignment)
+    {
+        return static_cast<char *>(::operator new(size, std::align_val_t(alignment)));
+    }
+
+    void freeBlock(char * block, size_t alignment)
+    {
+        ::operator delete(block, std::align_val_t(alignment));
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// FrameArena
+///////////////////////////////////////////////////////////////////////////////
+
+FrameArena::FrameArena(size_t capacity)
+    : m_capacity(capacity)
+{
+    m_block = allocateBlock(m_capacity, ARENA_ALIGNMENT);
+    m_overflow.reserve(16);
+}
+
+FrameArena::~FrameArena()
+{
+    reset();
+    freeBlock(m_block, ARENA_ALIGNMENT);
+}
+
+void FrameArena::reset()
+{
+    m_highWater = qMax(m_highWater, used());
+
+    for (const OverflowBlock & block : m_overflow)
+        freeBlock(block.data, block.alignment);
+    m_overflow.clear();
+
+    // Grow once to the high water mark (+25%) so the next frames fit in one block
+    if (m_highWater > m_capacity)
+    {
+        freeBlock(m_block, ARENA_ALIGNMENT);
+        m_capacity = m_highWater + m_highWater / 4;
+        m_block = allocateBlock(m_capacity, ARENA_ALIGNMENT);
+    }
+
+    m_used = 0;
+    m_overflowUsed = 0;
+}
+
+void * FrameArena::do_allocate(size_t bytes, size_t alignment)
+{
+    // Bump the pointer
+    const size_t offset = (m_used + alignment - 1) & ~(alignment - 1);
+    if (alignment <= ARENA_ALIGNMENT && offset + bytes <= m_capacity)
+    {
+        m_used = offset + bytes;
+        return m_block + offset;
+    }
+
+    // Full - this frame takes an extra heap block
+    m_overflowCount++;
+    m_overflowUsed += bytes;
+    OverflowBlock block;
+    block.size = bytes;
+    block.alignment = qMax(alignment, alignof(std::max_align_t));
+    block.data = allocateBlock(block.size, block.alignment);
+    m_overflow.push_back(block);
+    return block.data;
+}
+
+void FrameArena::do_deallocate(void *, size_t, size_t)
+{
+    // Nothing, memory is freed all at once by reset()
+}
+
+bool FrameArena::do_is_equal(const std::pmr::memory_resource & other) const noexcept
+{
+    return this == &other;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// FrameAllocator
+///////////////////////////////////////////////////////////////////////////////
+
+FrameAllocator::FrameAllocator(size_t bytesPerArena, int threadSlots)
+    : m_id(s_nextAllocatorId.fetch_add(1))
+{
+    threadSlots = qMax(1, threadSlots);
+    m_slotThreads.reserve(threadSlots);
+
+    for (auto & arenas : m_arenas)
+    {
+        arenas.reserve(threadSlots);
+        for (int ii = 0; ii < threadSlots; ++ii)
+            arenas.push_back(std::make_unique<FrameArena>(bytesPerArena));
+    }
+}
+
+FrameAllocator::~FrameAllocator()
+{
+    // Free the entry of the destroying (normally the owning) thread
+    for (ThreadSlot & entry : t_threadSlots)
+    {
+        if (entry.owner == m_id)
+            entry = ThreadSlot();
+    }
+}
+
+void FrameAllocator::beginFrame()
+{
+    // The other set was used by the previous frame and must stay valid,
+    // the set we switch to is from two frames ago and can be reused
+    m_current = 1 - m_current;
+    for (auto & arena : m_arenas[m_current])
+        arena->reset();
+    m_frameNumber++;
+}
+
+std::pmr::memory_resource * FrameAllocator::resource()
+{
+    const int slot = threadSlot();
+    if (slot < 0)
+        return std::pmr::new_delete_resource();
+    return m_arenas[m_current][slot].get();
+}
+
+int FrameAllocator::threadSlot()
+{
+    for (const ThreadSlot & entry : t_threadSlots)
+    {
+        if (entry.owner == m_id)
+            return entry.slot;
+    }
+
+    // First use on this thread, or its entry was replaced: the same slot again
+    const std::thread::id thread = std::this_thread::get_id();
+    int slot = -1;
+    {
+        std::lock_guard<std::mutex> lock(m_slotMutex);
+        for (size_t ii = 0; ii < m_slotThreads.size(); ++ii)
+        {
+            if (m_slotThreads[ii] == thread)
+                slot = int(ii);
+        }
+        if (slot < 0 && m_slotThreads.size() < m_arenas[0].size())
+        {
+            slot = int(m_slotThreads.size());
+            m_slotThreads.push_back(thread);
+        }
+        if (slot < 0 && !m_heapWarned)
+        {
+            qWarning() << "Frame allocator : no arena left for a thread, it uses the heap";
+            m_heapWarned = true;
+        }
+    }
+
+    ThreadSlot * free = nullptr;
+    for (ThreadSlot & entry : t_threadSlots)
+    {
+        if (!entry.owner)
+        {
+            free = &entry;
+            break;
+        }
+    }
+    if (!free)
+    {
+        free = &t_threadSlots[t_nextEviction];
+        t_nextEviction = (t_nextEviction + 1) % MAX_ALLOCATORS_PER_THREAD;
+    }
+    free->owner = m_id;
+    free->slot = slot;
+    return slot;
+}
+
+size_t FrameAllocator::usedBytes() const
+{
+    size_t used = 0;
+    for (const auto & arena : m_arenas[m_current])
+        used += arena->used();
+    return used;
+}
+
+quint64 FrameAllocator::overflowCount() const
+{
+    quint64 count = 0;
+    for (const auto & arena : m_arenas[m_current])
+        count += arena->overflowCount();
+    return count;
+}
@@ -0,0 +1,123 @@
+#pragma once
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include <QtGlobal>
+
+#include <atomic>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+///
+/// \brief The FrameArena is a bump (linear) allocator. Allocation just moves a
+/// pointer forward, deallocation does nothing and reset() frees everything at
+/// once. It is a std::pmr::memory_resource, so the std::pmr containers can use it.
+/// When the block is full an extra block is taken from the heap; on the next
+/// reset the arena grows to the high water mark so the steady state needs only
+/// one block and never touches the heap again.
+/// Not thread safe, each thread uses its own arena (see FrameAllocator).
+///
+class FrameArena : public std::pmr::memory_resource
+{
+public:
+    explicit FrameArena(size_t capacity = 1024 * 1024);
+    ~FrameArena() override;
+
+    FrameArena(const FrameArena &) = delete;
+    FrameArena & operator=(const FrameArena &) = delete;
+
+    // Everything allocated before is invalid afterwards
+    void reset();
+
+    size_t capacity() const { return m_capacity; }
+    size_t used() const { return m_used + m_overflowUsed; }
+    size_t highWater() const { return m_highWater; }
+
+    // Heap blocks taken because the arena was too small (since construction)
+    quint64 overflowCount() const { return m_overflowCount; }
+
+protected:
+    void * do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void * p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource & other) const noexcept override;
+
+private:
+    struct OverflowBlock
+    {
+        char * data {nullptr};
+        size_t size {0};
+        size_t alignment {0};
+    };
+
+    char * m_block {nullptr};
+    size_t m_capacity {0};
+    size_t m_used {0};
+    size_t m_overflowUsed {0};
+    size_t m_highWater {0};
+    quint64 m_overflowCount {0};
+    std::vector<OverflowBlock> m_overflow;
+};
+
+///
+/// \brief The FrameAllocator owns one FrameArena per thread and two sets of
+/// them (double buffered). Memory taken in frame N stays valid during frame N+1,
+/// e.g. for data still read by a job or an upload of the previous frame.
+/// beginFrame() flips the sets and resets the one from two frames ago.
+/// Each thread that calls resource() takes one of the threadSlots arenas on
+/// first use and keeps it while the allocator lives (the per thread lookup
+/// table is only a shortcut, a thread whose entry was replaced finds its slot
+/// again). A thread beyond them falls back to the heap, with one warning.
+///
+class FrameAllocator
+{
+public:
+    // One slot per thread that allocates, by default only the owning (OpenGL) thread
+    explicit FrameAllocator(size_t bytesPerArena = 1024 * 1024, int threadSlots = 1);
+    ~FrameAllocator();
+
+    FrameAllocator(const FrameAllocator &) = delete;
+    FrameAllocator & operator=(const FrameAllocator &) = delete;
+
+    // Call once per frame on the owning (OpenGL) thread, before any allocation
+    void beginFrame();
+
+    // The arena of the calling thread for the current frame
+    std::pmr::memory_resource * resource();
+
+    quint64 frameNumber() const { return m_frameNumber; }
+
+    // Sum over the arenas of the current frame
+    size_t usedBytes() const;
+    quint64 overflowCount() const;
+
+private:
+    int threadSlot();
+
+    std::vector<std::unique_ptr<FrameArena>> m_arenas[2];
+    int m_current {0};
+    quint64 m_frameNumber {0};
+    // The thread of each taken slot, only used when the lookup table misses
+    std::mutex m_slotMutex;
+    std::vector<std::thread::id> m_slotThreads;
+    bool m_heapWarned {false};
+    // Unique over the process lifetime, a new allocator at a reused address never matches old slots
+    const quint64 m_id;
+};
+
+// Containers for transient per frame data, e.g. FrameVector<DrawItem> list(allocator.resource())
+template<typename T>
+using FrameVector = std::pmr::vector<T>;
+using FrameString = std::pmr::string;
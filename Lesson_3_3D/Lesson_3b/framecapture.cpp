@@ -0,0 +1,300 @@
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "framecapture.h"
+#include "profiler.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QImage>
+
+#include <chrono>
+#include <cstring>
+
+namespace
+{
+    // Full range BT.601, 8 bit fixed point. The offset keeps the sums positive for the shift.
+    inline uchar lumaOf(int red, int green, int blue)
+    {
+        return uchar((77 * red + 150 * green + 29 * blue + 128) >> 8);
+    }
+    inline uchar chromaOf(int weightRed, int weightGreen, int weightBlue, int red, int green, int blue)
+    {
+        const int value = (weightRed * red + weightGreen * green + weightBlue * blue + 128 * 256 + 128) >> 8;
+        return uchar(qMin(value, 255));
+    }
+}
+
+FrameCapture::~FrameCapture()
+{
+    stop();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Start / Stop
+///////////////////////////////////////////////////////////////////////////////
+
+bool FrameCapture::start(const QString & directory, int width, int height, const Options & options)
+{
+    stop();
+    if (width <= 0 || height <= 0 || !QDir().mkpath(directory))
+    {
+        qWarning() << "Frame capture : start in" << directory << "FAILED";
+        return false;
+    }
+
+    m_options = options;
+    m_options.slotCount = qMax(2, options.slotCount);
+    m_directory = directory;
+    m_width = width;
+    m_height = height;
+
+    // All memory up front, receive() only copies
+    m_slots.clear();
+    m_slots.resize(size_t(m_options.slotCount));
+    for (Slot & slot : m_slots)
+        slot.pixels.resize(size_t(width) * size_t(height) * 4);
+    m_head.store(0);
+    m_tail.store(0);
+    m_quit.store(false);
+
+    m_received = 0;
+    m_dropped = 0;
+    m_droppedSize = 0;
+    m_copyNanoseconds = 0;
+    m_maxQueued = 0;
+    m_written.store(0);
+    m_bytesWritten.store(0);
+    m_writeNanoseconds.store(0);
+
+    if (m_options.format == Format::Y4m)
+    {
+        m_fileName = QDir(directory).filePath("capture.y4m");
+        m_y4mFile = std::make_unique<QFile>(m_fileName);
+        if (!m_y4mFile->open(QIODevice::WriteOnly))
+        {
+            qWarning() << "Frame capture : opening" << m_fileName << "FAILED";
+            m_y4mFile.reset();
+            return false;
+        }
+        const QByteArray header = QString("YUV4MPEG2 W%1 H%2 F%3:1 Ip A1:1 C444 XCOLORRANGE=FULL\n")
+                                      .arg(width).arg(height).arg(m_options.framesPerSecond).toLatin1();
+        m_y4mFile->write(header);
+        m_planes.resize(size_t(width) * size_t(height) * 3);
+    }
+    else
+    {
+        m_fileName = QDir(directory).filePath(m_options.format == Format::Png ? "frame-*.png" : "frame-*.bgra");
+    }
+
+    m_writer = std::thread(&FrameCapture::writerLoop, this);
+    qInfo() << "Frame capture : started" << width << "x" << height << "into" << m_fileName;
+    return true;
+}
+
+void FrameCapture::stop()
+{
+    if (!m_writer.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_quit.store(true);
+    }
+    m_wakeUp.notify_one();
+    m_writer.join();
+
+    if (m_y4mFile)
+        m_y4mFile->close();
+    m_y4mFile.reset();
+    m_slots.clear();
+    m_slots.shrink_to_fit();
+    m_planes.clear();
+    m_planes.shrink_to_fit();
+
+    const Statistics stats = statistics();
+    qInfo() << "Frame capture : stopped," << stats.written << "frames written," << stats.dropped << "dropped (writer behind),"
+            << stats.droppedSize << "dropped (size)," << double(stats.bytesWritten) / (1024.0 * 1024.0) << "MB";
+}
+
+FrameCapture::Statistics FrameCapture::statistics() const
+{
+    Statistics stats;
+    stats.received = m_received;
+    stats.dropped = m_dropped;
+    stats.droppedSize = m_droppedSize;
+    stats.copyNanoseconds = m_copyNanoseconds;
+    stats.maxQueued = m_maxQueued;
+    stats.written = m_written.load(std::memory_order_relaxed);
+    stats.bytesWritten = m_bytesWritten.load(std::memory_order_relaxed);
+    stats.writeNanoseconds = m_writeNanoseconds.load(std::memory_order_relaxed);
+    return stats;
+}
+
+FrameCapture::Format FrameCapture::formatFromName(const QString & name, bool * ok)
+{
+    if (ok)
+        *ok = true;
+    const QString lower = name.toLower();
+    if (lower == "y4m")
+        return Format::Y4m;
+    if (lower == "png")
+        return Format::Png;
+    if (ok && lower != "raw")
+        *ok = false;
+    return Format::Raw;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Render thread
+///////////////////////////////////////////////////////////////////////////////
+
+void FrameCapture::receive(void * user, const FrameReadback::Frame & frame)
+{
+    static_cast<FrameCapture *>(user)->push(frame);
+}
+
+void FrameCapture::push(const FrameReadback::Frame & frame)
+{
+    if (!isRunning())
+        return;
+
+    m_received++;
+    if (frame.width != m_width || frame.height != m_height)
+    {
+        // One size per recording (Y4M has a single header), resize the window before
+        m_droppedSize++;
+        return;
+    }
+
+    const quint64 tail = m_tail.load(std::memory_order_relaxed);
+    const quint64 head = m_head.load(std::memory_order_acquire);
+    const int queued = int(tail - head);
+    if (queued >= m_options.slotCount)
+    {
+        m_dropped++;
+        return;
+    }
+
+    // Flip while copying, the files are top row first
+    QElapsedTimer timer;
+    timer.start();
+    Slot & slot = m_slots[size_t(tail % quint64(m_options.slotCount))];
+    const size_t rowBytes = size_t(m_width) * 4;
+    for (int yy = 0; yy < m_height; ++yy)
+        memcpy(slot.pixels.data() + size_t(m_height - 1 - yy) * rowBytes, frame.data + qsizetype(yy) * frame.bytesPerLine, rowBytes);
+    slot.number = frame.number;
+    m_copyNanoseconds += timer.nsecsElapsed();
+
+    m_tail.store(tail + 1, std::memory_order_release);
+    m_maxQueued = qMax(m_maxQueued, queued + 1);
+    // The writer also wakes up on its own, a missed notify only costs a few ms
+    m_wakeUp.notify_one();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Writer thread
+///////////////////////////////////////////////////////////////////////////////
+
+void FrameCapture::writerLoop()
+{
+    Profiler::setThreadName("Frame capture writer");
+    for (;;)
+    {
+        const quint64 head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire))
+        {
+            // Quit only when everything queued is written
+            if (m_quit.load())
+                break;
+            std::unique_lock<std::mutex> lock(m_sleepMutex);
+            m_wakeUp.wait_for(lock, std::chrono::milliseconds(5), [&] {
+                return m_quit.load() || head != m_tail.load(std::memory_order_acquire);
+            });
+            continue;
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        const Slot & slot = m_slots[size_t(head % quint64(m_options.slotCount))];
+        if (writeFrame(slot))
+            m_written.fetch_add(1, std::memory_order_relaxed);
+        m_writeNanoseconds.fetch_add(timer.nsecsElapsed(), std::memory_order_relaxed);
+
+        // The slot is free again
+        m_head.store(head + 1, std::memory_order_release);
+    }
+}
+
+bool FrameCapture::writeFrame(const Slot & slot)
+{
+    PROFILE_FUNCTION();
+    if (m_options.format == Format::Y4m)
+        return writeY4m(slot);
+
+    const QString number = QString::number(m_written.load(std::memory_order_relaxed) + 1).rightJustified(6, '0');
+    if (m_options.format == Format::Png)
+    {
+        const QString fileName = QDir(m_directory).filePath("frame-" + number + ".png");
+        const QImage image(slot.pixels.data(), m_width, m_height, m_width * 4, QImage::Format_RGB32);
+        // Light zlib compression (quality 90), writing speed over file size
+        if (!image.save(fileName, "PNG", 90))
+        {
+            qWarning() << "Frame capture : writing" << fileName << "FAILED";
+            return false;
+        }
+        m_bytesWritten.fetch_add(quint64(QFile(fileName).size()), std::memory_order_relaxed);
+        return true;
+    }
+
+    const QString fileName = QDir(m_directory).filePath("frame-" + number + ".bgra");
+    QFile file(fileName);
+    const qint64 bytes = qint64(slot.pixels.size());
+    if (!file.open(QIODevice::WriteOnly) || file.write(reinterpret_cast<const char *>(slot.pixels.data()), bytes) != bytes)
+    {
+        qWarning() << "Frame capture : writing" << fileName << "FAILED";
+        return false;
+    }
+    m_bytesWritten.fetch_add(quint64(bytes), std::memory_order_relaxed);
+    return true;
+}
+
+bool FrameCapture::writeY4m(const Slot & slot)
+{
+    // BGRA to the three full size planes Y, Cb, Cr
+    const size_t planeSize = size_t(m_width) * size_t(m_height);
+    uchar * luma = m_planes.data();
+    uchar * blueDifference = luma + planeSize;
+    uchar * redDifference = blueDifference + planeSize;
+    const uchar * bgra = slot.pixels.data();
+    for (size_t ii = 0; ii < planeSize; ++ii, bgra += 4)
+    {
+        const int blue = bgra[0];
+        const int green = bgra[1];
+        const int red = bgra[2];
+        luma[ii] = lumaOf(red, green, blue);
+        blueDifference[ii] = chromaOf(-43, -85, 128, red, green, blue);
+        redDifference[ii] = chromaOf(128, -107, -21, red, green, blue);
+    }
+
+    const qint64 bytes = qint64(m_planes.size());
+    if (m_y4mFile->write("FRAME\n", 6) != 6
+        || m_y4mFile->write(reinterpret_cast<const char *>(m_planes.data()), bytes) != bytes)
+    {
+        qWarning() << "Frame capture : writing frame" << slot.number << "FAILED";
+        return false;
+    }
+    m_bytesWritten.fetch_add(quint64(bytes + 6), std::memory_order_relaxed);
+    return true;
+}
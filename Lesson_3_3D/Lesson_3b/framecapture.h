@@ -0,0 +1,134 @@
+#pragma once
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "framereadback.h"
+
+#include <QString>
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class QFile;
+
+///
+/// \brief The FrameCapture class records the frames delivered by the
+/// FrameReadback to disk without slowing down the rendering.
+/// The readback callback only copies the pixels into a free slot of a fixed
+/// ring (single producer / single consumer, no locks, no allocations), a writer
+/// thread converts and writes them. When the writer falls behind the ring runs
+/// full and frames are dropped (and counted), the render thread never waits.
+///
+/// Formats:
+/// - Raw (default): frame-000001.bgra ... (BGRA, top row first, lossless and fastest)
+/// - Png: frame-000001.png ... (lossless, the slowest to write)
+/// - Y4M: one YUV4MPEG2 file, 4:4:4 full range (plays in ffplay / mpv, or
+///   "ffmpeg -i capture.y4m" to encode it). Lossy: 8 bit YCbCr cannot hold
+///   every RGB colour, a channel may be off by a few levels.
+///
+class FrameCapture
+{
+public:
+    enum class Format
+    {
+        Raw,
+        Png,
+        Y4m
+    };
+
+    struct Options
+    {
+        Format format {Format::Raw};
+        int framesPerSecond {60};   // only written into the Y4M header
+        int slotCount {6};          // frames the writer may fall behind
+    };
+
+    struct Statistics
+    {
+        quint64 received {0};
+        quint64 written {0};
+        quint64 dropped {0};        // the ring was full
+        quint64 droppedSize {0};    // not the size capture started with
+        quint64 bytesWritten {0};
+        qint64 copyNanoseconds {0}; // render thread: readback buffer to slot
+        qint64 writeNanoseconds {0};// writer thread: convert and write
+        int maxQueued {0};
+    };
+
+    FrameCapture() = default;
+    ~FrameCapture();
+
+    FrameCapture(const FrameCapture &) = delete;
+    FrameCapture & operator=(const FrameCapture &) = delete;
+
+    // Allocates the slots and starts the writer. The frames must be width x height.
+    bool start(const QString & directory, int width, int height, const Options & options);
+    // Writes the queued frames and stops the writer
+    void stop();
+    bool isRunning() const { return m_writer.joinable(); }
+    QString fileName() const { return m_fileName; }
+
+    // FrameReadback::Callback, the user is the FrameCapture
+    static void receive(void * user, const FrameReadback::Frame & frame);
+
+    Statistics statistics() const;
+
+    // Raw for an unknown name
+    static Format formatFromName(const QString & name, bool * ok = nullptr);
+
+private:
+    struct Slot
+    {
+        std::vector<uchar> pixels;  // BGRA, top row first
+        quint64 number {0};
+    };
+
+    void push(const FrameReadback::Frame & frame);
+    void writerLoop();
+    bool writeFrame(const Slot & slot);
+    bool writeY4m(const Slot & slot);
+
+    Options m_options;
+    QString m_directory;
+    QString m_fileName;
+    int m_width {0};
+    int m_height {0};
+
+    // Ring: the render thread writes m_tail, the writer m_head
+    std::vector<Slot> m_slots;
+    std::atomic<quint64> m_head {0};
+    std::atomic<quint64> m_tail {0};
+
+    std::thread m_writer;
+    std::atomic<bool> m_quit {false};
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wakeUp;
+
+    // Writer only
+    std::unique_ptr<QFile> m_y4mFile;
+    std::vector<uchar> m_planes;
+
+    // Render thread counters
+    quint64 m_received {0};
+    quint64 m_dropped {0};
+    quint64 m_droppedSize {0};
+    qint64 m_copyNanoseconds {0};
+    int m_maxQueued {0};
+    // Writer counters, read from the render thread
+    std::atomic<quint64> m_written {0};
+    std::atomic<quint64> m_bytesWritten {0};
+    std::atomic<qint64> m_writeNanoseconds {0};
+};
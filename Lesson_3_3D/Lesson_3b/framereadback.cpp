@@ -0,0 +1,211 @@
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "framereadback.h"
+#include "profiler.h"
+
+#include <QDebug>
+
+#include <cstring>
+
+FrameReadback::~FrameReadback()
+{
+    // The buffers belong to the context, destroy() must be called while it is current
+    if (m_bufferCount)
+        qWarning() << "Frame readback : destroyed without destroy(), buffers leaked";
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Create / Destroy
+///////////////////////////////////////////////////////////////////////////////
+
+bool FrameReadback::create(int bufferCount)
+{
+    destroy();
+    if (!initializeOpenGLFunctions())
+    {
+        qWarning() << "Frame readback : OpenGL 3.3 functions FAILED";
+        return false;
+    }
+
+    m_bufferCount = qBound(2, bufferCount, MAX_BUFFERS);
+    for (int ii = 0; ii < m_bufferCount; ++ii)
+        glGenBuffers(1, &m_buffers[ii].buffer);
+    m_next = 0;
+    m_oldest = 0;
+    m_inFlight = 0;
+    m_captures = 0;
+
+    qInfo() << "Frame readback : created" << m_bufferCount << "pixel pack buffers";
+    return true;
+}
+
+void FrameReadback::destroy()
+{
+    if (!m_bufferCount)
+        return;
+
+    for (int ii = 0; ii < m_bufferCount; ++ii)
+    {
+        Buffer & buffer = m_buffers[ii];
+        if (buffer.fence)
+            glDeleteSync(buffer.fence);
+        glDeleteBuffers(1, &buffer.buffer);
+        buffer = Buffer();
+    }
+    m_bufferCount = 0;
+    m_inFlight = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Capture
+///////////////////////////////////////////////////////////////////////////////
+
+bool FrameReadback::capture(GLuint framebuffer, int width, int height, Callback callback, void * user)
+{
+    if (!m_bufferCount || width <= 0 || height <= 0 || !callback)
+        return false;
+
+    m_captures++;
+    Buffer & buffer = m_buffers[m_next];
+    if (buffer.fence)
+    {
+        // Every buffer is still on its way back, waiting here would be the stall we avoid
+        m_statistics.dropped++;
+        return false;
+    }
+
+    const GLsizeiptr size = GLsizeiptr(width) * height * 4;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer.buffer);
+    if (buffer.capacity < size)
+    {
+        glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+        buffer.capacity = size;
+    }
+
+    GLint readFramebuffer = 0;
+    GLint packAlignment = 4;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &readFramebuffer);
+    glGetIntegerv(GL_PACK_ALIGNMENT, &packAlignment);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    if (framebuffer)
+        glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+    // Into the bound buffer: returns once the copy is queued
+    glReadPixels(0, 0, width, height, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, nullptr);
+    buffer.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    glPixelStorei(GL_PACK_ALIGNMENT, packAlignment);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, GLuint(readFramebuffer));
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    buffer.width = width;
+    buffer.height = height;
+    buffer.number = m_captures;
+    buffer.callback = callback;
+    buffer.user = user;
+    buffer.captured.start();
+
+    m_next = (m_next + 1) % m_bufferCount;
+    m_inFlight++;
+    m_statistics.captured++;
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Delivery
+///////////////////////////////////////////////////////////////////////////////
+
+int FrameReadback::poll()
+{
+    PROFILE_FUNCTION();
+    int delivered = 0;
+    // In capture order, a later frame is never ready before an earlier one
+    while (m_inFlight)
+    {
+        Buffer & buffer = m_buffers[m_oldest];
+        const GLenum result = glClientWaitSync(buffer.fence, 0, 0);
+        if (result == GL_TIMEOUT_EXPIRED)
+            break;
+        if (result == GL_WAIT_FAILED)
+            qWarning() << "Frame readback : fence wait FAILED";
+        deliver(buffer);
+        delivered++;
+    }
+    return delivered;
+}
+
+void FrameReadback::finish()
+{
+    const GLuint64 oneMillisecond = 1000000;
+    while (m_inFlight)
+    {
+        Buffer & buffer = m_buffers[m_oldest];
+        GLenum result;
+        do
+        {
+            result = glClientWaitSync(buffer.fence, GL_SYNC_FLUSH_COMMANDS_BIT, oneMillisecond);
+        } while (result == GL_TIMEOUT_EXPIRED);
+        if (result == GL_WAIT_FAILED)
+            qWarning() << "Frame readback : fence wait FAILED";
+        deliver(buffer);
+    }
+}
+
+void FrameReadback::deliver(Buffer & buffer)
+{
+    glDeleteSync(buffer.fence);
+    buffer.fence = nullptr;
+    m_oldest = (m_oldest + 1) % m_bufferCount;
+    m_inFlight--;
+
+    QElapsedTimer timer;
+    timer.start();
+    const GLsizeiptr size = GLsizeiptr(buffer.width) * buffer.height * 4;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer.buffer);
+    const void * data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+    if (!data)
+    {
+        qWarning() << "Frame readback : map of frame" << buffer.number << "FAILED";
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        return;
+    }
+
+    Frame frame;
+    frame.data = static_cast<const uchar *>(data);
+    frame.width = buffer.width;
+    frame.height = buffer.height;
+    frame.bytesPerLine = buffer.width * 4;
+    frame.number = buffer.number;
+    frame.framesLater = int(m_captures - buffer.number);
+    frame.latencyNanoseconds = buffer.captured.nsecsElapsed();
+    buffer.callback(buffer.user, frame);
+
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    m_statistics.delivered++;
+    m_statistics.bytesRead += quint64(size);
+    m_statistics.totalLatencyNanoseconds += frame.latencyNanoseconds;
+    m_statistics.maxLatencyNanoseconds = qMax(m_statistics.maxLatencyNanoseconds, frame.latencyNanoseconds);
+    m_statistics.mapNanoseconds += timer.nsecsElapsed();
+}
+
+QImage FrameReadback::toImage(const Frame & frame)
+{
+    // OpenGL rows start at the bottom, flipped while copying
+    QImage image(frame.width, frame.height, QImage::Format_ARGB32);
+    for (int yy = 0; yy < frame.height; ++yy)
+        memcpy(image.scanLine(frame.height - 1 - yy), frame.data + qsizetype(yy) * frame.bytesPerLine, size_t(frame.width) * 4);
+    return image;
+}
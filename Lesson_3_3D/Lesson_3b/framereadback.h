@@ -0,0 +1,114 @@
+#pragma once
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include <QOpenGLFunctions_3_3_Core>
+#include <QElapsedTimer>
+#include <QImage>
+
+///
+/// \brief The FrameReadback class reads rendered frames back without
+/// stalling the pipeline. glReadPixels into a pixel pack buffer only queues
+/// the copy, a fence tells when the GPU is done. A ring of buffers keeps a few
+/// copies in flight; poll() hands every finished frame to its callback (in
+/// order, a few frames later) and never waits. When all buffers are still in
+/// flight capture() drops the frame instead of blocking.
+///
+/// The pixels are BGRA (GL_UNSIGNED_INT_8_8_8_8_REV, the same as a QImage
+/// Format_ARGB32), bottom row first, which most drivers copy without
+/// conversion.
+/// Only call from the OpenGL thread with the context current.
+///
+class FrameReadback : protected QOpenGLFunctions_3_3_Core
+{
+public:
+    ///
+    /// \brief A frame read back, the data is only valid during the callback
+    ///
+    struct Frame
+    {
+        const uchar * data {nullptr};
+        int width {0};
+        int height {0};
+        int bytesPerLine {0};
+        quint64 number {0};             // capture() call counter
+        int framesLater {0};            // captures since this one
+        qint64 latencyNanoseconds {0};  // capture() until delivered
+    };
+
+    // Called from poll() / finish() on the OpenGL thread. Copy what is needed.
+    using Callback = void (*)(void * user, const Frame & frame);
+
+    struct Statistics
+    {
+        quint64 captured {0};
+        quint64 delivered {0};
+        quint64 dropped {0};            // every buffer was in flight
+        quint64 bytesRead {0};
+        qint64 maxLatencyNanoseconds {0};
+        qint64 totalLatencyNanoseconds {0};
+        qint64 mapNanoseconds {0};      // map, callback and unmap
+    };
+
+    FrameReadback() = default;
+    ~FrameReadback();
+
+    FrameReadback(const FrameReadback &) = delete;
+    FrameReadback & operator=(const FrameReadback &) = delete;
+
+    // More buffers: more frames in flight before one is dropped
+    bool create(int bufferCount = 3);
+    void destroy();
+    bool isCreated() const { return m_bufferCount > 0; }
+
+    // After the frame is rendered: queue the copy of the framebuffer's first
+    // color attachment (0 = default framebuffer). False if the frame was dropped.
+    bool capture(GLuint framebuffer, int width, int height, Callback callback, void * user);
+
+    // Deliver the finished frames, never blocks. Returns the number delivered.
+    int poll();
+    // Deliver all frames in flight (waits for the GPU)
+    void finish();
+    int inFlight() const { return m_inFlight; }
+
+    const Statistics & statistics() const { return m_statistics; }
+    void resetStatistics() { m_statistics = Statistics(); }
+
+    // Top row first QImage (Format_ARGB32) copy of the frame
+    static QImage toImage(const Frame & frame);
+
+private:
+    static constexpr int MAX_BUFFERS = 8;
+
+    struct Buffer
+    {
+        GLuint buffer {0};
+        GLsizeiptr capacity {0};
+        GLsync fence {nullptr};
+        int width {0};
+        int height {0};
+        quint64 number {0};
+        Callback callback {nullptr};
+        void * user {nullptr};
+        QElapsedTimer captured;
+    };
+
+    void deliver(Buffer & buffer);
+
+    Buffer m_buffers[MAX_BUFFERS];
+    int m_bufferCount {0};
+    int m_next {0};             // next buffer to capture into
+    int m_oldest {0};           // next buffer to deliver
+    int m_inFlight {0};
+    quint64 m_captures {0};
+    Statistics m_statistics;
+};
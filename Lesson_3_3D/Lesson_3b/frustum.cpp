@@ -0,0 +1,73 @@
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "frustum.h"
+
+#include <QtMath>
+
+Frustum::Frustum(const QMatrix4x4 & viewProjection)
+{
+    setViewProjection(viewProjection);
+}
+
+void Frustum::setViewProjection(const QMatrix4x4 & viewProjection)
+{
+    // Gribb/Hartmann plane extraction from the rows of the clip matrix
+    const QVector4D row0 = viewProjection.row(0);
+    const QVector4D row1 = viewProjection.row(1);
+    const QVector4D row2 = viewProjection.row(2);
+    const QVector4D row3 = viewProjection.row(3);
+
+    m_planes[0] = row3 + row0; // left
+    m_planes[1] = row3 - row0; // right
+    m_planes[2] = row3 + row1; // bottom
+    m_planes[3] = row3 - row1; // top
+    m_planes[4] = row3 + row2; // near
+    m_planes[5] = row3 - row2; // far
+
+    for (QVector4D & plane : m_planes)
+    {
+        float length = plane.toVector3D().length();
+        if (length > 0.0f)
+            plane /= length;
+    }
+}
+
+bool Frustum::isBoxVisible(const QVector3D & center, const QVector3D & extents) const
+{
+    for (const QVector4D & plane : m_planes)
+    {
+        // Distance of the center and the projected radius of the box onto the plane normal
+        const float distance = plane.x() * center.x() + plane.y() * center.y() + plane.z() * center.z() + plane.w();
+        const float radius = qAbs(plane.x()) * extents.x() + qAbs(plane.y()) * extents.y() + qAbs(plane.z()) * extents.z();
+        if (distance + radius < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+void Frustum::transformBox(const QMatrix4x4 & model, const QVector3D & localMin, const QVector3D & localMax,
+                           QVector3D & center, QVector3D & extents)
+{
+    const QVector3D localCenter = (localMin + localMax) * 0.5f;
+    const QVector3D localExtents = (localMax - localMin) * 0.5f;
+
+    center = model.map(localCenter);
+
+    // Extents of the rotated/scaled box (Arvo's method)
+    for (int row = 0; row < 3; ++row)
+    {
+        extents[row] = qAbs(model(row, 0)) * localExtents.x()
+                       + qAbs(model(row, 1)) * localExtents.y()
+                       + qAbs(model(row, 2)) * localExtents.z();
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include <QVector3D>
+#include <QVector4D>
+#include <QMatrix4x4>
+
+///
+/// \brief The Frustum class holds the 6 clip planes of a view projection matrix
+/// and tests bounding boxes against them (used to skip objects outside of the view).
+///
+class Frustum
+{
+public:
+    Frustum() = default;
+    explicit Frustum(const QMatrix4x4 & viewProjection);
+
+    void setViewProjection(const QMatrix4x4 & viewProjection);
+
+    // World space axis aligned box, true if (partially) inside
+    bool isBoxVisible(const QVector3D & center, const QVector3D & extents) const;
+
+    // Transform a local space box by the model matrix into a world space box (center/extents)
+    static void transformBox(const QMatrix4x4 & model, const QVector3D & localMin, const QVector3D & localMax,
+                             QVector3D & center, QVector3D & extents);
+
+private:
+    // Plane equation a*x + b*y + c*z + d = 0, normal points inside
+    QVector4D m_planes[6];
+};
@@ -13,19 +13,59 @@
 #include "mainwindow.h"
 #include "glwidget.h"
 #include "texture2D.h"
+#include "components.h"
+#include "frustum.h"
+#include "heapallocationcounter.h"
+#include "profiler.h"
+#include "benchmarkresults.h"
 
 #include <QApplication>
 #include <QDebug>
 #include <QKeyEvent>
 #include <QTimer>
+#include <QDateTime>
+#include <QDir>
+#include <QStandardPaths>
 #include <QElapsedTimer>
 #include <QTime>
 #include <QMatrix4x4>
 #include <QVector3D>
+#include <QtMath>
 #include <Qt3DExtras/QCuboidMesh>
 #include <Qt3DRender/QMesh>
 #include <Qt3DCore/QEntity>
 #include <Qt3DExtras/QCuboidGeometry>
+#include <Qt3DExtras/QSphereGeometry>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+QString GLWidget::s_shaderDirectory;
+qint64 GLWidget::s_textureBudget = 32 * 1024 * 1024;
+FrameCapture::Format GLWidget::s_captureFormat = FrameCapture::Format::Raw;
+GLWidget::ReplayOptions GLWidget::s_replay;
+
+void GLWidget::setShaderDirectory(const QString & directory)
+{
+    s_shaderDirectory = directory;
+}
+
+void GLWidget::setTextureBudget(qint64 bytes)
+{
+    s_textureBudget = bytes;
+}
+
+void GLWidget::setCaptureFormat(FrameCapture::Format format)
+{
+    s_captureFormat = format;
+}
+
+void GLWidget::setReplay(const ReplayOptions & options)
+{
+    s_replay = options;
+}
 
 GLWidget::GLWidget(QWidget *parent)
     : QOpenGLWidget(parent)
@@ -61,6 +101,9 @@ void GLWidget::timerEvent(QTimerEvent *event)
 
 void GLWidget::initializeGL()
 {
+    PROFILE_FUNCTION();
+    QElapsedTimer initializeTimer;
+    initializeTimer.start();
     // Basic initialization
 
     qInfo() << "Initialize : OpenGL wrapper (Qt)";
@@ -68,6 +111,13 @@ void GLWidget::initializeGL()
     initializeStatistics();
     connect(context(), &QOpenGLContext::aboutToBeDestroyed, this, &GLWidget::cleanup, Qt::DirectConnection);
 
+    // Accounted together with the other widgets of the share group
+    m_gpuMemory = ResourceManager::instance().gpuMemory();
+    if (!m_gpuMemory) {
+        qWarning() << "Initialize : GPU memory failed!";
+        return;
+    }
+
     qInfo() << "Initialize : Vertex Buffer Object (vbo)";
     // Set up an array of vertices for a quad (2 triangls)
     // with an index buffer data
@@ -120,10 +170,6 @@ void GLWidget::initializeGL()
         qInfo() << "index: " << tt++ << ", value :" << indexPointer[ii];
     }
 
-    // Cube and floor positions
-    m_cubePos = QVector3D(0.0f, 0.0f, 0.0f);
-    m_floorPos = QVector3D(0.0f, -1.0f, 0.0f);
-
     // Set up vertex buffer(s) on the GPU
     // GL_ARRAY_BUFFER (Vertex attributes)
     // https://registry.khronos.org/OpenGL-Refpages/es3/html/glBindBuffer.xhtml
@@ -143,14 +189,67 @@ void GLWidget::initializeGL()
     //
     // https://registry.khronos.org/OpenGL-Refpages/es3/html/glBufferData.xhtml
 
+    // A sphere with enough triangles for levels of detail, same vertex layout
+    // as the cube (position, texCoord, normal, tangent) so both share the buffers
+    qInfo() << "Initialize : Sphere mesh and its levels of detail";
+    Qt3DExtras::QSphereGeometry sphereGeometry;
+    sphereGeometry.setRings(48);
+    sphereGeometry.setSlices(48);
+    sphereGeometry.setRadius(1.0f);
+    sphereGeometry.setGenerateTangents(true);
+    Q_ASSERT(sphereGeometry.positionAttribute()->byteStride() == uint(byteStride));
+    const QByteArray sphereVertices = sphereGeometry.positionAttribute()->buffer()->data();
+    const QByteArray sphereIndexData = sphereGeometry.indexAttribute()->buffer()->data();
+    const quint16 * sphereIndexPointer = reinterpret_cast<const quint16 *>(sphereIndexData.constData());
+    const std::vector<quint16> sphereIndices(sphereIndexPointer, sphereIndexPointer + sphereIndexData.size() / 2);
+
+    MeshSimplifier::Options simplifierOptions;
+    simplifierOptions.texCoordOffset = int(sphereGeometry.texCoordAttribute()->byteOffset() / 4);
+    MeshSimplifier simplifier(reinterpret_cast<const float *>(sphereVertices.constData()),
+                              int(sphereVertices.size() / byteStride), floatStride, simplifierOptions);
+    const std::vector<MeshSimplifier::Level> sphereLevels = simplifier.buildLodChain(sphereIndices, MeshLods::MAX_LEVELS);
+
+    // Vertices: cube, sphere. Indices: cube, sphere LOD 0, LOD 1 ...
+    QByteArray vertexData = cubeGeometry->positionAttribute()->buffer()->data();
+    const QByteArray cubeIndexData = cubeGeometry->indexAttribute()->buffer()->data();
+    const quint16 * cubeIndexPointer = reinterpret_cast<const quint16 *>(cubeIndexData.constData());
+    std::vector<quint16> indexData(cubeIndexPointer, cubeIndexPointer + intCount);
+
+    // CPU copy of the cube for the occlusion culler (positions are read with the vertex stride)
+    m_occluderVertices = vertexData;
+    m_occluderIndices = indexData;
+    m_cubeOccluder.vertices = reinterpret_cast<const float *>(m_occluderVertices.constData());
+    m_cubeOccluder.vertexCount = int(m_occluderVertices.size() / byteStride);
+    m_cubeOccluder.floatStride = floatStride;
+    m_cubeOccluder.indices = m_occluderIndices.data();
+    m_cubeOccluder.indexCount = int(m_occluderIndices.size());
+
+    m_sphereLods = MeshLods();
+    for (const MeshSimplifier::Level & level : sphereLevels)
+    {
+        MeshLods::Level & lod = m_sphereLods.levels[m_sphereLods.count++];
+        lod.indexCount = GLsizei(level.indices.size());
+        lod.firstIndex = GLuint(indexData.size());
+        lod.error = level.error;
+        indexData.insert(indexData.end(), level.indices.begin(), level.indices.end());
+    }
+    m_sphereMesh.indexCount = m_sphereLods.levels[0].indexCount;
+    m_sphereMesh.firstIndex = m_sphereLods.levels[0].firstIndex;
+    m_sphereMesh.baseVertex = GLint(vertexData.size() / byteStride);
+    vertexData.append(sphereVertices);
+
+    // The vao records the buffer and attribute layout set up below
+    m_vao.create();
+    m_vao.bind();
+
     if (!m_vbo.create()) {
         qWarning() << "Initialize : vbo failed!";
         return;
     }
     m_vbo.bind();
     m_vbo.setUsagePattern(QOpenGLBuffer::StaticDraw);
-    m_vbo.allocate(cubeGeometry->positionAttribute()->buffer()->data().constData(),
-                   cubeGeometry->positionAttribute()->buffer()->data().size());
+    m_vbo.allocate(vertexData.constData(), int(vertexData.size()));
+    m_gpuMemoryHandles.push_back(m_gpuMemory->add(GpuMemory::Category::VertexBuffer, "scene vertices", vertexData.size()));
 
     qInfo() << "Initialize : Vertex Array Object (vao)";
 
@@ -169,6 +268,10 @@ void GLWidget::initializeGL()
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, byteStride, (GLvoid*)(byteOffset) );
     glEnableVertexAttribArray(1);
 
+    // Per instance draw id (attribute 2) to find the object data
+    m_drawBatch.create(DRAW_ID_LOCATION);
+    m_gpuMemoryHandles.push_back(m_gpuMemory->add(GpuMemory::Category::StreamBuffer, "draw batch", m_drawBatch.memoryBytes()));
+
     // Set up index buffer which is used to indexed based vertex lookup
     // which reduces the number of vertices. Instead of 6, now we only need 4 vertices.
     qInfo() << "Initialize : Vertex Index Object (vao)";
@@ -179,19 +282,67 @@ void GLWidget::initializeGL()
     }
     m_ibo.bind();
     m_ibo.setUsagePattern(QOpenGLBuffer::StaticDraw);
-    m_ibo.allocate(cubeGeometry->indexAttribute()->buffer()->data().constData(), cubeGeometry->indexAttribute()->buffer()->data().size());
+    m_ibo.allocate(indexData.data(), int(indexData.size() * sizeof(quint16)));
+    m_gpuMemoryHandles.push_back(m_gpuMemory->add(GpuMemory::Category::IndexBuffer, "scene indices",
+                                                  qint64(indexData.size() * sizeof(quint16))));
 
     // "unbind" is good to make sure other code doesn't change it elsewhere
     glBindVertexArray(0);
 
     delete cubeVertices;
 
+    // Decode the small mip levels on the worker threads while the shaders compile,
+    // the upload itself has to happen here on the OpenGL thread
+    qInfo() << "Initialize : Texture streaming";
+    ResourceManager & resources = ResourceManager::instance();
+    ResourceManager::TextureDescription textureArray;
+    textureArray.fileNames = QStringList{ ":/Images/funpic.jpg", ":/Images/grid.jpg" };
+    textureArray.target = QOpenGLTexture::Target2DArray;
+    textureArray.streamed = true;
+    m_textureArrayHandle = resources.acquireTexture(textureArray);
+    m_textureArray = resources.texture(m_textureArrayHandle);
+    m_textureStreamer = resources.textureStreamer();
+    if (!m_textureArray || !m_textureStreamer) {
+        qWarning() << "Initialize : texture array failed!";
+        return;
+    }
+    // The budget of the share group is the largest its widgets ask for
+    resources.addStreamingClient(this, s_textureBudget);
+
+    // Only started here, the driver compiles while the rest is set up
     qInfo() << "Initialize : Shaders ";
-    m_shaderProgram.loadShaders(":/Shaders/basictexture3D.vert",
-                                ":/Shaders/basictexture3D.frag");
+    const QString shaderDirectory = s_shaderDirectory.isEmpty() ? QString(":/Shaders") : s_shaderDirectory;
+    m_shaders.setSources(shaderDirectory + "/uber.vert", shaderDirectory + "/uber.frag");
+    m_shaders.preload({ SCENE_FEATURES, WIREFRAME_FEATURES });
+    if (!s_shaderDirectory.isEmpty() && m_shaderHotReload.create(context()))
+        m_shaderHotReload.watch(&m_shaders, shaderDirectory + "/uber.vert", shaderDirectory + "/uber.frag");
+
+    // The matrices are streamed, no static uniform data anymore
+    qInfo() << "Initialize : Stream buffer";
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &m_uniformAlignment);
+    m_streamBuffer.create(64 * 1024);
+    m_gpuMemoryHandles.push_back(m_gpuMemory->add(GpuMemory::Category::StreamBuffer, "frame uniforms", m_streamBuffer.memoryBytes()));
+
+    qInfo() << "Initialize : Occlusion queries";
+    m_occlusionQueries.create();
+
+    qInfo() << "Initialize : Frame readback";
+    m_readback.create();
+    m_gpuProfiler.create();
 
-    m_texture.loadTexture(":/Images/funpic.jpg", true);
-    m_textureFloor.loadTexture(":/Images/grid.jpg", true);
+    qInfo() << "Initialize : Statistics overlay";
+    m_statsOverlay.create();
+
+    m_textureStreamer->waitForLoads();
+
+    // First use of the programs, waits for the compile if it is not done yet
+    initializeProgram(SCENE_FEATURES);
+    initializeProgram(WIREFRAME_FEATURES);
+    qInfo() << "Initialize : Shader permutations" << m_shaders.statistics().permutations
+            << "compiled in" << double(m_shaders.statistics().compileNanoseconds) / 1e6 << "ms";
+
+    // Everything to draw is an entity now
+    initializeScene(GLsizei(intCount));
 
     // QMesh helper can be used to load and parse our 3D object file
     //Qt3DRender::QMesh *mesh = new Qt3DRender::QMesh();
@@ -203,10 +354,24 @@ void GLWidget::initializeGL()
     //Qt3DCore::QEntity *object = new Qt3DCore::QEntity( /* rootEntity */ );
     //object->addComponent(mesh);
 
+    m_gpuMemory->dump();
+    m_initialized = true;
+
     qInfo() << "Initialize : DONE ... start the update timer";
     m_programStart = QTime::currentTime();
-    m_timerId = startTimer(10);
-    m_timerStarted = true;
+    m_initializeNanoseconds = initializeTimer.nsecsElapsed();
+    if (!s_replay.fileName.isEmpty() && !startReplay(s_replay.fileName))
+    {
+        if (!s_replay.headless)
+            QTimer::singleShot(0, qApp, [] { qApp->exit(1); });
+        return;
+    }
+    // Headless replays are driven by runHeadlessReplay
+    if (!s_replay.headless)
+    {
+        m_timerId = startTimer(m_replaying && s_replay.unlimitedSpeed ? 0 : 10);
+        m_timerStarted = true;
+    }
 }
 
 void GLWidget::cleanup()
@@ -214,19 +379,62 @@ void GLWidget::cleanup()
     qInfo() << "Shutdown : cleanup";
 
     makeCurrent();
-    m_shaderProgram.unloadShaders();
-    m_texture.destroy();
-    m_textureFloor.destroy();
+    m_initialized = false;
+    m_shaderHotReload.destroy();
+    m_shaders.clear();
+    // The last widget using them frees the shared resources
+    ResourceManager::instance().removeStreamingClient(this);
+    ResourceManager::instance().release(m_textureArrayHandle);
+    m_textureArray = nullptr;
+    m_textureStreamer = nullptr;
     m_vbo.destroy();
     m_ibo.destroy();
+    m_vao.destroy();
+    m_streamBuffer.destroy();
+    m_drawBatch.destroy();
+    m_occlusionQueries.destroy();
+    // Deliver what is still on its way, then let the jobs write the files
+    m_readback.finish();
+    m_readback.destroy();
+    m_capture.stop();
+    m_jobs.wait(m_screenshotsSaved);
+    m_gpuProfiler.destroy();
+    m_statsOverlay.destroy();
+    // The shared textures stay accounted until their last release
+    if (m_gpuMemory)
+    {
+        for (GpuMemory::Handle handle : m_gpuMemoryHandles)
+            m_gpuMemory->remove(handle);
+    }
+    m_gpuMemoryHandles.clear();
+    m_gpuMemory = nullptr;
+    if (m_headlessFence)
+        glDeleteSync(m_headlessFence);
+    m_headlessFence = nullptr;
     doneCurrent();
+    if (m_recording)
+        stopRecording();
 
     // Disconnect to the current context
     QObject::disconnect(context(), &QOpenGLContext::aboutToBeDestroyed, this, &GLWidget::cleanup);
 }
 void GLWidget::paintGL()
 {
+    PROFILE_FUNCTION();
+    // A failed initializeGL() left resources (GPU memory, streamer) unset
+    if (!m_initialized)
+        return;
+
+    // The keys of the replay as if pressed before this frame (they log)
+    if (m_replaying)
+        applyReplayEvents();
+
     // NOTE: no logging here, this function is called very often
+    // and no heap allocations, use the frame allocator for temporary data
+    HeapAllocationCounter::begin();
+    m_paintTimer.start();
+    m_frameAllocator.beginFrame();
+    m_statsOverlay.beginFrame();
 
     // Clear the viewport
     glClearColor(m_background.redF(), m_background.greenF(), m_background.blueF(), 1.0f);
@@ -234,23 +442,231 @@ void GLWidget::paintGL()
     glEnable(GL_DEPTH_TEST);
 
     // Just to demonstrate the rendering over time, add some movement
-    // Time since app was started
+    // Time since app was started, a replay steps the same time every frame
     QTime programRun = QTime::currentTime();
     float timeSecs = float(m_programStart.msecsTo(programRun)) / 1000.0;
+    if (m_replaying)
+        timeSecs = float(m_inputFrame) * REPLAY_STEP_SECS;
+    float deltaSecs = timeSecs - m_lastFrameSecs;
+    m_lastFrameSecs = timeSecs;
+
+    // Programs recompiled in the background since the last frame
+    for (quint32 features : m_shaderHotReload.applyPending())
+        initializeProgram(features);
+
+    updateScene(timeSecs, deltaSecs);
+    renderScene();
+
+    // The whole share group, its budget is kept with the streaming rounds
+    m_gpuMemoryStatistics = m_gpuMemory->statistics();
 
-    // Set up the MVP matrices
-    QMatrix4x4 model;
+    // The frame without the overlay, which is drawn on top (and recorded too)
+    StatsOverlay::Counters counters;
+    counters.drawCalls = m_drawCalls;
+    counters.triangles = m_triangles;
+    counters.stateChanges = m_stateChanges;
+    counters.gpuMemoryBytes = m_gpuMemoryStatistics.totalBytes;
+    counters.gpuBudgetBytes = m_gpuMemoryStatistics.budgetBytes;
+    counters.textureBytes = m_textureStatistics.residentBytes;
+    counters.textureBudgetBytes = m_textureStatistics.budgetBytes;
+    m_statsOverlay.endFrame(m_paintTimer.nsecsElapsed(), counters);
+    {
+        const qreal ratio = devicePixelRatioF();
+        m_statsOverlay.draw(qRound(width() * ratio), qRound(height() * ratio));
+    }
+
+    // Only queues the copy, the pixels arrive a few frames later
+    if (m_readbackFrames != 0)
+    {
+        PROFILE_GPU_SCOPE(m_gpuProfiler, "readback");
+        const qreal ratio = devicePixelRatioF();
+        if (m_readback.capture(defaultFramebufferObject(), qRound(width() * ratio), qRound(height() * ratio),
+                               m_readbackCallback, m_readbackUser) && m_readbackFrames > 0)
+            m_readbackFrames--;
+    }
+
+    // GPU zones of the previous frames
+    m_gpuProfiler.collect();
+
+    if (m_replaying)
+        m_replayFrameNanoseconds[size_t(m_inputFrame)] = m_paintTimer.nsecsElapsed();
+
+    checkFrameAllocations(HeapAllocationCounter::end());
+
+    // Outside of the counted part: the callbacks may allocate (images, files)
+    m_readback.poll();
+
+    m_inputFrame++;
+    if (m_replaying && m_inputFrame >= m_inputRecording.frameCount())
+        finishReplay();
+}
+
+void GLWidget::startReadback(FrameReadback::Callback callback, void * user, int frames)
+{
+    m_readbackCallback = callback;
+    m_readbackUser = user;
+    m_readbackFrames = callback ? frames : 0;
+}
+
+void GLWidget::stopReadback()
+{
+    // The frames in flight are still delivered
+    m_readbackFrames = 0;
+}
+
+void GLWidget::saveScreenshot(const QString & fileName)
+{
+    if (isCapturing())
+    {
+        qWarning() << "Screenshot : not while capturing, the recording has every frame";
+        return;
+    }
+    m_screenshotFile = fileName;
+    startReadback(&GLWidget::saveScreenshotFrame, this, 1);
+}
+
+void GLWidget::saveScreenshotFrame(void * user, const FrameReadback::Frame & frame)
+{
+    GLWidget * widget = static_cast<GLWidget *>(user);
+    // Copy out of the mapped buffer now, encode and write on a worker
+    const QImage image = FrameReadback::toImage(frame);
+    const QString fileName = widget->m_screenshotFile;
+    const int framesLater = frame.framesLater;
+    widget->m_jobs.run([image, fileName, framesLater]() {
+        if (image.save(fileName))
+            qInfo() << "Screenshot :" << fileName << "(" << framesLater << "frames later )";
+        else
+            qWarning() << "Screenshot : saving" << fileName << "FAILED";
+    }, &widget->m_screenshotsSaved);
+}
+
+bool GLWidget::startCapture(const QString & directory, FrameCapture::Format format)
+{
+    // The recording has one size, frames of another size are dropped
+    const qreal ratio = devicePixelRatioF();
+    FrameCapture::Options options;
+    options.format = format;
+    if (!m_capture.start(directory, qRound(width() * ratio), qRound(height() * ratio), options))
+        return false;
+    m_readback.resetStatistics();
+    startReadback(&FrameCapture::receive, &m_capture, -1);
+    return true;
+}
+
+void GLWidget::stopCapture()
+{
+    if (!isCapturing())
+        return;
+
+    // The frames in flight still belong to the recording
+    stopReadback();
+    makeCurrent();
+    m_readback.finish();
+    doneCurrent();
+    m_capture.stop();
+    qInfo() << "Frame capture :" << m_readback.statistics().dropped << "frames dropped by the readback (GPU behind)";
+}
+
+void GLWidget::checkFrameAllocations(quint64 allocations)
+{
+    // The first frames fill the caches (uniform locations, component pools, arenas)
+    const quint64 warmUpFrames = 100;
+    if (!HeapAllocationCounter::isEnabled() || allocations == 0 || m_frameAllocator.frameNumber() <= warmUpFrames)
+        return;
+
+    // Only built with LEARNOPENGL_COUNT_ALLOCATIONS, a steady state frame must not allocate
+    qFatal("GLWidget : steady state frame %llu made %llu heap allocations in paintGL (%s)",
+           static_cast<unsigned long long>(m_frameAllocator.frameNumber()),
+           static_cast<unsigned long long>(allocations),
+           HeapAllocationCounter::countsMalloc() ? "malloc and operator new" : "operator new only");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Scene
+///////////////////////////////////////////////////////////////////////////////
+
+void GLWidget::initializeProgram(quint32 features)
+{
+    PROFILE_FUNCTION();
+    ShaderProgram * program = m_shaders.program(features);
+    if (!program)
+        return;
+    program->use();
+    program->setUniformBlockBinding("FrameBlock", FRAME_BLOCK_BINDING);
+    if (features & ShaderPermutations::Textured)
+        program->setUniform("texSampler", 0);
+    if (features & ShaderPermutations::Instanced)
+        program->setUniform("objectData", GLint(OBJECT_DATA_UNIT));
+}
+
+void GLWidget::initializeScene(GLsizei cubeIndexCount)
+{
+    PROFILE_FUNCTION();
+    qInfo() << "Initialize : Scene entities";
+    m_registry.clear();
+
+    // Both objects use the same cube mesh (index range in the ibo)
+    MeshComponent cubeMesh;
+    cubeMesh.indexCount = cubeIndexCount;
+    Bounds cubeBounds;
+
+    // The cube in the center
+    m_cube = m_registry.create();
+    m_registry.add<Transform>(m_cube);
+    m_registry.add<MeshComponent>(m_cube, cubeMesh);
+    m_registry.add<Material>(m_cube, Material{m_textureArray, CUBE_LAYER});
+    m_registry.add<Bounds>(m_cube, cubeBounds);
+    m_registry.add<Velocity>(m_cube);
+    m_registry.add<Occluder>(m_cube, Occluder{&m_cubeOccluder});
+
+    // Position below the cube and squash it flat
+    Transform floorTransform;
+    floorTransform.position = QVector3D(0.0f, -1.0f, 0.0f);
+    floorTransform.scale = QVector3D(10.0f, 0.01f, 10.0f);
+    m_floor = m_registry.create();
+    m_registry.add<Transform>(m_floor, floorTransform);
+    m_registry.add<MeshComponent>(m_floor, cubeMesh);
+    m_registry.add<Material>(m_floor, Material{m_textureArray, FLOOR_LAYER});
+    m_registry.add<Bounds>(m_floor, cubeBounds);
+    m_registry.add<Occluder>(m_floor, Occluder{&m_cubeOccluder});
+
+    // A ring of spheres on the floor, detailed enough to need levels of detail
+    for (int ii = 0; ii < SPHERE_COUNT; ++ii)
+    {
+        const float angle = 2.0f * float(M_PI) * float(ii) / float(SPHERE_COUNT);
+        Transform sphereTransform;
+        sphereTransform.position = QVector3D(5.0f * cosf(angle), -0.5f, 5.0f * sinf(angle));
+        sphereTransform.scale = QVector3D(0.5f, 0.5f, 0.5f);
+        const Entity sphere = m_registry.create();
+        m_registry.add<Transform>(sphere, sphereTransform);
+        m_registry.add<MeshComponent>(sphere, m_sphereMesh);
+        m_registry.add<MeshLods>(sphere, m_sphereLods);
+        m_registry.add<Material>(sphere, Material{m_textureArray, FLOOR_LAYER});
+        m_registry.add<Bounds>(sphere, cubeBounds);
+    }
+}
+
+void GLWidget::updateScene(float timeSecs, float deltaSecs)
+{
+    PROFILE_FUNCTION();
+    // Movement system
+    m_registry.each<Velocity, Transform>([deltaSecs](Entity, const Velocity & velocity, Transform & transform) {
+        transform.position += velocity.linear * deltaSecs;
+    });
+
+    // Let the cube "breathe"
+    if (m_registry.isValid(m_cube))
+        m_registry.get<Transform>(m_cube).scale = QVector3D(1.0f, 1.0f, 1.0f) * (1.0f + sinf(timeSecs) * 0.05f);
+}
+
+void GLWidget::renderScene()
+{
+    PROFILE_FUNCTION();
+    PROFILE_GPU_SCOPE(m_gpuProfiler, "renderScene");
+    // Set up the VP matrices, the model matrix comes from each entity
     QMatrix4x4 view;
     QMatrix4x4 projection;
 
-    // Model TSR (rotate, scale, then translate)
-    // no rotate
-    // scale
-    //model.scale(2.0, 1.0, 1.0);
-    model.scale(1.0f + sinf(timeSecs) * 0.05f);
-    // translate
-    model.translate(m_cubePos);
-
     // Create the view matrix using the new camera class
     if (m_orbitalCameraMode)
     {
@@ -263,19 +679,106 @@ void GLWidget::paintGL()
 
     // Create the projection matrix
     //projection.setToIdentity();
-    projection.perspective(m_playerCamera.getFOV(), width()/height(), 0.1f, 100.0f);
+    const float fovDegrees = m_playerCamera.getFOV();
+    projection.perspective(fovDegrees, float(width()) / float(qMax(1, height())), 0.1f, 100.0f);
+
+    // Levels of detail from the size on screen
+    LodSelection lod;
+    lod.enabled = m_lodEnabled;
+    lod.cameraPosition = m_orbitalCameraMode ? m_orbitCamera.position() : m_playerCamera.position();
+    lod.pixelsPerUnit = float(height()) / (2.0f * tanf(qDegreesToRadians(fovDegrees) * 0.5f));
 
-    // Render the rectangle (two triangles)
-    // Must be called BEFORE setting uniforms because setting uniforms
-    // is done on the currently active shader program.
-    m_shaderProgram.use();
+    // Transform, cull (frustum and occlusion), select the LOD and sort on the worker threads
+    FrameDrawList drawList(m_frameAllocator.resource());
+    buildDrawList(drawList, projection * view, lod, m_occlusionEnabled);
+
+    // Texture levels from the size on screen, the bounding sphere stands in for the object.
+    // The streamer is shared, the manager updates it when all widgets have requested.
+    // None when initializeGL() stopped at the texture array.
+    if (m_textureStreamer)
+    {
+        for (const DrawItem & item : drawList.items)
+        {
+            const float radius = item.extents.length();
+            if (!item.texture || radius <= 0.0f)
+                continue;
+            const float distance = qMax((item.center - lod.cameraPosition).length() - radius, 0.1f);
+            m_textureStreamer->request(item.texture, 2.0f * radius * lod.pixelsPerUnit / distance);
+        }
+        ResourceManager::instance().endTextureRequests(this);
+        m_textureStatistics = m_textureStreamer->statistics();
+    }
+
+    // Write the VP matrices into this frame's part of the stream buffer
+    // (std140: a mat4 is 4 columns of vec4)
+    const GLsizeiptr matrixSize = 16 * sizeof(float);
+    m_streamBuffer.beginFrame();
+    StreamBuffer::Allocation frameBlock = m_streamBuffer.allocate(2 * matrixSize, m_uniformAlignment);
+    if (frameBlock.isValid())
+    {
+        memcpy(frameBlock.data, view.constData(), matrixSize);
+        memcpy(static_cast<char *>(frameBlock.data) + matrixSize, projection.constData(), matrixSize);
+    }
+    m_streamBuffer.flush();
+
+    // One batch command per mesh (instanced), a new command range per texture.
+    // Objects with an occlusion query in flight get a range of their own,
+    // it is drawn with conditional rendering.
+    struct DrawRange
+    {
+        Texture2D * texture {nullptr};
+        int firstCommand {0};
+        Entity conditional {INVALID_ENTITY};
+    };
+    FrameVector<DrawRange> drawRanges(m_frameAllocator.resource());
+    drawRanges.reserve(drawList.items.size());
+
+    // Used BEFORE drawing because the uniforms and block bindings belong to the
+    // active program. Without one (background compile still running, failed hot
+    // reload) nothing is drawn: checked before any query is added, because every
+    // added query must be issued by m_occlusionQueries.end().
+    ShaderProgram * shaderProgram = m_shaders.program(m_wireframeMode ? WIREFRAME_FEATURES : SCENE_FEATURES);
+    if (!shaderProgram)
+    {
+        m_streamBuffer.endFrame();
+        return;
+    }
+
+    m_occlusionQueries.beginFrame(projection * view, lod.cameraPosition);
+    m_drawBatch.begin();
+    for (const DrawItem & item : drawList.items)
+    {
+        // Occluders are always drawn, they fill the depth buffer for the queries
+        Entity conditional = INVALID_ENTITY;
+        if (m_queriesEnabled && !item.occluder && !item.extents.isNull())
+        {
+            const OcclusionQueries::Result result = m_occlusionQueries.result(item.entity, item.center, item.extents);
+            m_occlusionQueries.add(item.entity, item.center, item.extents);
+            if (result == OcclusionQueries::Result::Occluded)
+                continue;
+            if (result == OcclusionQueries::Result::Pending)
+                conditional = item.entity;
+        }
 
-    // Setup the MVP matrices inside the shaders
-    m_shaderProgram.setUniform("model", model);
-    m_shaderProgram.setUniform("view", view);
-    m_shaderProgram.setUniform("projection", projection);
+        if (drawRanges.empty() || drawRanges.back().texture != item.texture ||
+            drawRanges.back().conditional != INVALID_ENTITY || conditional != INVALID_ENTITY)
+        {
+            m_drawBatch.split();
+            drawRanges.push_back(DrawRange{item.texture, m_drawBatch.commandCount(), conditional});
+        }
+        const QVector2D scale = item.texture ? item.texture->layerScale(item.layer) : QVector2D(1.0f, 1.0f);
+        if (!m_drawBatch.add(item.mesh, item.model, QVector4D(float(item.layer), scale.x(), scale.y(), 0.0f)))
+            break; // the batch is full, the rest is not drawn
+    }
+    m_drawBatch.end();
 
-    m_texture.bind();
+    // Program, uniform block, object data, VAO and polygon mode, then per range
+    int stateChanges = 5;
+    shaderProgram->use();
+    if (frameBlock.isValid())
+        glBindBufferRange(GL_UNIFORM_BUFFER, FRAME_BLOCK_BINDING, m_streamBuffer.bufferId(), frameBlock.offset, frameBlock.size);
+    shaderProgram->setUniform("objectDataOffset", m_drawBatch.objectDataOffset());
+    m_drawBatch.bindObjectData(OBJECT_DATA_UNIT);
 
     // We want to draw the vertices so "bind" (select) the vao first
     m_vao.bind();
@@ -283,28 +786,223 @@ void GLWidget::paintGL()
     // The triangles will be drawn with this mode
     glPolygonMode(GL_FRONT_AND_BACK, m_wireframeMode ? GL_LINE : GL_FILL);
 
-    // Draw the cube - 0 offset
-    // glDrawArrays(GL_TRIANGLES, 0, 36);
-    glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_SHORT, 0);
+    // Render system - one texture bind and one batch submission per texture
+    Texture2D * boundTexture = nullptr;
+    for (size_t ii = 0; ii < drawRanges.size(); ++ii)
+    {
+        const DrawRange & range = drawRanges[ii];
+        const int endCommand = ii + 1 < drawRanges.size() ? drawRanges[ii + 1].firstCommand : m_drawBatch.commandCount();
+        if (range.texture && range.texture != boundTexture)
+        {
+            // Keeps it in the GPU memory budget (least recently used go first)
+            ResourceManager::instance().useTexture(range.texture);
+            range.texture->bind();
+            boundTexture = range.texture;
+            stateChanges++;
+        }
+        if (range.conditional != INVALID_ENTITY)
+        {
+            m_occlusionQueries.beginConditionalRender(range.conditional);
+            stateChanges++;
+        }
+        m_drawBatch.draw(range.firstCommand, endCommand - range.firstCommand, GL_UNSIGNED_SHORT);
+        if (range.conditional != INVALID_ENTITY)
+            m_occlusionQueries.endConditionalRender();
+    }
+    m_drawCalls = m_drawBatch.statistics().drawCalls;
+    m_triangles = m_drawBatch.statistics().triangles;
+    m_stateChanges = stateChanges;
 
-    // Position below the cube and squash it flat
-    model.setToIdentity();
-    model.translate(m_floorPos);
-    model.scale(QVector3D(10.0f, 0.01f, 10.0f));
+    // "unbind" to ensure no further changes the vao can be made
+    glBindVertexArray(0);
 
-    // Update the M(VP) matrices inside the shaders
-    m_shaderProgram.setUniform("model", model);
+    // Box queries against the depth of this frame, read in one of the next frames
+    m_occlusionQueries.end();
+    m_queryStatistics = m_occlusionQueries.statistics();
 
-    m_textureFloor.bind();
+    // Fence this frame's part of the stream buffers
+    m_drawBatch.finish();
+    m_streamBuffer.endFrame();
+}
 
-    // Draw the floor using the same squashed cubeVertices
-    //glDrawArrays(GL_TRIANGLES, 0, 36);
+void GLWidget::buildDrawList(FrameDrawList & drawList, const QMatrix4x4 & viewProjection, const LodSelection & lod, bool occlusionCulling)
+{
+    PROFILE_FUNCTION();
+    // Get the pools here (may create them), the jobs only read them
+    ComponentPool<MeshComponent> & meshes = m_registry.pool<MeshComponent>();
+    ComponentPool<Transform> & transforms = m_registry.pool<Transform>();
+    ComponentPool<Material> & materials = m_registry.pool<Material>();
+    ComponentPool<Bounds> & bounds = m_registry.pool<Bounds>();
+    ComponentPool<MeshLods> & meshLods = m_registry.pool<MeshLods>();
+    ComponentPool<Occluder> & occluders = m_registry.pool<Occluder>();
 
-    // Draw the "elements" - 0 offset
-    glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_SHORT, 0);
+    // Size both lists here on the OpenGL thread, the jobs must not allocate
+    // from this thread's arena
+    const int count = int(meshes.size());
+    drawList.candidates.resize(count);
+    drawList.items.reserve(count);
+    const Frustum frustum(viewProjection);
 
-    // "unbind" to ensure no further changes the vao can be made
-    glBindVertexArray(0);
+    // Transform update and frustum culling, one slot per mesh so no locking is needed
+    auto transformAndCull = [&](int begin, int end) {
+        for (int ii = begin; ii < end; ++ii)
+        {
+            DrawItem & item = drawList.candidates[ii];
+            const Entity entity = meshes.entities()[ii];
+            const Transform * transform = transforms.tryGet(entity);
+            item.visible = false;
+            if (!transform)
+                continue;
+
+            item.model = transform->modelMatrix();
+            item.entity = entity;
+            item.mesh = meshes.data()[ii];
+            const Material * material = materials.tryGet(entity);
+            item.texture = material ? material->texture : nullptr;
+            item.layer = material ? material->layer : 0;
+            item.occluder = occluders.tryGet(entity) != nullptr;
+
+            item.visible = true;
+            QVector3D center = transform->position;
+            QVector3D extents;
+            if (const Bounds * box = bounds.tryGet(entity))
+            {
+                Frustum::transformBox(item.model, box->min, box->max, center, extents);
+                item.visible = frustum.isBoxVisible(center, extents);
+            }
+            item.center = center;
+            item.extents = extents;
+
+            // Level of detail from the distance to the nearest point of the bounds
+            const MeshLods * lods = meshLods.tryGet(entity);
+            if (lods && lod.enabled && item.visible)
+            {
+                const float distance = (center - lod.cameraPosition).length() - extents.length();
+                const float worldScale = qMax(qAbs(transform->scale.x()), qMax(qAbs(transform->scale.y()), qAbs(transform->scale.z())));
+                const MeshLods::Level & level = lods->levels[lods->select(distance, worldScale, lod.pixelsPerUnit, lod.maxPixelError)];
+                item.mesh.indexCount = level.indexCount;
+                item.mesh.firstIndex = level.firstIndex;
+            }
+        }
+    };
+
+    // Boxes hidden behind the occluders are dropped, the occluders themselves are always drawn
+    auto occlusionTest = [&](int begin, int end) {
+        QElapsedTimer timer;
+        timer.start();
+        int occluded = 0;
+        for (int ii = begin; ii < end; ++ii)
+        {
+            DrawItem & item = drawList.candidates[ii];
+            if (!item.visible || item.occluder || item.extents.isNull())
+                continue;
+            if (!m_occlusionCuller.isVisible(item.center, item.extents))
+            {
+                item.visible = false;
+                occluded++;
+            }
+        }
+        drawList.occluded += occluded;
+        drawList.occlusionTestNanoseconds += timer.nsecsElapsed();
+    };
+
+    // The occluders are binned here, their tiles are rasterized by the workers
+    // at the same time as the transform jobs
+    JobCounter rasterized;
+    if (occlusionCulling)
+    {
+        m_occlusionCuller.beginFrame(viewProjection);
+        m_registry.each<Occluder, Transform>([this](Entity, const Occluder & occluder, const Transform & transform) {
+            if (occluder.mesh)
+                m_occlusionCuller.addOccluder(*occluder.mesh, transform.modelMatrix());
+        });
+        m_occlusionCuller.rasterize(m_jobs, rasterized);
+    }
+
+    // The sort depends on all transform (and occlusion test) jobs, then the draw list is ready
+    JobCounter transformed;
+    JobCounter tested;
+    JobCounter sorted;
+    m_jobs.parallelFor(count, 256, transformAndCull, transformed);
+
+    Job sortJob;
+    sortJob.function = &GLWidget::sortDrawList;
+    sortJob.data = &drawList;
+    sortJob.counter = &sorted;
+    if (occlusionCulling)
+    {
+        // The test needs the boxes and the complete depth buffer
+        m_jobs.wait(transformed);
+        m_jobs.wait(rasterized);
+        m_jobs.parallelFor(count, 256, occlusionTest, tested);
+        m_jobs.runAfter(tested, sortJob);
+    }
+    else
+    {
+        m_jobs.runAfter(transformed, sortJob);
+    }
+
+    m_jobs.wait(sorted);
+
+    if (occlusionCulling)
+    {
+        const OcclusionCuller::Statistics statistics = m_occlusionCuller.statistics();
+        m_occluded = drawList.occluded;
+        m_occlusionNanoseconds = statistics.binNanoseconds + statistics.rasterNanoseconds + drawList.occlusionTestNanoseconds;
+    }
+    else
+    {
+        m_occluded = 0;
+        m_occlusionNanoseconds = 0;
+    }
+}
+
+void GLWidget::sortDrawList(void * data, int, int)
+{
+    FrameDrawList * drawList = static_cast<FrameDrawList *>(data);
+
+    // Keep the visible items (capacity was reserved, no allocation here)
+    for (const DrawItem & item : drawList->candidates)
+    {
+        if (item.visible)
+            drawList->items.push_back(item);
+    }
+
+    // Group by texture to minimize the texture binds, then by mesh so
+    // equal objects are next to each other for the instanced draw
+    std::sort(drawList->items.begin(), drawList->items.end(), [](const DrawItem & a, const DrawItem & b) {
+        if (a.texture != b.texture)
+            return a.texture < b.texture;
+        if (a.mesh.firstIndex != b.mesh.firstIndex)
+            return a.mesh.firstIndex < b.mesh.firstIndex;
+        if (a.mesh.baseVertex != b.mesh.baseVertex)
+            return a.mesh.baseVertex < b.mesh.baseVertex;
+        return a.mesh.indexCount < b.mesh.indexCount;
+    });
+}
+
+QVector3D GLWidget::cubePosition()
+{
+    if (!m_registry.isValid(m_cube))
+        return QVector3D();
+    return m_registry.get<Transform>(m_cube).position;
+}
+
+void GLWidget::moveCube(const QVector3D & offset)
+{
+    if (!m_registry.isValid(m_cube))
+        return;
+    Transform & transform = m_registry.get<Transform>(m_cube);
+    transform.position += offset;
+    m_orbitCamera.setOrbitCenter(transform.position);
+}
+
+void GLWidget::resetCameras()
+{
+    m_playerCamera.setPosition(QVector3D(0.0f, 0.0f, 10.0f));
+    m_playerCamera.setRotation(0.0f, 0.0f);
+    m_orbitCamera.setRadius(10.0f);
+    m_orbitCamera.setRotation(0.0f, 0.0f);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -312,40 +1010,48 @@ void GLWidget::paintGL()
 ///////////////////////////////////////////////////////////////////////////////
 
 void GLWidget::keyPressEvent(QKeyEvent *event)
+{
+    // While replaying the recording alone moves the scene
+    const int key = event->key();
+    const bool sceneKey = InputRecording::isRecordedKey(key);
+    if (m_replaying && sceneKey)
+        return;
+    if (m_recording && sceneKey)
+        m_inputRecording.record(m_inputFrame, m_inputClock.elapsed(), key, int(event->modifiers()));
+    handleKey(key, event->modifiers());
+}
+
+void GLWidget::handleKey(int key, Qt::KeyboardModifiers modifiers)
 {
     const float speedMove = 0.05f;
     const float speedRotateDeg = 0.5f;
-    bool shiftPressed = (event->modifiers() & Qt::ShiftModifier);
+    bool shiftPressed = (modifiers & Qt::ShiftModifier);
 
     ///////////////////
     // Move the cube
     ///////////////////
     if (shiftPressed)
     {
-        switch(event->key())
+        switch(key)
         {
             case Qt::Key_Up:
             {
-                m_cubePos += QVector3D(0.0f, speedMove, 0.0f);
-                m_orbitCamera.setOrbitCenter(m_cubePos);
+                moveCube(QVector3D(0.0f, speedMove, 0.0f));
                 break;
             }
             case Qt::Key_Down:
             {
-                m_cubePos += QVector3D(0.0f, -speedMove, 0.0f );
-                m_orbitCamera.setOrbitCenter(m_cubePos);
+                moveCube(QVector3D(0.0f, -speedMove, 0.0f));
                 break;
             }
             case Qt::Key_Left:
             {
-                m_cubePos += QVector3D(-speedMove, 0.0f, 0.0f);
-                m_orbitCamera.setOrbitCenter(m_cubePos);
+                moveCube(QVector3D(-speedMove, 0.0f, 0.0f));
                 break;
             }
             case Qt::Key_Right:
             {
-                m_cubePos += QVector3D(speedMove, 0.0f, 0.0f);
-                m_orbitCamera.setOrbitCenter(m_cubePos);
+                moveCube(QVector3D(speedMove, 0.0f, 0.0f));
                 break;
             }
         }
@@ -355,7 +1061,7 @@ void GLWidget::keyPressEvent(QKeyEvent *event)
     ///////////////////
     // General functions
     ///////////////////
-    switch(event->key())
+    switch(key)
     {
     case Qt::Key_Escape:
         qInfo() << "Application - Escaping ... quit.";
@@ -374,12 +1080,73 @@ void GLWidget::keyPressEvent(QKeyEvent *event)
         break;
     case Qt::Key_F3:
         m_orbitalCameraMode = !m_orbitalCameraMode;
-        m_playerCamera.setPosition(QVector3D(0.0f, 0.0f, 10.0f));
-        m_playerCamera.setRotation(0.0f, 0.0f);
-        m_orbitCamera.setRadius(10.0f);
-        m_orbitCamera.setRotation(0.0f, 0.0f);
+        resetCameras();
         qInfo() << "Application - toggle orbital camera mode." << m_orbitalCameraMode;
         break;
+    case Qt::Key_F4:
+        m_lodEnabled = !m_lodEnabled;
+        qInfo() << "Application - toggle levels of detail." << m_lodEnabled;
+        break;
+    case Qt::Key_F5:
+        m_occlusionEnabled = !m_occlusionEnabled;
+        qInfo() << "Application - toggle occlusion culling." << m_occlusionEnabled;
+        break;
+    case Qt::Key_F6:
+        m_queriesEnabled = !m_queriesEnabled;
+        qInfo() << "Application - toggle occlusion queries." << m_queriesEnabled;
+        break;
+    case Qt::Key_F7:
+        // A quarter of the budget shows the streaming out of the finest levels
+        m_lowTextureBudget = !m_lowTextureBudget;
+        if (m_textureStreamer)
+            ResourceManager::instance().setTextureBudget(this, m_lowTextureBudget ? s_textureBudget / 4 : s_textureBudget);
+        qInfo() << "Application - toggle low texture budget." << m_lowTextureBudget;
+        break;
+    case Qt::Key_F8:
+    {
+        const QString directory = QStandardPaths::writableLocation(QStandardPaths::PicturesLocation);
+        const QString fileName = QString("learnopengl-%1.png").arg(QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss"));
+        saveScreenshot(QDir(directory).filePath(fileName));
+        qInfo() << "Application - screenshot" << m_screenshotFile;
+        break;
+    }
+    case Qt::Key_F9:
+        if (isCapturing())
+        {
+            stopCapture();
+        }
+        else
+        {
+            const QString directory = QStandardPaths::writableLocation(QStandardPaths::MoviesLocation);
+            const QString name = QString("learnopengl-%1").arg(QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss"));
+            startCapture(QDir(directory).filePath(name), s_captureFormat);
+        }
+        qInfo() << "Application - toggle frame capture." << isCapturing();
+        break;
+    case Qt::Key_F10:
+    {
+        // The last zones of every thread, open in chrome://tracing or ui.perfetto.dev
+        const QString directory = QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation);
+        const QString fileName = QString("learnopengl-trace-%1.json").arg(QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss"));
+        if (Profiler::isEnabled())
+            Profiler::writeChromeTrace(QDir(directory).filePath(fileName));
+        else
+            qInfo() << "Application - built without LEARNOPENGL_PROFILE, no trace";
+        break;
+    }
+    case Qt::Key_F11:
+        m_statsOverlay.setVisible(!m_statsOverlay.isVisible());
+        qInfo() << "Application - toggle statistics overlay." << m_statsOverlay.isVisible();
+        break;
+    case Qt::Key_F12:
+        if (m_replaying)
+            break;
+        if (m_recording)
+            stopRecording();
+        else
+            startRecording();
+        qInfo() << "Application - toggle input recording." << m_recording;
+        break;
     }
 
     if (m_orbitalCameraMode)
@@ -387,7 +1154,7 @@ void GLWidget::keyPressEvent(QKeyEvent *event)
         ////////////////////////////
         // OrbitalCamera control
         ////////////////////////////
-        switch(event->key())
+        switch(key)
         {
         case Qt::Key_W: // Camera forward (-z)
             m_orbitCamera.setRadius(m_orbitCamera.radius()-speedMove);
@@ -400,7 +1167,7 @@ void GLWidget::keyPressEvent(QKeyEvent *event)
         case Qt::Key_D: // Not used
             break;
         case Qt::Key_L: // Camera move right
-            m_orbitCamera.setLookAt(m_cubePos);
+            m_orbitCamera.setLookAt(cubePosition());
             break;
         case Qt::Key_Left: // Yaw to left (right hand rule, rotate around the y/up axis)
             m_orbitCamera.rotate(-speedRotateDeg, 0.0f);
@@ -421,7 +1188,7 @@ void GLWidget::keyPressEvent(QKeyEvent *event)
         ////////////////////////////
         // PlayerCamera control
         ////////////////////////////
-        switch(event->key())
+        switch(key)
         {
         case Qt::Key_W:
         {
@@ -460,7 +1227,7 @@ void GLWidget::keyPressEvent(QKeyEvent *event)
             break;
         }
         case Qt::Key_L: // Camera pitch and yaw set to look at cube
-            m_playerCamera.setLookAt(m_cubePos);
+            m_playerCamera.setLookAt(cubePosition());
             break;
         case Qt::Key_Left: // Yaw to left (right hand rule, rotate around the y/up axis)
             m_playerCamera.rotate(-speedRotateDeg, 0.0f);
@@ -478,6 +1245,144 @@ void GLWidget::keyPressEvent(QKeyEvent *event)
     }
 }
 
+///////////////////////////////////////////////////////////////////////////////
+/// Input recording and replay
+///////////////////////////////////////////////////////////////////////////////
+
+InputRecording::State GLWidget::inputState() const
+{
+    InputRecording::State state;
+    state.orbitalCamera = m_orbitalCameraMode;
+    state.wireframe = m_wireframeMode;
+    state.levelOfDetail = m_lodEnabled;
+    state.occlusionCulling = m_occlusionEnabled;
+    state.occlusionQueries = m_queriesEnabled;
+    state.lowTextureBudget = m_lowTextureBudget;
+    return state;
+}
+
+void GLWidget::resetInputState(const InputRecording::State & state)
+{
+    // Recording and replay start from the same scene
+    m_orbitalCameraMode = state.orbitalCamera;
+    m_wireframeMode = state.wireframe;
+    m_lodEnabled = state.levelOfDetail;
+    m_occlusionEnabled = state.occlusionCulling;
+    m_queriesEnabled = state.occlusionQueries;
+    m_lowTextureBudget = state.lowTextureBudget;
+    if (m_textureStreamer)
+        ResourceManager::instance().setTextureBudget(this, m_lowTextureBudget ? s_textureBudget / 4 : s_textureBudget);
+    resetCameras();
+    if (m_registry.isValid(m_cube))
+        moveCube(-cubePosition());
+    m_lastFrameSecs = 0.0f;
+    m_inputFrame = 0;
+    m_inputClock.start();
+}
+
+void GLWidget::startRecording()
+{
+    if (m_replaying)
+        return;
+    const InputRecording::State state = inputState();
+    resetInputState(state);
+    m_inputRecording.start(state);
+    m_recording = true;
+}
+
+void GLWidget::stopRecording()
+{
+    if (!m_recording)
+        return;
+    m_recording = false;
+    m_inputRecording.finish(m_inputFrame);
+    const QString directory = QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation);
+    const QString fileName = QString("learnopengl-input-%1.txt").arg(QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss"));
+    m_inputRecording.save(QDir(directory).filePath(fileName));
+}
+
+bool GLWidget::startReplay(const QString & fileName)
+{
+    if (!m_inputRecording.load(fileName) || m_inputRecording.frameCount() == 0)
+    {
+        qWarning() << "Replay : loading" << fileName << "FAILED";
+        return false;
+    }
+    resetInputState(m_inputRecording.state());
+    m_replayEvent = 0;
+    m_replayFrameNanoseconds.assign(size_t(m_inputRecording.frameCount()), 0);
+    m_replaying = true;
+    m_replayComplete = false;
+    qInfo() << "Replay :" << fileName << (s_replay.unlimitedSpeed ? "at unlimited speed" : "") << (s_replay.headless ? "(headless)" : "");
+    return true;
+}
+
+void GLWidget::applyReplayEvents()
+{
+    const std::vector<InputRecording::Event> & events = m_inputRecording.events();
+    for (; m_replayEvent < events.size() && events[m_replayEvent].frame <= m_inputFrame; ++m_replayEvent)
+        handleKey(events[m_replayEvent].key, Qt::KeyboardModifiers(events[m_replayEvent].modifiers));
+}
+
+void GLWidget::finishReplay()
+{
+    m_replaying = false;
+    m_replayComplete = true;
+    const qint64 wallNanoseconds = m_inputClock.nsecsElapsed();
+
+    std::vector<qint64> sorted = m_replayFrameNanoseconds;
+    std::sort(sorted.begin(), sorted.end());
+    auto percentile = [&](double fraction) {
+        return double(sorted[size_t(fraction * double(sorted.size() - 1))]) / 1e6;
+    };
+    const size_t frames = sorted.size();
+    qInfo().noquote() << QString("Replay : %1 frames in %2 s (%3 ms / frame), paintGL CPU p50 %4 ms, p95 %5 ms, p99 %6 ms, max %7 ms")
+                             .arg(frames).arg(double(wallNanoseconds) / 1e9, 0, 'f', 3)
+                             .arg(double(wallNanoseconds) / 1e6 / double(frames), 0, 'f', 3)
+                             .arg(percentile(0.50), 0, 'f', 3).arg(percentile(0.95), 0, 'f', 3)
+                             .arg(percentile(0.99), 0, 'f', 3).arg(percentile(1.0), 0, 'f', 3);
+
+    // Baseline or run to compare (--compare)
+    if (!s_replay.resultsFile.isEmpty())
+    {
+        BenchmarkResults results;
+        std::vector<double> cpuMilliseconds;
+        cpuMilliseconds.reserve(m_replayFrameNanoseconds.size());
+        for (qint64 nanoseconds : m_replayFrameNanoseconds)
+            cpuMilliseconds.push_back(double(nanoseconds) / 1e6);
+        results.add("replay/cpu_ms", "ms", cpuMilliseconds);
+        results.add("replay/frame_ms", "ms", double(wallNanoseconds) / 1e6 / double(frames));
+        results.add("replay/initialize_ms", "ms", double(m_initializeNanoseconds) / 1e6);
+        results.add("replay/gpu_memory_mb", "MB", double(m_gpuMemoryStatistics.totalBytes) / (1024.0 * 1024.0));
+        results.save(s_replay.resultsFile);
+    }
+
+    if (!s_replay.headless)
+        qApp->quit();
+}
+
+int GLWidget::runHeadlessReplay()
+{
+    // Initializes OpenGL (which starts the replay) and renders the first frame
+    grabFramebuffer();
+    while (m_replaying)
+    {
+        makeCurrent();
+        paintGL();
+        // Like a swap chain: at most one frame queued on the GPU
+        if (m_headlessFence)
+        {
+            glClientWaitSync(m_headlessFence, GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(1000000000));
+            glDeleteSync(m_headlessFence);
+        }
+        m_headlessFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glFlush();
+        doneCurrent();
+        QCoreApplication::processEvents();
+    }
+    return m_replayComplete ? 0 : 1;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 /// Statistics
 ///////////////////////////////////////////////////////////////////////////////
@@ -489,7 +1394,30 @@ void GLWidget::initializeStatistics()
     QTimer * timer = new QTimer(this);
     timer->setInterval(1000);
     connect(timer, &QTimer::timeout, [=] {
-        topLevelWidget()->setWindowTitle(QString("%1 - %2 fps, %3 ms / 1s").arg(MainWindow::APP_TITLE).arg(m_frameCount).arg(float(m_nsecsElapsed)/1000000, 3));
+        QString occlusion = m_occlusionEnabled ? QString(", %1 occluded (%2 ms)").arg(m_occluded).arg(double(m_occlusionNanoseconds) / 1e6, 0, 'f', 3)
+                                               : QString(" (occlusion off)");
+        occlusion += m_queriesEnabled ? QString(", queries %1 hidden %2 pending").arg(m_queryStatistics.occluded).arg(m_queryStatistics.pending)
+                                      : QString(" (queries off)");
+        const QString textures = QString(", textures %1 / %2 MB (stream %3 ms)")
+                                     .arg(double(m_textureStatistics.residentBytes) / (1024.0 * 1024.0), 0, 'f', 1)
+                                     .arg(double(m_textureStatistics.budgetBytes) / (1024.0 * 1024.0), 0, 'f', 1)
+                                     .arg(double(m_textureStatistics.lastLatencyNanoseconds) / 1e6, 0, 'f', 1);
+        const GpuMemory::Statistics & memory = m_gpuMemoryStatistics;
+        auto megabytes = [](qint64 bytes) { return QString::number(double(bytes) / (1024.0 * 1024.0), 'f', 1); };
+        const QString gpuMemory = QString(", GPU %1 MB (vertex %2, index %3, stream %4, texture %5)")
+                                      .arg(megabytes(memory.totalBytes),
+                                           megabytes(memory.bytes[int(GpuMemory::Category::VertexBuffer)]),
+                                           megabytes(memory.bytes[int(GpuMemory::Category::IndexBuffer)]),
+                                           megabytes(memory.bytes[int(GpuMemory::Category::StreamBuffer)]),
+                                           megabytes(memory.bytes[int(GpuMemory::Category::Texture)]));
+        QString capture;
+        if (isCapturing())
+        {
+            const FrameCapture::Statistics recorded = m_capture.statistics();
+            capture = QString(", REC %1 frames, %2 dropped").arg(recorded.written).arg(recorded.dropped + recorded.droppedSize + m_readback.statistics().dropped);
+        }
+        topLevelWidget()->setWindowTitle(QString("%1 - %2 fps, %3 ms / 1s, %4 draws, %5 triangles%6%7%8%9%10").arg(MainWindow::APP_TITLE).arg(m_frameCount).arg(float(m_nsecsElapsed)/1000000, 3)
+                                         .arg(m_drawCalls).arg(m_triangles).arg(m_lodEnabled ? QString() : QString(" (LOD off)"), occlusion, textures, gpuMemory, capture));
         m_frameCount = 0;
         m_nsecsElapsed = 0;
     });
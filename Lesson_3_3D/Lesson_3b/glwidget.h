@@ -14,6 +14,24 @@
 #include "shaderprogram.h"
 #include "texture2D.h"
 #include "camera.h"
+#include "entityregistry.h"
+#include "components.h"
+#include "jobsystem.h"
+#include "framearena.h"
+#include "streambuffer.h"
+#include "drawbatch.h"
+#include "meshsimplifier.h"
+#include "occlusionculler.h"
+#include "occlusionqueries.h"
+#include "shaderhotreload.h"
+#include "texturestreamer.h"
+#include "resourcemanager.h"
+#include "gpumemory.h"
+#include "framereadback.h"
+#include "framecapture.h"
+#include "gpuprofiler.h"
+#include "statsoverlay.h"
+#include "inputrecording.h"
 
 #include <QOpenGLWidget>
 #include <QOpenGLFunctions>
@@ -35,6 +53,52 @@ public:
     GLWidget(QWidget *parent);
     virtual ~GLWidget();
 
+    // Development mode: load the shaders from this directory instead of the
+    // resources and reload them when they change. Set before the widget is shown.
+    static void setShaderDirectory(const QString & directory);
+
+    // GPU memory for the streamed texture levels. Set before the widget is shown.
+    static void setTextureBudget(qint64 bytes);
+
+    // Copy the next rendered frames (frames < 0: until stopReadback) to the
+    // callback. It is called a few frames later, the GPU copy never stalls paintGL.
+    void startReadback(FrameReadback::Callback callback, void * user, int frames = 1);
+    void stopReadback();
+    const FrameReadback::Statistics & readbackStatistics() const { return m_readback.statistics(); }
+
+    // PNG of the next frame, written by a job
+    void saveScreenshot(const QString & fileName);
+
+    // Record every frame into the directory (see FrameCapture)
+    bool startCapture(const QString & directory, FrameCapture::Format format);
+    void stopCapture();
+    bool isCapturing() const { return m_capture.isRunning(); }
+
+    // Format of the F9 recordings. Set before the widget is shown.
+    static void setCaptureFormat(FrameCapture::Format format);
+
+    // Key presses into a file (F12), see InputRecording
+    void startRecording();
+    void stopRecording();
+    bool isRecording() const { return m_recording; }
+
+    // Replay of a recording at fixed simulated time steps, started by
+    // initializeGL. Set before the widget is shown. The application quits
+    // when the replay is done (unless headless, see runHeadlessReplay).
+    struct ReplayOptions
+    {
+        QString fileName;
+        bool unlimitedSpeed {false};    // no update timer interval
+        bool headless {false};          // driven by runHeadlessReplay, no timer
+        QString resultsFile;            // frame times etc., see BenchmarkResults
+    };
+    static void setReplay(const ReplayOptions & options);
+    bool isReplaying() const { return m_replaying; }
+
+    // Renders the replay as fast as possible into the hidden widget
+    // (Qt::WA_DontShowOnScreen, shown). Returns 0 when it was complete.
+    int runHeadlessReplay();
+
 protected:
     // QOpenGLWidget overrides - the context is set by Qt
     void paintGL() override;
@@ -42,6 +106,7 @@ protected:
 
     // User keyboard interaction
     void keyPressEvent(QKeyEvent *event) override;
+    void handleKey(int key, Qt::KeyboardModifiers modifiers);
 
     // "update" timer
     void timerEvent(QTimerEvent *event) override;
@@ -56,17 +121,155 @@ private slots:
 private:
     // Helper
     void initializeStatistics();
+    static void saveScreenshotFrame(void * user, const FrameReadback::Frame & frame);
+
+    // Scene (entities and their systems)
+    void initializeScene(GLsizei cubeIndexCount);
+    void initializeProgram(quint32 features);
+    void updateScene(float timeSecs, float deltaSecs);
+    void renderScene();
+    struct FrameDrawList;
+    struct LodSelection;
+    void buildDrawList(FrameDrawList & drawList, const QMatrix4x4 & viewProjection, const LodSelection & lod, bool occlusionCulling);
+    static void sortDrawList(void * data, int begin, int end);
+    // Aborts on a steady state frame that allocated (LEARNOPENGL_COUNT_ALLOCATIONS).
+    // Counted: the OpenGL thread and the frame jobs; malloc only with glibc,
+    // elsewhere just operator new (see HeapAllocationCounter).
+    void checkFrameAllocations(quint64 allocations);
+    QVector3D cubePosition();
+    void moveCube(const QVector3D & offset);
+    void resetCameras();
+
+    // Recording and replay
+    InputRecording::State inputState() const;
+    void resetInputState(const InputRecording::State & state);
+    bool startReplay(const QString & fileName);
+    void applyReplayEvents();
+    void finishReplay();
 
     // Scene data
-    ShaderProgram m_shaderProgram;
+    // Permutations of the uber shader (Shaders/uber.vert, uber.frag)
+    static constexpr quint32 SCENE_FEATURES = ShaderPermutations::Textured | ShaderPermutations::Instanced;
+    static constexpr quint32 WIREFRAME_FEATURES = ShaderPermutations::Instanced | ShaderPermutations::Wireframe;
+    ShaderPermutations m_shaders;
+    ShaderHotReload m_shaderHotReload;
+    static QString s_shaderDirectory;
     QColor m_background {Qt::red};
     QOpenGLBuffer m_vbo;
     QOpenGLBuffer m_ibo;
     QOpenGLVertexArrayObject m_vao;
-    Texture2D m_texture;
-    Texture2D m_textureFloor;
-    QVector3D m_cubePos;
-    QVector3D m_floorPos;
+
+    // Uniform block written every frame (see uber.vert)
+    static constexpr GLuint FRAME_BLOCK_BINDING = 0;
+    StreamBuffer m_streamBuffer;
+    GLint m_uniformAlignment {256};
+
+    // All objects are submitted with a few (multi draw indirect) calls,
+    // the per object data is read from a texture buffer
+    static constexpr GLuint DRAW_ID_LOCATION = 2;
+    static constexpr GLuint OBJECT_DATA_UNIT = 1;
+    DrawBatch m_drawBatch;
+
+    // All textures are layers of one array texture, so one bind for all objects.
+    // Loaded once by the ResourceManager for all widgets.
+    static constexpr int CUBE_LAYER = 0;
+    static constexpr int FLOOR_LAYER = 1;
+    TextureHandle m_textureArrayHandle;
+    Texture2D * m_textureArray {nullptr};
+
+    // Only the mip levels needed for the size on screen are on the GPU
+    // (the streamer of the share group, see ResourceManager)
+    TextureStreamer * m_textureStreamer {nullptr};
+    static qint64 s_textureBudget;
+    static FrameCapture::Format s_captureFormat;
+    bool m_lowTextureBudget {false};
+
+    // Entities - the cube and the floor are just entities with components
+    EntityRegistry m_registry;
+    Entity m_cube {INVALID_ENTITY};
+    Entity m_floor {INVALID_ENTITY};
+    float m_lastFrameSecs {0.0f};
+
+    // The spheres have levels of detail, chosen by their size on screen
+    static constexpr int SPHERE_COUNT = 8;
+    MeshComponent m_sphereMesh;
+    MeshLods m_sphereLods;
+    struct LodSelection
+    {
+        bool enabled {true};
+        QVector3D cameraPosition;
+        float pixelsPerUnit {1.0f};     // pixels of one world unit at distance 1
+        float maxPixelError {1.0f};
+    };
+    bool m_lodEnabled {true};
+
+    // The cube and the floor hide the objects behind them, tested on the CPU
+    // against a low resolution depth buffer before anything is submitted
+    QByteArray m_occluderVertices;
+    std::vector<quint16> m_occluderIndices;
+    OccluderMesh m_cubeOccluder;
+    OcclusionCuller m_occlusionCuller;
+    bool m_occlusionEnabled {true};
+
+    // What the CPU test lets through is checked on the GPU (box queries of the
+    // previous frames, conditional rendering while a result is in flight)
+    OcclusionQueries m_occlusionQueries;
+    bool m_queriesEnabled {true};
+
+    // Per frame draw list - filled by the jobs, submitted by the OpenGL thread
+    struct DrawItem
+    {
+        QMatrix4x4 model;
+        Entity entity {INVALID_ENTITY};
+        MeshComponent mesh;
+        Texture2D * texture {nullptr};
+        int layer {0};
+        QVector3D center;       // world space box
+        QVector3D extents;
+        bool occluder {false};
+        bool visible {false};
+    };
+    struct FrameDrawList
+    {
+        explicit FrameDrawList(std::pmr::memory_resource * resource)
+            : candidates(resource)
+            , items(resource)
+        {
+        }
+        FrameVector<DrawItem> candidates;
+        FrameVector<DrawItem> items;
+        std::atomic<int> occluded {0};
+        std::atomic<qint64> occlusionTestNanoseconds {0};
+    };
+
+    // Size of every buffer and texture on the GPU, one account (and budget) per
+    // share group in the ResourceManager. The shared textures are added there,
+    // this widget adds its own buffers.
+    GpuMemory * m_gpuMemory {nullptr};
+    std::vector<GpuMemory::Handle> m_gpuMemoryHandles;
+
+    // GPU zones of the timeline (PROFILE_GPU_SCOPE)
+    GpuProfiler m_gpuProfiler;
+
+    // Frame time graphs and counters in the viewport
+    StatsOverlay m_statsOverlay;
+    QElapsedTimer m_paintTimer;
+
+    // Transient per frame memory (draw lists etc.), no heap use in paintGL.
+    // Only the OpenGL thread allocates from it, one arena per frame set.
+    FrameAllocator m_frameAllocator;
+
+    // Worker threads for the per frame CPU work (and saving), shared by all widgets
+    JobSystem & m_jobs {ResourceManager::instance().jobs()};
+
+    // Frames copied back through pixel pack buffers (screenshots, capture)
+    FrameReadback m_readback;
+    FrameReadback::Callback m_readbackCallback {nullptr};
+    void * m_readbackUser {nullptr};
+    int m_readbackFrames {0};       // still to capture, < 0 until stopped
+    QString m_screenshotFile;
+    JobCounter m_screenshotsSaved;
+    FrameCapture m_capture;
 
     // Camera
     PlayerCamera m_playerCamera;
@@ -74,13 +277,37 @@ private:
 
     // Statistics data
     unsigned int m_frameCount {0};
+    int m_drawCalls {0};    // last frame
+    quint64 m_triangles {0};
+    int m_stateChanges {0};
+    int m_occluded {0};
+    qint64 m_occlusionNanoseconds {0};
+    OcclusionQueries::Statistics m_queryStatistics;
+    TextureStreamer::Statistics m_textureStatistics;
+    GpuMemory::Statistics m_gpuMemoryStatistics;
     qint64 m_nsecsElapsed {0};
     QElapsedTimer m_elapsedTime;
     QTime m_programStart;
+    // initializeGL() got through, else paintGL() draws nothing
+    bool m_initialized {false};
 
     // User interaction
     bool m_wireframeMode {false};
     bool m_orbitalCameraMode {false};
     bool m_timerStarted {false};
     int m_timerId;
+
+    // Input recording and replay, frames counted from their start
+    static constexpr float REPLAY_STEP_SECS = 1.0f / 60.0f;
+    static ReplayOptions s_replay;
+    InputRecording m_inputRecording;
+    bool m_recording {false};
+    bool m_replaying {false};
+    bool m_replayComplete {false};
+    quint64 m_inputFrame {0};
+    size_t m_replayEvent {0};
+    QElapsedTimer m_inputClock;
+    std::vector<qint64> m_replayFrameNanoseconds;   // sized at the start
+    qint64 m_initializeNanoseconds {0};
+    GLsync m_headlessFence {nullptr};
 };
@@ -0,0 +1,312 @@
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "gpumemory.h"
+
+#include <QDebug>
+
+namespace
+{
+    // Bytes per 4x4 block of the compressed formats, 0 for the others
+    int blockBytes(QOpenGLTexture::TextureFormat format)
+    {
+        switch (format)
+        {
+        case QOpenGLTexture::RGB_DXT1:
+        case QOpenGLTexture::RGBA_DXT1:
+        case QOpenGLTexture::R_ATI1N_UNorm:
+        case QOpenGLTexture::R_ATI1N_SNorm:
+            return 8;
+        case QOpenGLTexture::RGBA_DXT3:
+        case QOpenGLTexture::RGBA_DXT5:
+        case QOpenGLTexture::RG_ATI2N_UNorm:
+        case QOpenGLTexture::RG_ATI2N_SNorm:
+        case QOpenGLTexture::BPTC_UNorm:
+        case QOpenGLTexture::BPTC_SRGB:
+        case QOpenGLTexture::BPTC_RGBFloat:
+        case QOpenGLTexture::BPTC_RGBUFloat:
+            return 16;
+        default:
+            return 0;
+        }
+    }
+
+    // Uncompressed formats, the 3 component formats are stored with 4 by the drivers
+    int texelBytes(QOpenGLTexture::TextureFormat format)
+    {
+        switch (format)
+        {
+        case QOpenGLTexture::R8_UNorm:
+        case QOpenGLTexture::R8_SNorm:
+        case QOpenGLTexture::R8U:
+        case QOpenGLTexture::R8I:
+        case QOpenGLTexture::S8:
+            return 1;
+        case QOpenGLTexture::RG8_UNorm:
+        case QOpenGLTexture::RG8_SNorm:
+        case QOpenGLTexture::R16_UNorm:
+        case QOpenGLTexture::R16F:
+        case QOpenGLTexture::R16U:
+        case QOpenGLTexture::D16:
+            return 2;
+        case QOpenGLTexture::RGBA16_UNorm:
+        case QOpenGLTexture::RGBA16F:
+        case QOpenGLTexture::RGB16F:
+        case QOpenGLTexture::RG32F:
+        case QOpenGLTexture::D32FS8X24:
+            return 8;
+        case QOpenGLTexture::RGB32F:
+        case QOpenGLTexture::RGBA32F:
+        case QOpenGLTexture::RGBA32U:
+        case QOpenGLTexture::RGBA32I:
+            return 16;
+        default:
+            // RGBA8, SRGB8_Alpha8, RGB10A2, RG16F, R32F, D24, D24S8, D32F ...
+            return 4;
+        }
+    }
+}
+
+GpuMemory::GpuMemory(qint64 budgetBytes)
+    : m_budget(budgetBytes)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Resources
+///////////////////////////////////////////////////////////////////////////////
+
+GpuMemory::Handle GpuMemory::add(Category category, const QString & name, qint64 bytes,
+                                 EvictFunction evict, void * owner, quintptr key)
+{
+    int index = -1;
+    if (!m_freeSlots.empty())
+    {
+        index = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    }
+    else
+    {
+        index = int(m_resources.size());
+        m_resources.emplace_back();
+    }
+
+    Resource & resource = m_resources[index];
+    resource.name = name;
+    resource.category = category;
+    resource.bytes = bytes;
+    resource.evict = evict;
+    resource.owner = owner;
+    resource.key = key;
+    resource.lastUsedFrame = m_frame;
+    resource.alive = true;
+    pushFront(index);
+
+    m_statistics.bytes[int(category)] += bytes;
+    m_statistics.resources[int(category)]++;
+    m_statistics.totalBytes += bytes;
+    return Handle(index + 1);
+}
+
+void GpuMemory::remove(Handle handle)
+{
+    if (!isValid(handle))
+        return;
+
+    const int index = int(handle) - 1;
+    Resource & resource = m_resources[index];
+    unlink(index);
+    m_statistics.bytes[int(resource.category)] -= resource.bytes;
+    m_statistics.resources[int(resource.category)]--;
+    m_statistics.totalBytes -= resource.bytes;
+    resource = Resource();
+    m_freeSlots.push_back(index);
+}
+
+void GpuMemory::clear()
+{
+    const quint64 evictions = m_statistics.evictions;
+    const qint64 evictedBytes = m_statistics.evictedBytes;
+    m_resources.clear();
+    m_freeSlots.clear();
+    m_front = -1;
+    m_back = -1;
+    m_statistics = Statistics();
+    m_statistics.evictions = evictions;
+    m_statistics.evictedBytes = evictedBytes;
+}
+
+void GpuMemory::resize(Handle handle, qint64 bytes)
+{
+    if (!isValid(handle))
+        return;
+
+    Resource & resource = m_resources[int(handle) - 1];
+    m_statistics.bytes[int(resource.category)] += bytes - resource.bytes;
+    m_statistics.totalBytes += bytes - resource.bytes;
+    resource.bytes = bytes;
+}
+
+bool GpuMemory::isValid(Handle handle) const
+{
+    return handle > 0 && handle <= m_resources.size() && m_resources[handle - 1].alive;
+}
+
+void GpuMemory::touch(Handle handle)
+{
+    if (!isValid(handle))
+        return;
+
+    const int index = int(handle) - 1;
+    m_resources[index].lastUsedFrame = m_frame;
+    if (m_front == index)
+        return;
+    unlink(index);
+    pushFront(index);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Budget
+///////////////////////////////////////////////////////////////////////////////
+
+int GpuMemory::enforceBudget()
+{
+    if (m_budget <= 0 || m_statistics.totalBytes <= m_budget)
+        return 0;
+
+    // From the least recently used on, until a resource of this frame is reached
+    int evicted = 0;
+    int index = m_back;
+    while (index >= 0 && m_statistics.totalBytes > m_budget)
+    {
+        Resource & resource = m_resources[index];
+        const int previous = resource.previous;
+        if (resource.lastUsedFrame >= m_frame)
+            break;
+
+        if (resource.evict)
+        {
+            const EvictFunction evict = resource.evict;
+            void * owner = resource.owner;
+            const quintptr key = resource.key;
+            m_statistics.evictions++;
+            m_statistics.evictedBytes += resource.bytes;
+            remove(Handle(index + 1));
+            evict(owner, key);
+            evicted++;
+        }
+        index = previous;
+    }
+
+    if (m_statistics.totalBytes > m_budget)
+        m_statistics.overBudgetFrames++;
+    return evicted;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// LRU list
+///////////////////////////////////////////////////////////////////////////////
+
+void GpuMemory::unlink(int index)
+{
+    Resource & resource = m_resources[index];
+    if (resource.previous >= 0)
+        m_resources[resource.previous].next = resource.next;
+    else
+        m_front = resource.next;
+    if (resource.next >= 0)
+        m_resources[resource.next].previous = resource.previous;
+    else
+        m_back = resource.previous;
+    resource.previous = -1;
+    resource.next = -1;
+}
+
+void GpuMemory::pushFront(int index)
+{
+    Resource & resource = m_resources[index];
+    resource.previous = -1;
+    resource.next = m_front;
+    if (m_front >= 0)
+        m_resources[m_front].previous = index;
+    m_front = index;
+    if (m_back < 0)
+        m_back = index;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Information
+///////////////////////////////////////////////////////////////////////////////
+
+GpuMemory::Statistics GpuMemory::statistics() const
+{
+    Statistics statistics = m_statistics;
+    statistics.budgetBytes = m_budget;
+    return statistics;
+}
+
+void GpuMemory::dump() const
+{
+    qInfo() << "GPU memory :" << double(m_statistics.totalBytes) / (1024.0 * 1024.0) << "MB of"
+            << double(m_budget) / (1024.0 * 1024.0) << "MB budget";
+    for (int category = 0; category < CATEGORY_COUNT; ++category)
+        qInfo() << "GPU memory :" << categoryName(Category(category)) << m_statistics.resources[category] << "resources"
+                << double(m_statistics.bytes[category]) / (1024.0 * 1024.0) << "MB";
+
+    // Most recently used first
+    for (int index = m_front; index >= 0; index = m_resources[index].next)
+    {
+        const Resource & resource = m_resources[index];
+        qInfo() << "GPU memory :   " << categoryName(resource.category) << resource.name << resource.bytes << "bytes"
+                << (resource.evict ? "evictable" : "") << "last used" << resource.lastUsedFrame;
+    }
+}
+
+const char * GpuMemory::categoryName(Category category)
+{
+    switch (category)
+    {
+    case Category::VertexBuffer: return "vertex";
+    case Category::IndexBuffer: return "index";
+    case Category::StreamBuffer: return "stream";
+    case Category::Texture: return "texture";
+    case Category::Other: return "other";
+    }
+    return "";
+}
+
+qint64 GpuMemory::textureBytes(const QOpenGLTexture & texture)
+{
+    if (!texture.isStorageAllocated())
+        return 0;
+    return textureBytes(texture.format(), texture.width(), texture.height(), texture.depth(),
+                        qMax(1, texture.layers()), qMax(1, texture.mipLevels()), qMax(1, texture.faces()));
+}
+
+qint64 GpuMemory::textureBytes(QOpenGLTexture::TextureFormat format, int width, int height,
+                               int depth, int layers, int mipLevels, int faces)
+{
+    const int block = blockBytes(format);
+    const int texel = texelBytes(format);
+    qint64 bytes = 0;
+    for (int level = 0; level < mipLevels; ++level)
+    {
+        const qint64 levelWidth = qMax(1, width >> level);
+        const qint64 levelHeight = qMax(1, height >> level);
+        const qint64 levelDepth = qMax(1, depth >> level);
+        if (block)
+            bytes += (levelWidth + 3) / 4 * ((levelHeight + 3) / 4) * block * levelDepth;
+        else
+            bytes += levelWidth * levelHeight * levelDepth * texel;
+    }
+    return bytes * layers * faces;
+}
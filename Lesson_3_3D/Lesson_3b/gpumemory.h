@@ -0,0 +1,122 @@
+#pragma once
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include <QOpenGLTexture>
+#include <QString>
+
+#include <vector>
+
+///
+/// \brief The GpuMemory class accounts the GPU memory of the buffers and
+/// textures (OpenGL does not tell how much it uses).
+/// Every resource is added with its category and size. Resources that can be
+/// reloaded from their source come with an evict function. When the total is
+/// over the budget, enforceBudget() evicts the least recently used of them
+/// (touch() marks a resource used); resources used in the current frame are
+/// never evicted. The owner frees the memory in the evict function and loads
+/// the resource again on its next use.
+///
+/// Not thread safe, use it from the OpenGL thread.
+///
+class GpuMemory
+{
+public:
+    enum class Category
+    {
+        VertexBuffer,
+        IndexBuffer,
+        StreamBuffer,   // per frame data (uniforms, draw commands, object data)
+        Texture,
+        Other
+    };
+    static constexpr int CATEGORY_COUNT = 5;
+
+    // 0 is no resource
+    using Handle = quint32;
+
+    // Free the GPU memory of the resource (key as given to add()). The
+    // resource is already removed, the handle is invalid afterwards.
+    // It must not add or remove other resources.
+    using EvictFunction = void (*)(void * owner, quintptr key);
+
+    struct Statistics
+    {
+        qint64 bytes[CATEGORY_COUNT] {};
+        int resources[CATEGORY_COUNT] {};
+        qint64 totalBytes {0};
+        qint64 budgetBytes {0};
+        quint64 evictions {0};
+        qint64 evictedBytes {0};
+        quint64 overBudgetFrames {0};   // everything evictable was in use
+    };
+
+    explicit GpuMemory(qint64 budgetBytes = 0);
+
+    GpuMemory(const GpuMemory &) = delete;
+    GpuMemory & operator=(const GpuMemory &) = delete;
+
+    // 0 = no budget
+    void setBudget(qint64 budgetBytes) { m_budget = budgetBytes; }
+    qint64 budget() const { return m_budget; }
+
+    Handle add(Category category, const QString & name, qint64 bytes,
+               EvictFunction evict = nullptr, void * owner = nullptr, quintptr key = 0);
+    void remove(Handle handle);
+    void clear();
+    void resize(Handle handle, qint64 bytes);
+    bool isValid(Handle handle) const;
+
+    // Used in this frame, moves it to the front of the LRU list
+    void touch(Handle handle);
+
+    // Per frame: beginFrame() before the resources are used, enforceBudget()
+    // after they are (or after loading a resource)
+    void beginFrame() { m_frame++; }
+    int enforceBudget();
+
+    Statistics statistics() const;
+    void dump() const;
+
+    static const char * categoryName(Category category);
+
+    // Size of the storage incl. all mip levels, layers and cube faces
+    static qint64 textureBytes(const QOpenGLTexture & texture);
+    static qint64 textureBytes(QOpenGLTexture::TextureFormat format, int width, int height,
+                               int depth = 1, int layers = 1, int mipLevels = 1, int faces = 1);
+
+private:
+    struct Resource
+    {
+        QString name;
+        Category category {Category::Other};
+        qint64 bytes {0};
+        EvictFunction evict {nullptr};
+        void * owner {nullptr};
+        quintptr key {0};
+        quint64 lastUsedFrame {0};
+        int previous {-1};      // LRU list, towards the most recently used
+        int next {-1};          // towards the least recently used
+        bool alive {false};
+    };
+
+    void unlink(int index);
+    void pushFront(int index);
+
+    std::vector<Resource> m_resources;
+    std::vector<int> m_freeSlots;
+    int m_front {-1};           // most recently used
+    int m_back {-1};            // least recently used
+    quint64 m_frame {1};
+    qint64 m_budget {0};
+    Statistics m_statistics;
+};
@@ -0,0 +1,122 @@
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "gpuprofiler.h"
+
+#include <QDebug>
+
+GpuProfiler::~GpuProfiler()
+{
+    // The queries belong to the context, destroy() must be called while it is current
+    if (isCreated())
+        qWarning() << "GPU profiler : destroyed without destroy(), queries leaked";
+}
+
+bool GpuProfiler::create(const QString & trackName)
+{
+    if (!Profiler::isEnabled())
+        return false;
+
+    destroy();
+    if (!initializeOpenGLFunctions())
+    {
+        qWarning() << "GPU profiler : OpenGL 3.3 functions FAILED";
+        return false;
+    }
+
+    glGenQueries(2 * MAX_ZONES, m_queries);
+    // A track per profiler, kept by the Profiler for the export
+    if (!m_track)
+        m_track = Profiler::createTrack(trackName);
+    m_next = 0;
+    m_oldest = 0;
+    m_collects = 0;
+    calibrate();
+    return true;
+}
+
+void GpuProfiler::destroy()
+{
+    if (!isCreated())
+        return;
+
+    glDeleteQueries(2 * MAX_ZONES, m_queries);
+    for (GLuint & query : m_queries)
+        query = 0;
+    m_next = 0;
+    m_oldest = 0;
+}
+
+int GpuProfiler::begin(const char * name)
+{
+    if (!isCreated())
+        return -1;
+    if (m_next - m_oldest >= quint64(MAX_ZONES))
+    {
+        m_dropped++;
+        return -1;
+    }
+
+    const int zone = int(m_next % MAX_ZONES);
+    m_zones[zone].name = name;
+    m_zones[zone].ended = false;
+    glQueryCounter(m_queries[2 * zone], GL_TIMESTAMP);
+    m_next++;
+    return zone;
+}
+
+void GpuProfiler::end(int zone)
+{
+    if (zone < 0 || !isCreated())
+        return;
+
+    glQueryCounter(m_queries[2 * zone + 1], GL_TIMESTAMP);
+    m_zones[zone].ended = true;
+}
+
+void GpuProfiler::collect()
+{
+    if (!isCreated())
+        return;
+
+    if (++m_collects % CALIBRATE_INTERVAL == 0)
+        calibrate();
+
+    // In the order begun: an outer zone holds back its inner zones until it ended too
+    while (m_oldest < m_next)
+    {
+        const int zone = int(m_oldest % MAX_ZONES);
+        if (!m_zones[zone].ended)
+            break;
+
+        // The end timestamp is written after the begin timestamp
+        GLuint available = GL_FALSE;
+        glGetQueryObjectuiv(m_queries[2 * zone + 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            break;
+
+        GLuint64 begin = 0;
+        GLuint64 end = 0;
+        glGetQueryObjectui64v(m_queries[2 * zone], GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(m_queries[2 * zone + 1], GL_QUERY_RESULT, &end);
+        Profiler::record(m_track, m_zones[zone].name, qint64(begin) + m_clockOffset, qint64(end) + m_clockOffset);
+        m_oldest++;
+    }
+}
+
+void GpuProfiler::calibrate()
+{
+    // The current GPU time (not waiting for the queued commands) against the CPU clock
+    GLint64 gpuTime = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpuTime);
+    m_clockOffset = Profiler::now() - qint64(gpuTime);
+}
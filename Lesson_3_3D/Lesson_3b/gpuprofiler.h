@@ -0,0 +1,88 @@
+#pragma once
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "profiler.h"
+
+#include <QOpenGLFunctions_3_3_Core>
+
+///
+/// \brief The GpuProfiler measures zones on the GPU with GL_TIMESTAMP queries
+/// and puts them on a "GPU" track of the Profiler, next to the CPU zones.
+/// A timestamp is written when the GPU reaches the query (zones may nest,
+/// unlike GL_TIME_ELAPSED). The results are collected frames later, once
+/// available, so the CPU never waits. The GPU clock is mapped to Profiler::now()
+/// with a glGetInteger64v(GL_TIMESTAMP) now and then.
+///
+/// Does nothing without LEARNOPENGL_PROFILE. Only call from the OpenGL thread
+/// with the context current; use PROFILE_GPU_SCOPE for the zones.
+///
+class GpuProfiler : protected QOpenGLFunctions_3_3_Core
+{
+public:
+    GpuProfiler() = default;
+    ~GpuProfiler();
+
+    GpuProfiler(const GpuProfiler &) = delete;
+    GpuProfiler & operator=(const GpuProfiler &) = delete;
+
+    bool create(const QString & trackName = QString("GPU"));
+    void destroy();
+    bool isCreated() const { return m_queries[0] != 0; }
+
+    // name: string literal. Returns the zone for end(), -1 if too many are in flight.
+    int begin(const char * name);
+    void end(int zone);
+
+    // Once per frame: move the finished zones to the track, never waits
+    void collect();
+
+    quint64 droppedZones() const { return m_dropped; }
+
+    ///
+    /// \brief GPU zone for the commands issued in the scope (see PROFILE_GPU_SCOPE)
+    ///
+    class Scope
+    {
+    public:
+        Scope(GpuProfiler & profiler, const char * name) : m_profiler(profiler), m_zone(profiler.begin(name)) {}
+        ~Scope() { m_profiler.end(m_zone); }
+
+        Scope(const Scope &) = delete;
+        Scope & operator=(const Scope &) = delete;
+
+    private:
+        GpuProfiler & m_profiler;
+        int m_zone;
+    };
+
+private:
+    static constexpr int MAX_ZONES = 256;
+    static constexpr int CALIBRATE_INTERVAL = 120;     // collect() calls
+
+    struct Zone
+    {
+        const char * name {nullptr};
+        bool ended {false};
+    };
+
+    void calibrate();
+
+    GLuint m_queries[2 * MAX_ZONES] {};     // begin and end timestamp per zone
+    Zone m_zones[MAX_ZONES];
+    quint64 m_next {0};                     // zones begun
+    quint64 m_oldest {0};                   // zones collected
+    quint64 m_dropped {0};
+    Profiler::Track * m_track {nullptr};
+    qint64 m_clockOffset {0};               // Profiler::now() - GPU time
+    int m_collects {0};
+};
@@ -0,0 +1,261 @@
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "heapallocationcounter.h"
+
+#ifdef LEARNOPENGL_COUNT_ALLOCATIONS
+
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    // Plain thread locals and atomics, no constructor, safe inside malloc
+    thread_local bool t_counting = false;
+    std::atomic<bool> s_running {false};
+    std::atomic<quint64> s_allocations {0};
+
+    inline void countAllocation()
+    {
+        if (t_counting)
+            s_allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+#ifdef __GLIBC__
+
+///////////////////////////////////////////////////////////////////////////////
+/// malloc level (glibc): the executable's definitions replace the C library's
+/// for all shared libraries too, the real ones stay reachable as __libc_*
+///////////////////////////////////////////////////////////////////////////////
+
+extern "C"
+{
+    void * __libc_malloc(size_t size);
+    void * __libc_calloc(size_t count, size_t size);
+    void * __libc_realloc(void * p, size_t size);
+    void * __libc_memalign(size_t alignment, size_t size);
+    void * __libc_valloc(size_t size);
+    void * __libc_pvalloc(size_t size);
+
+    void * malloc(size_t size) noexcept
+    {
+        countAllocation();
+        return __libc_malloc(size);
+    }
+
+    void * calloc(size_t count, size_t size) noexcept
+    {
+        countAllocation();
+        return __libc_calloc(count, size);
+    }
+
+    void * realloc(void * p, size_t size) noexcept
+    {
+        countAllocation();
+        return __libc_realloc(p, size);
+    }
+
+    void * memalign(size_t alignment, size_t size) noexcept
+    {
+        countAllocation();
+        return __libc_memalign(alignment, size);
+    }
+
+    void * aligned_alloc(size_t alignment, size_t size) noexcept
+    {
+        countAllocation();
+        return __libc_memalign(alignment, size);
+    }
+
+    int posix_memalign(void ** result, size_t alignment, size_t size) noexcept
+    {
+        if (alignment % sizeof(void *) != 0 || (alignment & (alignment - 1)) != 0)
+            return EINVAL;
+        countAllocation();
+        void * p = __libc_memalign(alignment, size);
+        if (!p)
+            return ENOMEM;
+        *result = p;
+        return 0;
+    }
+
+    void * valloc(size_t size) noexcept
+    {
+        countAllocation();
+        return __libc_valloc(size);
+    }
+
+    void * pvalloc(size_t size) noexcept
+    {
+        countAllocation();
+        return __libc_pvalloc(size);
+    }
+}
+
+bool HeapAllocationCounter::countsMalloc()
+{
+    return true;
+}
+
+#else
+
+///////////////////////////////////////////////////////////////////////////////
+/// operator new level: malloc is not counted (see the class documentation)
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    void * countedAllocate(std::size_t size)
+    {
+        countAllocation();
+        if (size == 0)
+            size = 1;
+        return std::malloc(size);
+    }
+
+    void * countedAllocateAligned(std::size_t size, std::size_t alignment)
+    {
+        countAllocation();
+        if (size == 0)
+            size = 1;
+#ifdef _WIN32
+        return _aligned_malloc(size, alignment);
+#else
+        void * p = nullptr;
+        if (posix_memalign(&p, qMax(alignment, sizeof(void *)), size) != 0)
+            return nullptr;
+        return p;
+#endif
+    }
+
+    void freeAligned(void * p)
+    {
+#ifdef _WIN32
+        _aligned_free(p);
+#else
+        std::free(p);
+#endif
+    }
+}
+
+// Replacements of the global allocation functions (all variants must match)
+void * operator new(std::size_t size)
+{
+    if (void * p = countedAllocate(size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void * operator new[](std::size_t size)
+{
+    if (void * p = countedAllocate(size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void * operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    return countedAllocate(size);
+}
+
+void * operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+    return countedAllocate(size);
+}
+
+void * operator new(std::size_t size, std::align_val_t alignment)
+{
+    if (void * p = countedAllocateAligned(size, std::size_t(alignment)))
+        return p;
+    throw std::bad_alloc();
+}
+
+void * operator new[](std::size_t size, std::align_val_t alignment)
+{
+    if (void * p = countedAllocateAligned(size, std::size_t(alignment)))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void * p) noexcept { std::free(p); }
+void operator delete[](void * p) noexcept { std::free(p); }
+void operator delete(void * p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void * p, std::size_t) noexcept { std::free(p); }
+void operator delete(void * p, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete[](void * p, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete(void * p, std::align_val_t) noexcept { freeAligned(p); }
+void operator delete[](void * p, std::align_val_t) noexcept { freeAligned(p); }
+void operator delete(void * p, std::size_t, std::align_val_t) noexcept { freeAligned(p); }
+void operator delete[](void * p, std::size_t, std::align_val_t) noexcept { freeAligned(p); }
+
+bool HeapAllocationCounter::countsMalloc()
+{
+    return false;
+}
+
+#endif
+
+void HeapAllocationCounter::begin()
+{
+    s_allocations.store(0, std::memory_order_relaxed);
+    s_running.store(true, std::memory_order_release);
+    t_counting = true;
+}
+
+quint64 HeapAllocationCounter::end()
+{
+    t_counting = false;
+    s_running.store(false, std::memory_order_release);
+    return s_allocations.load(std::memory_order_relaxed);
+}
+
+bool HeapAllocationCounter::enterThread()
+{
+    const bool previous = t_counting;
+    t_counting = s_running.load(std::memory_order_acquire);
+    return previous;
+}
+
+void HeapAllocationCounter::leaveThread(bool previous)
+{
+    t_counting = previous;
+}
+
+#else
+
+bool HeapAllocationCounter::countsMalloc()
+{
+    return false;
+}
+
+void HeapAllocationCounter::begin()
+{
+}
+
+quint64 HeapAllocationCounter::end()
+{
+    return 0;
+}
+
+bool HeapAllocationCounter::enterThread()
+{
+    return false;
+}
+
+void HeapAllocationCounter::leaveThread(bool)
+{
+}
+
+#endif
@@ -0,0 +1,72 @@
+#pragma once
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include <QtGlobal>
+
+///
+/// \brief The HeapAllocationCounter counts the heap allocations made between
+/// begin() and end() by the calling thread and by the threads that join the
+/// count with a ThreadScope (the job workers while they run frame jobs).
+/// Only available when built with LEARNOPENGL_COUNT_ALLOCATIONS (CMake option),
+/// otherwise end() returns 0.
+///
+/// With glibc malloc, calloc, realloc and the aligned variants are replaced,
+/// so Qt's own allocations (QString, QByteArray, QList, QImage data) are
+/// counted as well as operator new. Elsewhere only the global operator
+/// new/delete are replaced: allocations through malloc, e.g. the Qt
+/// containers, are NOT counted there.
+/// Allocations of other threads (Qt's threads, background jobs) never count.
+///
+class HeapAllocationCounter
+{
+public:
+    static constexpr bool isEnabled()
+    {
+#ifdef LEARNOPENGL_COUNT_ALLOCATIONS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // True when malloc itself is counted (glibc), not only operator new
+    static bool countsMalloc();
+
+    // Start counting on this thread
+    static void begin();
+
+    // Stop counting and return the number of allocations since begin(),
+    // including those of the threads in a ThreadScope meanwhile
+    static quint64 end();
+
+    ///
+    /// \brief While it lives the allocations of this thread count as well,
+    /// if a count is running. Used by the job workers around frame jobs.
+    ///
+    class ThreadScope
+    {
+    public:
+        ThreadScope() : m_previous(enterThread()) {}
+        ~ThreadScope() { leaveThread(m_previous); }
+
+        ThreadScope(const ThreadScope &) = delete;
+        ThreadScope & operator=(const ThreadScope &) = delete;
+
+    private:
+        bool m_previous;
+    };
+
+private:
+    static bool enterThread();
+    static void leaveThread(bool previous);
+};
@@ -0,0 +1,160 @@
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "inputrecording.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QSaveFile>
+#include <QStringList>
+
+namespace
+{
+    const QByteArray FILE_HEADER = "learnopengl-input 1";
+}
+
+void InputRecording::start(const State & state)
+{
+    m_state = state;
+    m_events.clear();
+    m_frameCount = 0;
+}
+
+void InputRecording::record(quint64 frame, qint64 milliseconds, int key, int modifiers)
+{
+    m_events.push_back(Event{frame, milliseconds, key, modifiers});
+}
+
+void InputRecording::finish(quint64 frameCount)
+{
+    m_frameCount = frameCount;
+}
+
+bool InputRecording::isRecordedKey(int key)
+{
+    switch (key)
+    {
+    // Not the scene: fullscreen, screenshot, capture, trace, overlay, recording
+    case Qt::Key_Escape:
+    case Qt::Key_F1:
+    case Qt::Key_F8:
+    case Qt::Key_F9:
+    case Qt::Key_F10:
+    case Qt::Key_F11:
+    case Qt::Key_F12:
+        return false;
+    default:
+        return true;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// File
+///////////////////////////////////////////////////////////////////////////////
+
+bool InputRecording::save(const QString & fileName) const
+{
+    QByteArray text = FILE_HEADER + '\n';
+    text += QString("state %1 %2 %3 %4 %5 %6\n")
+                .arg(int(m_state.orbitalCamera)).arg(int(m_state.wireframe)).arg(int(m_state.levelOfDetail))
+                .arg(int(m_state.occlusionCulling)).arg(int(m_state.occlusionQueries)).arg(int(m_state.lowTextureBudget))
+                .toLatin1();
+    text += "frames " + QByteArray::number(m_frameCount) + '\n';
+    for (const Event & event : m_events)
+    {
+        text += "key " + QByteArray::number(event.frame) + ' ' + QByteArray::number(event.milliseconds) + ' '
+                + QByteArray::number(event.key) + ' ' + QByteArray::number(event.modifiers) + '\n';
+    }
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly) || file.write(text) != text.size() || !file.commit())
+    {
+        qWarning() << "Input recording : writing" << fileName << "FAILED";
+        return false;
+    }
+    qInfo() << "Input recording :" << m_events.size() << "events in" << m_frameCount << "frames written to" << fileName;
+    return true;
+}
+
+bool InputRecording::load(const QString & fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        qWarning() << "Input recording : opening" << fileName << "FAILED";
+        return false;
+    }
+    const QList<QByteArray> lines = file.readAll().split('\n');
+    if (lines.isEmpty() || lines.first().trimmed() != FILE_HEADER)
+    {
+        qWarning() << "Input recording :" << fileName << "is not an input recording";
+        return false;
+    }
+
+    m_state = State();
+    m_events.clear();
+    m_frameCount = 0;
+    for (int ii = 1; ii < lines.size(); ++ii)
+    {
+        const QList<QByteArray> fields = lines.at(ii).simplified().split(' ');
+        const QByteArray type = fields.first();
+        bool ok = true;
+        if (type.isEmpty())
+        {
+            continue;
+        }
+        else if (type == "state" && fields.size() == 7)
+        {
+            m_state.orbitalCamera = fields.at(1).toInt() != 0;
+            m_state.wireframe = fields.at(2).toInt() != 0;
+            m_state.levelOfDetail = fields.at(3).toInt() != 0;
+            m_state.occlusionCulling = fields.at(4).toInt() != 0;
+            m_state.occlusionQueries = fields.at(5).toInt() != 0;
+            m_state.lowTextureBudget = fields.at(6).toInt() != 0;
+        }
+        else if (type == "frames" && fields.size() == 2)
+        {
+            m_frameCount = fields.at(1).toULongLong(&ok);
+        }
+        else if (type == "key" && fields.size() == 5)
+        {
+            Event event;
+            bool fieldOk[4] = {};
+            event.frame = fields.at(1).toULongLong(&fieldOk[0]);
+            event.milliseconds = fields.at(2).toLongLong(&fieldOk[1]);
+            event.key = fields.at(3).toInt(&fieldOk[2]);
+            event.modifiers = fields.at(4).toInt(&fieldOk[3]);
+            ok = fieldOk[0] && fieldOk[1] && fieldOk[2] && fieldOk[3];
+            // Applied in order, a replay can not go back
+            if (ok && !m_events.empty() && event.frame < m_events.back().frame)
+                ok = false;
+            if (ok)
+                m_events.push_back(event);
+        }
+        else
+        {
+            ok = false;
+        }
+
+        if (!ok)
+        {
+            qWarning() << "Input recording :" << fileName << "bad line" << ii + 1;
+            return false;
+        }
+    }
+
+    // Old or cut files: at least up to the last event
+    if (!m_events.empty())
+        m_frameCount = qMax(m_frameCount, m_events.back().frame + 1);
+    qInfo() << "Input recording :" << m_events.size() << "events in" << m_frameCount << "frames read from" << fileName;
+    return true;
+}
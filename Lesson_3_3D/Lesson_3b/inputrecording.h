@@ -0,0 +1,70 @@
+#pragma once
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include <QString>
+
+#include <vector>
+
+///
+/// \brief The InputRecording holds the key presses of a session with the
+/// frame they arrived in, so a replay applies them at exactly the same frames
+/// (GLWidget advances a simulated clock in fixed steps while replaying). The
+/// toggles the scene started with are part of the recording.
+/// Only keys that change the scene are recorded, not e.g. screenshots.
+///
+/// The file is text, one line per event:
+///   learnopengl-input 1
+///   state <orbital> <wireframe> <lod> <occlusion> <queries> <lowTextureBudget>
+///   frames <count>
+///   key <frame> <milliseconds> <Qt::Key> <Qt::KeyboardModifiers>
+///
+class InputRecording
+{
+public:
+    struct State
+    {
+        bool orbitalCamera {false};
+        bool wireframe {false};
+        bool levelOfDetail {true};
+        bool occlusionCulling {true};
+        bool occlusionQueries {true};
+        bool lowTextureBudget {false};
+    };
+
+    struct Event
+    {
+        quint64 frame {0};          // since the start, applied before this frame
+        qint64 milliseconds {0};    // wall clock when recorded, for information
+        int key {0};
+        int modifiers {0};
+    };
+
+    void start(const State & state);
+    void record(quint64 frame, qint64 milliseconds, int key, int modifiers);
+    void finish(quint64 frameCount);
+
+    bool save(const QString & fileName) const;
+    bool load(const QString & fileName);
+
+    const State & state() const { return m_state; }
+    const std::vector<Event> & events() const { return m_events; }
+    quint64 frameCount() const { return m_frameCount; }
+
+    // Keys that change the scene (camera, cube, render toggles)
+    static bool isRecordedKey(int key);
+
+private:
+    State m_state;
+    std::vector<Event> m_events;
+    quint64 m_frameCount {0};
+};
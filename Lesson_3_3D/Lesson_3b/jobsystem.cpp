@@ -0,0 +1,401 @@
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "jobsystem.h"
+#include "heapallocationcounter.h"
+#include "profiler.h"
+
+#include <QDebug>
+
+#include <chrono>
+
+namespace
+{
+    // Which queue the current thread owns (per job system, there may be several)
+    struct ThreadQueue
+    {
+        const JobSystem * owner {nullptr};
+        int index {0};
+        bool background {false};    // running a background job
+    };
+    thread_local ThreadQueue t_threadQueue;
+
+    struct Task
+    {
+        std::function<void()> function;
+    };
+}
+
+JobSystem::JobSystem(int workerCount)
+{
+    if (workerCount <= 0)
+    {
+        // The submitting thread helps out while waiting, so leave one core for it
+        int hardwareThreads = int(std::thread::hardware_concurrency());
+        workerCount = qMax(1, hardwareThreads - 1);
+    }
+
+    m_queues.reserve(workerCount + 1);
+    for (int ii = 0; ii < workerCount + 1; ++ii)
+        m_queues.push_back(std::make_unique<WorkQueue>());
+    m_background = std::make_unique<WorkQueue>();
+
+    m_workers.reserve(workerCount);
+    for (int ii = 0; ii < workerCount; ++ii)
+        m_workers.emplace_back(&JobSystem::workerLoop, this, ii + 1);
+
+    qInfo() << "Job system : started" << workerCount << "worker threads";
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_quit = true;
+    }
+    m_wakeUp.notify_all();
+    for (std::thread & worker : m_workers)
+        worker.join();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Submit
+///////////////////////////////////////////////////////////////////////////////
+
+void JobSystem::submit(const Job & job)
+{
+    if (job.counter)
+        job.counter->m_pending.fetch_add(1, std::memory_order_relaxed);
+    enqueue(job);
+}
+
+void JobSystem::submitBackground(const Job & job)
+{
+    if (job.counter)
+        job.counter->m_pending.fetch_add(1, std::memory_order_relaxed);
+    enqueueBackground(job);
+}
+
+void JobSystem::enqueue(const Job & job)
+{
+    // Work of a background job stays background work
+    if (inBackgroundJob())
+    {
+        enqueueBackground(job);
+        return;
+    }
+
+    const int queueIndex = currentQueueIndex();
+    WorkQueue & queue = *m_queues[queueIndex];
+    if (!push(queue, job))
+    {
+        // Queue full - just do it now
+        queue.inlineExecuted.fetch_add(1, std::memory_order_relaxed);
+        execute(job, queueIndex);
+        return;
+    }
+
+    m_queuedJobs.fetch_add(1, std::memory_order_release);
+    m_wakeUp.notify_one();
+}
+
+void JobSystem::enqueueBackground(const Job & job)
+{
+    if (!push(*m_background, job))
+    {
+        // Queue full - just do it now (on a non worker thread as well)
+        const int queueIndex = currentQueueIndex();
+        m_queues[queueIndex]->inlineExecuted.fetch_add(1, std::memory_order_relaxed);
+        executeBackground(job, queueIndex);
+        return;
+    }
+
+    m_queuedBackgroundJobs.fetch_add(1, std::memory_order_release);
+    m_wakeUp.notify_one();
+}
+
+void JobSystem::runAfter(JobCounter & dependency, const Job & job)
+{
+    {
+        std::lock_guard<std::mutex> lock(dependency.m_mutex);
+        if (!dependency.isDone())
+        {
+            // The job counts as pending from now on
+            if (job.counter)
+                job.counter->m_pending.fetch_add(1, std::memory_order_relaxed);
+            if (dependency.m_continuationCount < JobCounter::INLINE_CONTINUATIONS)
+                dependency.m_continuations[dependency.m_continuationCount++] = job;
+            else
+                dependency.m_moreContinuations.push_back(job);
+            return;
+        }
+    }
+    submit(job);
+}
+
+void JobSystem::run(std::function<void()> task, JobCounter * counter)
+{
+    Job job;
+    job.function = &JobSystem::invokeTask;
+    job.data = new Task{std::move(task)};
+    job.counter = counter;
+    submitBackground(job);
+}
+
+void JobSystem::invokeTask(void * data, int, int)
+{
+    std::unique_ptr<Task> task(static_cast<Task *>(data));
+    task->function();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Execute
+///////////////////////////////////////////////////////////////////////////////
+
+void JobSystem::wait(JobCounter & counter)
+{
+    // Only a background job may help with other background jobs, the frame
+    // (non worker threads and frame jobs) must not be held up by them
+    const int queueIndex = currentQueueIndex();
+    const bool background = inBackgroundJob();
+    while (!counter.isDone())
+    {
+        Job job;
+        if (findJob(queueIndex, job))
+            execute(job, queueIndex);
+        else if (background && findBackgroundJob(job))
+            executeBackground(job, queueIndex);
+        else
+            std::this_thread::yield();
+    }
+
+    // The last finishing job may still hold the counter lock, make sure it is
+    // released before the caller destroys the counter
+    std::lock_guard<std::mutex> lock(counter.m_mutex);
+}
+
+void JobSystem::workerLoop(int queueIndex)
+{
+    Profiler::setThreadName(QString("Job worker %1").arg(queueIndex));
+    t_threadQueue.owner = this;
+    t_threadQueue.index = queueIndex;
+
+    while (!m_quit.load(std::memory_order_acquire))
+    {
+        // Frame jobs first, background jobs when there are none
+        Job job;
+        if (findJob(queueIndex, job))
+        {
+            execute(job, queueIndex);
+            continue;
+        }
+        if (findBackgroundJob(job))
+        {
+            executeBackground(job, queueIndex);
+            continue;
+        }
+
+        // Nothing to do - sleep until new work arrives (with timeout as safety net)
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_wakeUp.wait_for(lock, std::chrono::milliseconds(2), [this] {
+            return m_quit.load(std::memory_order_acquire) || m_queuedJobs.load(std::memory_order_acquire) > 0 ||
+                   m_queuedBackgroundJobs.load(std::memory_order_acquire) > 0;
+        });
+    }
+}
+
+int JobSystem::currentQueueIndex() const
+{
+    return t_threadQueue.owner == this ? t_threadQueue.index : 0;
+}
+
+bool JobSystem::inBackgroundJob() const
+{
+    return t_threadQueue.owner == this && t_threadQueue.background;
+}
+
+void JobSystem::execute(const Job & job, int queueIndex)
+{
+    // Frame jobs count into the allocations of a running frame (background jobs never do)
+    HeapAllocationCounter::ThreadScope countAllocations;
+    job.function(job.data, job.begin, job.end);
+    m_queues[queueIndex]->jobsExecuted.fetch_add(1, std::memory_order_relaxed);
+    finish(job.counter);
+}
+
+void JobSystem::executeBackground(const Job & job, int queueIndex)
+{
+    // Only the inline fallback of a full queue runs here on a non worker thread
+    const bool owned = t_threadQueue.owner == this;
+    const bool wasBackground = t_threadQueue.background;
+    if (owned)
+        t_threadQueue.background = true;
+    job.function(job.data, job.begin, job.end);
+    m_queues[queueIndex]->jobsExecuted.fetch_add(1, std::memory_order_relaxed);
+    // The dependent jobs it releases are background jobs too
+    finish(job.counter);
+    if (owned)
+        t_threadQueue.background = wasBackground;
+}
+
+void JobSystem::finish(JobCounter * counter)
+{
+    if (!counter)
+        return;
+
+    // Last job of the group releases the dependent jobs
+    Job continuations[JobCounter::INLINE_CONTINUATIONS];
+    int continuationCount = 0;
+    std::vector<Job> moreContinuations;
+    {
+        std::lock_guard<std::mutex> lock(counter->m_mutex);
+        if (counter->m_pending.fetch_sub(1, std::memory_order_acq_rel) != 1)
+            return;
+        continuationCount = counter->m_continuationCount;
+        for (int ii = 0; ii < continuationCount; ++ii)
+            continuations[ii] = counter->m_continuations[ii];
+        counter->m_continuationCount = 0;
+        moreContinuations.swap(counter->m_moreContinuations);
+    }
+
+    // Already counted in runAfter
+    for (int ii = 0; ii < continuationCount; ++ii)
+        enqueue(continuations[ii]);
+    for (const Job & job : moreContinuations)
+        enqueue(job);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Queues
+///////////////////////////////////////////////////////////////////////////////
+
+void JobSystem::lock(WorkQueue & queue)
+{
+    if (queue.mutex.try_lock())
+        return;
+    queue.lockContended.fetch_add(1, std::memory_order_relaxed);
+    queue.mutex.lock();
+}
+
+bool JobSystem::push(WorkQueue & queue, const Job & job)
+{
+    lock(queue);
+    if (queue.count == WorkQueue::CAPACITY)
+    {
+        queue.mutex.unlock();
+        return false;
+    }
+    queue.jobs[(queue.head + queue.count) % WorkQueue::CAPACITY] = job;
+    queue.count++;
+    queue.mutex.unlock();
+    return true;
+}
+
+bool JobSystem::popBack(WorkQueue & queue, Job & job)
+{
+    lock(queue);
+    if (queue.count == 0)
+    {
+        queue.mutex.unlock();
+        return false;
+    }
+    queue.count--;
+    job = queue.jobs[(queue.head + queue.count) % WorkQueue::CAPACITY];
+    queue.mutex.unlock();
+    return true;
+}
+
+bool JobSystem::stealFront(WorkQueue & queue, Job & job)
+{
+    lock(queue);
+    if (queue.count == 0)
+    {
+        queue.mutex.unlock();
+        return false;
+    }
+    job = queue.jobs[queue.head];
+    queue.head = (queue.head + 1) % WorkQueue::CAPACITY;
+    queue.count--;
+    queue.mutex.unlock();
+    return true;
+}
+
+bool JobSystem::findJob(int queueIndex, Job & job)
+{
+    if (m_queuedJobs.load(std::memory_order_acquire) <= 0)
+        return false;
+
+    // Own work first
+    WorkQueue & own = *m_queues[queueIndex];
+    if (popBack(own, job))
+    {
+        m_queuedJobs.fetch_sub(1, std::memory_order_acq_rel);
+        return true;
+    }
+
+    // Then steal, starting at the neighbour to spread the thieves
+    const int queueCount = int(m_queues.size());
+    for (int ii = 1; ii < queueCount; ++ii)
+    {
+        WorkQueue & victim = *m_queues[(queueIndex + ii) % queueCount];
+        own.stealAttempts.fetch_add(1, std::memory_order_relaxed);
+        if (stealFront(victim, job))
+        {
+            own.jobsStolen.fetch_add(1, std::memory_order_relaxed);
+            m_queuedJobs.fetch_sub(1, std::memory_order_acq_rel);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool JobSystem::findBackgroundJob(Job & job)
+{
+    if (m_queuedBackgroundJobs.load(std::memory_order_acquire) <= 0)
+        return false;
+
+    // Oldest first, the background queue has no owner
+    if (!stealFront(*m_background, job))
+        return false;
+    m_queuedBackgroundJobs.fetch_sub(1, std::memory_order_acq_rel);
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Statistics
+///////////////////////////////////////////////////////////////////////////////
+
+JobSystem::Statistics JobSystem::statistics() const
+{
+    Statistics stats;
+    for (const auto & queue : m_queues)
+    {
+        stats.jobsExecuted += queue->jobsExecuted.load(std::memory_order_relaxed);
+        stats.jobsStolen += queue->jobsStolen.load(std::memory_order_relaxed);
+        stats.stealAttempts += queue->stealAttempts.load(std::memory_order_relaxed);
+        stats.lockContended += queue->lockContended.load(std::memory_order_relaxed);
+        stats.inlineExecuted += queue->inlineExecuted.load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+void JobSystem::resetStatistics()
+{
+    for (const auto & queue : m_queues)
+    {
+        queue->jobsExecuted = 0;
+        queue->jobsStolen = 0;
+        queue->stealAttempts = 0;
+        queue->lockContended = 0;
+        queue->inlineExecuted = 0;
+    }
+}
@@ -0,0 +1,204 @@
+#pragma once
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include <QtGlobal>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class JobSystem;
+
+///
+/// \brief A job is a plain function pointer with a data pointer and an index
+/// range, so submitting a job never allocates. The data must stay alive until
+/// the job has finished (wait on its counter).
+///
+using JobFunction = void (*)(void * data, int begin, int end);
+
+struct Job
+{
+    JobFunction function {nullptr};
+    void * data {nullptr};
+    int begin {0};
+    int end {0};
+    class JobCounter * counter {nullptr};
+};
+
+///
+/// \brief Counts the unfinished jobs of a group. Wait on it with JobSystem::wait.
+/// Jobs added with JobSystem::runAfter are only started when the counter is done,
+/// which is how dependencies between job groups are expressed.
+///
+class JobCounter
+{
+public:
+    JobCounter() = default;
+    JobCounter(const JobCounter &) = delete;
+    JobCounter & operator=(const JobCounter &) = delete;
+
+    bool isDone() const { return m_pending.load(std::memory_order_acquire) == 0; }
+
+private:
+    friend class JobSystem;
+
+    // A few dependent jobs are kept inline so the usual case does not allocate
+    static constexpr int INLINE_CONTINUATIONS = 8;
+
+    std::atomic<int> m_pending {0};
+    std::mutex m_mutex;
+    Job m_continuations[INLINE_CONTINUATIONS];
+    int m_continuationCount {0};
+    std::vector<Job> m_moreContinuations;
+};
+
+///
+/// \brief The JobSystem is a work stealing scheduler.
+/// Every worker thread owns a job queue; it pushes and pops its own jobs at the
+/// back (LIFO, cache warm) and steals from the front of the other queues when
+/// it runs dry. Threads that are not workers (e.g. the GUI/OpenGL thread)
+/// submit into a shared frame queue and help executing frame jobs while they
+/// wait, so nothing blocks idle. Only the OpenGL thread may call OpenGL
+/// functions, jobs must only prepare data (cull, transform, sort, decode).
+///
+/// Background jobs (submitBackground, run: decoding, file writing) go into a
+/// separate queue that only the workers take from, after the frame jobs.
+/// Jobs submitted while a background job runs are background jobs as well,
+/// so a thread waiting in the frame never picks up background work.
+/// One JobSystem is shared by the whole process (ResourceManager::jobs).
+///
+class JobSystem
+{
+public:
+    // workerCount 0 means one worker per hardware thread minus the calling thread
+    explicit JobSystem(int workerCount = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem &) = delete;
+    JobSystem & operator=(const JobSystem &) = delete;
+
+    int workerCount() const { return int(m_workers.size()); }
+
+    // Schedule a single job, counter may be null (fire and forget)
+    void submit(const Job & job);
+
+    // Schedule a job for the workers only, never run by a waiting non worker thread
+    void submitBackground(const Job & job);
+
+    // Schedule the job once the dependency counter is done
+    void runAfter(JobCounter & dependency, const Job & job);
+
+    // Convenience for one-off background tasks like asset loading or saving
+    // (allocates, not for per-frame use)
+    void run(std::function<void()> task, JobCounter * counter = nullptr);
+
+    // Split [0, count) into chunks of grainSize and call func(begin, end) for each.
+    // The func object must stay alive until the counter is done.
+    template<typename Func>
+    void parallelFor(int count, int grainSize, const Func & func, JobCounter & counter)
+    {
+        grainSize = qMax(1, grainSize);
+        for (int begin = 0; begin < count; begin += grainSize)
+        {
+            Job job;
+            job.function = &JobSystem::invokeRange<Func>;
+            job.data = const_cast<Func *>(&func);
+            job.begin = begin;
+            job.end = qMin(count, begin + grainSize);
+            job.counter = &counter;
+            submit(job);
+        }
+    }
+
+    // Blocking version, the calling thread helps until all chunks are done
+    template<typename Func>
+    void parallelFor(int count, int grainSize, const Func & func)
+    {
+        JobCounter counter;
+        parallelFor(count, grainSize, func, counter);
+        wait(counter);
+    }
+
+    // Execute jobs until the counter is done, a non worker thread only helps
+    // with the frame jobs and yields while the counter waits for background jobs
+    void wait(JobCounter & counter);
+
+    ///
+    /// \brief Scheduler counters to judge the scaling (see Benchmark "jobs")
+    ///
+    struct Statistics
+    {
+        quint64 jobsExecuted {0};
+        quint64 jobsStolen {0};
+        quint64 stealAttempts {0};   // all tries on other queues, successful or not
+        quint64 lockContended {0};   // queue lock was already held by another thread
+        quint64 inlineExecuted {0};  // queue was full, job ran on the submitting thread
+    };
+    Statistics statistics() const;
+    void resetStatistics();
+
+private:
+    // Fixed size ring buffer, so the steady state never allocates
+    struct WorkQueue
+    {
+        static constexpr int CAPACITY = 4096;
+        std::mutex mutex;
+        Job jobs[CAPACITY];
+        int head {0};   // steal end (oldest)
+        int count {0};
+
+        std::atomic<quint64> jobsExecuted {0};
+        std::atomic<quint64> jobsStolen {0};
+        std::atomic<quint64> stealAttempts {0};
+        std::atomic<quint64> lockContended {0};
+        std::atomic<quint64> inlineExecuted {0};
+    };
+
+    template<typename Func>
+    static void invokeRange(void * data, int begin, int end)
+    {
+        (*static_cast<const Func *>(data))(begin, end);
+    }
+
+    static void invokeTask(void * data, int begin, int end);
+
+    void enqueue(const Job & job);
+    void enqueueBackground(const Job & job);
+    void workerLoop(int queueIndex);
+    int currentQueueIndex() const;
+    bool inBackgroundJob() const;
+    void lock(WorkQueue & queue);
+    bool push(WorkQueue & queue, const Job & job);
+    bool popBack(WorkQueue & queue, Job & job);
+    bool stealFront(WorkQueue & queue, Job & job);
+    bool findJob(int queueIndex, Job & job);
+    bool findBackgroundJob(Job & job);
+    void execute(const Job & job, int queueIndex);
+    void executeBackground(const Job & job, int queueIndex);
+    void finish(JobCounter * counter);
+
+    // Queue 0 is shared by all non worker threads, queue i+1 belongs to worker i
+    std::vector<std::unique_ptr<WorkQueue>> m_queues;
+    std::unique_ptr<WorkQueue> m_background;
+    std::vector<std::thread> m_workers;
+
+    std::atomic<int> m_queuedJobs {0};
+    std::atomic<int> m_queuedBackgroundJobs {0};
+    std::atomic<bool> m_quit {false};
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wakeUp;
+};
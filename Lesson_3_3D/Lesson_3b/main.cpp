@@ -11,19 +11,111 @@
 //-----------------------------------------------------------------------------
 
 #include "mainwindow.h"
+#include "benchmark.h"
+#include "benchmarkresults.h"
+#include "glwidget.h"
+#include "resourcemanager.h"
+#include "profiler.h"
 
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QDebug>
 #include <QSurfaceFormat>
 #include <QOpenGLContext>
 
 int main(int argc, char *argv[])
 {
+    // All widgets share their textures and programs (see ResourceManager),
+    // must be set before the application object is created
+    QCoreApplication::setAttribute(Qt::AA_ShareOpenGLContexts);
     QApplication a(argc, argv);
+    Profiler::setThreadName("Main (GUI / OpenGL)");
 
     QCoreApplication::setApplicationName("Qt QOpenGLWidget Lesson 2a");
     QCoreApplication::setOrganizationName("Bla");
     QCoreApplication::setApplicationVersion(QT_VERSION_STR);
 
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption benchmarkOption("benchmark",
+                                       QString("Run a benchmark and quit (%1).").arg(Benchmark::names().join(", ")),
+                                       "name");
+    parser.addOption(benchmarkOption);
+    QCommandLineOption seedOption("seed",
+                                  "Seed of the generated benchmark scenes (default 1).",
+                                  "number");
+    parser.addOption(seedOption);
+    QCommandLineOption benchmarkResultsOption("benchmark-results",
+                                              "Write the samples of the benchmark into this JSON file (a baseline for --compare).",
+                                              "file");
+    parser.addOption(benchmarkResultsOption);
+    QCommandLineOption compareOption("compare",
+                                     "Compare the results files given as arguments (repeated runs are merged) with this baseline and quit, exit code 1 on a regression.",
+                                     "baseline");
+    parser.addOption(compareOption);
+    QCommandLineOption thresholdOption("threshold",
+                                       "Allowed growth of a median in percent (default 5), for one metric as name=percent. Can be repeated.",
+                                       "percent");
+    parser.addOption(thresholdOption);
+    QCommandLineOption alphaOption("alpha",
+                                   "Significance level of the Mann-Whitney test of --compare (default 0.01).",
+                                   "alpha");
+    parser.addOption(alphaOption);
+    parser.addPositionalArgument("results", "Results files to compare (--compare).", "[results...]");
+    QCommandLineOption shaderDirectoryOption("shader-dir",
+                                             "Load the shaders from this directory and reload them when they change (development).",
+                                             "directory");
+    parser.addOption(shaderDirectoryOption);
+    QCommandLineOption textureBudgetOption("texture-budget",
+                                           "GPU memory for the streamed texture levels in MB (default 32).",
+                                           "megabytes");
+    parser.addOption(textureBudgetOption);
+    QCommandLineOption captureFormatOption("capture-format",
+                                           "Format of the F9 frame capture: raw (default, lossless), png or y4m (lossy YCbCr).",
+                                           "format");
+    parser.addOption(captureFormatOption);
+    QCommandLineOption traceOption("trace",
+                                   "Write the profiler zones (Chrome trace JSON) into this file at exit.",
+                                   "file");
+    parser.addOption(traceOption);
+    QCommandLineOption replayOption("replay",
+                                    "Replay an input recording (F12) at fixed time steps, then quit.",
+                                    "file");
+    parser.addOption(replayOption);
+    QCommandLineOption replayUnlimitedOption("replay-unlimited",
+                                             "Replay as fast as possible (no update interval, no vsync).");
+    parser.addOption(replayUnlimitedOption);
+    QCommandLineOption replayResultsOption("replay-results",
+                                           "Write the frame times of the replay into this JSON file (a baseline for --compare).",
+                                           "file");
+    parser.addOption(replayResultsOption);
+    QCommandLineOption headlessOption("headless",
+                                      "Replay without showing a window (needs --replay).");
+    parser.addOption(headlessOption);
+    parser.process(a);
+
+    // Comparison of results files, no OpenGL needed
+    if (parser.isSet(compareOption))
+    {
+        BenchmarkResults::Thresholds thresholds;
+        for (const QString & threshold : parser.values(thresholdOption))
+        {
+            const int separator = threshold.lastIndexOf('=');
+            if (separator < 0)
+                thresholds.percent = threshold.toDouble();
+            else
+                thresholds.metricPercent[threshold.left(separator)] = threshold.mid(separator + 1).toDouble();
+        }
+        if (parser.isSet(alphaOption))
+            thresholds.alpha = parser.value(alphaOption).toDouble();
+        if (parser.positionalArguments().isEmpty())
+        {
+            qWarning() << "--compare needs the results files to compare";
+            return 2;
+        }
+        return BenchmarkResults::compareFiles(parser.value(compareOption), parser.positionalArguments(), thresholds);
+    }
+
     //! [1]
     QSurfaceFormat format;
     format.setDepthBufferSize(24);
@@ -42,12 +134,73 @@ int main(int argc, char *argv[])
         format.setVersion(3, 0);
     }
 
+    // Replays measure the rendering, not the display
+    if (parser.isSet(replayUnlimitedOption) || parser.isSet(headlessOption))
+        format.setSwapInterval(0);
+
     QSurfaceFormat::setDefaultFormat(format);
     //! [1]
 
-    MainWindow mw;
-    mw.resize(1200, 800);
-    mw.show();
+    // Benchmarks use the same (default) surface format for their offscreen context
+    if (parser.isSet(benchmarkOption))
+    {
+        if (parser.isSet(seedOption))
+            Benchmark::setSeed(parser.value(seedOption).toUInt());
+        if (parser.isSet(benchmarkResultsOption))
+            Benchmark::setResultsFile(parser.value(benchmarkResultsOption));
+        const int result = Benchmark::run(parser.value(benchmarkOption));
+        ResourceManager::instance().shutdown();
+        return result;
+    }
+
+    if (parser.isSet(shaderDirectoryOption))
+        GLWidget::setShaderDirectory(parser.value(shaderDirectoryOption));
+    if (parser.isSet(textureBudgetOption))
+        GLWidget::setTextureBudget(qint64(parser.value(textureBudgetOption).toDouble() * 1024.0 * 1024.0));
+    if (parser.isSet(captureFormatOption))
+    {
+        bool ok = false;
+        GLWidget::setCaptureFormat(FrameCapture::formatFromName(parser.value(captureFormatOption), &ok));
+        if (!ok)
+            qWarning() << "Unknown capture format" << parser.value(captureFormatOption) << "- using raw";
+    }
+
+    if (parser.isSet(headlessOption) && !parser.isSet(replayOption))
+    {
+        qWarning() << "--headless needs --replay";
+        return 1;
+    }
+    if (parser.isSet(replayOption))
+    {
+        GLWidget::ReplayOptions replay;
+        replay.fileName = parser.value(replayOption);
+        replay.unlimitedSpeed = parser.isSet(replayUnlimitedOption) || parser.isSet(headlessOption);
+        replay.headless = parser.isSet(headlessOption);
+        replay.resultsFile = parser.value(replayResultsOption);
+        GLWidget::setReplay(replay);
+    }
+
+    int result = 0;
+    if (parser.isSet(headlessOption))
+    {
+        // Rendered into the widget's framebuffer object only
+        GLWidget widget(nullptr);
+        widget.setAttribute(Qt::WA_DontShowOnScreen);
+        widget.resize(1200, 800);
+        widget.show();
+        result = widget.runHeadlessReplay();
+    }
+    else
+    {
+        MainWindow mw;
+        mw.resize(1200, 800);
+        mw.show();
+        result = a.exec();
+    }
 
-    return a.exec();
+    // The widgets are gone, free what they did not release with the application still there
+    ResourceManager::instance().shutdown();
+    if (parser.isSet(traceOption))
+        Profiler::writeChromeTrace(parser.value(traceOption));
+    return result;
 }
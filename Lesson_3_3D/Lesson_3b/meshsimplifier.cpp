@@ -0,0 +1,378 @@
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "meshsimplifier.h"
+
+#include <QDebug>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace
+{
+    ///
+    /// Sum of squared distances to planes: Q(p) = p'Ap + 2b'p + c
+    ///
+    struct Quadric
+    {
+        double a00 {0}, a01 {0}, a02 {0}, a11 {0}, a12 {0}, a22 {0};
+        double b0 {0}, b1 {0}, b2 {0};
+        double c {0};
+        double weight {0};
+
+        // Plane n.p + d = 0 with a unit normal
+        void addPlane(double nx, double ny, double nz, double d, double planeWeight)
+        {
+            a00 += planeWeight * nx * nx; a01 += planeWeight * nx * ny; a02 += planeWeight * nx * nz;
+            a11 += planeWeight * ny * ny; a12 += planeWeight * ny * nz; a22 += planeWeight * nz * nz;
+            b0 += planeWeight * nx * d; b1 += planeWeight * ny * d; b2 += planeWeight * nz * d;
+            c += planeWeight * d * d;
+            weight += planeWeight;
+        }
+
+        void add(const Quadric & other)
+        {
+            a00 += other.a00; a01 += other.a01; a02 += other.a02;
+            a11 += other.a11; a12 += other.a12; a22 += other.a22;
+            b0 += other.b0; b1 += other.b1; b2 += other.b2;
+            c += other.c;
+            weight += other.weight;
+        }
+
+        // Mean squared distance (area weighted) of the point to the planes
+        double evaluate(const float * p) const
+        {
+            const double x = p[0], y = p[1], z = p[2];
+            const double result = a00 * x * x + a11 * y * y + a22 * z * z
+                                  + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z)
+                                  + 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+            return weight > 0.0 ? std::fabs(result) / weight : 0.0;
+        }
+    };
+
+    void triangleNormal(const float * p0, const float * p1, const float * p2, double normal[3])
+    {
+        const double e1[3] = { double(p1[0]) - p0[0], double(p1[1]) - p0[1], double(p1[2]) - p0[2] };
+        const double e2[3] = { double(p2[0]) - p0[0], double(p2[1]) - p0[1], double(p2[2]) - p0[2] };
+        normal[0] = e1[1] * e2[2] - e1[2] * e2[1];
+        normal[1] = e1[2] * e2[0] - e1[0] * e2[2];
+        normal[2] = e1[0] * e2[1] - e1[1] * e2[0];
+    }
+
+    quint64 edgeKey(quint32 from, quint32 to)
+    {
+        return (quint64(from) << 32) | to;
+    }
+
+    struct Collapse
+    {
+        quint32 from;
+        quint32 to;
+        double error;   // squared distance to the surface
+        double cost;    // error and texture coordinate stretch, the order of the collapses
+    };
+}
+
+MeshSimplifier::MeshSimplifier(const float * vertices, int vertexCount, int floatStride)
+    : MeshSimplifier(vertices, vertexCount, floatStride, Options())
+{
+}
+
+MeshSimplifier::MeshSimplifier(const float * vertices, int vertexCount, int floatStride, const Options & options)
+    : m_vertices(vertices)
+    , m_vertexCount(vertexCount)
+    , m_floatStride(floatStride)
+    , m_options(options)
+{
+    Q_ASSERT(floatStride >= 3);
+    if (m_options.texCoordOffset + 2 > floatStride)
+        m_options.texCoordOffset = -1;
+
+    // Vertices at the same position are wedges of one corner (seams)
+    struct PositionKey
+    {
+        quint32 bits[3];
+        bool operator==(const PositionKey & other) const { return memcmp(bits, other.bits, sizeof(bits)) == 0; }
+    };
+    struct PositionHash
+    {
+        size_t operator()(const PositionKey & key) const
+        {
+            return size_t(key.bits[0] * 73856093u ^ key.bits[1] * 19349663u ^ key.bits[2] * 83492791u);
+        }
+    };
+    std::unordered_map<PositionKey, quint32, PositionHash> firstVertex;
+    firstVertex.reserve(size_t(vertexCount));
+    m_positionRemap.resize(size_t(vertexCount));
+    m_wedgeCount.assign(size_t(vertexCount), 0);
+
+    float minimum[3] = { 1.0e30f, 1.0e30f, 1.0e30f };
+    float maximum[3] = { -1.0e30f, -1.0e30f, -1.0e30f };
+    for (int vv = 0; vv < vertexCount; ++vv)
+    {
+        const float * p = position(quint32(vv));
+        PositionKey key;
+        memcpy(key.bits, p, sizeof(key.bits));
+        auto inserted = firstVertex.emplace(key, quint32(vv));
+        m_positionRemap[vv] = inserted.first->second;
+        m_wedgeCount[inserted.first->second]++;
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            minimum[axis] = std::min(minimum[axis], p[axis]);
+            maximum[axis] = std::max(maximum[axis], p[axis]);
+        }
+    }
+    if (vertexCount > 0)
+    {
+        const float dx = maximum[0] - minimum[0], dy = maximum[1] - minimum[1], dz = maximum[2] - minimum[2];
+        m_meshSize = std::max(std::sqrt(dx * dx + dy * dy + dz * dz), 1.0e-6f);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Simplify
+///////////////////////////////////////////////////////////////////////////////
+
+std::vector<quint16> MeshSimplifier::simplify(const std::vector<quint16> & indices, size_t targetIndexCount,
+                                              float maxError, float * resultError) const
+{
+    std::vector<quint32> triangles(indices.begin(), indices.end() - indices.size() % 3);
+    double reachedError = 0.0;
+    const double maxErrorSquared = double(maxError) * double(maxError);
+
+    // Open edges in position space, an edge is open if no triangle uses it in the other direction
+    std::unordered_set<quint64> directedEdges;
+    directedEdges.reserve(triangles.size());
+    for (size_t tt = 0; tt < triangles.size(); tt += 3)
+    {
+        for (int ee = 0; ee < 3; ++ee)
+            directedEdges.insert(edgeKey(m_positionRemap[triangles[tt + ee]], m_positionRemap[triangles[tt + (ee + 1) % 3]]));
+    }
+    auto isBorderEdge = [&directedEdges](quint32 a, quint32 b) {
+        return directedEdges.count(edgeKey(b, a)) == 0;
+    };
+
+    std::vector<Kind> kinds(size_t(m_vertexCount), Kind::Manifold);
+    for (int vv = 0; vv < m_vertexCount; ++vv)
+    {
+        if (m_wedgeCount[m_positionRemap[vv]] > 1)
+            kinds[vv] = Kind::Seam;
+    }
+    for (size_t tt = 0; tt < triangles.size(); tt += 3)
+    {
+        for (int ee = 0; ee < 3; ++ee)
+        {
+            const quint32 a = triangles[tt + ee];
+            const quint32 b = triangles[tt + (ee + 1) % 3];
+            if (!isBorderEdge(m_positionRemap[a], m_positionRemap[b]))
+                continue;
+            for (quint32 vertex : { a, b })
+            {
+                if (kinds[vertex] == Kind::Manifold)
+                    kinds[vertex] = m_options.lockBorder ? Kind::Locked : Kind::Border;
+            }
+        }
+    }
+
+    // Area weighted plane quadrics per position
+    std::vector<Quadric> quadrics(static_cast<size_t>(m_vertexCount));
+    for (size_t tt = 0; tt < triangles.size(); tt += 3)
+    {
+        const float * p0 = position(triangles[tt]);
+        double normal[3];
+        triangleNormal(p0, position(triangles[tt + 1]), position(triangles[tt + 2]), normal);
+        const double length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        if (length <= 0.0)
+            continue;
+        const double nx = normal[0] / length, ny = normal[1] / length, nz = normal[2] / length;
+        const double d = -(nx * p0[0] + ny * p0[1] + nz * p0[2]);
+        for (int cc = 0; cc < 3; ++cc)
+            quadrics[m_positionRemap[triangles[tt + cc]]].addPlane(nx, ny, nz, d, length * 0.5);
+    }
+
+    const double texCoordScale = double(m_options.texCoordWeight) * m_meshSize;
+    auto makeCollapse = [&](quint32 from, quint32 to) {
+        Quadric quadric = quadrics[m_positionRemap[from]];
+        quadric.add(quadrics[m_positionRemap[to]]);
+        Collapse collapse { from, to, quadric.evaluate(position(to)), 0.0 };
+        collapse.cost = collapse.error;
+        if (m_options.texCoordOffset >= 0)
+        {
+            const float * uvFrom = texCoord(from);
+            const float * uvTo = texCoord(to);
+            const double du = (double(uvFrom[0]) - uvTo[0]) * texCoordScale;
+            const double dv = (double(uvFrom[1]) - uvTo[1]) * texCoordScale;
+            collapse.cost += du * du + dv * dv;
+        }
+        return collapse;
+    };
+    auto canCollapse = [&](quint32 from, quint32 to) {
+        switch (kinds[from])
+        {
+        case Kind::Manifold:
+            return true;
+        case Kind::Border:
+            // Only along the border onto another border vertex
+            return kinds[to] != Kind::Manifold &&
+                   (isBorderEdge(m_positionRemap[from], m_positionRemap[to]) || isBorderEdge(m_positionRemap[to], m_positionRemap[from]));
+        default:
+            return false;
+        }
+    };
+
+    std::vector<quint32> collapseTo(static_cast<size_t>(m_vertexCount));
+    std::vector<char> touched(static_cast<size_t>(m_vertexCount));
+    std::vector<quint32> triangleOffsets;
+    std::vector<quint32> vertexTriangles;
+    std::vector<Collapse> candidates;
+
+    const int maxPasses = 100;
+    for (int pass = 0; pass < maxPasses && triangles.size() > targetIndexCount; ++pass)
+    {
+        // Triangles around each vertex
+        triangleOffsets.assign(size_t(m_vertexCount) + 1, 0);
+        for (quint32 index : triangles)
+            triangleOffsets[index + 1]++;
+        for (int vv = 0; vv < m_vertexCount; ++vv)
+            triangleOffsets[vv + 1] += triangleOffsets[vv];
+        vertexTriangles.resize(triangles.size());
+        std::vector<quint32> fill(triangleOffsets.begin(), triangleOffsets.end() - 1);
+        for (size_t ii = 0; ii < triangles.size(); ++ii)
+            vertexTriangles[fill[triangles[ii]]++] = quint32(ii / 3);
+
+        // Both directions of every edge, cheapest first
+        candidates.clear();
+        for (size_t tt = 0; tt < triangles.size(); tt += 3)
+        {
+            for (int ee = 0; ee < 3; ++ee)
+            {
+                const quint32 a = triangles[tt + ee];
+                const quint32 b = triangles[tt + (ee + 1) % 3];
+                if (canCollapse(a, b))
+                    candidates.push_back(makeCollapse(a, b));
+                if (canCollapse(b, a))
+                    candidates.push_back(makeCollapse(b, a));
+            }
+        }
+        std::sort(candidates.begin(), candidates.end(), [](const Collapse & x, const Collapse & y) {
+            return x.cost < y.cost;
+        });
+
+        for (int vv = 0; vv < m_vertexCount; ++vv)
+            collapseTo[vv] = quint32(vv);
+        std::fill(touched.begin(), touched.end(), 0);
+
+        // Independent collapses only: the one ring of a collapsed vertex is not changed again in this pass
+        const size_t trianglesToRemove = (triangles.size() - targetIndexCount) / 3;
+        size_t trianglesRemoved = 0;
+        int collapses = 0;
+        for (const Collapse & collapse : candidates)
+        {
+            if (trianglesRemoved >= trianglesToRemove)
+                break;
+            if (touched[collapse.from] || touched[collapse.to] || collapse.error > maxErrorSquared)
+                continue;
+
+            // The triangles around "from" must not flip or degenerate
+            bool valid = true;
+            size_t removed = 0;
+            for (quint32 ii = triangleOffsets[collapse.from]; ii < triangleOffsets[collapse.from + 1] && valid; ++ii)
+            {
+                const quint32 * triangle = &triangles[size_t(vertexTriangles[ii]) * 3];
+                if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+                {
+                    removed++;
+                    continue;
+                }
+                const float * before[3];
+                const float * after[3];
+                for (int cc = 0; cc < 3; ++cc)
+                {
+                    before[cc] = position(triangle[cc]);
+                    after[cc] = triangle[cc] == collapse.from ? position(collapse.to) : before[cc];
+                }
+                double normalBefore[3];
+                double normalAfter[3];
+                triangleNormal(before[0], before[1], before[2], normalBefore);
+                triangleNormal(after[0], after[1], after[2], normalAfter);
+                const double dot = normalBefore[0] * normalAfter[0] + normalBefore[1] * normalAfter[1] + normalBefore[2] * normalAfter[2];
+                const double lengthBefore = std::sqrt(normalBefore[0] * normalBefore[0] + normalBefore[1] * normalBefore[1] + normalBefore[2] * normalBefore[2]);
+                const double lengthAfter = std::sqrt(normalAfter[0] * normalAfter[0] + normalAfter[1] * normalAfter[1] + normalAfter[2] * normalAfter[2]);
+                valid = dot > 0.1 * lengthBefore * lengthAfter && lengthAfter > 0.0;
+            }
+            if (!valid)
+                continue;
+
+            collapseTo[collapse.from] = collapse.to;
+            for (quint32 ii = triangleOffsets[collapse.from]; ii < triangleOffsets[collapse.from + 1]; ++ii)
+            {
+                const quint32 * triangle = &triangles[size_t(vertexTriangles[ii]) * 3];
+                touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = 1;
+            }
+            quadrics[m_positionRemap[collapse.to]].add(quadrics[m_positionRemap[collapse.from]]);
+            reachedError = std::max(reachedError, collapse.error);
+            trianglesRemoved += removed;
+            collapses++;
+        }
+        if (collapses == 0)
+            break;
+
+        // Apply and drop the triangles that became degenerate
+        size_t write = 0;
+        for (size_t tt = 0; tt < triangles.size(); tt += 3)
+        {
+            const quint32 a = collapseTo[triangles[tt]];
+            const quint32 b = collapseTo[triangles[tt + 1]];
+            const quint32 c = collapseTo[triangles[tt + 2]];
+            if (a == b || b == c || a == c)
+                continue;
+            triangles[write++] = a;
+            triangles[write++] = b;
+            triangles[write++] = c;
+        }
+        triangles.resize(write);
+    }
+
+    if (resultError)
+        *resultError = float(std::sqrt(reachedError));
+    return std::vector<quint16>(triangles.begin(), triangles.end());
+}
+
+std::vector<MeshSimplifier::Level> MeshSimplifier::buildLodChain(const std::vector<quint16> & indices, int maxLevels,
+                                                                 float reduction, float maxError) const
+{
+    std::vector<Level> levels;
+    levels.push_back(Level{ indices, 0.0f });
+
+    for (int level = 1; level < maxLevels; ++level)
+    {
+        const std::vector<quint16> & previous = levels.back().indices;
+        const size_t target = size_t(float(previous.size() / 3) * reduction) * 3;
+        float error = 0.0f;
+        std::vector<quint16> simplified = simplify(previous, target, maxError, &error);
+
+        // Not worth another level (e.g. everything is locked)
+        if (simplified.empty() || simplified.size() > previous.size() * 9 / 10)
+            break;
+
+        // The errors of the steps add up at most
+        const float totalError = levels.back().error + error;
+        levels.push_back(Level{ std::move(simplified), totalError });
+    }
+
+    qInfo() << "Mesh simplifier : LOD chain" << levels.size() << "levels," << indices.size() / 3 << "->" << levels.back().indices.size() / 3 << "triangles";
+    return levels;
+}
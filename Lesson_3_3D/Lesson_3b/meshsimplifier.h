@@ -0,0 +1,84 @@
+#pragma once
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include <QtGlobal>
+
+#include <vector>
+
+///
+/// \brief The MeshSimplifier class builds coarser versions of an indexed
+/// triangle mesh by edge collapses ordered by the quadric error metric
+/// (Garland & Heckbert). A vertex is always collapsed onto one of its
+/// neighbours, so the simplified meshes are just new index lists for the
+/// same vertex buffer and can be stored behind the original indices.
+/// - Attribute seams (several vertices at one position, e.g. texture
+///   coordinate seams) are never moved, the texture coordinate stretch is
+///   part of the error.
+/// - Border vertices are locked, or may only slide along the border.
+///
+/// Runs offline or at load time (any thread), not per frame.
+///
+class MeshSimplifier
+{
+public:
+    struct Options
+    {
+        int texCoordOffset {3};         // floats from the vertex start, -1 for none
+        float texCoordWeight {0.5f};    // error of a texture coordinate difference of 1, relative to the mesh size
+        bool lockBorder {true};
+    };
+
+    struct Level
+    {
+        std::vector<quint16> indices;
+        float error {0.0f};             // max. distance from the original surface in model units
+    };
+
+    // Interleaved vertices, the position (3 floats) is at the start of each vertex
+    MeshSimplifier(const float * vertices, int vertexCount, int floatStride);
+    MeshSimplifier(const float * vertices, int vertexCount, int floatStride, const Options & options);
+
+    // Collapse until targetIndexCount is reached or the next collapse would
+    // exceed maxError (model units). The error reached is written to resultError.
+    std::vector<quint16> simplify(const std::vector<quint16> & indices, size_t targetIndexCount,
+                                  float maxError, float * resultError = nullptr) const;
+
+    // Level 0 is the input, every next level has about reduction times the
+    // triangles of the previous one. Stops early when no progress is possible.
+    std::vector<Level> buildLodChain(const std::vector<quint16> & indices, int maxLevels = 4,
+                                     float reduction = 0.5f, float maxError = 1.0e30f) const;
+
+    float meshSize() const { return m_meshSize; }
+
+private:
+    enum class Kind : quint8
+    {
+        Manifold,   // free to collapse
+        Border,     // on an open edge
+        Seam,       // shares the position with other vertices
+        Locked
+    };
+
+    const float * position(quint32 vertex) const { return m_vertices + size_t(vertex) * m_floatStride; }
+    const float * texCoord(quint32 vertex) const { return m_vertices + size_t(vertex) * m_floatStride + m_options.texCoordOffset; }
+
+    const float * m_vertices {nullptr};
+    int m_vertexCount {0};
+    int m_floatStride {0};
+    Options m_options;
+
+    // First vertex with the same position
+    std::vector<quint32> m_positionRemap;
+    std::vector<quint32> m_wedgeCount;
+    float m_meshSize {1.0f};
+};
@@ -0,0 +1,391 @@
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "microbenchmark.h"
+#include "camera.h"
+#include "shaderprogram.h"
+#include "texture2D.h"
+#include "resourcemanager.h"
+#include "profiler.h"
+
+#include <QCommandLineParser>
+#include <QDebug>
+#include <QGuiApplication>
+#include <QLoggingCategory>
+#include <QMatrix4x4>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions_3_3_Core>
+#include <QSurfaceFormat>
+#include <QTextStream>
+
+///
+/// The microbenchmarks of learnopengl_microbench: the camera updates, the
+/// uniform setters, texture decode and upload and the matrix products of a
+/// frame. The OpenGL ones need the offscreen context created by main().
+///
+
+namespace
+{
+    // Current for the whole run, nullptr when there is no OpenGL
+    QOpenGLContext * s_context = nullptr;
+    QOpenGLFunctions_3_3_Core * s_gl = nullptr;
+
+    bool needsContext(MicroBenchmark::State & state)
+    {
+        if (s_context)
+            return true;
+        state.skip("no OpenGL 3.3 context");
+        return false;
+    }
+
+    // The protected update of the cameras, called directly
+    class PlayerCameraAccess : public PlayerCamera
+    {
+    public:
+        using PlayerCamera::updateCameraVectors;
+    };
+    class OrbitCameraAccess : public OrbitCamera
+    {
+    public:
+        OrbitCameraAccess() : OrbitCamera(10.0f, 0.0f, 0.0f) {}
+        using OrbitCamera::updateCameraVectors;
+    };
+
+    const char * UNIFORM_VERTEX_SHADER =
+        "#version 330 core\n"
+        "layout (location = 0) in vec3 pos;\n"
+        "uniform mat4 model;\n"
+        "uniform mat4 viewProjection;\n"
+        "uniform vec3 offset;\n"
+        "void main() { gl_Position = viewProjection * model * vec4(pos + offset, 1.0); }\n";
+    const char * UNIFORM_FRAGMENT_SHADER =
+        "#version 330 core\n"
+        "uniform int layer;\n"
+        "out vec4 frag_color;\n"
+        "void main() { frag_color = vec4(float(layer)); }\n";
+
+    const char * TEXTURE_FILE = ":/Images/funpic.jpg";
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Camera
+///////////////////////////////////////////////////////////////////////////////
+
+static void playerCameraRotate(MicroBenchmark::State & state)
+{
+    PlayerCamera camera(QVector3D(0.0f, 0.0f, 10.0f));
+    float direction = 1.0f;
+    for (auto _ : state)
+    {
+        // Back and forth, an unchanged rotation returns early
+        camera.rotate(0.5f * direction, 0.25f * direction);
+        direction = -direction;
+    }
+    MicroBenchmark::doNotOptimize(camera.viewMatrix());
+}
+MICROBENCHMARK(playerCameraRotate, "camera/PlayerCamera::rotate");
+
+static void orbitCameraRotate(MicroBenchmark::State & state)
+{
+    OrbitCamera camera(10.0f, 0.0f, 0.0f);
+    float direction = 1.0f;
+    for (auto _ : state)
+    {
+        camera.rotate(0.5f * direction, 0.25f * direction);
+        direction = -direction;
+    }
+    MicroBenchmark::doNotOptimize(camera.viewMatrix());
+}
+MICROBENCHMARK(orbitCameraRotate, "camera/OrbitCamera::rotate");
+
+static void playerCameraSetLookAt(MicroBenchmark::State & state)
+{
+    PlayerCamera camera(QVector3D(0.0f, 2.0f, 10.0f));
+    // Two targets in turn, the same target returns early
+    const QVector3D targets[2] = { QVector3D(1.0f, 0.0f, 0.0f), QVector3D(-1.0f, 0.5f, 0.0f) };
+    int index = 0;
+    for (auto _ : state)
+    {
+        camera.setLookAt(targets[index]);
+        index ^= 1;
+    }
+    MicroBenchmark::doNotOptimize(camera.viewMatrix());
+}
+MICROBENCHMARK(playerCameraSetLookAt, "camera/PlayerCamera::setLookAt");
+
+static void playerCameraUpdateVectors(MicroBenchmark::State & state)
+{
+    PlayerCameraAccess camera;
+    camera.setRotation(30.0f, 10.0f);
+    for (auto _ : state)
+        camera.updateCameraVectors();
+    MicroBenchmark::doNotOptimize(camera.viewMatrix());
+}
+MICROBENCHMARK(playerCameraUpdateVectors, "camera/PlayerCamera::updateCameraVectors");
+
+static void orbitCameraUpdateVectors(MicroBenchmark::State & state)
+{
+    OrbitCameraAccess camera;
+    camera.setRotation(30.0f, 10.0f);
+    for (auto _ : state)
+        camera.updateCameraVectors();
+    MicroBenchmark::doNotOptimize(camera.viewMatrix());
+}
+MICROBENCHMARK(orbitCameraUpdateVectors, "camera/OrbitCamera::updateCameraVectors");
+
+///////////////////////////////////////////////////////////////////////////////
+/// Matrices - the model view projection of one object
+///////////////////////////////////////////////////////////////////////////////
+
+static void matrixModelViewProjection(MicroBenchmark::State & state)
+{
+    QMatrix4x4 projection;
+    projection.perspective(45.0f, 16.0f / 9.0f, 0.1f, 100.0f);
+    PlayerCamera camera(QVector3D(0.0f, 2.0f, 10.0f), QVector3D(0.0f, 0.0f, 0.0f));
+    const QMatrix4x4 view = camera.viewMatrix();
+    float angle = 0.0f;
+    for (auto _ : state)
+    {
+        QMatrix4x4 model;
+        model.translate(1.0f, 0.0f, -2.0f);
+        model.rotate(angle, 0.0f, 1.0f, 0.0f);
+        model.scale(0.5f);
+        const QMatrix4x4 mvp = projection * view * model;
+        MicroBenchmark::doNotOptimize(mvp);
+        angle += 0.1f;
+    }
+}
+MICROBENCHMARK(matrixModelViewProjection, "matrix/projection * view * model");
+
+static void matrixViewProjectionOnce(MicroBenchmark::State & state)
+{
+    // View projection multiplied once per frame, one product per object
+    QMatrix4x4 projection;
+    projection.perspective(45.0f, 16.0f / 9.0f, 0.1f, 100.0f);
+    PlayerCamera camera(QVector3D(0.0f, 2.0f, 10.0f), QVector3D(0.0f, 0.0f, 0.0f));
+    const QMatrix4x4 viewProjection = projection * camera.viewMatrix();
+    float angle = 0.0f;
+    for (auto _ : state)
+    {
+        QMatrix4x4 model;
+        model.translate(1.0f, 0.0f, -2.0f);
+        model.rotate(angle, 0.0f, 1.0f, 0.0f);
+        model.scale(0.5f);
+        const QMatrix4x4 mvp = viewProjection * model;
+        MicroBenchmark::doNotOptimize(mvp);
+        angle += 0.1f;
+    }
+}
+MICROBENCHMARK(matrixViewProjectionOnce, "matrix/viewProjection * model");
+
+///////////////////////////////////////////////////////////////////////////////
+/// Uniforms - ShaderProgram::setUniform (name lookup and glUniform) per call
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // The values alternate, a driver could skip an unchanged uniform
+    template <class Setter>
+    void runUniform(MicroBenchmark::State & state, Setter setter)
+    {
+        if (!needsContext(state))
+            return;
+        ShaderProgram program;
+        if (!program.beginLoadFromSource(UNIFORM_VERTEX_SHADER, UNIFORM_FRAGMENT_SHADER) || !program.finishLoad())
+        {
+            state.skip("shader compile failed");
+            return;
+        }
+        program.use();
+        int index = 0;
+        for (auto _ : state)
+        {
+            setter(program, index);
+            index ^= 1;
+        }
+        program.release();
+    }
+}
+
+static void uniformInt(MicroBenchmark::State & state)
+{
+    runUniform(state, [](ShaderProgram & program, int index) { program.setUniform("layer", GLint(index)); });
+}
+MICROBENCHMARK(uniformInt, "uniform/ShaderProgram::setUniform(int)");
+
+static void uniformVector3(MicroBenchmark::State & state)
+{
+    const QVector3D values[2] = { QVector3D(1.0f, 2.0f, 3.0f), QVector3D(3.0f, 2.0f, 1.0f) };
+    runUniform(state, [&values](ShaderProgram & program, int index) { program.setUniform("offset", values[index]); });
+}
+MICROBENCHMARK(uniformVector3, "uniform/ShaderProgram::setUniform(vec3)");
+
+static void uniformMatrix(MicroBenchmark::State & state)
+{
+    QMatrix4x4 values[2];
+    values[1].rotate(45.0f, 0.0f, 1.0f, 0.0f);
+    runUniform(state, [&values](ShaderProgram & program, int index) { program.setUniform("model", values[index]); });
+}
+MICROBENCHMARK(uniformMatrix, "uniform/ShaderProgram::setUniform(mat4)");
+
+static void uniformMatrixLocation(MicroBenchmark::State & state)
+{
+    // Reference: the glUniform call alone, location looked up once
+    if (!needsContext(state))
+        return;
+    ShaderProgram program;
+    if (!program.beginLoadFromSource(UNIFORM_VERTEX_SHADER, UNIFORM_FRAGMENT_SHADER) || !program.finishLoad())
+    {
+        state.skip("shader compile failed");
+        return;
+    }
+    program.use();
+    const GLint location = s_gl->glGetUniformLocation(program.getProgram(), "model");
+    QMatrix4x4 values[2];
+    values[1].rotate(45.0f, 0.0f, 1.0f, 0.0f);
+    int index = 0;
+    for (auto _ : state)
+    {
+        s_gl->glUniformMatrix4fv(location, 1, GL_FALSE, values[index].constData());
+        index ^= 1;
+    }
+    program.release();
+}
+MICROBENCHMARK(uniformMatrixLocation, "uniform/glUniformMatrix4fv (cached location)");
+
+///////////////////////////////////////////////////////////////////////////////
+/// Textures - decode, upload and both (Texture2D::loadTexture)
+///////////////////////////////////////////////////////////////////////////////
+
+static void textureDecode(MicroBenchmark::State & state)
+{
+    qint64 bytes = 0;
+    for (auto _ : state)
+    {
+        const QImage image = Texture2D::readImage(TEXTURE_FILE);
+        bytes = image.sizeInBytes();
+        MicroBenchmark::doNotOptimize(image.constBits());
+    }
+    state.setBytesPerIteration(bytes);
+}
+MICROBENCHMARK(textureDecode, "texture/Texture2D::readImage");
+
+static void textureUpload(MicroBenchmark::State & state)
+{
+    if (!needsContext(state))
+        return;
+    const QImage image = Texture2D::readImage(TEXTURE_FILE);
+    for (auto _ : state)
+    {
+        // Finished on the GPU, not only queued by the driver
+        Texture2D texture;
+        texture.loadTexture(image);
+        s_gl->glFinish();
+    }
+    state.setBytesPerIteration(image.sizeInBytes());
+    state.setLabel(QString("%1 x %2, mipmaps").arg(image.width()).arg(image.height()));
+}
+MICROBENCHMARK(textureUpload, "texture/Texture2D::loadTexture(QImage)");
+
+static void textureDecodeUpload(MicroBenchmark::State & state)
+{
+    if (!needsContext(state))
+        return;
+    qint64 bytes = 0;
+    for (auto _ : state)
+    {
+        Texture2D texture;
+        texture.loadTexture(QString(TEXTURE_FILE));
+        s_gl->glFinish();
+        bytes = qint64(texture.width()) * texture.height() * 4;
+    }
+    state.setBytesPerIteration(bytes);
+}
+MICROBENCHMARK(textureDecodeUpload, "texture/Texture2D::loadTexture(file)");
+
+///////////////////////////////////////////////////////////////////////////////
+/// main
+///////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char *argv[])
+{
+    // Without a display: QT_QPA_PLATFORM=offscreen (e.g. Mesa llvmpipe)
+    QGuiApplication a(argc, argv);
+    Profiler::setThreadName("Main (microbenchmarks)");
+    QCoreApplication::setApplicationName("learnopengl_microbench");
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption filterOption("filter", "Run the benchmarks whose name matches this regular expression.", "regex");
+    parser.addOption(filterOption);
+    QCommandLineOption minTimeOption("min-time", "Minimum time of one repetition in seconds (default 0.1).", "seconds");
+    parser.addOption(minTimeOption);
+    QCommandLineOption repetitionsOption("repetitions", "Repetitions of every benchmark, the median is reported (default 5).", "count");
+    parser.addOption(repetitionsOption);
+    QCommandLineOption resultsOption("results", "Write the time per iteration of every repetition into this JSON file (for lesson_3b --compare).", "file");
+    parser.addOption(resultsOption);
+    QCommandLineOption listOption("list", "List the benchmarks and quit.");
+    parser.addOption(listOption);
+    parser.process(a);
+
+    if (parser.isSet(listOption))
+    {
+        QTextStream(stdout) << MicroBenchmark::names().join('\n') << '\n';
+        return 0;
+    }
+
+    MicroBenchmark::Options options;
+    options.filter = parser.value(filterOption);
+    if (parser.isSet(minTimeOption))
+        options.minSeconds = parser.value(minTimeOption).toDouble();
+    if (parser.isSet(repetitionsOption))
+        options.repetitions = parser.value(repetitionsOption).toInt();
+    options.resultsFile = parser.value(resultsOption);
+
+    // Same context as the application: OpenGL 3.3 core, no window
+    QSurfaceFormat format;
+    format.setDepthBufferSize(24);
+    format.setVersion(3, 3);
+    format.setProfile(QSurfaceFormat::CoreProfile);
+    QSurfaceFormat::setDefaultFormat(format);
+
+    QOffscreenSurface surface;
+    surface.setFormat(format);
+    surface.create();
+    QOpenGLContext context;
+    context.setFormat(format);
+    QOpenGLFunctions_3_3_Core gl;
+    if (context.create() && context.makeCurrent(&surface) && context.format().version() >= qMakePair(3, 3)
+        && gl.initializeOpenGLFunctions())
+    {
+        s_context = &context;
+        s_gl = &gl;
+    }
+    else
+        qWarning() << "Microbenchmark : no OpenGL 3.3 context, the OpenGL benchmarks are skipped";
+    if (s_context)
+        qInfo().noquote() << "Microbenchmark :" << reinterpret_cast<const char *>(s_gl->glGetString(GL_RENDERER));
+
+    // The loaders and the cameras log every call, only the table is of interest.
+    // Filtered out only when printed: the numbers still include formatting the QDebug streams.
+    QLoggingCategory::setFilterRules("default.debug=false\ndefault.info=false");
+    const int result = MicroBenchmark::run(options);
+    QLoggingCategory::setFilterRules(QString());
+
+    if (s_context)
+    {
+        ResourceManager::instance().shutdown();
+        context.doneCurrent();
+    }
+    return result;
+}
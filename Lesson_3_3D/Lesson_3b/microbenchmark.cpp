@@ -0,0 +1,185 @@
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "microbenchmark.h"
+#include "benchmarkresults.h"
+
+#include <QDebug>
+#include <QRegularExpression>
+#include <QTextStream>
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace
+{
+    struct Registered
+    {
+        QString name;
+        MicroBenchmark::Function function;
+    };
+
+    // Filled by the static MICROBENCHMARK registrations, before main
+    std::vector<Registered> & registry()
+    {
+        static std::vector<Registered> benchmarks;
+        return benchmarks;
+    }
+
+    QString formatNanoseconds(double nanoseconds)
+    {
+        if (nanoseconds < 1e3)
+            return QString::number(nanoseconds, 'f', 1) + " ns";
+        if (nanoseconds < 1e6)
+            return QString::number(nanoseconds / 1e3, 'f', 2) + " us";
+        return QString::number(nanoseconds / 1e6, 'f', 2) + " ms";
+    }
+}
+
+namespace MicroBenchmark
+{
+
+///////////////////////////////////////////////////////////////////////////////
+/// State
+///////////////////////////////////////////////////////////////////////////////
+
+State::Iterator State::begin()
+{
+    m_elapsed = 0;
+    m_running = true;
+    m_timer.start();
+    return Iterator(this, m_iterations);
+}
+
+void State::pauseTiming()
+{
+    if (!m_running)
+        return;
+    m_elapsed += m_timer.nsecsElapsed();
+    m_running = false;
+}
+
+void State::resumeTiming()
+{
+    if (m_running)
+        return;
+    m_running = true;
+    m_timer.start();
+}
+
+void State::stopTiming()
+{
+    pauseTiming();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Runner
+///////////////////////////////////////////////////////////////////////////////
+
+bool add(const char * name, Function function)
+{
+    registry().push_back(Registered{QString::fromLatin1(name), function});
+    return true;
+}
+
+QStringList names()
+{
+    QStringList list;
+    for (const Registered & benchmark : registry())
+        list << benchmark.name;
+    return list;
+}
+
+int run(const Options & options)
+{
+    const QRegularExpression filter(options.filter);
+    if (!filter.isValid())
+    {
+        qWarning() << "Microbenchmark : bad filter" << options.filter << filter.errorString();
+        return 1;
+    }
+
+    QTextStream out(stdout);
+    out << QString("%1 %2 %3 %4  %5\n").arg(QString("Benchmark"), -48).arg(QString("Time"), 12).arg(QString("Min"), 12)
+               .arg(QString("Iterations"), 12).arg(QString("Throughput"));
+    out << QString(104, '-') << "\n";
+    out.flush();
+
+    BenchmarkResults results;
+    const qint64 minNanoseconds = qint64(options.minSeconds * 1e9);
+    int count = 0;
+    for (const Registered & benchmark : registry())
+    {
+        if (!options.filter.isEmpty() && !filter.match(benchmark.name).hasMatch())
+            continue;
+        count++;
+
+        // Double the iterations until one pass takes long enough (timer resolution, warm caches)
+        qint64 iterations = 1;
+        QString skipped;
+        for (;;)
+        {
+            State state(iterations);
+            benchmark.function(state);
+            skipped = state.skipped();
+            if (!skipped.isEmpty() || state.elapsedNanoseconds() >= minNanoseconds || iterations >= (qint64(1) << 40))
+                break;
+            // Jump close to the target when the pass was long enough to be measured
+            const qint64 elapsed = state.elapsedNanoseconds();
+            iterations = elapsed > 1000000 ? qMax(iterations * 2, qint64(double(iterations) * 1.2 * double(minNanoseconds) / double(elapsed)))
+                                           : iterations * 2;
+        }
+        if (!skipped.isEmpty())
+        {
+            out << QString("%1 skipped: %2\n").arg(benchmark.name, -48).arg(skipped);
+            out.flush();
+            continue;
+        }
+
+        std::vector<double> perIteration;
+        qint64 bytesPerIteration = 0;
+        QString label;
+        for (int repetition = 0; repetition < qMax(1, options.repetitions); ++repetition)
+        {
+            State state(iterations);
+            benchmark.function(state);
+            perIteration.push_back(double(state.elapsedNanoseconds()) / double(iterations));
+            bytesPerIteration = state.bytesPerIteration();
+            label = state.label();
+        }
+
+        const double median = BenchmarkResults::median(perIteration);
+        const double minimum = *std::min_element(perIteration.begin(), perIteration.end());
+        QString throughput;
+        if (bytesPerIteration > 0 && median > 0.0)
+            throughput = QString::number(double(bytesPerIteration) / median * 1e9 / (1024.0 * 1024.0), 'f', 1) + " MB/s";
+        if (!label.isEmpty())
+            throughput += (throughput.isEmpty() ? "" : "  ") + label;
+        out << QString("%1 %2 %3 %4  %5\n").arg(benchmark.name, -48).arg(formatNanoseconds(median), 12)
+                   .arg(formatNanoseconds(minimum), 12).arg(iterations, 12).arg(throughput);
+        out.flush();
+
+        results.add("microbench/" + benchmark.name, "ns", perIteration);
+    }
+
+    if (count == 0)
+    {
+        qWarning() << "Microbenchmark : nothing matches" << options.filter << "- use one of" << names();
+        return 1;
+    }
+    if (!options.resultsFile.isEmpty() && !results.save(options.resultsFile))
+        return 1;
+    return 0;
+}
+
+}
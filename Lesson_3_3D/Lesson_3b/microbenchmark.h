@@ -0,0 +1,125 @@
+#pragma once
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include <QElapsedTimer>
+#include <QString>
+#include <QStringList>
+
+#include <vector>
+
+///
+/// \brief Microbenchmarks of single functions, in the style of Google Benchmark
+/// without the dependency (see learnopengl_microbench in CMakeLists.txt).
+/// A benchmark is a function that runs the measured code once per loop pass:
+///
+///   static void cameraRotate(MicroBenchmark::State & state)
+///   {
+///       PlayerCamera camera;            // setup, not measured
+///       for (auto _ : state)
+///           camera.rotate(0.5f, 0.0f);
+///   }
+///   MICROBENCHMARK(cameraRotate, "camera/PlayerCamera::rotate");
+///
+/// The runner doubles the iterations until a pass takes the minimum time,
+/// then repeats the pass and reports the median time per iteration.
+///
+namespace MicroBenchmark
+{
+    class State
+    {
+    public:
+        explicit State(qint64 iterations) : m_iterations(iterations) {}
+
+        // Range for loop over the iterations, starts the timer on the first pass
+        class Iterator
+        {
+        public:
+            Iterator(State * state, qint64 remaining) : m_state(state), m_remaining(remaining) {}
+            bool operator!=(const Iterator &) const
+            {
+                if (m_remaining > 0)
+                    return true;
+                m_state->stopTiming();
+                return false;
+            }
+            void operator++() { --m_remaining; }
+            int operator*() const { return 0; }
+
+        private:
+            State * m_state;
+            qint64 m_remaining;
+        };
+        Iterator begin();
+        Iterator end() { return Iterator(this, 0); }
+
+        // Around work inside the loop that must not be measured (e.g. a glFinish)
+        void pauseTiming();
+        void resumeTiming();
+
+        qint64 iterations() const { return m_iterations; }
+        // Throughput column, per iteration
+        void setBytesPerIteration(qint64 bytes) { m_bytesPerIteration = bytes; }
+        qint64 bytesPerIteration() const { return m_bytesPerIteration; }
+        void setLabel(const QString & label) { m_label = label; }
+        const QString & label() const { return m_label; }
+        // A benchmark that can not run here (e.g. missing context) reports why
+        void skip(const QString & reason) { m_skipped = reason; }
+        const QString & skipped() const { return m_skipped; }
+
+        qint64 elapsedNanoseconds() const { return m_elapsed; }
+
+    private:
+        void stopTiming();
+
+        qint64 m_iterations {1};
+        qint64 m_bytesPerIteration {0};
+        QString m_label;
+        QString m_skipped;
+        QElapsedTimer m_timer;
+        qint64 m_elapsed {0};
+        bool m_running {false};
+    };
+
+    using Function = void (*)(State & state);
+
+    struct Options
+    {
+        QString filter;             // regular expression on the names, empty: all
+        double minSeconds {0.1};    // per repetition
+        int repetitions {5};
+        QString resultsFile;        // ns per iteration of every repetition, see BenchmarkResults
+    };
+
+    // Keeps the compiler from removing a computation whose result is unused
+    template <class T>
+    inline void doNotOptimize(const T & value)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "r,m"(value) : "memory");
+#else
+        const volatile char * volatile sink = reinterpret_cast<const volatile char *>(&value);
+        (void)sink;
+#endif
+    }
+
+    bool add(const char * name, Function function);
+    QStringList names();
+
+    // Returns the process exit code (0 = ok)
+    int run(const Options & options);
+}
+
+#define MICROBENCHMARK_CONCAT_(a, b) a##b
+#define MICROBENCHMARK_CONCAT(a, b) MICROBENCHMARK_CONCAT_(a, b)
+#define MICROBENCHMARK(function, name) \
+    static const bool MICROBENCHMARK_CONCAT(s_registered_, __LINE__) = MicroBenchmark::add(name, function)
@@ -0,0 +1,411 @@
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "mipmapbuilder.h"
+#include "jobsystem.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define MIPMAP_BUILDER_SSE 1
+#endif
+
+namespace
+{
+    // Destination rows per job, the horizontal pass of the rows between
+    // two bands (filter taps - 2) is done twice
+    constexpr int BAND_ROWS = 32;
+
+    // Kaiser windowed sinc, 3 destination texels wide (alpha 4)
+    constexpr int KAISER_TAPS = 12;
+    constexpr double KAISER_WIDTH = 3.0;
+    constexpr double KAISER_ALPHA = 4.0;
+
+    constexpr int MAX_TAPS = KAISER_TAPS;
+    constexpr int TO_SRGB_SIZE = 4096;
+
+    ///
+    /// \brief Source texels stride * i + first ... + taps - 1 make destination texel i
+    ///
+    struct Kernel
+    {
+        int stride {2};
+        int first {0};
+        int taps {0};
+        float weights[MAX_TAPS] {};
+        int oddSize {0};    // box filter of an odd size, the 3 weights depend on i
+    };
+
+    // Weights of destination texel i (odd: space for the 3 computed ones)
+    inline const float * kernelWeights(const Kernel & kernel, int index, float * odd)
+    {
+        if (!kernel.oddSize)
+            return kernel.weights;
+        // 2n + 1 source texels into n: each destination texel covers 2 + 1/n of
+        // them, the outer two in part (polyphase box)
+        const float size = float(kernel.oddSize);
+        const float destinationSize = float(kernel.oddSize / 2);
+        odd[0] = (destinationSize - float(index)) / size;
+        odd[1] = destinationSize / size;
+        odd[2] = (float(index) + 1.0f) / size;
+        return odd;
+    }
+
+    // Zero order modified Bessel function of the first kind
+    double besselI0(double x)
+    {
+        double sum = 1.0;
+        double term = 1.0;
+        for (int kk = 1; kk < 32; ++kk)
+        {
+            term *= (x / (2.0 * kk)) * (x / (2.0 * kk));
+            sum += term;
+        }
+        return sum;
+    }
+
+    Kernel makeKernel(MipmapBuilder::Filter filter, int sourceSize)
+    {
+        Kernel kernel;
+        if (sourceSize == 1)
+        {
+            // Nothing left to halve in this direction
+            kernel.stride = 1;
+            kernel.taps = 1;
+            kernel.weights[0] = 1.0f;
+            return kernel;
+        }
+
+        if (filter == MipmapBuilder::Filter::Box)
+        {
+            // 2x2 would drop the last column or row of an odd size
+            if (sourceSize % 2 != 0)
+            {
+                kernel.taps = 3;
+                kernel.oddSize = sourceSize;
+                return kernel;
+            }
+            kernel.taps = 2;
+            kernel.weights[0] = 0.5f;
+            kernel.weights[1] = 0.5f;
+            return kernel;
+        }
+
+        // Destination texel i is centered between the source texels 2i and 2i + 1
+        kernel.first = 1 - KAISER_TAPS / 2;
+        kernel.taps = KAISER_TAPS;
+        const double pi = 3.14159265358979323846;
+        double sum = 0.0;
+        double weights[KAISER_TAPS];
+        for (int tt = 0; tt < KAISER_TAPS; ++tt)
+        {
+            // Distance in destination texels
+            const double x = (double(kernel.first + tt) - 0.5) * 0.5;
+            const double sinc = std::sin(pi * x) / (pi * x);
+            const double window = x / KAISER_WIDTH;
+            const double kaiser = std::fabs(window) < 1.0
+                                      ? besselI0(KAISER_ALPHA * std::sqrt(1.0 - window * window)) / besselI0(KAISER_ALPHA)
+                                      : 0.0;
+            weights[tt] = sinc * kaiser;
+            sum += weights[tt];
+        }
+        for (int tt = 0; tt < KAISER_TAPS; ++tt)
+            kernel.weights[tt] = float(weights[tt] / sum);
+        return kernel;
+    }
+
+    ///
+    /// \brief sRGB decode (8 bit) and encode (from 12 bit linear) tables
+    ///
+    struct ColorTables
+    {
+        ColorTables()
+        {
+            for (int ii = 0; ii < 256; ++ii)
+            {
+                const double c = ii / 255.0;
+                srgbToLinear[ii] = float(c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4));
+                unormToFloat[ii] = float(c);
+            }
+            for (int ii = 0; ii < TO_SRGB_SIZE; ++ii)
+            {
+                const double c = ii / double(TO_SRGB_SIZE - 1);
+                const double srgb = c <= 0.0031308 ? c * 12.92 : 1.055 * std::pow(c, 1.0 / 2.4) - 0.055;
+                linearToSrgb[ii] = quint8(qBound(0.0, srgb * 255.0 + 0.5, 255.0));
+            }
+        }
+
+        float srgbToLinear[256];
+        float unormToFloat[256];
+        quint8 linearToSrgb[TO_SRGB_SIZE];
+    };
+
+    const ColorTables & colorTables()
+    {
+        static const ColorTables tables;
+        return tables;
+    }
+
+    int address(int index, int size, bool wrap)
+    {
+        if (wrap)
+        {
+            index %= size;
+            return index < 0 ? index + size : index;
+        }
+        return qBound(0, index, size - 1);
+    }
+
+    // out += weight * in, 4 channels per texel
+    inline void accumulate(float * out, const float * in, float weight, int texels)
+    {
+#ifdef MIPMAP_BUILDER_SSE
+        const __m128 w = _mm_set1_ps(weight);
+        for (int ii = 0; ii < texels; ++ii)
+            _mm_storeu_ps(out + ii * 4, _mm_add_ps(_mm_loadu_ps(out + ii * 4), _mm_mul_ps(w, _mm_loadu_ps(in + ii * 4))));
+#else
+        for (int ii = 0; ii < texels * 4; ++ii)
+            out[ii] += weight * in[ii];
+#endif
+    }
+
+    ///
+    /// \brief One level down: the source rows are decoded and filtered
+    /// horizontally into a band buffer, then the band is filtered vertically
+    ///
+    struct Pass
+    {
+        const QImage * source {nullptr};
+        QImage * destination {nullptr};
+        Kernel kernelX;
+        Kernel kernelY;
+        const float * toLinear {nullptr};
+        bool srgb {true};
+        bool wrap {true};
+    };
+
+    void decodeRow(const Pass & pass, int sourceY, int padLeft, float * line)
+    {
+        const int width = pass.source->width();
+        const quint8 * texels = pass.source->constScanLine(sourceY);
+        const float * alphaTable = colorTables().unormToFloat;
+        const int paddedWidth = width + padLeft + pass.kernelX.taps;
+        for (int xx = 0; xx < paddedWidth; ++xx)
+        {
+            // The border texels come from the other side (wrap) or the edge (clamp)
+            const int sourceX = (xx >= padLeft && xx < padLeft + width) ? xx - padLeft : address(xx - padLeft, width, pass.wrap);
+            const quint8 * texel = texels + sourceX * 4;
+            const float alpha = alphaTable[texel[3]];
+            float * out = line + xx * 4;
+            out[0] = pass.toLinear[texel[0]] * alpha;
+            out[1] = pass.toLinear[texel[1]] * alpha;
+            out[2] = pass.toLinear[texel[2]] * alpha;
+            out[3] = alpha;
+        }
+    }
+
+    void encodeRow(const Pass & pass, const float * row, int destinationY)
+    {
+        const ColorTables & tables = colorTables();
+        quint8 * texels = pass.destination->scanLine(destinationY);
+        const int width = pass.destination->width();
+        for (int xx = 0; xx < width; ++xx)
+        {
+            const float * in = row + xx * 4;
+            const float alpha = qBound(0.0f, in[3], 1.0f);
+            // Back from premultiplied, fully transparent texels have no color left
+            const float scale = alpha > 1.0f / 1024.0f ? 1.0f / alpha : 0.0f;
+            for (int cc = 0; cc < 3; ++cc)
+            {
+                const float c = qBound(0.0f, in[cc] * scale, 1.0f);
+                texels[xx * 4 + cc] = pass.srgb ? tables.linearToSrgb[int(c * (TO_SRGB_SIZE - 1) + 0.5f)]
+                                                : quint8(c * 255.0f + 0.5f);
+            }
+            texels[xx * 4 + 3] = quint8(alpha * 255.0f + 0.5f);
+        }
+    }
+
+    void filterBand(const Pass & pass, int firstRow, int endRow)
+    {
+        const Kernel & kx = pass.kernelX;
+        const Kernel & ky = pass.kernelY;
+        const int sourceHeight = pass.source->height();
+        const int width = pass.destination->width();
+
+        // Source rows of this band and the texels left of the first one
+        const int rowFirst = ky.stride * firstRow + ky.first;
+        const int rows = ky.stride * (endRow - 1 - firstRow) + ky.taps;
+        const int padLeft = qMax(0, -kx.first);
+
+        std::vector<float> line(size_t(pass.source->width() + padLeft + kx.taps) * 4);
+        std::vector<float> horizontal(size_t(rows) * width * 4, 0.0f);
+        for (int rr = 0; rr < rows; ++rr)
+        {
+            decodeRow(pass, address(rowFirst + rr, sourceHeight, pass.wrap), padLeft, line.data());
+            float * out = horizontal.data() + size_t(rr) * width * 4;
+            for (int xx = 0; xx < width; ++xx)
+            {
+                const float * in = line.data() + size_t(kx.stride * xx + kx.first + padLeft) * 4;
+                float odd[3];
+                const float * weights = kernelWeights(kx, xx, odd);
+#ifdef MIPMAP_BUILDER_SSE
+                __m128 sum = _mm_setzero_ps();
+                for (int tt = 0; tt < kx.taps; ++tt)
+                    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[tt]), _mm_loadu_ps(in + tt * 4)));
+                _mm_storeu_ps(out + xx * 4, sum);
+#else
+                float sum[4] {};
+                for (int tt = 0; tt < kx.taps; ++tt)
+                    for (int cc = 0; cc < 4; ++cc)
+                        sum[cc] += weights[tt] * in[tt * 4 + cc];
+                std::copy(sum, sum + 4, out + xx * 4);
+#endif
+            }
+        }
+
+        std::vector<float> row(size_t(width) * 4);
+        for (int yy = firstRow; yy < endRow; ++yy)
+        {
+            std::fill(row.begin(), row.end(), 0.0f);
+            const int first = ky.stride * (yy - firstRow);
+            float odd[3];
+            const float * weights = kernelWeights(ky, yy, odd);
+            for (int tt = 0; tt < ky.taps; ++tt)
+                accumulate(row.data(), horizontal.data() + size_t(first + tt) * width * 4, weights[tt], width);
+            encodeRow(pass, row.data(), yy);
+        }
+    }
+
+    // Part of the texels with alpha above the reference
+    float alphaCoverage(const QImage & image, float reference, const std::vector<int> & histogram, float scale)
+    {
+        const float threshold = reference * 255.0f;
+        qint64 covered = 0;
+        for (int alpha = 0; alpha < 256; ++alpha)
+        {
+            if (qMin(255.0f, alpha * scale) > threshold)
+                covered += histogram[alpha];
+        }
+        return float(covered) / float(qint64(image.width()) * image.height());
+    }
+
+    std::vector<int> alphaHistogram(const QImage & image)
+    {
+        std::vector<int> histogram(256, 0);
+        for (int yy = 0; yy < image.height(); ++yy)
+        {
+            const quint8 * texels = image.constScanLine(yy);
+            for (int xx = 0; xx < image.width(); ++xx)
+                histogram[texels[xx * 4 + 3]]++;
+        }
+        return histogram;
+    }
+
+    // Scale the alpha of the level so the same part passes the alpha test as in level 0
+    void preserveCoverage(QImage & level, float reference, float coverage)
+    {
+        const std::vector<int> histogram = alphaHistogram(level);
+        float low = 0.0f;
+        float high = 16.0f;
+        for (int ii = 0; ii < 16; ++ii)
+        {
+            const float middle = 0.5f * (low + high);
+            if (alphaCoverage(level, reference, histogram, middle) < coverage)
+                low = middle;
+            else
+                high = middle;
+        }
+
+        const float scale = high;
+        for (int yy = 0; yy < level.height(); ++yy)
+        {
+            quint8 * texels = level.scanLine(yy);
+            for (int xx = 0; xx < level.width(); ++xx)
+                texels[xx * 4 + 3] = quint8(qMin(255.0f, texels[xx * 4 + 3] * scale + 0.5f));
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Mip chain
+///////////////////////////////////////////////////////////////////////////////
+
+std::vector<QImage> MipmapBuilder::build(const QImage & image, const Options & options, JobSystem * jobs)
+{
+    PROFILE_FUNCTION();
+    std::vector<QImage> levels;
+    if (image.isNull())
+        return levels;
+    levels.reserve(size_t(levelCount(image.size())));
+
+    QImage level = image.convertToFormat(QImage::Format_RGBA8888);
+    levels.push_back(level);
+
+    const bool keepCoverage = options.alphaReference > 0.0f && options.alphaReference < 1.0f;
+    const float coverage = keepCoverage
+                               ? alphaCoverage(level, options.alphaReference, alphaHistogram(level), 1.0f)
+                               : 0.0f;
+
+    // Each level from the previous one, the alpha scaling is not passed on
+    while (level.width() > 1 || level.height() > 1)
+    {
+        level = downsample(level, options, jobs);
+        if (keepCoverage)
+        {
+            QImage scaled = level.copy();
+            preserveCoverage(scaled, options.alphaReference, coverage);
+            levels.push_back(scaled);
+        }
+        else
+        {
+            levels.push_back(level);
+        }
+    }
+    return levels;
+}
+
+QImage MipmapBuilder::downsample(const QImage & image, const Options & options, JobSystem * jobs)
+{
+    const QImage source = image.convertToFormat(QImage::Format_RGBA8888);
+    QImage destination(qMax(1, source.width() / 2), qMax(1, source.height() / 2), QImage::Format_RGBA8888);
+
+    Pass pass;
+    pass.source = &source;
+    pass.destination = &destination;
+    pass.kernelX = makeKernel(options.filter, source.width());
+    pass.kernelY = makeKernel(options.filter, source.height());
+    pass.toLinear = options.srgb ? colorTables().srgbToLinear : colorTables().unormToFloat;
+    pass.srgb = options.srgb;
+    pass.wrap = options.wrap;
+
+    const int bands = (destination.height() + BAND_ROWS - 1) / BAND_ROWS;
+    auto filterBands = [&pass, &destination](int begin, int end) {
+        for (int band = begin; band < end; ++band)
+            filterBand(pass, band * BAND_ROWS, qMin(destination.height(), (band + 1) * BAND_ROWS));
+    };
+    if (jobs && bands > 1)
+        jobs->parallelFor(bands, 1, filterBands);
+    else
+        filterBands(0, bands);
+    return destination;
+}
+
+int MipmapBuilder::levelCount(const QSize & size)
+{
+    int levels = 1;
+    for (int extent = qMax(size.width(), size.height()); extent > 1; extent /= 2)
+        levels++;
+    return levels;
+}
@@ -0,0 +1,58 @@
+#pragma once
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include <QImage>
+
+#include <vector>
+
+class JobSystem;
+
+///
+/// \brief The MipmapBuilder creates the mip chain of an RGBA8 image on the
+/// CPU instead of glGenerateMipmap (a plain box filter, on software drivers
+/// like llvmpipe also single threaded).
+/// Every level is filtered down from the previous one with a separable filter:
+/// - in linear light (sRGB decoded and encoded again), so dark and bright
+///   texels average like they do on screen
+/// - with premultiplied alpha, transparent texels do not bleed their color
+/// - optionally keeping the alpha test coverage of level 0 (cutout textures
+///   like foliage do not fade away in the distance)
+/// The rows of a level are split into bands for the jobs, the four channels
+/// of a texel are filtered at once (SSE).
+///
+class MipmapBuilder
+{
+public:
+    enum class Filter
+    {
+        Box,        // 2x2 average, like glGenerateMipmap (3 weighted taps at an odd size)
+        Kaiser      // windowed sinc, sharper, fewer aliasing artefacts
+    };
+
+    struct Options
+    {
+        Filter filter {Filter::Kaiser};
+        bool srgb {true};               // the texels are sRGB encoded (colors, not data)
+        bool wrap {true};               // repeat at the border (else clamp)
+        float alphaReference {-1.0f};   // 0..1 = keep the coverage of alpha > reference
+    };
+
+    // Level 0 (the image as RGBA8888) down to 1x1.
+    // jobs: filter the rows in parallel, null for the calling thread only.
+    static std::vector<QImage> build(const QImage & image, const Options & options, JobSystem * jobs = nullptr);
+
+    // The next level (half the size, at least 1) of an RGBA8888 image
+    static QImage downsample(const QImage & image, const Options & options, JobSystem * jobs = nullptr);
+
+    static int levelCount(const QSize & size);
+};
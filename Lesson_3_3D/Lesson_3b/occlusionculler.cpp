@@ -0,0 +1,365 @@
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "occlusionculler.h"
+#include "jobsystem.h"
+
+#include <QElapsedTimer>
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define OCCLUSION_CULLER_SSE 1
+#endif
+
+namespace
+{
+    constexpr float CLEAR_DEPTH = 1.0e30f;
+}
+
+OcclusionCuller::OcclusionCuller(int width, int height)
+{
+    m_tilesX = qMax(1, (width + TILE_SIZE - 1) / TILE_SIZE);
+    m_tilesY = qMax(1, (height + TILE_SIZE - 1) / TILE_SIZE);
+    m_width = m_tilesX * TILE_SIZE;
+    m_height = m_tilesY * TILE_SIZE;
+    m_blocksX = m_width / BLOCK_SIZE;
+
+    m_depth.assign(size_t(m_width) * m_height, CLEAR_DEPTH);
+    m_blockMin.assign(size_t(m_blocksX) * (m_height / BLOCK_SIZE), CLEAR_DEPTH);
+    m_blockMax.assign(m_blockMin.size(), CLEAR_DEPTH);
+    m_bins.resize(size_t(tileCount()));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Occluders - transform, cull and bin the triangles into the tiles
+///////////////////////////////////////////////////////////////////////////////
+
+void OcclusionCuller::beginFrame(const QMatrix4x4 & viewProjection)
+{
+    m_viewProjection = viewProjection;
+    m_triangles.clear();
+    for (std::vector<quint32> & bin : m_bins)
+        bin.clear();
+
+    m_occluders = 0;
+    m_binNanoseconds = 0;
+    m_rasterNanoseconds = 0;
+}
+
+OcclusionCuller::Statistics OcclusionCuller::statistics() const
+{
+    Statistics statistics;
+    statistics.occluders = m_occluders;
+    statistics.triangles = int(m_triangles.size());
+    statistics.binNanoseconds = m_binNanoseconds;
+    statistics.rasterNanoseconds = m_rasterNanoseconds.load();
+    return statistics;
+}
+
+void OcclusionCuller::addOccluder(const OccluderMesh & mesh, const QMatrix4x4 & model)
+{
+    QElapsedTimer timer;
+    timer.start();
+    m_occluders++;
+
+    // Clip space positions, 4 floats per vertex
+    const QMatrix4x4 modelViewProjection = m_viewProjection * model;
+    const float * matrix = modelViewProjection.constData(); // column major
+    m_clip.resize(size_t(mesh.vertexCount) * 4);
+    for (int vv = 0; vv < mesh.vertexCount; ++vv)
+    {
+        const float * p = mesh.vertices + size_t(vv) * mesh.floatStride;
+#ifdef OCCLUSION_CULLER_SSE
+        __m128 clip = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(matrix), _mm_set1_ps(p[0])),
+                                 _mm_mul_ps(_mm_loadu_ps(matrix + 4), _mm_set1_ps(p[1])));
+        clip = _mm_add_ps(clip, _mm_mul_ps(_mm_loadu_ps(matrix + 8), _mm_set1_ps(p[2])));
+        clip = _mm_add_ps(clip, _mm_loadu_ps(matrix + 12));
+        _mm_storeu_ps(&m_clip[size_t(vv) * 4], clip);
+#else
+        for (int row = 0; row < 4; ++row)
+            m_clip[size_t(vv) * 4 + row] = matrix[row] * p[0] + matrix[4 + row] * p[1] + matrix[8 + row] * p[2] + matrix[12 + row];
+#endif
+    }
+
+    // A mirroring model matrix turns the winding around
+    const float * m = model.constData();
+    const float determinant = m[0] * (m[5] * m[10] - m[9] * m[6]) -
+                              m[4] * (m[1] * m[10] - m[9] * m[2]) +
+                              m[8] * (m[1] * m[6] - m[5] * m[2]);
+    const bool mirrored = determinant < 0.0f;
+    const float halfWidth = 0.5f * float(m_width);
+    const float halfHeight = 0.5f * float(m_height);
+
+    for (int ii = 0; ii + 2 < mesh.indexCount; ii += 3)
+    {
+        ScreenTriangle triangle;
+        bool behindNearPlane = false;
+        for (int cc = 0; cc < 3; ++cc)
+        {
+            const float * clip = &m_clip[size_t(mesh.indices[ii + cc]) * 4];
+            // Not clipped: an occluder triangle crossing the near plane is just left out (conservative)
+            if (clip[3] <= 1.0e-5f || clip[2] < -clip[3])
+            {
+                behindNearPlane = true;
+                break;
+            }
+            const float inverseW = 1.0f / clip[3];
+            triangle.x[cc] = (clip[0] * inverseW + 1.0f) * halfWidth;
+            triangle.y[cc] = (clip[1] * inverseW + 1.0f) * halfHeight;
+            triangle.z[cc] = clip[2] * inverseW;
+        }
+        if (behindNearPlane)
+            continue;
+
+        // Counter clockwise is the front, back faces are behind the front anyway
+        float area = (triangle.x[1] - triangle.x[0]) * (triangle.y[2] - triangle.y[0]) -
+                     (triangle.x[2] - triangle.x[0]) * (triangle.y[1] - triangle.y[0]);
+        if (mirrored)
+            area = -area;
+        if (area <= 0.0f)
+            continue;
+        if (mirrored)
+        {
+            std::swap(triangle.x[1], triangle.x[2]);
+            std::swap(triangle.y[1], triangle.y[2]);
+            std::swap(triangle.z[1], triangle.z[2]);
+        }
+
+        const float minX = std::min({ triangle.x[0], triangle.x[1], triangle.x[2] });
+        const float maxX = std::max({ triangle.x[0], triangle.x[1], triangle.x[2] });
+        const float minY = std::min({ triangle.y[0], triangle.y[1], triangle.y[2] });
+        const float maxY = std::max({ triangle.y[0], triangle.y[1], triangle.y[2] });
+        if (maxX < 0.0f || maxY < 0.0f || minX >= float(m_width) || minY >= float(m_height))
+            continue;
+
+        const int tileX0 = qBound(0, int(minX) / TILE_SIZE, m_tilesX - 1);
+        const int tileX1 = qBound(0, int(maxX) / TILE_SIZE, m_tilesX - 1);
+        const int tileY0 = qBound(0, int(minY) / TILE_SIZE, m_tilesY - 1);
+        const int tileY1 = qBound(0, int(maxY) / TILE_SIZE, m_tilesY - 1);
+
+        const quint32 index = quint32(m_triangles.size());
+        m_triangles.push_back(triangle);
+        for (int ty = tileY0; ty <= tileY1; ++ty)
+        {
+            for (int tx = tileX0; tx <= tileX1; ++tx)
+                m_bins[size_t(ty) * m_tilesX + tx].push_back(index);
+        }
+    }
+    m_binNanoseconds += timer.nsecsElapsed();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Rasterize - one tile per job, the tiles do not share any pixel
+///////////////////////////////////////////////////////////////////////////////
+
+void OcclusionCuller::rasterize(JobSystem & jobs, JobCounter & counter)
+{
+    for (int tile = 0; tile < tileCount(); ++tile)
+    {
+        Job job;
+        job.function = &OcclusionCuller::rasterizeJob;
+        job.data = this;
+        job.begin = tile;
+        job.end = tile + 1;
+        job.counter = &counter;
+        jobs.submit(job);
+    }
+}
+
+void OcclusionCuller::rasterizeJob(void * data, int begin, int end)
+{
+    static_cast<OcclusionCuller *>(data)->rasterizeTiles(begin, end);
+}
+
+void OcclusionCuller::rasterizeTiles(int beginTile, int endTile)
+{
+    QElapsedTimer timer;
+    timer.start();
+    for (int tile = beginTile; tile < endTile; ++tile)
+        rasterizeTile(tile);
+    m_rasterNanoseconds += timer.nsecsElapsed();
+}
+
+void OcclusionCuller::rasterizeTile(int tile)
+{
+    const int tileX = tile % m_tilesX;
+    const int tileY = tile / m_tilesX;
+    const int tileLeft = tileX * TILE_SIZE;
+    const int tileBottom = tileY * TILE_SIZE;
+
+    for (int yy = tileBottom; yy < tileBottom + TILE_SIZE; ++yy)
+        std::fill_n(&m_depth[size_t(yy) * m_width + tileLeft], TILE_SIZE, CLEAR_DEPTH);
+
+    for (quint32 index : m_bins[size_t(tile)])
+    {
+        const ScreenTriangle & t = m_triangles[index];
+
+        // Edge functions, positive inside (counter clockwise)
+        float edgeA[3];
+        float edgeB[3];
+        float edgeC[3];
+        for (int ee = 0; ee < 3; ++ee)
+        {
+            const int next = (ee + 1) % 3;
+            edgeA[ee] = t.y[ee] - t.y[next];
+            edgeB[ee] = t.x[next] - t.x[ee];
+            edgeC[ee] = t.x[ee] * t.y[next] - t.x[next] * t.y[ee];
+        }
+
+        // Depth plane z = z0 + dzdx (x - x0) + dzdy (y - y0)
+        const float area = (t.x[1] - t.x[0]) * (t.y[2] - t.y[0]) - (t.x[2] - t.x[0]) * (t.y[1] - t.y[0]);
+        const float dzdx = ((t.z[1] - t.z[0]) * (t.y[2] - t.y[0]) - (t.z[2] - t.z[0]) * (t.y[1] - t.y[0])) / area;
+        const float dzdy = ((t.z[2] - t.z[0]) * (t.x[1] - t.x[0]) - (t.z[1] - t.z[0]) * (t.x[2] - t.x[0])) / area;
+        const float zAtOrigin = t.z[0] - dzdx * t.x[0] - dzdy * t.y[0];
+
+        // Bounding box inside the tile, x aligned to 4 pixels
+        const int x0 = qMax(tileLeft, int(std::floor(std::min({ t.x[0], t.x[1], t.x[2] })))) & ~3;
+        const int x1 = qMin(tileLeft + TILE_SIZE - 1, int(std::ceil(std::max({ t.x[0], t.x[1], t.x[2] }))));
+        const int y0 = qMax(tileBottom, int(std::floor(std::min({ t.y[0], t.y[1], t.y[2] }))));
+        const int y1 = qMin(tileBottom + TILE_SIZE - 1, int(std::ceil(std::max({ t.y[0], t.y[1], t.y[2] }))));
+
+        for (int yy = y0; yy <= y1; ++yy)
+        {
+            const float py = float(yy) + 0.5f;
+            float * row = &m_depth[size_t(yy) * m_width];
+#ifdef OCCLUSION_CULLER_SSE
+            const __m128 offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+            const __m128 zero = _mm_setzero_ps();
+            for (int xx = x0; xx <= x1; xx += 4)
+            {
+                const __m128 px = _mm_add_ps(_mm_set1_ps(float(xx)), offsets);
+                __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+                for (int ee = 0; ee < 3; ++ee)
+                {
+                    const __m128 edge = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edgeA[ee]), px), _mm_set1_ps(edgeB[ee] * py + edgeC[ee]));
+                    inside = _mm_and_ps(inside, _mm_cmpge_ps(edge, zero));
+                }
+                if (_mm_movemask_ps(inside) == 0)
+                    continue;
+                const __m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(dzdx), px), _mm_set1_ps(zAtOrigin + dzdy * py));
+                const __m128 depth = _mm_loadu_ps(row + xx);
+                const __m128 nearer = _mm_min_ps(depth, z);
+                _mm_storeu_ps(row + xx, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, depth)));
+            }
+#else
+            for (int xx = x0; xx <= x1; ++xx)
+            {
+                const float px = float(xx) + 0.5f;
+                if (edgeA[0] * px + edgeB[0] * py + edgeC[0] < 0.0f ||
+                    edgeA[1] * px + edgeB[1] * py + edgeC[1] < 0.0f ||
+                    edgeA[2] * px + edgeB[2] * py + edgeC[2] < 0.0f)
+                    continue;
+                row[xx] = std::min(row[xx], zAtOrigin + dzdx * px + dzdy * py);
+            }
+#endif
+        }
+    }
+
+    updateBlocks(tileX, tileY);
+}
+
+void OcclusionCuller::updateBlocks(int tileX, int tileY)
+{
+    const int blocksPerTile = TILE_SIZE / BLOCK_SIZE;
+    for (int by = tileY * blocksPerTile; by < (tileY + 1) * blocksPerTile; ++by)
+    {
+        for (int bx = tileX * blocksPerTile; bx < (tileX + 1) * blocksPerTile; ++bx)
+        {
+            float minimum = CLEAR_DEPTH;
+            float maximum = -CLEAR_DEPTH;
+            for (int yy = by * BLOCK_SIZE; yy < (by + 1) * BLOCK_SIZE; ++yy)
+            {
+                const float * row = &m_depth[size_t(yy) * m_width + size_t(bx) * BLOCK_SIZE];
+                for (int xx = 0; xx < BLOCK_SIZE; ++xx)
+                {
+                    minimum = std::min(minimum, row[xx]);
+                    maximum = std::max(maximum, row[xx]);
+                }
+            }
+            m_blockMin[size_t(by) * m_blocksX + bx] = minimum;
+            m_blockMax[size_t(by) * m_blocksX + bx] = maximum;
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Test
+///////////////////////////////////////////////////////////////////////////////
+
+bool OcclusionCuller::isVisible(const QVector3D & center, const QVector3D & extents) const
+{
+    // Screen rectangle and nearest depth of the box corners
+    float minX = CLEAR_DEPTH, minY = CLEAR_DEPTH, minZ = CLEAR_DEPTH;
+    float maxX = -CLEAR_DEPTH, maxY = -CLEAR_DEPTH;
+    const float * matrix = m_viewProjection.constData();
+    for (int corner = 0; corner < 8; ++corner)
+    {
+        const float px = center.x() + ((corner & 1) ? extents.x() : -extents.x());
+        const float py = center.y() + ((corner & 2) ? extents.y() : -extents.y());
+        const float pz = center.z() + ((corner & 4) ? extents.z() : -extents.z());
+        float clip[4];
+        for (int row = 0; row < 4; ++row)
+            clip[row] = matrix[row] * px + matrix[4 + row] * py + matrix[8 + row] * pz + matrix[12 + row];
+
+        // Crossing the near plane, too close to decide
+        if (clip[3] <= 1.0e-5f || clip[2] < -clip[3])
+            return true;
+
+        const float inverseW = 1.0f / clip[3];
+        const float sx = (clip[0] * inverseW + 1.0f) * 0.5f * float(m_width);
+        const float sy = (clip[1] * inverseW + 1.0f) * 0.5f * float(m_height);
+        minX = std::min(minX, sx);
+        maxX = std::max(maxX, sx);
+        minY = std::min(minY, sy);
+        maxY = std::max(maxY, sy);
+        minZ = std::min(minZ, clip[2] * inverseW);
+    }
+
+    // Every pixel the rectangle touches
+    const int x0 = qMax(0, int(std::floor(minX)));
+    const int x1 = qMin(m_width - 1, int(std::floor(maxX)));
+    const int y0 = qMax(0, int(std::floor(minY)));
+    const int y1 = qMin(m_height - 1, int(std::floor(maxY)));
+    if (x0 > x1 || y0 > y1)
+        return true; // off screen, that is the frustum test's decision
+
+    for (int by = y0 / BLOCK_SIZE; by <= y1 / BLOCK_SIZE; ++by)
+    {
+        for (int bx = x0 / BLOCK_SIZE; bx <= x1 / BLOCK_SIZE; ++bx)
+        {
+            const size_t block = size_t(by) * m_blocksX + bx;
+            if (minZ < m_blockMin[block])
+                return true;    // nearer than everything in the block
+            if (minZ >= m_blockMax[block])
+                continue;       // behind everything in the block
+
+            // Partly covered block, check the pixels in the rectangle
+            const int px0 = qMax(x0, bx * BLOCK_SIZE);
+            const int px1 = qMin(x1, bx * BLOCK_SIZE + BLOCK_SIZE - 1);
+            const int py0 = qMax(y0, by * BLOCK_SIZE);
+            const int py1 = qMin(y1, by * BLOCK_SIZE + BLOCK_SIZE - 1);
+            for (int yy = py0; yy <= py1; ++yy)
+            {
+                const float * row = &m_depth[size_t(yy) * m_width];
+                for (int xx = px0; xx <= px1; ++xx)
+                {
+                    if (minZ < row[xx])
+                        return true;
+                }
+            }
+        }
+    }
+    return false;
+}
@@ -0,0 +1,113 @@
+#pragma once
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include <QMatrix4x4>
+#include <QVector3D>
+
+#include <atomic>
+#include <vector>
+
+class JobSystem;
+class JobCounter;
+
+///
+/// \brief Triangle mesh used as occluder, positions (3 floats) at the start of
+/// each vertex. The data is not copied, it must stay alive.
+///
+struct OccluderMesh
+{
+    const float * vertices {nullptr};
+    int vertexCount {0};
+    int floatStride {3};
+    const quint16 * indices {nullptr};
+    int indexCount {0};
+};
+
+///
+/// \brief The OcclusionCuller is a small software rasterizer for occlusion
+/// culling on the CPU. A few large occluders are rendered into a low resolution
+/// depth buffer, then the bounding boxes of the other objects are tested
+/// against it. The screen is split into tiles that are rasterized in parallel
+/// (SSE, 4 pixels at a time). Every 8x8 block keeps its min. and max. depth, so
+/// most box tests are decided without looking at single pixels.
+///
+/// Per frame: beginFrame(), addOccluder()... on one thread, rasterize(),
+/// then isVisible() from any thread.
+///
+class OcclusionCuller
+{
+public:
+    static constexpr int TILE_SIZE = 32;
+    static constexpr int BLOCK_SIZE = 8;
+
+    struct Statistics
+    {
+        int occluders {0};
+        int triangles {0};              // in the bins, after near plane and back face culling
+        qint64 binNanoseconds {0};      // addOccluder() on the calling thread
+        qint64 rasterNanoseconds {0};   // sum over all tiles (CPU time, not wall time)
+    };
+
+    // width and height are rounded up to whole tiles
+    explicit OcclusionCuller(int width = 256, int height = 128);
+
+    void beginFrame(const QMatrix4x4 & viewProjection);
+    void addOccluder(const OccluderMesh & mesh, const QMatrix4x4 & model);
+
+    // All tiles on the job system, wait on the counter before testing
+    void rasterize(JobSystem & jobs, JobCounter & counter);
+    // Single threaded, or a part of the tiles
+    void rasterizeTiles(int beginTile, int endTile);
+    int tileCount() const { return m_tilesX * m_tilesY; }
+
+    // World space box, false if it is completely hidden behind the occluders
+    bool isVisible(const QVector3D & center, const QVector3D & extents) const;
+
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+    const float * depth() const { return m_depth.data(); }
+
+    // Of the current frame, complete after the rasterization
+    Statistics statistics() const;
+
+private:
+    struct ScreenTriangle
+    {
+        float x[3];
+        float y[3];
+        float z[3];
+    };
+
+    static void rasterizeJob(void * data, int begin, int end);
+    void rasterizeTile(int tile);
+    void updateBlocks(int tileX, int tileY);
+
+    int m_width {0};
+    int m_height {0};
+    int m_tilesX {0};
+    int m_tilesY {0};
+    int m_blocksX {0};
+    QMatrix4x4 m_viewProjection;
+
+    // Capacity is kept between frames, no steady state allocations
+    std::vector<float> m_depth;
+    std::vector<float> m_blockMin;
+    std::vector<float> m_blockMax;
+    std::vector<ScreenTriangle> m_triangles;
+    std::vector<std::vector<quint32>> m_bins;
+    std::vector<float> m_clip;
+
+    int m_occluders {0};
+    qint64 m_binNanoseconds {0};
+    std::atomic<qint64> m_rasterNanoseconds {0};
+};
@@ -0,0 +1,265 @@
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "occlusionqueries.h"
+
+#include <QDebug>
+
+namespace
+{
+    // Objects not tested for this many frames give their query back
+    constexpr quint64 UNUSED_FRAMES = 120;
+
+    const char * BOX_VERTEX_SHADER =
+        "#version 330 core\n"
+        "layout (location = 0) in vec3 pos;\n"
+        "uniform mat4 mvp;\n"
+        "void main() { gl_Position = mvp * vec4(pos, 1.0); }\n";
+
+    const char * BOX_FRAGMENT_SHADER =
+        "#version 330 core\n"
+        "out vec4 frag_color;\n"
+        "void main() { frag_color = vec4(1.0); }\n";
+}
+
+OcclusionQueries::~OcclusionQueries()
+{
+    destroy();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Create
+///////////////////////////////////////////////////////////////////////////////
+
+bool OcclusionQueries::create()
+{
+    destroy();
+    initializeOpenGLFunctions();
+
+    if (!m_program.addShaderFromSourceCode(QOpenGLShader::Vertex, BOX_VERTEX_SHADER) ||
+        !m_program.addShaderFromSourceCode(QOpenGLShader::Fragment, BOX_FRAGMENT_SHADER) ||
+        !m_program.link())
+    {
+        qWarning() << "Occlusion queries : box shader FAILED" << m_program.log();
+        m_program.removeAllShaders();
+        return false;
+    }
+    m_mvpLocation = m_program.uniformLocation("mvp");
+
+    // Unit box (-1..1), both windings are drawn (no face culling is needed)
+    const float vertices[] = {
+        -1.0f, -1.0f, -1.0f,   1.0f, -1.0f, -1.0f,   1.0f, 1.0f, -1.0f,   -1.0f, 1.0f, -1.0f,
+        -1.0f, -1.0f,  1.0f,   1.0f, -1.0f,  1.0f,   1.0f, 1.0f,  1.0f,   -1.0f, 1.0f,  1.0f };
+    const quint16 indices[] = {
+        4, 5, 6,  4, 6, 7,
+        1, 0, 3,  1, 3, 2,
+        5, 1, 2,  5, 2, 6,
+        0, 4, 7,  0, 7, 3,
+        7, 6, 2,  7, 2, 3,
+        0, 1, 5,  0, 5, 4 };
+
+    glGenVertexArrays(1, &m_vao);
+    glBindVertexArray(m_vao);
+    glGenBuffers(2, m_buffers);
+    glBindBuffer(GL_ARRAY_BUFFER, m_buffers[0]);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), nullptr);
+    glEnableVertexAttribArray(0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_buffers[1]);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+    glBindVertexArray(0);
+
+    qInfo() << "Occlusion queries : created";
+    return true;
+}
+
+void OcclusionQueries::destroy()
+{
+    if (!m_vao)
+        return;
+
+    for (const auto & entry : m_states)
+        m_freeQueries.push_back(entry.second.query);
+    if (!m_freeQueries.empty())
+        glDeleteQueries(GLsizei(m_freeQueries.size()), m_freeQueries.data());
+    m_freeQueries.clear();
+    m_states.clear();
+    m_boxes.clear();
+
+    glDeleteVertexArrays(1, &m_vao);
+    glDeleteBuffers(2, m_buffers);
+    m_vao = 0;
+    m_program.removeAllShaders();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Per frame
+///////////////////////////////////////////////////////////////////////////////
+
+void OcclusionQueries::beginFrame(const QMatrix4x4 & viewProjection, const QVector3D & cameraPosition)
+{
+    m_viewProjection = viewProjection;
+    m_cameraPosition = cameraPosition;
+    m_frame++;
+    m_boxes.clear();
+    m_statistics = Statistics();
+
+    if (m_frame % UNUSED_FRAMES == 0)
+        releaseUnused();
+}
+
+OcclusionQueries::Result OcclusionQueries::result(quint32 key, const QVector3D & center, const QVector3D & extents)
+{
+    m_statistics.tested++;
+    State & state = m_states[key];
+    state.lastFrame = m_frame;
+
+    // The box would be clipped by the near plane, its query means nothing
+    if (containsCamera(center, extents))
+    {
+        state.visible = true;
+        return Result::Visible;
+    }
+
+    if (state.pending)
+    {
+        GLuint available = GL_FALSE;
+        glGetQueryObjectuiv(state.query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+        {
+            m_statistics.pending++;
+            return Result::Pending;
+        }
+        GLuint samplesPassed = GL_FALSE;
+        glGetQueryObjectuiv(state.query, GL_QUERY_RESULT, &samplesPassed);
+        state.pending = false;
+        state.visible = samplesPassed != GL_FALSE;
+    }
+
+    if (!state.visible)
+    {
+        m_statistics.occluded++;
+        return Result::Occluded;
+    }
+    return Result::Visible;
+}
+
+void OcclusionQueries::beginConditionalRender(quint32 key)
+{
+    const auto found = m_states.find(key);
+    if (found == m_states.end() || !found->second.pending)
+        return;
+
+    // NO_WAIT: if the GPU has no result yet it draws anyway
+    glBeginConditionalRender(found->second.query, GL_QUERY_NO_WAIT);
+    m_conditionalActive = true;
+}
+
+void OcclusionQueries::endConditionalRender()
+{
+    if (!m_conditionalActive)
+        return;
+    glEndConditionalRender();
+    m_conditionalActive = false;
+}
+
+void OcclusionQueries::add(quint32 key, const QVector3D & center, const QVector3D & extents)
+{
+    State & state = m_states[key];
+    state.lastFrame = m_frame;
+    if (state.pending || containsCamera(center, extents))
+        return;
+
+    if (!state.query)
+    {
+        if (!m_freeQueries.empty())
+        {
+            state.query = m_freeQueries.back();
+            m_freeQueries.pop_back();
+        }
+        else
+        {
+            glGenQueries(1, &state.query);
+        }
+    }
+    state.pending = true;
+    m_boxes.push_back(Box{state.query, center, extents});
+}
+
+void OcclusionQueries::end()
+{
+    if (m_boxes.empty() || !m_vao)
+        return;
+
+    // Only the depth test, nothing is written
+    GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+    glEnable(GL_DEPTH_TEST);
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glDepthMask(GL_FALSE);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+
+    m_program.bind();
+    glBindVertexArray(m_vao);
+    for (const Box & box : m_boxes)
+    {
+        QMatrix4x4 mvp = m_viewProjection;
+        mvp.translate(box.center);
+        mvp.scale(box.extents);
+        glUniformMatrix4fv(m_mvpLocation, 1, GL_FALSE, mvp.constData());
+
+        glBeginQuery(GL_ANY_SAMPLES_PASSED, box.query);
+        glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_SHORT, nullptr);
+        glEndQuery(GL_ANY_SAMPLES_PASSED);
+    }
+    glBindVertexArray(0);
+    m_program.release();
+
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glDepthMask(GL_TRUE);
+    if (!depthTest)
+        glDisable(GL_DEPTH_TEST);
+
+    m_statistics.issued = int(m_boxes.size());
+    m_boxes.clear();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Helper
+///////////////////////////////////////////////////////////////////////////////
+
+bool OcclusionQueries::containsCamera(const QVector3D & center, const QVector3D & extents) const
+{
+    // A bit larger than the box, the near plane is in front of the camera
+    const float margin = 0.2f;
+    const QVector3D distance = m_cameraPosition - center;
+    return qAbs(distance.x()) <= extents.x() + margin &&
+           qAbs(distance.y()) <= extents.y() + margin &&
+           qAbs(distance.z()) <= extents.z() + margin;
+}
+
+void OcclusionQueries::releaseUnused()
+{
+    for (auto it = m_states.begin(); it != m_states.end();)
+    {
+        const State & state = it->second;
+        if (!state.pending && m_frame - state.lastFrame > UNUSED_FRAMES)
+        {
+            if (state.query)
+                m_freeQueries.push_back(state.query);
+            it = m_states.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
@@ -0,0 +1,114 @@
+#pragma once
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include <QOpenGLFunctions_3_3_Core>
+#include <QOpenGLShaderProgram>
+#include <QMatrix4x4>
+#include <QVector3D>
+
+#include <unordered_map>
+#include <vector>
+
+///
+/// \brief The OcclusionQueries class decides on the GPU if objects are hidden.
+/// After the scene is drawn, the bounding box of each object is rendered with
+/// color and depth writes off inside a GL_ANY_SAMPLES_PASSED query.
+/// The results are only read when they are available (temporal coherence: the
+/// result of a previous frame decides this frame), so the CPU never waits.
+/// While a query is still in flight the object is drawn inside
+/// beginConditionalRender(), the GPU then skips it if the query found no samples.
+/// Objects are identified by a key (e.g. the entity).
+///
+/// Per frame: beginFrame(), result() for each object before drawing it,
+/// add() for each object, end() after the scene is drawn.
+/// Only call from the OpenGL thread with the context current.
+///
+class OcclusionQueries : public QOpenGLFunctions_3_3_Core
+{
+public:
+    enum class Result
+    {
+        Visible,    // draw it
+        Occluded,   // skip it
+        Pending     // the query is in flight, draw it with conditional rendering
+    };
+
+    struct Statistics
+    {
+        int tested {0};     // last frame
+        int occluded {0};
+        int pending {0};
+        int issued {0};
+    };
+
+    OcclusionQueries() = default;
+    ~OcclusionQueries();
+
+    OcclusionQueries(const OcclusionQueries &) = delete;
+    OcclusionQueries & operator=(const OcclusionQueries &) = delete;
+
+    bool create();
+    void destroy();
+    bool isCreated() const { return m_vao != 0; }
+
+    void beginFrame(const QMatrix4x4 & viewProjection, const QVector3D & cameraPosition);
+
+    // Last known result, never waits for the GPU. center and extents are the world space box.
+    Result result(quint32 key, const QVector3D & center, const QVector3D & extents);
+
+    // Draws between begin and end are skipped by the GPU if the pending query of the object failed
+    void beginConditionalRender(quint32 key);
+    void endConditionalRender();
+
+    // Queue the box query of the object, nothing if its last query is still in flight
+    void add(quint32 key, const QVector3D & center, const QVector3D & extents);
+
+    // Draw the queued boxes against the depth buffer of the scene.
+    // Binds its own program and VAO, both are unbound afterwards.
+    void end();
+
+    const Statistics & statistics() const { return m_statistics; }
+
+private:
+    struct State
+    {
+        GLuint query {0};
+        bool pending {false};
+        bool visible {true};
+        quint64 lastFrame {0};
+    };
+    struct Box
+    {
+        GLuint query {0};
+        QVector3D center;
+        QVector3D extents;
+    };
+
+    bool containsCamera(const QVector3D & center, const QVector3D & extents) const;
+    void releaseUnused();
+
+    QOpenGLShaderProgram m_program;
+    GLint m_mvpLocation {-1};
+    GLuint m_vao {0};
+    GLuint m_buffers[2] {};
+
+    std::unordered_map<quint32, State> m_states;
+    std::vector<GLuint> m_freeQueries;
+    std::vector<Box> m_boxes;
+
+    QMatrix4x4 m_viewProjection;
+    QVector3D m_cameraPosition;
+    quint64 m_frame {0};
+    bool m_conditionalActive {false};
+    Statistics m_statistics;
+};
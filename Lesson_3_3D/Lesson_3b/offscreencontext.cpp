@@ -0,0 +1,53 @@
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "offscreencontext.h"
+
+#include <QDebug>
+#include <QSurfaceFormat>
+
+OffscreenContext::~OffscreenContext()
+{
+    if (!m_framebuffer)
+        return;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteRenderbuffers(2, m_renderbuffers);
+    glDeleteFramebuffers(1, &m_framebuffer);
+}
+
+bool OffscreenContext::create(int targetSize)
+{
+    m_surface.setFormat(QSurfaceFormat::defaultFormat());
+    m_surface.create();
+    m_context.setFormat(QSurfaceFormat::defaultFormat());
+    if (!m_context.create() || !m_context.makeCurrent(&m_surface))
+    {
+        qWarning() << "Benchmark : no OpenGL context";
+        return false;
+    }
+    if (targetSize <= 0)
+        return true;
+
+    initializeOpenGLFunctions();
+    glGenFramebuffers(1, &m_framebuffer);
+    glGenRenderbuffers(2, m_renderbuffers);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_renderbuffers[0]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, targetSize, targetSize);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_renderbuffers[1]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, targetSize, targetSize);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_renderbuffers[0]);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_renderbuffers[1]);
+    glViewport(0, 0, targetSize, targetSize);
+    return true;
+}
@@ -0,0 +1,40 @@
+#pragma once
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions_3_3_Core>
+
+///
+/// \brief Current OpenGL context without a window for the GPU benchmarks,
+/// optionally with a bound framebuffer (color and depth) of targetSize pixels
+///
+class OffscreenContext : protected QOpenGLFunctions_3_3_Core
+{
+public:
+    OffscreenContext() = default;
+    ~OffscreenContext();
+
+    OffscreenContext(const OffscreenContext &) = delete;
+    OffscreenContext & operator=(const OffscreenContext &) = delete;
+
+    bool create(int targetSize = 0);
+
+    QOpenGLContext & context() { return m_context; }
+
+private:
+    QOffscreenSurface m_surface;
+    QOpenGLContext m_context;
+    GLuint m_framebuffer {0};
+    GLuint m_renderbuffers[2] {};
+};
@@ -0,0 +1,259 @@
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "pixelconversion.h"
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define PIXEL_CONVERSION_SSE 1
+#endif
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#define PIXEL_CONVERSION_SSSE3 1
+#endif
+
+namespace
+{
+    // The 32 bit QImage formats are 0xAARRGGBB values, B G R A bytes on little endian machines
+    constexpr bool LITTLE_ENDIAN_TEXELS = Q_BYTE_ORDER == Q_LITTLE_ENDIAN;
+
+    inline uchar multiplyAlpha(uint color, uint alpha)
+    {
+        // color * alpha / 255, rounded
+        const uint product = color * alpha + 128;
+        return uchar((product + (product >> 8)) >> 8);
+    }
+
+    // RGB888 into a new RGBA8888 image, flipped while copying
+    QImage expandRgb(const QImage & image, bool flip)
+    {
+        QImage rgba(image.size(), QImage::Format_RGBA8888);
+        const int height = image.height();
+        for (int yy = 0; yy < height; ++yy)
+            PixelConversion::rgbToRgba(image.constScanLine(yy), rgba.scanLine(flip ? height - 1 - yy : yy), image.width());
+        return rgba;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Upload
+///////////////////////////////////////////////////////////////////////////////
+
+PixelConversion::Upload PixelConversion::prepareUpload(QImage image, const Options & options)
+{
+    Upload upload;
+    bool flip = options.flip;
+
+    switch (image.format())
+    {
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32:
+    case QImage::Format_ARGB32_Premultiplied:
+        // Native: GL_BGRA with GL_UNSIGNED_INT_8_8_8_8_REV reads the 0xAARRGGBB values
+        upload.pixelFormat = QOpenGLTexture::BGRA;
+        upload.pixelType = QOpenGLTexture::UInt32_RGBA8_Rev;
+        break;
+    case QImage::Format_RGBA8888:
+    case QImage::Format_RGBX8888:
+    case QImage::Format_RGBA8888_Premultiplied:
+        break;
+    case QImage::Format_RGB888:
+        image = expandRgb(image, flip);
+        upload.bytesCopied += image.sizeInBytes();
+        flip = false;
+        break;
+    default:
+        image = toRgba8888(std::move(image), &upload.bytesCopied);
+        break;
+    }
+
+    if (flip)
+    {
+        flipVertical(image);
+        upload.bytesCopied += image.sizeInBytes();
+    }
+
+    if (options.premultiply)
+    {
+        if (image.format() == QImage::Format_ARGB32 && LITTLE_ENDIAN_TEXELS)
+        {
+            premultiply(image.bits(), image.width() * image.height());
+            image.reinterpretAsFormat(QImage::Format_ARGB32_Premultiplied);
+            upload.bytesCopied += image.sizeInBytes();
+        }
+        else if (image.format() == QImage::Format_RGBA8888)
+        {
+            premultiply(image.bits(), image.width() * image.height());
+            image.reinterpretAsFormat(QImage::Format_RGBA8888_Premultiplied);
+            upload.bytesCopied += image.sizeInBytes();
+        }
+        else if (image.format() == QImage::Format_ARGB32)
+        {
+            image.convertTo(QImage::Format_ARGB32_Premultiplied);
+            upload.bytesCopied += image.sizeInBytes();
+        }
+    }
+
+    upload.image = std::move(image);
+    return upload;
+}
+
+QImage PixelConversion::toRgba8888(QImage image, qint64 * bytesCopied)
+{
+    qint64 bytes = 0;
+    switch (image.format())
+    {
+    case QImage::Format_RGBA8888:
+        break;
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32:
+        if (LITTLE_ENDIAN_TEXELS)
+        {
+            // Same size, swap R and B in place (RGB32 has alpha 0xFF already)
+            bgraToRgba(image.bits(), image.bits(), image.width() * image.height());
+            image.reinterpretAsFormat(QImage::Format_RGBA8888);
+        }
+        else
+        {
+            image = image.convertToFormat(QImage::Format_RGBA8888);
+        }
+        bytes = image.sizeInBytes();
+        break;
+    case QImage::Format_RGB888:
+        image = expandRgb(image, false);
+        bytes = image.sizeInBytes();
+        break;
+    default:
+        image = image.convertToFormat(QImage::Format_RGBA8888);
+        bytes = image.sizeInBytes();
+        break;
+    }
+
+    if (bytesCopied)
+        *bytesCopied += bytes;
+    return image;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Kernels
+///////////////////////////////////////////////////////////////////////////////
+
+void PixelConversion::bgraToRgba(const uchar * source, uchar * destination, int texels)
+{
+    int ii = 0;
+#ifdef PIXEL_CONVERSION_SSE
+    // Swap byte 0 and 2 of every texel, 4 texels at a time
+    const __m128i maskGreenAlpha = _mm_set1_epi32(int(0xFF00FF00u));
+    const __m128i maskLow = _mm_set1_epi32(0x000000FF);
+    for (; ii + 4 <= texels; ii += 4)
+    {
+        const __m128i bgra = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + ii * 4));
+        const __m128i red = _mm_and_si128(_mm_srli_epi32(bgra, 16), maskLow);
+        const __m128i blue = _mm_slli_epi32(_mm_and_si128(bgra, maskLow), 16);
+        const __m128i rgba = _mm_or_si128(_mm_and_si128(bgra, maskGreenAlpha), _mm_or_si128(red, blue));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(destination + ii * 4), rgba);
+    }
+#endif
+    for (; ii < texels; ++ii)
+    {
+        const uchar blue = source[ii * 4 + 0];
+        const uchar red = source[ii * 4 + 2];
+        destination[ii * 4 + 0] = red;
+        destination[ii * 4 + 1] = source[ii * 4 + 1];
+        destination[ii * 4 + 2] = blue;
+        destination[ii * 4 + 3] = source[ii * 4 + 3];
+    }
+}
+
+void PixelConversion::rgbToRgba(const uchar * source, uchar * destination, int texels)
+{
+    int ii = 0;
+#ifdef PIXEL_CONVERSION_SSSE3
+    // 16 bytes loaded, 4 texels (12 bytes) used: stop 6 texels before the end
+    const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m128i alpha = _mm_set1_epi32(int(0xFF000000u));
+    for (; ii + 6 <= texels; ii += 4)
+    {
+        const __m128i rgb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + ii * 3));
+        const __m128i rgba = _mm_or_si128(_mm_shuffle_epi8(rgb, shuffle), alpha);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(destination + ii * 4), rgba);
+    }
+#endif
+    for (; ii < texels; ++ii)
+    {
+        destination[ii * 4 + 0] = source[ii * 3 + 0];
+        destination[ii * 4 + 1] = source[ii * 3 + 1];
+        destination[ii * 4 + 2] = source[ii * 3 + 2];
+        destination[ii * 4 + 3] = 0xFF;
+    }
+}
+
+void PixelConversion::premultiply(uchar * texels, int count)
+{
+    int ii = 0;
+#ifdef PIXEL_CONVERSION_SSE
+    // 16 bit lanes, 2 texels per register half
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i half = _mm_set1_epi16(128);
+    const __m128i maskAlpha = _mm_set1_epi32(int(0xFF000000u));
+    auto multiply = [&](__m128i color) {
+        __m128i alpha = _mm_shufflelo_epi16(color, _MM_SHUFFLE(3, 3, 3, 3));
+        alpha = _mm_shufflehi_epi16(alpha, _MM_SHUFFLE(3, 3, 3, 3));
+        const __m128i product = _mm_add_epi16(_mm_mullo_epi16(color, alpha), half);
+        return _mm_srli_epi16(_mm_add_epi16(product, _mm_srli_epi16(product, 8)), 8);
+    };
+    for (; ii + 4 <= count; ii += 4)
+    {
+        __m128i * pointer = reinterpret_cast<__m128i *>(texels + ii * 4);
+        const __m128i rgba = _mm_loadu_si128(pointer);
+        const __m128i low = multiply(_mm_unpacklo_epi8(rgba, zero));
+        const __m128i high = multiply(_mm_unpackhi_epi8(rgba, zero));
+        const __m128i premultiplied = _mm_packus_epi16(low, high);
+        // The alpha itself stays
+        _mm_storeu_si128(pointer, _mm_or_si128(_mm_andnot_si128(maskAlpha, premultiplied), _mm_and_si128(rgba, maskAlpha)));
+    }
+#endif
+    for (; ii < count; ++ii)
+    {
+        uchar * texel = texels + ii * 4;
+        const uint alpha = texel[3];
+        texel[0] = multiplyAlpha(texel[0], alpha);
+        texel[1] = multiplyAlpha(texel[1], alpha);
+        texel[2] = multiplyAlpha(texel[2], alpha);
+    }
+}
+
+void PixelConversion::flipVertical(QImage & image)
+{
+    const int height = image.height();
+    const qsizetype rowBytes = image.bytesPerLine();
+    if (height < 2)
+        return;
+
+    // Swap the rows from the outside in, through a chunk on the stack (no heap use)
+    constexpr size_t CHUNK_BYTES = 1024;
+    uchar chunk[CHUNK_BYTES];
+    for (int top = 0, bottom = height - 1; top < bottom; ++top, --bottom)
+    {
+        uchar * topLine = image.scanLine(top);
+        uchar * bottomLine = image.scanLine(bottom);
+        for (size_t offset = 0; offset < size_t(rowBytes); offset += CHUNK_BYTES)
+        {
+            const size_t bytes = qMin(CHUNK_BYTES, size_t(rowBytes) - offset);
+            memcpy(chunk, topLine + offset, bytes);
+            memcpy(topLine + offset, bottomLine + offset, bytes);
+            memcpy(bottomLine + offset, chunk, bytes);
+        }
+    }
+}
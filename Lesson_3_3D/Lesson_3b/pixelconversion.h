@@ -0,0 +1,59 @@
+#pragma once
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include <QImage>
+#include <QOpenGLTexture>
+
+///
+/// \brief The PixelConversion class prepares decoded images for the upload
+/// without the extra copies of QImage::mirrored() and convertToFormat().
+/// QImage decodes most files to Format_RGB32 / Format_ARGB32, a 32 bit 0xAARRGGBB
+/// value per texel, which OpenGL takes as it is with GL_BGRA and
+/// GL_UNSIGNED_INT_8_8_8_8_REV. Other formats are converted with SIMD kernels
+/// (SSE2 / SSSE3), in place where the size stays the same. The vertical flip
+/// for the OpenGL texture coordinates swaps the rows in place.
+///
+/// All functions can be called from any thread.
+///
+class PixelConversion
+{
+public:
+    struct Options
+    {
+        bool flip {true};           // bottom row first (OpenGL texture coordinates)
+        bool premultiply {false};   // color times alpha
+    };
+
+    ///
+    /// \brief Image ready for QOpenGLTexture::setData with the given format and type
+    ///
+    struct Upload
+    {
+        QImage image;
+        QOpenGLTexture::PixelFormat pixelFormat {QOpenGLTexture::RGBA};
+        QOpenGLTexture::PixelType pixelType {QOpenGLTexture::UInt8};
+        qint64 bytesCopied {0};     // written by the conversions (and copies of shared images)
+    };
+
+    // Pass the image with std::move to convert it in place
+    static Upload prepareUpload(QImage image, const Options & options);
+
+    // RGBA8888 in place where possible (e.g. for the array layers or the mip builder)
+    static QImage toRgba8888(QImage image, qint64 * bytesCopied = nullptr);
+
+    // Kernels on packed texels, source and destination may be the same (not for rgbToRgba)
+    static void bgraToRgba(const uchar * source, uchar * destination, int texels);
+    static void rgbToRgba(const uchar * source, uchar * destination, int texels);
+    static void premultiply(uchar * texels, int count);     // alpha in the 4th byte
+    static void flipVertical(QImage & image);
+};
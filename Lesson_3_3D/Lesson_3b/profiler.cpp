@@ -0,0 +1,179 @@
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "profiler.h"
+
+#include <QDebug>
+#include <QSaveFile>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+///
+/// \brief Ring of the last events of one thread. Written by its thread only,
+/// read by the export (events overwritten during the export may be torn,
+/// the oldest part of a full ring is skipped for that).
+///
+class Profiler::Track
+{
+public:
+    static constexpr quint64 CAPACITY = 32768;
+    static constexpr quint64 EXPORT_MARGIN = 1024;
+
+    struct Event
+    {
+        const char * name;
+        qint64 begin;
+        qint64 end;
+    };
+
+    Track(const QString & name, int id) : m_name(name), m_id(id), m_events(new Event[CAPACITY]) {}
+
+    void record(const char * name, qint64 begin, qint64 end)
+    {
+        const quint64 written = m_written.load(std::memory_order_relaxed);
+        m_events[written % CAPACITY] = Event{name, begin, end};
+        m_written.store(written + 1, std::memory_order_release);
+    }
+
+    QString m_name;
+    const int m_id;
+    std::unique_ptr<Event[]> m_events;
+    std::atomic<quint64> m_written {0};
+};
+
+namespace
+{
+    // The tracks live until the end of the program, also after their threads ended
+    std::mutex s_tracksMutex;
+    std::vector<std::unique_ptr<Profiler::Track>> s_tracks;
+
+    thread_local Profiler::Track * t_track = nullptr;
+
+    const std::chrono::steady_clock::time_point s_start = std::chrono::steady_clock::now();
+
+    void appendEscaped(QByteArray & json, const char * text)
+    {
+        for (const char * character = text; *character; ++character)
+        {
+            if (*character == '"' || *character == '\\')
+                json += '\\';
+            if (uchar(*character) >= 0x20)
+                json += *character;
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Recording
+///////////////////////////////////////////////////////////////////////////////
+
+qint64 Profiler::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - s_start).count();
+}
+
+Profiler::Track * Profiler::createTrack(const QString & name)
+{
+    std::lock_guard<std::mutex> lock(s_tracksMutex);
+    const int id = int(s_tracks.size()) + 1;
+    s_tracks.push_back(std::make_unique<Track>(name.isEmpty() ? QString("Thread %1").arg(id) : name, id));
+    return s_tracks.back().get();
+}
+
+Profiler::Track * Profiler::threadTrack()
+{
+    if (!t_track)
+        t_track = createTrack(QString());
+    return t_track;
+}
+
+void Profiler::setThreadName(const QString & name)
+{
+    if (!isEnabled())
+        return;
+    Track * track = threadTrack();
+    std::lock_guard<std::mutex> lock(s_tracksMutex);
+    track->m_name = name;
+}
+
+void Profiler::record(const char * name, qint64 begin, qint64 end)
+{
+    threadTrack()->record(name, begin, end);
+}
+
+void Profiler::record(Track * track, const char * name, qint64 begin, qint64 end)
+{
+    track->record(name, begin, end);
+}
+
+void Profiler::clear()
+{
+    // Only forgets the events, the rings are reused
+    std::lock_guard<std::mutex> lock(s_tracksMutex);
+    for (const std::unique_ptr<Track> & track : s_tracks)
+        track->m_written.store(0, std::memory_order_relaxed);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Export
+///////////////////////////////////////////////////////////////////////////////
+
+bool Profiler::writeChromeTrace(const QString & fileName)
+{
+    // Chrome trace event format: complete events ("X") with microsecond times,
+    // one tid per track and its name as metadata ("M")
+    QByteArray json;
+    qint64 events = 0;
+    {
+        std::lock_guard<std::mutex> lock(s_tracksMutex);
+        json.reserve(qsizetype(s_tracks.size()) * 1024 * 1024);
+        json += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        bool first = true;
+        for (const std::unique_ptr<Track> & track : s_tracks)
+        {
+            if (!first)
+                json += ",\n";
+            first = false;
+            json += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + QByteArray::number(track->m_id)
+                    + ",\"args\":{\"name\":\"";
+            appendEscaped(json, track->m_name.toUtf8().constData());
+            json += "\"}}";
+
+            const quint64 written = track->m_written.load(std::memory_order_acquire);
+            const quint64 begin = written > Track::CAPACITY ? written - Track::CAPACITY + Track::EXPORT_MARGIN : 0;
+            for (quint64 ii = begin; ii < written; ++ii)
+            {
+                const Track::Event event = track->m_events[ii % Track::CAPACITY];
+                json += ",\n{\"name\":\"";
+                appendEscaped(json, event.name);
+                json += "\",\"ph\":\"X\",\"pid\":1,\"tid\":" + QByteArray::number(track->m_id)
+                        + ",\"ts\":" + QByteArray::number(double(event.begin) / 1000.0, 'f', 3)
+                        + ",\"dur\":" + QByteArray::number(double(event.end - event.begin) / 1000.0, 'f', 3) + "}";
+                events++;
+            }
+        }
+        json += "\n]}\n";
+    }
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly) || file.write(json) != json.size() || !file.commit())
+    {
+        qWarning() << "Profiler : writing" << fileName << "FAILED";
+        return false;
+    }
+    qInfo() << "Profiler :" << events << "zones written to" << fileName;
+    return true;
+}
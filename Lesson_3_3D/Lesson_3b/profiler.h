@@ -0,0 +1,97 @@
+#pragma once
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include <QString>
+
+///
+/// Zone macros, removed completely without LEARNOPENGL_PROFILE (CMake option).
+/// The name must be a string literal (only the pointer is stored).
+///
+/// PROFILE_SCOPE("name")                   CPU zone until the end of the scope
+/// PROFILE_FUNCTION()                      CPU zone named after the function
+/// PROFILE_GPU_SCOPE(gpuProfiler, "name")  GPU zone (see GpuProfiler)
+///
+#ifdef LEARNOPENGL_PROFILE
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+#define PROFILE_SCOPE(name) const Profiler::Scope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__func__)
+#define PROFILE_GPU_SCOPE(gpuProfiler, name) const GpuProfiler::Scope PROFILE_CONCAT(gpuProfileScope, __LINE__)(gpuProfiler, name)
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_FUNCTION()
+#define PROFILE_GPU_SCOPE(gpuProfiler, name)
+#endif
+
+///
+/// \brief The Profiler records named time zones per thread for a timeline
+/// view of single frames (the window title only shows one second averages).
+/// Every thread writes into its own ring of the last events, a zone costs two
+/// clock reads and a store: no locks and no allocations (except the ring of a
+/// thread at its first zone). The rings are always recording, writeChromeTrace()
+/// exports what they hold on demand as Chrome trace JSON, which opens in
+/// chrome://tracing and in the Perfetto UI (ui.perfetto.dev).
+///
+class Profiler
+{
+public:
+    static constexpr bool isEnabled()
+    {
+#ifdef LEARNOPENGL_PROFILE
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    ///
+    /// \brief Timeline row of the trace, one per thread (or e.g. for the GPU)
+    ///
+    class Track;
+
+    // Nanoseconds on the steady clock, the time base of all events
+    static qint64 now();
+
+    // Name of the calling thread in the trace (default "Thread <n>")
+    static void setThreadName(const QString & name);
+
+    // A track not bound to a thread, written by one thread only
+    static Track * createTrack(const QString & name);
+
+    // name: string literal, times from now()
+    static void record(const char * name, qint64 begin, qint64 end);
+    static void record(Track * track, const char * name, qint64 begin, qint64 end);
+
+    static bool writeChromeTrace(const QString & fileName);
+    static void clear();
+
+    ///
+    /// \brief CPU zone from construction to destruction (see PROFILE_SCOPE)
+    ///
+    class Scope
+    {
+    public:
+        explicit Scope(const char * name) : m_name(name), m_begin(now()) {}
+        ~Scope() { record(m_name, m_begin, now()); }
+
+        Scope(const Scope &) = delete;
+        Scope & operator=(const Scope &) = delete;
+
+    private:
+        const char * m_name;
+        qint64 m_begin;
+    };
+
+private:
+    static Track * threadTrack();
+};
@@ -0,0 +1,35 @@
+#pragma once
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include <QtGlobal>
+
+///
+/// \brief Typed handle of a shared resource. Like an Entity the lower 24 bits
+/// are the slot index and the upper 8 bits a generation counter, so the handle
+/// of a released resource never finds the resource that reuses its slot.
+///
+template<typename T>
+struct ResourceHandle
+{
+    static constexpr quint32 INVALID = 0xFFFFFFFFu;
+    static constexpr quint32 INDEX_BITS = 24;
+    static constexpr quint32 INDEX_MASK = (1u << INDEX_BITS) - 1u;
+
+    quint32 id {INVALID};
+
+    bool isValid() const { return id != INVALID; }
+    quint32 index() const { return id & INDEX_MASK; }
+    quint32 generation() const { return id >> INDEX_BITS; }
+    bool operator==(const ResourceHandle & other) const { return id == other.id; }
+    bool operator!=(const ResourceHandle & other) const { return id != other.id; }
+};
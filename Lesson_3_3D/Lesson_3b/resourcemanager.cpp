@@ -0,0 +1,500 @@
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "resourcemanager.h"
+
+#include <QDebug>
+
+namespace
+{
+    // Makes a context current and the previous one current again
+    class ScopedCurrent
+    {
+    public:
+        ScopedCurrent(QOpenGLContext & context, QSurface & surface)
+            : m_previous(QOpenGLContext::currentContext())
+            , m_previousSurface(m_previous ? m_previous->surface() : nullptr)
+        {
+            if (m_previous != &context)
+                context.makeCurrent(&surface);
+        }
+
+        ~ScopedCurrent()
+        {
+            if (m_previous && m_previous != QOpenGLContext::currentContext())
+                m_previous->makeCurrent(m_previousSurface);
+            else if (!m_previous && QOpenGLContext::currentContext())
+                QOpenGLContext::currentContext()->doneCurrent();
+        }
+
+        ScopedCurrent(const ScopedCurrent &) = delete;
+        ScopedCurrent & operator=(const ScopedCurrent &) = delete;
+
+    private:
+        QOpenGLContext * m_previous {nullptr};
+        QSurface * m_previousSurface {nullptr};
+    };
+}
+
+QString ResourceManager::TextureDescription::key() const
+{
+    QString flags;
+    if (streamed)
+        flags += 's';
+    if (generateMipMaps)
+        flags += 'm';
+    if (fit == Texture2D::LayerFit::Pad)
+        flags += 'p';
+    return "texture:" + QString::number(int(target)) + ':' + flags + ':' + fileNames.join('|');
+}
+
+ResourceManager & ResourceManager::instance()
+{
+    static ResourceManager manager;
+    return manager;
+}
+
+ResourceManager::~ResourceManager()
+{
+    shutdown();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Keys and groups
+///////////////////////////////////////////////////////////////////////////////
+
+QString ResourceManager::scopedKey(const QString & key)
+{
+    // Objects are only visible within their share group
+    QString scoped = QString::number(quintptr(QOpenGLContext::currentContext()->shareGroup()), 16) + '/' + key;
+    if (!m_sharingEnabled)
+        scoped += '#' + QString::number(++m_unsharedKeys);
+    return scoped;
+}
+
+ResourceManager::Group * ResourceManager::currentGroup()
+{
+    QOpenGLContext * current = QOpenGLContext::currentContext();
+    if (!current)
+    {
+        qWarning() << "Resource manager : no current OpenGL context ... FAILED";
+        return nullptr;
+    }
+
+    std::unique_ptr<Group> & group = m_groups[current->shareGroup()];
+    if (!group)
+    {
+        group = std::make_unique<Group>();
+        group->surface.setFormat(current->format());
+        group->surface.create();
+        group->context.setFormat(current->format());
+        group->context.setShareContext(current);
+        if (!group->context.create() || !group->context.shareGroup() ||
+            group->context.shareGroup() != current->shareGroup())
+        {
+            qWarning() << "Resource manager : shared resource context ... FAILED";
+            m_groups.erase(current->shareGroup());
+            return nullptr;
+        }
+        qInfo() << "Resource manager : resource context for share group" << m_groups.size();
+    }
+    return group.get();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Textures
+///////////////////////////////////////////////////////////////////////////////
+
+TextureHandle ResourceManager::acquireTexture(const TextureDescription & description)
+{
+    Group * group = currentGroup();
+    if (!group || description.fileNames.isEmpty())
+        return TextureHandle();
+
+    const QString key = scopedKey(description.key());
+    TextureHandle handle = m_textures.acquire(key);
+    if (handle.isValid())
+    {
+        m_statistics.hits++;
+        // Evicted since: loaded again here rather than at the first bind
+        useTexture(m_textures.get(handle));
+        return handle;
+    }
+
+    std::unique_ptr<Texture2D> texture = std::make_unique<Texture2D>(description.target);
+    bool loaded = false;
+    if (description.streamed)
+    {
+        // The levels are uploaded by the streamer in the widget contexts
+        TextureStreamer * streamer = textureStreamer();
+        loaded = streamer && streamer->add(texture.get(), description.fileNames);
+    }
+    else
+    {
+        loaded = loadTexture(*group, *texture, description);
+    }
+
+    if (!loaded)
+    {
+        qWarning() << "Resource manager : texture" << description.fileNames.join(", ") << "... FAILED";
+        return TextureHandle();
+    }
+
+    m_statistics.textureLoads++;
+    m_textureGroups.insert(texture.get(), group);
+    if (description.streamed)
+        m_streamedTextures.insert(texture.get());
+    else
+        m_textureDescriptions.insert(texture.get(), description);
+    m_textureMemory.insert(texture.get(), addTextureMemory(*group, texture.get(), description));
+    return m_textures.insert(key, std::move(texture));
+}
+
+bool ResourceManager::loadTexture(Group & group, Texture2D & texture, const TextureDescription & description)
+{
+    ScopedCurrent current(group.context, group.surface);
+    bool loaded = false;
+    if (description.target == QOpenGLTexture::Target2DArray)
+    {
+        QList<QImage> images;
+        for (const QString & fileName : description.fileNames)
+            images.append(Texture2D::readImage(fileName));
+        loaded = texture.loadTextureArray(images, description.fit, description.generateMipMaps);
+    }
+    else
+    {
+        loaded = texture.loadTexture(description.fileNames.first(), description.generateMipMaps);
+    }
+    if (!loaded)
+        texture.destroy();
+    return loaded;
+}
+
+GpuMemory::Handle ResourceManager::addTextureMemory(Group & group, Texture2D * texture, const TextureDescription & description)
+{
+    // Once for the share group, a streamed texture only with its resident levels
+    // (the streamer keeps to its own budget)
+    const QString name = description.fileNames.join(", ");
+    if (description.streamed)
+        return group.memory.add(GpuMemory::Category::Texture, name, group.streamer->residentBytes(texture));
+
+    // The others can be loaded from their files again
+    return group.memory.add(GpuMemory::Category::Texture, name, GpuMemory::textureBytes(*texture),
+                            &ResourceManager::evictTexture, this, quintptr(texture));
+}
+
+void ResourceManager::evictTexture(void * owner, quintptr key)
+{
+    ResourceManager * manager = static_cast<ResourceManager *>(owner);
+    Texture2D * texture = reinterpret_cast<Texture2D *>(key);
+    Group * group = manager->m_textureGroups.value(texture);
+
+    // Only the storage, the widgets keep pointers to the object
+    ScopedCurrent current(group->context, group->surface);
+    texture->destroy();
+    manager->m_textureMemory.insert(texture, 0);
+    manager->m_statistics.textureEvictions++;
+}
+
+bool ResourceManager::useTexture(Texture2D * texture)
+{
+    const auto found = m_textureMemory.constFind(texture);
+    if (found == m_textureMemory.constEnd())
+        return false;
+
+    Group * group = m_textureGroups.value(texture);
+    if (found.value())
+    {
+        group->memory.touch(found.value());
+        return true;
+    }
+
+    // Evicted, added again as used in this frame
+    const TextureDescription description = m_textureDescriptions.value(texture);
+    if (!loadTexture(*group, *texture, description))
+    {
+        qWarning() << "Resource manager : reload texture" << description.fileNames.join(", ") << "... FAILED";
+        return false;
+    }
+    m_statistics.textureLoads++;
+    m_textureMemory.insert(texture, addTextureMemory(*group, texture, description));
+    return true;
+}
+
+void ResourceManager::release(TextureHandle & handle)
+{
+    std::unique_ptr<Texture2D> texture = m_textures.release(handle);
+    handle = TextureHandle();
+    if (!texture)
+        return;
+
+    Group * group = m_textureGroups.take(texture.get());
+    group->memory.remove(m_textureMemory.take(texture.get()));
+    m_textureDescriptions.remove(texture.get());
+    ScopedCurrent current(group->context, group->surface);
+    if (m_streamedTextures.remove(texture.get()) && group->streamer)
+        group->streamer->remove(texture.get());
+    texture->destroy();
+}
+
+TextureStreamer * ResourceManager::textureStreamer()
+{
+    Group * group = currentGroup();
+    if (!group)
+        return nullptr;
+
+    if (!group->streamer)
+    {
+        // Resolves its functions in the resource context, which lives as long as the group
+        ScopedCurrent current(group->context, group->surface);
+        group->streamer = std::make_unique<TextureStreamer>();
+        group->streamer->create(jobs(), 0);
+    }
+    return group->streamer.get();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Texture streaming rounds
+///////////////////////////////////////////////////////////////////////////////
+
+ResourceManager::StreamingClient * ResourceManager::findStreamingClient(Group & group, const void * client)
+{
+    for (StreamingClient & entry : group.streamingClients)
+    {
+        if (entry.client == client)
+            return &entry;
+    }
+    return nullptr;
+}
+
+void ResourceManager::addStreamingClient(const void * client, qint64 budgetBytes)
+{
+    Group * group = currentGroup();
+    if (!group || !textureStreamer() || findStreamingClient(*group, client))
+        return;
+    StreamingClient entry;
+    entry.client = client;
+    entry.budget = budgetBytes;
+    group->streamingClients.push_back(entry);
+    applyTextureBudget(*group);
+}
+
+void ResourceManager::removeStreamingClient(const void * client)
+{
+    Group * group = currentGroup();
+    if (!group)
+        return;
+    std::vector<StreamingClient> & clients = group->streamingClients;
+    for (auto it = clients.begin(); it != clients.end(); ++it)
+    {
+        if (it->client == client)
+        {
+            clients.erase(it);
+            applyTextureBudget(*group);
+            return;
+        }
+    }
+}
+
+void ResourceManager::setTextureBudget(const void * client, qint64 budgetBytes)
+{
+    // No OpenGL, so also from key events where no context is current
+    for (auto & entry : m_groups)
+    {
+        StreamingClient * streamingClient = findStreamingClient(*entry.second, client);
+        if (streamingClient)
+        {
+            streamingClient->budget = budgetBytes;
+            applyTextureBudget(*entry.second);
+            return;
+        }
+    }
+}
+
+void ResourceManager::applyTextureBudget(Group & group)
+{
+    if (!group.streamer || group.streamingClients.empty())
+        return;
+
+    // The textures are shared, one widget's low budget must not starve the others
+    qint64 budget = 0;
+    for (const StreamingClient & entry : group.streamingClients)
+        budget = qMax(budget, entry.budget);
+    if (budget == group.streamer->budget())
+    {
+        qInfo() << "Resource manager : texture budget of the share group stays"
+                << double(budget) / (1024.0 * 1024.0) << "MB (" << group.streamingClients.size() << "widgets )";
+        return;
+    }
+    group.streamer->setBudget(budget);
+}
+
+void ResourceManager::endTextureRequests(const void * client)
+{
+    Group * group = currentGroup();
+    StreamingClient * entry = group ? findStreamingClient(*group, client) : nullptr;
+    if (!entry || !group->streamer)
+        return;
+
+    // Back again before the others: they are not painting, do not wait for them
+    if (entry->requested)
+    {
+        updateStreaming(*group);
+        return;
+    }
+    entry->requested = true;
+    for (const StreamingClient & other : group->streamingClients)
+    {
+        if (!other.requested)
+            return;
+    }
+    updateStreaming(*group);
+}
+
+void ResourceManager::updateStreaming(Group & group)
+{
+    group.streamer->update();
+
+    // The memory of the share group follows the rounds, its frame is theirs
+    for (auto it = m_textureMemory.constBegin(); it != m_textureMemory.constEnd(); ++it)
+    {
+        if (m_streamedTextures.contains(it.key()) && m_textureGroups.value(it.key()) == &group)
+            group.memory.resize(it.value(), group.streamer->residentBytes(it.key()));
+    }
+    group.memory.enforceBudget();
+    group.memory.beginFrame();
+
+    group.streamer->beginFrame();
+    for (StreamingClient & entry : group.streamingClients)
+        entry.requested = false;
+}
+
+GpuMemory * ResourceManager::gpuMemory()
+{
+    Group * group = currentGroup();
+    return group ? &group->memory : nullptr;
+}
+
+JobSystem & ResourceManager::jobs()
+{
+    // Shared, one pool per widget would oversubscribe the cores
+    if (!m_jobs)
+        m_jobs = std::make_unique<JobSystem>();
+    return *m_jobs;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Shader programs
+///////////////////////////////////////////////////////////////////////////////
+
+ProgramHandle ResourceManager::acquireProgram(const QString & key, const std::function<bool(ShaderProgram &)> & load)
+{
+    Group * group = currentGroup();
+    if (!group)
+        return ProgramHandle();
+
+    const QString scoped = scopedKey("program:" + key);
+    ProgramHandle handle = m_programs.acquire(scoped);
+    if (handle.isValid())
+    {
+        m_statistics.hits++;
+        return handle;
+    }
+
+    std::unique_ptr<ShaderProgram> program = std::make_unique<ShaderProgram>();
+    {
+        ScopedCurrent current(group->context, group->surface);
+        if (!load(*program))
+        {
+            program->unloadShaders();
+            qWarning() << "Resource manager : program" << key << "... FAILED";
+            return ProgramHandle();
+        }
+    }
+
+    m_statistics.programLoads++;
+    m_programGroups.insert(program.get(), group);
+    return m_programs.insert(scoped, std::move(program));
+}
+
+void ResourceManager::release(ProgramHandle & handle)
+{
+    std::unique_ptr<ShaderProgram> program = m_programs.release(handle);
+    handle = ProgramHandle();
+    if (!program)
+        return;
+
+    Group * group = m_programGroups.take(program.get());
+    ScopedCurrent current(group->context, group->surface);
+    program->unloadShaders();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Information and shutdown
+///////////////////////////////////////////////////////////////////////////////
+
+ResourceManager::Statistics ResourceManager::statistics() const
+{
+    Statistics statistics = m_statistics;
+    statistics.textures = m_textures.size();
+    statistics.programs = m_programs.size();
+    m_textures.each([&](const Texture2D & texture) {
+        if (!m_streamedTextures.contains(&texture) && m_textureMemory.value(&texture))
+            statistics.textureBytes += GpuMemory::textureBytes(texture);
+    });
+    for (const auto & group : m_groups)
+    {
+        if (group.second->streamer)
+            statistics.textureBytes += group.second->streamer->statistics().residentBytes;
+    }
+    return statistics;
+}
+
+void ResourceManager::shutdown()
+{
+    if (m_groups.empty())
+    {
+        m_jobs.reset();
+        return;
+    }
+
+    qInfo() << "Resource manager : shutdown," << m_textures.size() << "textures and"
+            << m_programs.size() << "programs still referenced";
+
+    for (auto & entry : m_groups)
+    {
+        Group * group = entry.second.get();
+        ScopedCurrent current(group->context, group->surface);
+        if (group->streamer)
+            group->streamer->destroy();
+        for (auto it = m_textureGroups.constBegin(); it != m_textureGroups.constEnd(); ++it)
+        {
+            if (it.value() == group)
+                const_cast<Texture2D *>(it.key())->destroy();
+        }
+        for (auto it = m_programGroups.constBegin(); it != m_programGroups.constEnd(); ++it)
+        {
+            if (it.value() == group)
+                const_cast<ShaderProgram *>(it.key())->unloadShaders();
+        }
+    }
+
+    m_textures.clear();
+    m_programs.clear();
+    m_textureGroups.clear();
+    m_programGroups.clear();
+    m_streamedTextures.clear();
+    m_textureMemory.clear();
+    m_textureDescriptions.clear();
+    m_groups.clear();
+    m_jobs.reset();
+}
@@ -0,0 +1,310 @@
+#pragma once
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "resourcehandle.h"
+#include "texture2D.h"
+#include "shaderprogram.h"
+#include "texturestreamer.h"
+#include "jobsystem.h"
+#include "gpumemory.h"
+
+#include <QHash>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+using TextureHandle = ResourceHandle<Texture2D>;
+using ProgramHandle = ResourceHandle<ShaderProgram>;
+
+///
+/// \brief Reference counted resources of one type, found by their key
+///
+template<typename T>
+class ResourcePool
+{
+public:
+    // Existing resource of the key (one more reference) or an invalid handle
+    ResourceHandle<T> acquire(const QString & key)
+    {
+        const auto found = m_keys.constFind(key);
+        if (found == m_keys.constEnd())
+            return ResourceHandle<T>();
+        Slot & slot = m_slots[found.value()];
+        slot.references++;
+        return handle(found.value());
+    }
+
+    ResourceHandle<T> insert(const QString & key, std::unique_ptr<T> resource)
+    {
+        quint32 index = 0;
+        if (!m_freeSlots.empty())
+        {
+            index = m_freeSlots.back();
+            m_freeSlots.pop_back();
+        }
+        else
+        {
+            index = quint32(m_slots.size());
+            m_slots.emplace_back();
+        }
+        Slot & slot = m_slots[index];
+        slot.resource = std::move(resource);
+        slot.key = key;
+        slot.references = 1;
+        m_keys.insert(key, index);
+        return handle(index);
+    }
+
+    T * get(ResourceHandle<T> handle) const
+    {
+        const Slot * slot = find(handle);
+        return slot ? slot->resource.get() : nullptr;
+    }
+
+    // The resource when this was the last reference (the caller destroys it)
+    std::unique_ptr<T> release(ResourceHandle<T> handle)
+    {
+        Slot * slot = const_cast<Slot *>(find(handle));
+        if (!slot || --slot->references > 0)
+            return nullptr;
+
+        std::unique_ptr<T> resource = std::move(slot->resource);
+        m_keys.remove(slot->key);
+        slot->key.clear();
+        slot->generation = (slot->generation + 1) & 0xFFu;
+        m_freeSlots.push_back(handle.index());
+        return resource;
+    }
+
+    // Forget every resource, the handles are invalid afterwards
+    void clear()
+    {
+        for (quint32 index = 0; index < m_slots.size(); ++index)
+        {
+            Slot & slot = m_slots[index];
+            if (!slot.resource)
+                continue;
+            slot.resource.reset();
+            slot.key.clear();
+            slot.references = 0;
+            slot.generation = (slot.generation + 1) & 0xFFu;
+            m_freeSlots.push_back(index);
+        }
+        m_keys.clear();
+    }
+
+    int size() const { return int(m_keys.size()); }
+    int references(ResourceHandle<T> handle) const
+    {
+        const Slot * slot = find(handle);
+        return slot ? slot->references : 0;
+    }
+
+    template<typename Func>
+    void each(const Func & func) const
+    {
+        for (const Slot & slot : m_slots)
+        {
+            if (slot.resource)
+                func(*slot.resource);
+        }
+    }
+
+private:
+    struct Slot
+    {
+        std::unique_ptr<T> resource;
+        QString key;
+        int references {0};
+        quint32 generation {0};
+    };
+
+    ResourceHandle<T> handle(quint32 index) const
+    {
+        ResourceHandle<T> result;
+        result.id = (m_slots[index].generation << ResourceHandle<T>::INDEX_BITS) | index;
+        return result;
+    }
+
+    const Slot * find(ResourceHandle<T> handle) const
+    {
+        if (!handle.isValid() || handle.index() >= m_slots.size())
+            return nullptr;
+        const Slot & slot = m_slots[handle.index()];
+        if (!slot.resource || slot.generation != handle.generation())
+            return nullptr;
+        return &slot;
+    }
+
+    std::vector<Slot> m_slots;
+    std::vector<quint32> m_freeSlots;
+    QHash<QString, quint32> m_keys;
+};
+
+///
+/// \brief The ResourceManager loads the textures and shader programs once for
+/// all widgets. A resource is found by its key (file names and load
+/// parameters), every acquire adds a reference and the last release destroys
+/// it (with a context of its share group current).
+///
+/// OpenGL objects are only shared between contexts of one share group: set
+/// Qt::AA_ShareOpenGLContexts before the QApplication is created (main.cpp),
+/// then all QOpenGLWidgets share with the global share context. Without it
+/// every widget gets its own copy (the share group is part of the key).
+/// Vertex array objects are never shared, the widgets keep their own.
+///
+/// Each share group gets a hidden resource context that creates (and
+/// destroys) its resources, so they do not depend on the widget that loaded
+/// them first. Call shutdown() before the QApplication is destroyed.
+/// Its GpuMemory accounts everything on the GPU of the share group: the
+/// shared textures (by the manager) and the buffers of the widgets. Over its
+/// budget it evicts the least recently used textures that are not streamed
+/// (they are loaded from files), the widgets call useTexture() before they
+/// bind one and the next use or acquire loads it again.
+///
+/// Only call from the GUI (OpenGL) thread with a context current.
+///
+class ResourceManager
+{
+public:
+    struct TextureDescription
+    {
+        QStringList fileNames;          // one for Target2D, one per layer for Target2DArray
+        QOpenGLTexture::Target target {QOpenGLTexture::Target2D};
+        bool streamed {false};          // mip levels by the TextureStreamer, else all at once
+        bool generateMipMaps {true};
+        Texture2D::LayerFit fit {Texture2D::LayerFit::Scale};
+
+        QString key() const;
+    };
+
+    struct Statistics
+    {
+        int textures {0};
+        int programs {0};
+        quint64 textureLoads {0};
+        quint64 programLoads {0};
+        quint64 hits {0};               // acquired an existing resource
+        quint64 textureEvictions {0};   // freed over the GPU memory budget, loaded again on use
+        qint64 textureBytes {0};        // resident (streamed: the levels on the GPU)
+    };
+
+    static ResourceManager & instance();
+
+    ResourceManager(const ResourceManager &) = delete;
+    ResourceManager & operator=(const ResourceManager &) = delete;
+
+    // Off: every acquire loads its own copy (to compare, see Benchmark "widgets")
+    void setSharingEnabled(bool enabled) { m_sharingEnabled = enabled; }
+    bool isSharingEnabled() const { return m_sharingEnabled; }
+
+    TextureHandle acquireTexture(const TextureDescription & description);
+    // load is only called for a new program (e.g. ShaderProgram::beginLoadFromSource)
+    ProgramHandle acquireProgram(const QString & key, const std::function<bool(ShaderProgram &)> & load);
+
+    // Null for an invalid or released handle
+    Texture2D * texture(TextureHandle handle) const { return m_textures.get(handle); }
+    ShaderProgram * program(ProgramHandle handle) const { return m_programs.get(handle); }
+
+    // Before a shared texture is bound for drawing: loads it again if it was
+    // evicted and marks it used in this frame. False if it is not resident.
+    bool useTexture(Texture2D * texture);
+
+    // The handle is invalid afterwards
+    void release(TextureHandle & handle);
+    void release(ProgramHandle & handle);
+
+    // Streamer of the current share group. The widgets only request() levels,
+    // the manager updates it once per frame for all of them (see below).
+    TextureStreamer * textureStreamer();
+
+    // Texture streaming of the current share group, shared by its widgets.
+    // Every widget is a client: per frame it requests the levels of its visible
+    // objects, then calls endTextureRequests(). The streamer is updated (and a
+    // new round of requests begun) once every client has requested, or when a
+    // client comes around again before the others (they do not paint, e.g.
+    // hidden). So the fade in and the keep frames run at the frame rate, not
+    // once per widget. The budget is the largest of the clients' budgets.
+    void addStreamingClient(const void * client, qint64 budgetBytes);
+    void removeStreamingClient(const void * client);
+    void setTextureBudget(const void * client, qint64 budgetBytes);   // no context needed
+    void endTextureRequests(const void * client);
+
+    // GPU memory of the current share group, null without a context. The
+    // widgets add (and remove) their own buffers, the textures are added here.
+    // beginFrame() and enforceBudget() run with the streaming rounds.
+    static constexpr qint64 GPU_MEMORY_BUDGET = 256 * 1024 * 1024;
+    GpuMemory * gpuMemory();
+
+    // The job system of the process (frame work of all widgets, streaming),
+    // one worker per hardware thread minus one, created on first use
+    JobSystem & jobs();
+
+    Statistics statistics() const;
+
+    // Destroy everything still loaded and the resource contexts
+    void shutdown();
+
+private:
+    struct StreamingClient
+    {
+        const void * client {nullptr};
+        qint64 budget {0};
+        bool requested {false};         // in this round
+    };
+
+    // Per share group
+    struct Group
+    {
+        QOffscreenSurface surface;
+        QOpenGLContext context;         // shares with the widgets, creates the resources
+        std::unique_ptr<TextureStreamer> streamer;
+        std::vector<StreamingClient> streamingClients;
+        GpuMemory memory {GPU_MEMORY_BUDGET};
+    };
+
+    ResourceManager() = default;
+    ~ResourceManager();
+
+    QString scopedKey(const QString & key);
+    // Group of the current context, null without one
+    Group * currentGroup();
+
+    bool loadTexture(Group & group, Texture2D & texture, const TextureDescription & description);
+    GpuMemory::Handle addTextureMemory(Group & group, Texture2D * texture, const TextureDescription & description);
+    static void evictTexture(void * owner, quintptr key);
+
+    StreamingClient * findStreamingClient(Group & group, const void * client);
+    void applyTextureBudget(Group & group);
+    void updateStreaming(Group & group);
+
+    ResourcePool<Texture2D> m_textures;
+    ResourcePool<ShaderProgram> m_programs;
+    QHash<const Texture2D *, Group *> m_textureGroups;
+    QHash<const ShaderProgram *, Group *> m_programGroups;
+    QSet<const Texture2D *> m_streamedTextures;
+    QHash<const Texture2D *, GpuMemory::Handle> m_textureMemory;   // 0 = evicted
+    QHash<const Texture2D *, TextureDescription> m_textureDescriptions; // not streamed, to load them again
+    std::unordered_map<QOpenGLContextGroup *, std::unique_ptr<Group>> m_groups;
+    std::unique_ptr<JobSystem> m_jobs;
+    bool m_sharingEnabled {true};
+    quint64 m_unsharedKeys {0};
+    Statistics m_statistics;
+};
@@ -0,0 +1,253 @@
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "shaderhotreload.h"
+#include "shaderprogram.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+
+namespace
+{
+    // Editors save in several steps (truncate, write, rename), wait until it is quiet
+    constexpr int RELOAD_DELAY_MSECS = 100;
+}
+
+ShaderHotReload::ShaderHotReload(QObject * parent)
+    : QObject(parent)
+{
+    m_reloadTimer.setSingleShot(true);
+    m_reloadTimer.setInterval(RELOAD_DELAY_MSECS);
+    connect(&m_reloadTimer, &QTimer::timeout, this, &ShaderHotReload::startReload);
+    connect(&m_watcher, &QFileSystemWatcher::fileChanged, this, &ShaderHotReload::onFileChanged);
+}
+
+ShaderHotReload::~ShaderHotReload()
+{
+    destroy();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Create
+///////////////////////////////////////////////////////////////////////////////
+
+bool ShaderHotReload::create(QOpenGLContext * shareContext)
+{
+    destroy();
+    initializeOpenGLFunctions();
+
+    // Created here on the GUI thread, then handed to the compile thread
+    m_context = new QOpenGLContext;
+    m_context->setShareContext(shareContext);
+    m_context->setFormat(shareContext->format());
+    if (!m_context->create())
+    {
+        qWarning() << "Shader hot reload : shared context FAILED";
+        delete m_context;
+        m_context = nullptr;
+        return false;
+    }
+    m_surface = new QOffscreenSurface;
+    m_surface->setFormat(m_context->format());
+    m_surface->create();
+
+    m_worker = new QObject;
+    m_worker->moveToThread(&m_thread);
+    m_context->moveToThread(&m_thread);
+    connect(&m_thread, &QThread::finished, m_worker, &QObject::deleteLater);
+    m_thread.setObjectName("Shader compile");
+    m_thread.start();
+
+    qInfo() << "Shader hot reload : ready";
+    return true;
+}
+
+void ShaderHotReload::destroy()
+{
+    if (!m_context)
+        return;
+
+    m_reloadTimer.stop();
+    m_watcher.removePaths(m_watcher.files());
+
+    // Give the context back to this thread before the compile thread ends
+    QOpenGLContext * context = m_context;
+    QThread * guiThread = thread();
+    QMetaObject::invokeMethod(m_worker, [context, guiThread] {
+        context->doneCurrent();
+        context->moveToThread(guiThread);
+    }, Qt::BlockingQueuedConnection);
+    m_thread.quit();
+    m_thread.wait();
+    m_worker = nullptr;
+
+    delete m_context;
+    m_context = nullptr;
+    delete m_surface;
+    m_surface = nullptr;
+
+    // Compiled but never swapped in (the renderer's context is current)
+    QMutexLocker locker(&m_mutex);
+    for (const Reload & reload : m_finished)
+        deletePrograms(reload);
+    m_finished.clear();
+    m_permutations = nullptr;
+}
+
+void ShaderHotReload::watch(ShaderPermutations * permutations, const QString & vsFilename, const QString & fsFilename)
+{
+    m_permutations = permutations;
+    m_vsFilename = vsFilename;
+    m_fsFilename = fsFilename;
+
+    QStringList files;
+    ShaderProgram::readSource(vsFilename, &files);
+    ShaderProgram::readSource(fsFilename, &files);
+    watchFiles(files);
+    qInfo() << "Shader hot reload : watching" << m_watcher.files();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Reload
+///////////////////////////////////////////////////////////////////////////////
+
+void ShaderHotReload::onFileChanged(const QString & path)
+{
+    qInfo() << "Shader hot reload : changed" << path;
+    m_reloadTimer.start();
+}
+
+void ShaderHotReload::startReload()
+{
+    if (!m_permutations || !m_context)
+        return;
+
+    // Read on this thread, the includes may have changed too
+    QStringList files;
+    Reload reload;
+    reload.vsSource = ShaderProgram::readSource(m_vsFilename, &files);
+    reload.fsSource = ShaderProgram::readSource(m_fsFilename, &files);
+    watchFiles(files);
+    if (reload.vsSource.isEmpty() || reload.fsSource.isEmpty())
+    {
+        qWarning() << "Shader hot reload : source not readable, keeping the old programs";
+        return;
+    }
+
+    // Every permutation in use is compiled again
+    for (quint32 features : m_permutations->featureSets())
+    {
+        Program program;
+        program.features = features;
+        program.vsSource = ShaderProgram::insertDefines(reload.vsSource, ShaderPermutations::defines(features));
+        program.fsSource = ShaderProgram::insertDefines(reload.fsSource, ShaderPermutations::defines(features));
+        reload.programs.append(program);
+    }
+
+    QMetaObject::invokeMethod(m_worker, [this, reload] { compile(reload); }, Qt::QueuedConnection);
+}
+
+void ShaderHotReload::compile(Reload reload)
+{
+    if (QOpenGLContext::currentContext() != m_context && !m_context->makeCurrent(m_surface))
+    {
+        qWarning() << "Shader hot reload : makeCurrent FAILED";
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    for (Program & program : reload.programs)
+    {
+        ShaderProgram compiler;
+        compiler.beginLoadFromSource(program.vsSource, program.fsSource);
+        program.program = compiler.takeProgram();
+        if (!program.program)
+        {
+            qWarning() << "Shader hot reload : permutation" << program.features << "FAILED";
+            reload.ok = false;
+        }
+    }
+
+    // The programs must be complete before another context uses them
+    m_context->functions()->glFinish();
+    qInfo() << "Shader hot reload :" << reload.programs.size() << "permutations compiled in"
+            << double(timer.nsecsElapsed()) / 1e6 << "ms" << (reload.ok ? "" : "- keeping the old programs");
+
+    QMutexLocker locker(&m_mutex);
+    m_finished.append(reload);
+}
+
+QList<quint32> ShaderHotReload::applyPending()
+{
+    QList<quint32> swapped;
+    if (!m_context)
+        return swapped;
+
+    QList<Reload> finished;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_finished.isEmpty())
+            return swapped;
+        finished.swap(m_finished);
+    }
+
+    for (const Reload & reload : finished)
+    {
+        if (!reload.ok)
+        {
+            deletePrograms(reload);
+            continue;
+        }
+
+        // All or nothing, the permutations stay consistent
+        for (const Program & program : reload.programs)
+        {
+            ShaderProgram * target = m_permutations->cached(program.features);
+            if (target)
+            {
+                target->adoptProgram(program.program);
+                if (!swapped.contains(program.features))
+                    swapped.append(program.features);
+            }
+            else
+            {
+                glDeleteProgram(program.program);
+            }
+        }
+        m_permutations->setSourceText(reload.vsSource, reload.fsSource);
+    }
+    return swapped;
+}
+
+void ShaderHotReload::deletePrograms(const Reload & reload)
+{
+    for (const Program & program : reload.programs)
+    {
+        if (program.program)
+            glDeleteProgram(program.program);
+    }
+}
+
+void ShaderHotReload::watchFiles(const QStringList & files)
+{
+    // Saving often replaces the file, the watcher then forgets it
+    for (const QString & file : files)
+    {
+        if (!m_watcher.files().contains(file) && QFileInfo::exists(file))
+            m_watcher.addPath(file);
+    }
+}
@@ -0,0 +1,91 @@
+#pragma once
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include <QObject>
+#include <QFileSystemWatcher>
+#include <QTimer>
+#include <QThread>
+#include <QMutex>
+#include <QList>
+#include <QStringList>
+#include <QOpenGLFunctions_3_3_Core>
+
+class QOpenGLContext;
+class QOffscreenSurface;
+class ShaderPermutations;
+
+///
+/// \brief The ShaderHotReload class is a development helper: it watches the
+/// shader files on disk and recompiles all permutations when one changes.
+/// The compile runs on a background thread with its own OpenGL context that
+/// shares objects with the renderer, so the frames go on meanwhile.
+/// applyPending() swaps the new programs in on the next frame, all at once.
+/// If any permutation fails to compile, the old programs stay.
+///
+class ShaderHotReload : public QObject, protected QOpenGLFunctions_3_3_Core
+{
+    Q_OBJECT
+public:
+    explicit ShaderHotReload(QObject * parent = nullptr);
+    ~ShaderHotReload() override;
+
+    // The renderer's context must be current, the background context shares with it
+    bool create(QOpenGLContext * shareContext);
+    void destroy();
+    bool isCreated() const { return m_context != nullptr; }
+
+    // Reload these permutations when a source or an included file changes
+    void watch(ShaderPermutations * permutations, const QString & vsFilename, const QString & fsFilename);
+
+    // Once per frame on the OpenGL thread, never waits. Returns the feature
+    // sets of the swapped permutations, their uniforms must be set again.
+    QList<quint32> applyPending();
+
+private:
+    struct Program
+    {
+        quint32 features {0};
+        QByteArray vsSource;
+        QByteArray fsSource;
+        GLuint program {0};
+    };
+    struct Reload
+    {
+        QByteArray vsSource;
+        QByteArray fsSource;
+        QList<Program> programs;
+        bool ok {true};
+    };
+
+    void onFileChanged(const QString & path);
+    void startReload();
+    void compile(Reload reload);       // background thread
+    void deletePrograms(const Reload & reload);
+    void watchFiles(const QStringList & files);
+
+    QFileSystemWatcher m_watcher;
+    QTimer m_reloadTimer;   // one reload for the burst of notifications of a save
+
+    QThread m_thread;
+    QObject * m_worker {nullptr};     // lives in m_thread
+    QOpenGLContext * m_context {nullptr};
+    QOffscreenSurface * m_surface {nullptr};
+
+    ShaderPermutations * m_permutations {nullptr};
+    QString m_vsFilename;
+    QString m_fsFilename;
+
+    // Finished reloads, handed from the background thread to the OpenGL thread
+    QMutex m_mutex;
+    QList<Reload> m_finished;
+};
@@ -11,10 +11,25 @@
 //-----------------------------------------------------------------------------
 
 #include "shaderprogram.h"
+#include "resourcemanager.h"
+#include "profiler.h"
 
 #include <QFile>
+#include <QFileInfo>
 #include <QString>
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QOpenGLContext>
+
+// KHR_parallel_shader_compile is not part of the 3.3 function set
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+namespace
+{
+    using MaxShaderCompilerThreadsFunction = void (QOPENGLF_APIENTRYP)(GLuint count);
+}
 
 ShaderProgram::ShaderProgram()
 {
@@ -28,6 +43,17 @@ ShaderProgram::~ShaderProgram()
 void ShaderProgram::initializeGL()
 {
     initializeOpenGLFunctions();
+
+    // Let the driver use as many compiler threads as it likes (0xFFFFFFFF)
+    QOpenGLContext * context = QOpenGLContext::currentContext();
+    MaxShaderCompilerThreadsFunction maxCompilerThreads = nullptr;
+    if (context->hasExtension("GL_KHR_parallel_shader_compile"))
+        maxCompilerThreads = reinterpret_cast<MaxShaderCompilerThreadsFunction>(context->getProcAddress("glMaxShaderCompilerThreadsKHR"));
+    else if (context->hasExtension("GL_ARB_parallel_shader_compile"))
+        maxCompilerThreads = reinterpret_cast<MaxShaderCompilerThreadsFunction>(context->getProcAddress("glMaxShaderCompilerThreadsARB"));
+    m_parallelCompile = maxCompilerThreads != nullptr;
+    if (maxCompilerThreads)
+        maxCompilerThreads(0xFFFFFFFF);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -36,52 +62,144 @@ void ShaderProgram::initializeGL()
 
 bool ShaderProgram::loadShaders(const QString & vsFilename, const QString & fsFilename)
 {
-    initializeGL();
+    PROFILE_FUNCTION();
+    if (!beginLoad(vsFilename, fsFilename))
+        return false;
+    return finishLoad();
+}
 
+bool ShaderProgram::beginLoad(const QString & vsFilename, const QString & fsFilename, const QByteArray & defines)
+{
     qInfo() << "Shader program : read files... ";
-    QString vsStr = readFileToString(vsFilename);
-    QString fsStr = readFileToString(fsFilename);
-    if (vsStr.isEmpty()) return false;
-    if (fsStr.isEmpty()) return false;
+    QByteArray vsSource = readSource(vsFilename);
+    QByteArray fsSource = readSource(fsFilename);
+    if (vsSource.isEmpty()) return false;
+    if (fsSource.isEmpty()) return false;
 
-    qInfo() << "Shader program : create shaders";
-    m_program = new QOpenGLShaderProgram;
+    return beginLoadFromSource(insertDefines(vsSource, defines), insertDefines(fsSource, defines));
+}
+
+bool ShaderProgram::beginLoadFromSource(const QByteArray & vsSource, const QByteArray & fsSource)
+{
+    PROFILE_FUNCTION();
+    unloadShaders();
+    initializeGL();
 
-    qInfo() << "Shader program : copy and compile vertex shader sources";
-    if (!m_program->addShaderFromSourceCode(QOpenGLShader::Vertex, vsStr))
+    // Only hand the work to the driver, any status query would wait for it
+    const GLenum types[2] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER };
+    const QByteArray * sources[2] = { &vsSource, &fsSource };
+    m_program = glCreateProgram();
+    for (int ii = 0; ii < 2; ++ii)
     {
-        qWarning() << "Shader program : failed to compile. " << m_program->log();
+        const GLchar * source = sources[ii]->constData();
+        const GLint length = GLint(sources[ii]->size());
+        m_shaders[ii] = glCreateShader(types[ii]);
+        glShaderSource(m_shaders[ii], 1, &source, &length);
+        glCompileShader(m_shaders[ii]);
+        glAttachShader(m_program, m_shaders[ii]);
+    }
+    glLinkProgram(m_program);
+    m_state = State::Compiling;
+
+    // Ensure clean location lookup of all uniforms
+    m_UniformLocations.clear();
+    return true;
+}
+
+bool ShaderProgram::isReady()
+{
+    if (m_state != State::Compiling)
+        return true;
+    if (!m_parallelCompile)
         return false;
+
+    GLint completed = GL_FALSE;
+    glGetProgramiv(m_program, GL_COMPLETION_STATUS_KHR, &completed);
+    return completed != GL_FALSE;
+}
+
+bool ShaderProgram::finishLoad()
+{
+    PROFILE_FUNCTION();
+    if (m_state != State::Compiling)
+        return m_state == State::Ready;
+
+    // The link status waits for the driver if it is not done yet
+    GLint linked = GL_FALSE;
+    glGetProgramiv(m_program, GL_LINK_STATUS, &linked);
+    if (!linked)
+    {
+        // Find out which stage failed for a useful log
+        for (GLuint shader : m_shaders)
+        {
+            GLint compiled = GL_FALSE;
+            glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+            if (!compiled)
+                qWarning() << "Shader program : failed to compile. " << shaderLog(shader);
+        }
+        qWarning() << "Shader program : failed to link. " << programLog();
     }
 
-    qInfo() << "Shader program : copy and compile fragment shader sources";
-    if (!m_program->addShaderFromSourceCode(QOpenGLShader::Fragment, fsStr))
+    // The program keeps what it needs
+    for (GLuint & shader : m_shaders)
     {
-        qWarning() << "Shader program : failed to compile. " << m_program->log();
-        return false;
+        glDetachShader(m_program, shader);
+        glDeleteShader(shader);
+        shader = 0;
     }
 
-    qInfo() << "Shader program : link the shader program";
-    if (!m_program->link())
+    if (!linked)
     {
-        qWarning() << "Shader program : failed to link. " << m_program->log();
+        glDeleteProgram(m_program);
+        m_program = 0;
+        m_state = State::Failed;
         return false;
     }
 
-    m_program->bind();
-
-    // Ensure clean location lookup of all uniforms
-    m_UniformLocations.clear();
+    // Bound after loading (as before), ready for the uniform setup
+    glUseProgram(m_program);
 
+    m_state = State::Ready;
     qInfo() << "Shader program : Ready";
     return true;
 }
 
 void ShaderProgram::unloadShaders()
 {
+    if (m_state == State::Empty)
+        return;
+
+    for (GLuint & shader : m_shaders)
+    {
+        if (shader)
+            glDeleteShader(shader);
+        shader = 0;
+    }
     if (m_program)
-        delete m_program;
-    m_program = nullptr;
+        glDeleteProgram(m_program);
+    m_program = 0;
+    m_state = State::Empty;
+    m_UniformLocations.clear();
+}
+
+GLuint ShaderProgram::takeProgram()
+{
+    if (!finishLoad())
+        return 0;
+
+    const GLuint program = m_program;
+    m_program = 0;
+    m_state = State::Empty;
+    m_UniformLocations.clear();
+    return program;
+}
+
+void ShaderProgram::adoptProgram(GLuint program)
+{
+    unloadShaders();
+    initializeGL();
+    m_program = program;
+    m_state = program ? State::Ready : State::Empty;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -92,14 +210,15 @@ void ShaderProgram::use()
 {
     // As you can have multiple shader programs created you
     // need to tell OpenGL which program we want to use.
-    if (m_program)
-        m_program->bind();
+    // The first use waits for the compile.
+    if (finishLoad())
+        glUseProgram(m_program);
 }
 
 void ShaderProgram::release()
 {
     if (m_program)
-        m_program->release();
+        glUseProgram(0);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -121,58 +240,284 @@ QString ShaderProgram::readFileToString(const QString& filename)
     return retStr;
 }
 
+QByteArray ShaderProgram::readSource(const QString & filename, QStringList * includedFiles)
+{
+    QByteArray source;
+    QStringList included;
+    if (!resolveIncludes(filename, source, included))
+        return QByteArray();
+    if (includedFiles)
+        *includedFiles += included;
+    return source;
+}
+
+bool ShaderProgram::resolveIncludes(const QString & filename, QByteArray & source, QStringList & included)
+{
+    const QString content = readFileToString(filename);
+    if (content.isEmpty())
+        return false;
+    included.append(filename);
+
+    // GLSL has no #include, replace the line with the file
+    const QString directory = QFileInfo(filename).path();
+    const QStringList lines = content.split('\n');
+    for (int ii = 0; ii < lines.size(); ++ii)
+    {
+        const QString line = lines[ii].trimmed();
+        if (!line.startsWith("#include"))
+        {
+            source += lines[ii].toUtf8();
+            if (ii + 1 < lines.size())
+                source += '\n';
+            continue;
+        }
+
+        const qsizetype first = line.indexOf('"');
+        const qsizetype last = line.lastIndexOf('"');
+        if (first < 0 || last <= first)
+        {
+            qWarning() << "Shader program : bad #include in" << filename << "line" << ii + 1;
+            return false;
+        }
+        const QString includeName = directory + "/" + line.mid(first + 1, last - first - 1);
+        if (!included.contains(includeName) && !resolveIncludes(includeName, source, included))
+            return false;
+        source += '\n';
+    }
+    return true;
+}
+
+QByteArray ShaderProgram::insertDefines(const QByteArray & source, const QByteArray & defines)
+{
+    if (defines.isEmpty())
+        return source;
+
+    // #version must stay the first line
+    qsizetype lineEnd = 0;
+    if (source.trimmed().startsWith("#version"))
+        lineEnd = source.indexOf('\n') + 1;
+    return source.left(lineEnd) + defines + source.mid(lineEnd);
+}
+
+QByteArray ShaderProgram::shaderLog(GLuint shader)
+{
+    GLint length = 0;
+    glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+    QByteArray log(qMax(length, 1), '\0');
+    glGetShaderInfoLog(shader, GLsizei(log.size()), nullptr, log.data());
+    return log;
+}
+
+QByteArray ShaderProgram::programLog()
+{
+    GLint length = 0;
+    glGetProgramiv(m_program, GL_INFO_LOG_LENGTH, &length);
+    QByteArray log(qMax(length, 1), '\0');
+    glGetProgramInfoLog(m_program, GLsizei(log.size()), nullptr, log.data());
+    return log;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 /// Uniform access
 ///////////////////////////////////////////////////////////////////////////////
 
+void ShaderProgram::setUniform(const GLchar* name, GLint v)
+{
+    if (!finishLoad()) return;
+    int loc = getUniformLocation(name);
+    glUniform1i(loc, v);
+}
+
 void ShaderProgram::setUniform(const GLchar* name, const QVector2D & v)
 {
-    if (!m_program) return;
+    if (!finishLoad()) return;
     int loc = getUniformLocation(name);
-    m_program->setUniformValue(loc, v);
+    glUniform2f(loc, v.x(), v.y());
 }
 
 void ShaderProgram::setUniform(const GLchar* name, const QVector3D & v)
 {
-    if (!m_program) return;
-    int loc = m_program->uniformLocation(name);
-    m_program->setUniformValue(loc, v);
+    if (!finishLoad()) return;
+    int loc = getUniformLocation(name);
+    glUniform3f(loc, v.x(), v.y(), v.z());
 }
 
 void ShaderProgram::setUniform(const GLchar* name, const QVector4D & v)
 {
-    if (!m_program) return;
+    if (!finishLoad()) return;
     int loc = getUniformLocation(name);
-    m_program->setUniformValue(loc, v);
+    glUniform4f(loc, v.x(), v.y(), v.z(), v.w());
 }
 
 void ShaderProgram::setUniform(const GLchar *name, const QMatrix4x4 &m)
 {
-    if (!m_program) return;
+    if (!finishLoad()) return;
     GLint loc = getUniformLocation(name);
     // constData is column major data, thus no transpose needed
-    m_program->setUniformValue(loc, m);
-    //m_program->glUniformMatrix4fv(loc, 1, GL_FALSE, m.constData());
+    glUniformMatrix4fv(loc, 1, GL_FALSE, m.constData());
+}
+
+void ShaderProgram::setUniformBlockBinding(const GLchar* blockName, GLuint binding)
+{
+    if (!finishLoad()) return;
+    GLuint index = glGetUniformBlockIndex(m_program, blockName);
+    if (index == GL_INVALID_INDEX)
+    {
+        qWarning() << "Shader program : uniform block lookup FAILED - " << blockName;
+        return;
+    }
+    glUniformBlockBinding(m_program, index, binding);
 }
 
 int ShaderProgram::getUniformLocation(const GLchar* name)
 {
     if (!m_program) return -1;
 
-    QString qStr(name);
-    if (qStr.isEmpty())
+    if (!name || !*name)
         return -1;
 
     // Only look up once and keep the location (improve performance)
-    QMap<QString, GLint>::iterator it = m_UniformLocations.find(qStr);
-    if (it == m_UniformLocations.end())
+    // fromRawData does not copy, so the lookup itself never allocates
+    const QByteArray key = QByteArray::fromRawData(name, qstrlen(name));
+    QHash<QByteArray, int>::const_iterator it = m_UniformLocations.constFind(key);
+    if (it != m_UniformLocations.constEnd())
+        return it.value();
+
+    int result = glGetUniformLocation(m_program, name);
+    if (result == -1)
     {
-        int result = m_program->uniformLocation(name);
-        if (result == -1)
-        {
-            qWarning() << "Shader program : uniform location lookup FAILED - " << name;
-        }
-        m_UniformLocations[qStr] = result;
+        qWarning() << "Shader program : uniform location lookup FAILED - " << name;
+    }
+    // Store a deep copy, the name may not outlive this call
+    m_UniformLocations.insert(QByteArray(name), result);
+    return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// ShaderLoadBatch
+///////////////////////////////////////////////////////////////////////////////
+
+bool ShaderLoadBatch::add(ShaderProgram & program, const QString & vsFilename, const QString & fsFilename)
+{
+    m_programs.append(&program);
+    return program.beginLoad(vsFilename, fsFilename);
+}
+
+bool ShaderLoadBatch::addFromSource(ShaderProgram & program, const QByteArray & vsSource, const QByteArray & fsSource)
+{
+    m_programs.append(&program);
+    return program.beginLoadFromSource(vsSource, fsSource);
+}
+
+int ShaderLoadBatch::pendingCount()
+{
+    int pending = 0;
+    for (ShaderProgram * program : m_programs)
+    {
+        if (!program->isReady())
+            pending++;
+    }
+    return pending;
+}
+
+bool ShaderLoadBatch::finish()
+{
+    bool ok = true;
+    for (ShaderProgram * program : m_programs)
+        ok = program->finishLoad() && ok;
+    return ok;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// ShaderPermutations
+///////////////////////////////////////////////////////////////////////////////
+
+bool ShaderPermutations::setSources(const QString & vsFilename, const QString & fsFilename, QStringList * includedFiles)
+{
+    setSourceText(ShaderProgram::readSource(vsFilename, includedFiles),
+                  ShaderProgram::readSource(fsFilename, includedFiles));
+    return !m_vsSource.isEmpty() && !m_fsSource.isEmpty();
+}
+
+void ShaderPermutations::setSourceText(const QByteArray & vsSource, const QByteArray & fsSource)
+{
+    m_vsSource = vsSource;
+    m_fsSource = fsSource;
+    // Same text, same programs (also for the widgets loading the same files)
+    m_sourceKey = QString::number(qHash(vsSource), 16) + '-' + QString::number(qHash(fsSource), 16) + '-' +
+                  QString::number(vsSource.size()) + '-' + QString::number(fsSource.size());
+}
+
+void ShaderPermutations::preload(const QList<quint32> & featureSets)
+{
+    for (quint32 features : featureSets)
+    {
+        if (m_programs.find(features) == m_programs.end())
+            start(features);
     }
-    return m_UniformLocations[qStr];
+}
+
+ShaderProgram * ShaderPermutations::program(quint32 features)
+{
+    const auto found = m_programs.find(features);
+    ShaderProgram * program = found != m_programs.end() ? ResourceManager::instance().program(found->second)
+                                                        : start(features);
+    if (!program)
+        return nullptr;
+
+    // Waits for the driver the first time
+    if (!program->isReady())
+    {
+        QElapsedTimer timer;
+        timer.start();
+        program->finishLoad();
+        m_statistics.compileNanoseconds += timer.nsecsElapsed();
+    }
+    return program->getProgram() ? program : nullptr;
+}
+
+ShaderProgram * ShaderPermutations::start(quint32 features)
+{
+    PROFILE_FUNCTION();
+    QElapsedTimer timer;
+    timer.start();
+    ResourceManager & manager = ResourceManager::instance();
+    const QString key = m_sourceKey + '/' + QString::number(features);
+
+    // Only compiled if no other widget did it already
+    ProgramHandle & handle = m_programs[features];
+    handle = manager.acquireProgram(key, [&](ShaderProgram & program) {
+        m_statistics.permutations++;
+        return program.beginLoadFromSource(ShaderProgram::insertDefines(m_vsSource, defines(features)),
+                                           ShaderProgram::insertDefines(m_fsSource, defines(features)));
+    });
+    m_statistics.compileNanoseconds += timer.nsecsElapsed();
+    return manager.program(handle);
+}
+
+void ShaderPermutations::clear()
+{
+    for (auto & entry : m_programs)
+        ResourceManager::instance().release(entry.second);
+    m_programs.clear();
+    m_statistics = Statistics();
+}
+
+QList<quint32> ShaderPermutations::featureSets() const
+{
+    QList<quint32> featureSets;
+    for (const auto & entry : m_programs)
+        featureSets.append(entry.first);
+    return featureSets;
+}
+
+ShaderProgram * ShaderPermutations::cached(quint32 features) const
+{
+    const auto found = m_programs.find(features);
+    return found != m_programs.end() ? ResourceManager::instance().program(found->second) : nullptr;
+}
+
+QByteArray ShaderPermutations::defines(quint32 features)
+{
+    return "#define FEATURES " + QByteArray::number(features) + "\n";
 }
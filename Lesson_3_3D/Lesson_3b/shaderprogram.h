@@ -11,10 +11,18 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 //-----------------------------------------------------------------------------
 
+#include "resourcehandle.h"
+
 #include <QFile>
 #include <QOpenGLFunctions>
 #include <QString>
-#include <QMap>
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QStringList>
+
+#include <memory>
+#include <unordered_map>
 
 // For Qt version of vec/mat types see
 // https://doc.qt.io/qt-6/qml-qtquick-shadereffect.html
@@ -23,7 +31,6 @@
 #include <QVector4D>
 #include <QMatrix4x4>
 #include <QOpenGLFunctions_3_3_Core>
-#include <QOpenGLShaderProgram>
 
 ///
 /// \brief The ShaderProgram class uses the OpenGL Core 330 Wrapper which
@@ -33,6 +40,11 @@
 /// Only call loadShaders when the OpenGL is already set, e.g. from
 /// QOpenGLWidget::initializeGL
 ///
+/// Compile and link can run in the background: beginLoad() only starts them,
+/// the status is checked (and waited for) on first use. With
+/// KHR_parallel_shader_compile the driver compiles on its own threads and
+/// isReady() tells without blocking if the program is done.
+///
 class ShaderProgram: public QOpenGLFunctions_3_3_Core // QOpenGLFunctions
 {
 public:
@@ -43,9 +55,35 @@ public:
     // This initializes the QOpenGLFunctions for the current OpenGL context
     bool loadShaders(const QString & vsFilename, const QString & fsFilename);
 
+    // Start compile and link, no status check (see ShaderLoadBatch).
+    // defines (e.g. "#define FEATURES 3\n") are put after the #version line.
+    // False only if a file can not be read.
+    bool beginLoad(const QString & vsFilename, const QString & fsFilename, const QByteArray & defines = QByteArray());
+    bool beginLoadFromSource(const QByteArray & vsSource, const QByteArray & fsSource);
+
+    // Shader source with every #include "file" replaced by the file (relative
+    // to the including file, each file only once). Empty on failure.
+    // includedFiles gets the file itself and all included files.
+    static QByteArray readSource(const QString & filename, QStringList * includedFiles = nullptr);
+    static QByteArray insertDefines(const QByteArray & source, const QByteArray & defines);
+
+    // True when the program is linked (or failed) and can be used without waiting.
+    // Never blocks, without the parallel compile extension only true after finishLoad()
+    bool isReady();
+
+    // Wait for compile and link and check the status. Called on first use.
+    bool finishLoad();
+
     // Cleanup
     void unloadShaders();
 
+    // Hand over the linked program object, e.g. compiled in a shared context
+    // (see ShaderHotReload). The ShaderProgram is empty afterwards.
+    GLuint takeProgram();
+    // Replace the program by a linked one, the old one is deleted and the
+    // uniforms have to be set again
+    void adoptProgram(GLuint program);
+
     // Apply this shader program
     void use();
 
@@ -53,28 +91,136 @@ public:
     void release();
 
     // Program handle
-    GLuint getProgram() const
+    GLuint getProgram()
     {
-        return m_program ? m_program->programId() : 0;
+        finishLoad();
+        return m_program;
     }
 
     // Set the uniform by name
+    void setUniform(const GLchar* name, GLint v);
     void setUniform(const GLchar* name, const QVector2D & v);
     void setUniform(const GLchar* name, const QVector3D & v);
     void setUniform(const GLchar* name, const QVector4D & v);
     void setUniform(const GLchar* name, const QMatrix4x4 & m);
 
+    // Connect the named uniform block to a uniform buffer binding point
+    void setUniformBlockBinding(const GLchar* blockName, GLuint binding);
+
+    // KHR_parallel_shader_compile (or the ARB version) is used in this context
+    bool hasParallelCompile() const { return m_parallelCompile; }
+
 private:
+    enum class State
+    {
+        Empty,
+        Compiling,
+        Ready,
+        Failed
+    };
 
     void initializeGL();
 
     // Read the file into a string. String is empty on failure and error logged
-    QString readFileToString(const QString & filename);
+    static QString readFileToString(const QString & filename);
+    static bool resolveIncludes(const QString & filename, QByteArray & source, QStringList & included);
+
+    // Log of a failed compile (shader) or link (program)
+    QByteArray shaderLog(GLuint shader);
+    QByteArray programLog();
 
     // Find and keep location to the uniform by exact name
     int getUniformLocation(const GLchar * name);
 
     // Shader program
-    QOpenGLShaderProgram * m_program {nullptr};
-    QMap<QString, int> m_UniformLocations;
+    GLuint m_program {0};
+    GLuint m_shaders[2] {};
+    State m_state {State::Empty};
+    bool m_parallelCompile {false};
+    QHash<QByteArray, int> m_UniformLocations;
+};
+
+///
+/// \brief The ShaderLoadBatch starts compile and link of many programs up
+/// front, so the driver can work on them in parallel (KHR_parallel_shader_compile)
+/// or at least while the application does other startup work.
+/// The programs must outlive the batch.
+///
+class ShaderLoadBatch
+{
+public:
+    // Starts loading right away
+    bool add(ShaderProgram & program, const QString & vsFilename, const QString & fsFilename);
+    bool addFromSource(ShaderProgram & program, const QByteArray & vsSource, const QByteArray & fsSource);
+
+    // Programs still compiling, never blocks
+    int pendingCount();
+
+    // Wait for all, false if any failed
+    bool finish();
+
+    int count() const { return int(m_programs.size()); }
+
+private:
+    QList<ShaderProgram *> m_programs;
+};
+
+///
+/// \brief The ShaderPermutations class compiles one uber shader source with
+/// different feature defines. A permutation is compiled when it is first
+/// asked for and cached by its feature bits. The features are constants in
+/// the shader, so the compiler strips the branches of the unused ones.
+/// The programs come from the ResourceManager (keyed by the sources and the
+/// features), so the widgets with the same shaders compile them only once.
+///
+class ShaderPermutations
+{
+public:
+    // Same bits as FEATURE_* in Shaders/uber_common.glsl
+    enum Feature : quint32
+    {
+        Textured = 1,
+        Instanced = 2,
+        VertexColor = 4,
+        Wireframe = 8
+    };
+    static constexpr int FEATURE_COUNT = 4;
+
+    struct Statistics
+    {
+        int permutations {0};
+        qint64 compileNanoseconds {0};  // OpenGL thread time in compile and link (incl. waits)
+    };
+
+    // Read (and resolve the includes of) the sources once
+    bool setSources(const QString & vsFilename, const QString & fsFilename, QStringList * includedFiles = nullptr);
+    // Already read sources, new permutations use them
+    void setSourceText(const QByteArray & vsSource, const QByteArray & fsSource);
+
+    // Start compiling permutations that will be needed soon, does not wait
+    void preload(const QList<quint32> & featureSets);
+
+    // The program for these features, compiled (or waited for) on first request.
+    // Null if it failed. Owned by the ResourceManager.
+    ShaderProgram * program(quint32 features);
+
+    // Release every permutation (OpenGL context must be current)
+    void clear();
+
+    // Feature sets compiled so far, the cached program (null if not compiled yet)
+    QList<quint32> featureSets() const;
+    ShaderProgram * cached(quint32 features) const;
+
+    const Statistics & statistics() const { return m_statistics; }
+
+    static QByteArray defines(quint32 features);
+
+private:
+    ShaderProgram * start(quint32 features);
+
+    QByteArray m_vsSource;
+    QByteArray m_fsSource;
+    QString m_sourceKey;        // identifies the sources in the ResourceManager
+    std::unordered_map<quint32, ResourceHandle<ShaderProgram>> m_programs;
+    Statistics m_statistics;
 };
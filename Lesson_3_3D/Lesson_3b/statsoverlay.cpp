@@ -0,0 +1,405 @@
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "statsoverlay.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFont>
+#include <QFontDatabase>
+#include <QFontMetrics>
+#include <QImage>
+#include <QPainter>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstddef>
+
+namespace
+{
+    // 0xRRGGBBAA
+    constexpr quint32 PANEL_COLOR = 0x000000B0;
+    constexpr quint32 TEXT_COLOR = 0xFFFFFFFF;
+    constexpr quint32 CPU_COLOR = 0x4CD964FF;
+    constexpr quint32 GPU_COLOR = 0xFF9500FF;
+    constexpr quint32 LINE_COLOR = 0xFFFFFF60;
+
+    // Top of the graphs: 2 frames at 60 Hz, the lines at 1 and 2 frames
+    constexpr float GRAPH_MILLISECONDS = 33.3f;
+    constexpr float FRAME_MILLISECONDS = 16.7f;
+
+    constexpr float MARGIN = 8.0f;
+    constexpr float GRAPH_HEIGHT = 48.0f;
+
+    inline double megabytes(qint64 bytes)
+    {
+        return double(bytes) / (1024.0 * 1024.0);
+    }
+}
+
+StatsOverlay::~StatsOverlay()
+{
+    // The GL objects belong to the context, destroy() must be called while it is current
+    if (isCreated())
+        qWarning() << "Stats overlay : destroyed without destroy(), GL objects leaked";
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Create / Destroy
+///////////////////////////////////////////////////////////////////////////////
+
+bool StatsOverlay::create()
+{
+    destroy();
+    if (!initializeOpenGLFunctions())
+    {
+        qWarning() << "Stats overlay : OpenGL 3.3 functions FAILED";
+        return false;
+    }
+    if (!m_program.loadShaders(":/Shaders/overlay.vert", ":/Shaders/overlay.frag") || !createAtlas())
+    {
+        qWarning() << "Stats overlay : create FAILED";
+        return false;
+    }
+
+    std::fill(std::begin(m_cpuMilliseconds), std::end(m_cpuMilliseconds), -1.0f);
+    std::fill(std::begin(m_gpuMilliseconds), std::end(m_gpuMilliseconds), -1.0f);
+    m_frame = 0;
+    glGenQueries(2 * GPU_FRAMES, m_gpuQueries);
+    std::fill(std::begin(m_gpuQueryPending), std::end(m_gpuQueryPending), false);
+
+    // The vertices are written every frame, the buffer is orphaned before
+    m_vertices.reserve(MAX_QUADS * 6);
+    glGenVertexArrays(1, &m_vao);
+    glGenBuffers(1, &m_vbo);
+    glBindVertexArray(m_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(MAX_QUADS * 6 * sizeof(Vertex)), nullptr, GL_STREAM_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<const void *>(offsetof(Vertex, x)));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<const void *>(offsetof(Vertex, u)));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), reinterpret_cast<const void *>(offsetof(Vertex, color)));
+    glEnableVertexAttribArray(2);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    m_program.use();
+    m_program.setUniform("glyphs", 0);
+    m_program.release();
+    return true;
+}
+
+void StatsOverlay::destroy()
+{
+    if (!isCreated())
+        return;
+
+    glDeleteQueries(2 * GPU_FRAMES, m_gpuQueries);
+    std::fill(std::begin(m_gpuQueries), std::end(m_gpuQueries), 0u);
+    glDeleteTextures(1, &m_atlas);
+    glDeleteBuffers(1, &m_vbo);
+    glDeleteVertexArrays(1, &m_vao);
+    m_atlas = 0;
+    m_vbo = 0;
+    m_vao = 0;
+    m_program.unloadShaders();
+}
+
+bool StatsOverlay::createAtlas()
+{
+    // Fixed width glyphs in a grid, white on transparent
+    QFont font = QFontDatabase::systemFont(QFontDatabase::FixedFont);
+    font.setPixelSize(12);
+    const QFontMetrics metrics(font);
+    m_cellWidth = qMax(1, metrics.horizontalAdvance(QLatin1Char('M')));
+    m_cellHeight = qMax(1, metrics.height());
+    m_atlasWidth = ATLAS_COLUMNS * m_cellWidth;
+    m_atlasHeight = (GLYPH_COUNT + ATLAS_COLUMNS - 1) / ATLAS_COLUMNS * m_cellHeight;
+
+    QImage image(m_atlasWidth, m_atlasHeight, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    {
+        QPainter painter(&image);
+        painter.setFont(font);
+        painter.setPen(Qt::white);
+        for (int glyph = 0; glyph < GLYPH_COUNT - 1; ++glyph)
+        {
+            const int column = glyph % ATLAS_COLUMNS;
+            const int row = glyph / ATLAS_COLUMNS;
+            painter.drawText(column * m_cellWidth, row * m_cellHeight + metrics.ascent(), QString(QChar(FIRST_GLYPH + glyph)));
+        }
+        // The last cell is solid, for the panel and the bars
+        const int solid = GLYPH_COUNT - 1;
+        painter.fillRect((solid % ATLAS_COLUMNS) * m_cellWidth, (solid / ATLAS_COLUMNS) * m_cellHeight,
+                         m_cellWidth, m_cellHeight, Qt::white);
+    }
+
+    // Only the coverage (alpha) goes to the GPU, one byte per texel
+    std::vector<uchar> coverage(static_cast<size_t>(m_atlasWidth) * static_cast<size_t>(m_atlasHeight));
+    for (int yy = 0; yy < m_atlasHeight; ++yy)
+    {
+        const QRgb * line = reinterpret_cast<const QRgb *>(image.constScanLine(yy));
+        for (int xx = 0; xx < m_atlasWidth; ++xx)
+            coverage[size_t(yy) * size_t(m_atlasWidth) + size_t(xx)] = uchar(qAlpha(line[xx]));
+    }
+
+    glGenTextures(1, &m_atlas);
+    glBindTexture(GL_TEXTURE_2D, m_atlas);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, m_atlasWidth, m_atlasHeight, 0, GL_RED, GL_UNSIGNED_BYTE, coverage.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Measure
+///////////////////////////////////////////////////////////////////////////////
+
+void StatsOverlay::beginFrame()
+{
+    if (!isCreated())
+        return;
+
+    // A slot still in flight after GPU_FRAMES frames: skip its GPU time
+    const int slot = int(m_frame % GPU_FRAMES);
+    if (m_gpuQueryPending[slot])
+        return;
+    glQueryCounter(m_gpuQueries[2 * slot], GL_TIMESTAMP);
+}
+
+void StatsOverlay::endFrame(qint64 cpuNanoseconds, const Counters & counters)
+{
+    if (!isCreated())
+        return;
+
+    const int slot = int(m_frame % GPU_FRAMES);
+    if (!m_gpuQueryPending[slot])
+    {
+        glQueryCounter(m_gpuQueries[2 * slot + 1], GL_TIMESTAMP);
+        m_gpuQueryPending[slot] = true;
+        m_gpuQueryFrame[slot] = m_frame;
+    }
+    collectGpuTimes();
+
+    m_cpuMilliseconds[m_frame % HISTORY] = float(double(cpuNanoseconds) / 1e6);
+    m_gpuMilliseconds[m_frame % HISTORY] = -1.0f;
+    m_counters = counters;
+    m_frame++;
+}
+
+void StatsOverlay::collectGpuTimes()
+{
+    for (int slot = 0; slot < GPU_FRAMES; ++slot)
+    {
+        if (!m_gpuQueryPending[slot])
+            continue;
+        GLuint available = GL_FALSE;
+        glGetQueryObjectuiv(m_gpuQueries[2 * slot + 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            continue;
+
+        GLuint64 begin = 0;
+        GLuint64 end = 0;
+        glGetQueryObjectui64v(m_gpuQueries[2 * slot], GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(m_gpuQueries[2 * slot + 1], GL_QUERY_RESULT, &end);
+        m_gpuQueryPending[slot] = false;
+
+        // Too late for the graph if the history moved on
+        const quint64 frame = m_gpuQueryFrame[slot];
+        if (m_frame - frame < quint64(HISTORY))
+            m_gpuMilliseconds[frame % HISTORY] = float(double(end - begin) / 1e6);
+    }
+}
+
+StatsOverlay::Percentiles StatsOverlay::percentiles(const float * samples) const
+{
+    Percentiles result;
+    float sorted[HISTORY];
+    int count = 0;
+    for (int ii = 0; ii < HISTORY; ++ii)
+    {
+        if (samples[ii] >= 0.0f)
+            sorted[count++] = samples[ii];
+    }
+    if (count == 0)
+        return result;
+
+    std::sort(sorted, sorted + count);
+    auto at = [&](float fraction) { return sorted[qMin(count - 1, int(fraction * float(count)))]; };
+    result.p50 = at(0.50f);
+    result.p95 = at(0.95f);
+    result.p99 = at(0.99f);
+    result.max = sorted[count - 1];
+
+    // The newest frame with a value (the GPU times arrive late)
+    for (quint64 ii = 1; ii <= qMin<quint64>(m_frame, HISTORY); ++ii)
+    {
+        const float value = samples[(m_frame - ii) % HISTORY];
+        if (value >= 0.0f)
+        {
+            result.last = value;
+            break;
+        }
+    }
+    return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Draw
+///////////////////////////////////////////////////////////////////////////////
+
+void StatsOverlay::draw(int width, int height)
+{
+    if (!m_visible || !isCreated() || width <= 0 || height <= 0)
+        return;
+
+    QElapsedTimer timer;
+    timer.start();
+    m_vertices.clear();
+
+    const float lineHeight = float(m_cellHeight);
+    const float graphWidth = float(HISTORY);
+    const float panelWidth = qMax(graphWidth, 46.0f * float(m_cellWidth)) + 2.0f * MARGIN;
+    const float panelHeight = 2.0f * (GRAPH_HEIGHT + MARGIN) + 6.0f * lineHeight + 3.0f * MARGIN;
+    addRect(MARGIN, MARGIN, panelWidth, panelHeight, PANEL_COLOR);
+
+    float x = 2.0f * MARGIN;
+    float y = 2.0f * MARGIN;
+    char line[128];
+
+    const Percentiles cpu = percentiles(m_cpuMilliseconds);
+    const Percentiles gpu = percentiles(m_gpuMilliseconds);
+    snprintf(line, sizeof(line), "CPU %6.2f ms  p50 %5.2f p95 %5.2f p99 %5.2f", double(cpu.last), double(cpu.p50), double(cpu.p95), double(cpu.p99));
+    addText(x, y, line, CPU_COLOR);
+    y += lineHeight;
+    addGraph(x, y, graphWidth, GRAPH_HEIGHT, m_cpuMilliseconds, CPU_COLOR);
+    y += GRAPH_HEIGHT + MARGIN;
+
+    snprintf(line, sizeof(line), "GPU %6.2f ms  p50 %5.2f p95 %5.2f p99 %5.2f", double(gpu.last), double(gpu.p50), double(gpu.p95), double(gpu.p99));
+    addText(x, y, line, GPU_COLOR);
+    y += lineHeight;
+    addGraph(x, y, graphWidth, GRAPH_HEIGHT, m_gpuMilliseconds, GPU_COLOR);
+    y += GRAPH_HEIGHT + MARGIN;
+
+    snprintf(line, sizeof(line), "max CPU %.2f ms, GPU %.2f ms (%d frames)", double(cpu.max), double(gpu.max), HISTORY);
+    addText(x, y, line, TEXT_COLOR);
+    y += lineHeight;
+    snprintf(line, sizeof(line), "draws %d  triangles %llu  states %d", m_counters.drawCalls,
+             static_cast<unsigned long long>(m_counters.triangles), m_counters.stateChanges);
+    addText(x, y, line, TEXT_COLOR);
+    y += lineHeight;
+    snprintf(line, sizeof(line), "GPU memory %.1f / %.1f MB", megabytes(m_counters.gpuMemoryBytes), megabytes(m_counters.gpuBudgetBytes));
+    addText(x, y, line, TEXT_COLOR);
+    y += lineHeight;
+    snprintf(line, sizeof(line), "textures %.1f / %.1f MB", megabytes(m_counters.textureBytes), megabytes(m_counters.textureBudgetBytes));
+    addText(x, y, line, TEXT_COLOR);
+    y += lineHeight;
+    snprintf(line, sizeof(line), "overlay %.3f ms, %d quads", double(m_drawNanoseconds) / 1e6, int(m_vertices.size() / 6));
+    addText(x, y, line, TEXT_COLOR);
+
+    // One upload into the orphaned buffer, one draw call
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(MAX_QUADS * 6 * sizeof(Vertex)), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, GLsizeiptr(m_vertices.size() * sizeof(Vertex)), m_vertices.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    m_program.use();
+    m_program.setUniform("viewportSize", QVector2D(float(width), float(height)));
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, m_atlas);
+    glBindVertexArray(m_vao);
+    glDrawArrays(GL_TRIANGLES, 0, GLsizei(m_vertices.size()));
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    m_program.release();
+    glDisable(GL_BLEND);
+    glEnable(GL_DEPTH_TEST);
+
+    m_drawNanoseconds = timer.nsecsElapsed();
+}
+
+void StatsOverlay::addQuad(float x, float y, float width, float height, float u0, float v0, float u1, float v1, quint32 color)
+{
+    // Never grows the vector, the rest of a full frame is cut off
+    if (m_vertices.size() + 6 > m_vertices.capacity())
+        return;
+
+    Vertex corners[4] = {
+        { x, y, u0, v0, {} }, { x + width, y, u1, v0, {} },
+        { x, y + height, u0, v1, {} }, { x + width, y + height, u1, v1, {} } };
+    for (Vertex & corner : corners)
+    {
+        corner.color[0] = uchar(color >> 24);
+        corner.color[1] = uchar(color >> 16);
+        corner.color[2] = uchar(color >> 8);
+        corner.color[3] = uchar(color);
+    }
+    m_vertices.push_back(corners[0]);
+    m_vertices.push_back(corners[1]);
+    m_vertices.push_back(corners[2]);
+    m_vertices.push_back(corners[2]);
+    m_vertices.push_back(corners[1]);
+    m_vertices.push_back(corners[3]);
+}
+
+void StatsOverlay::addRect(float x, float y, float width, float height, quint32 color)
+{
+    // Center of the solid cell
+    const int solid = GLYPH_COUNT - 1;
+    const float u = (float((solid % ATLAS_COLUMNS) * m_cellWidth) + 0.5f * float(m_cellWidth)) / float(m_atlasWidth);
+    const float v = (float((solid / ATLAS_COLUMNS) * m_cellHeight) + 0.5f * float(m_cellHeight)) / float(m_atlasHeight);
+    addQuad(x, y, width, height, u, v, u, v, color);
+}
+
+void StatsOverlay::addText(float x, float y, const char * text, quint32 color)
+{
+    for (const char * character = text; *character; ++character, x += float(m_cellWidth))
+    {
+        const int glyph = int(uchar(*character)) - FIRST_GLYPH;
+        if (glyph <= 0 || glyph >= GLYPH_COUNT - 1)
+            continue; // space and anything not in the atlas
+        const float u0 = float((glyph % ATLAS_COLUMNS) * m_cellWidth) / float(m_atlasWidth);
+        const float v0 = float((glyph / ATLAS_COLUMNS) * m_cellHeight) / float(m_atlasHeight);
+        const float u1 = u0 + float(m_cellWidth) / float(m_atlasWidth);
+        const float v1 = v0 + float(m_cellHeight) / float(m_atlasHeight);
+        addQuad(x, y, float(m_cellWidth), float(m_cellHeight), u0, v0, u1, v1, color);
+    }
+}
+
+void StatsOverlay::addGraph(float x, float y, float width, float height, const float * samples, quint32 color)
+{
+    // Oldest frame on the left, one pixel wide bar per frame
+    const float barWidth = width / float(HISTORY);
+    for (int ii = 0; ii < HISTORY; ++ii)
+    {
+        const quint64 frame = m_frame + quint64(ii);   // m_frame - HISTORY + ii, modulo HISTORY
+        const float value = samples[frame % HISTORY];
+        if (value < 0.0f)
+            continue;
+        const float barHeight = qMin(value / GRAPH_MILLISECONDS, 1.0f) * height;
+        addRect(x + float(ii) * barWidth, y + height - barHeight, barWidth, barHeight, color);
+    }
+
+    // One and two frames at 60 Hz
+    addRect(x, y + height - FRAME_MILLISECONDS / GRAPH_MILLISECONDS * height, width, 1.0f, LINE_COLOR);
+    addRect(x, y, width, 1.0f, LINE_COLOR);
+}
@@ -0,0 +1,122 @@
+#pragma once
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "shaderprogram.h"
+
+#include <QOpenGLFunctions_3_3_Core>
+
+#include <vector>
+
+///
+/// \brief The StatsOverlay draws the frame statistics into the viewport:
+/// rolling graphs of the CPU and GPU frame times, their percentiles and the
+/// counters of the last frame (draw calls, triangles, state changes, memory).
+/// Text and graphs are quads of one vertex buffer, written every frame and
+/// drawn with a single draw call. The glyphs come from a small atlas texture
+/// rendered with QPainter at create(), one solid texel of it colors the bars.
+///
+/// The GPU time is measured with GL_TIMESTAMP queries around the frame and
+/// read a few frames later (never waits). No heap allocations per frame.
+/// Only call from the OpenGL thread with the context current.
+///
+class StatsOverlay : protected QOpenGLFunctions_3_3_Core
+{
+public:
+    struct Counters
+    {
+        int drawCalls {0};
+        quint64 triangles {0};
+        int stateChanges {0};       // program, buffer, texture binds etc.
+        qint64 gpuMemoryBytes {0};
+        qint64 gpuBudgetBytes {0};
+        qint64 textureBytes {0};
+        qint64 textureBudgetBytes {0};
+    };
+
+    StatsOverlay() = default;
+    ~StatsOverlay();
+
+    StatsOverlay(const StatsOverlay &) = delete;
+    StatsOverlay & operator=(const StatsOverlay &) = delete;
+
+    bool create();
+    void destroy();
+    bool isCreated() const { return m_vao != 0; }
+
+    // Measured also while hidden, the graph is full when it is shown
+    void setVisible(bool visible) { m_visible = visible; }
+    bool isVisible() const { return m_visible; }
+
+    // Around the frame's GL commands
+    void beginFrame();
+    void endFrame(qint64 cpuNanoseconds, const Counters & counters);
+
+    // On top of the frame (viewport in pixels), nothing when hidden
+    void draw(int width, int height);
+
+private:
+    static constexpr int HISTORY = 240;         // frames in the graphs
+    static constexpr int GPU_FRAMES = 4;        // timestamp pairs in flight
+    static constexpr int MAX_QUADS = 2048;
+    static constexpr int FIRST_GLYPH = 32;      // printable ASCII
+    static constexpr int GLYPH_COUNT = 96;      // the last one is the solid cell
+    static constexpr int ATLAS_COLUMNS = 16;
+
+    struct Vertex
+    {
+        float x, y;
+        float u, v;
+        uchar color[4];
+    };
+
+    struct Percentiles
+    {
+        float last {0.0f};
+        float p50 {0.0f};
+        float p95 {0.0f};
+        float p99 {0.0f};
+        float max {0.0f};
+    };
+
+    bool createAtlas();
+    void collectGpuTimes();
+    Percentiles percentiles(const float * samples) const;
+
+    void addQuad(float x, float y, float width, float height, float u0, float v0, float u1, float v1, quint32 color);
+    void addRect(float x, float y, float width, float height, quint32 color);
+    void addText(float x, float y, const char * text, quint32 color);
+    void addGraph(float x, float y, float width, float height, const float * samples, quint32 color);
+
+    bool m_visible {false};
+
+    // History, indexed by frame % HISTORY, < 0: no value (yet)
+    float m_cpuMilliseconds[HISTORY];
+    float m_gpuMilliseconds[HISTORY];
+    quint64 m_frame {0};
+    Counters m_counters;
+    qint64 m_drawNanoseconds {0};   // the overlay itself, last frame
+
+    GLuint m_gpuQueries[2 * GPU_FRAMES] {};
+    quint64 m_gpuQueryFrame[GPU_FRAMES] {};
+    bool m_gpuQueryPending[GPU_FRAMES] {};
+
+    ShaderProgram m_program;
+    GLuint m_vao {0};
+    GLuint m_vbo {0};
+    GLuint m_atlas {0};
+    int m_cellWidth {0};
+    int m_cellHeight {0};
+    int m_atlasWidth {0};
+    int m_atlasHeight {0};
+    std::vector<Vertex> m_vertices;   // capacity MAX_QUADS * 6, reused
+};
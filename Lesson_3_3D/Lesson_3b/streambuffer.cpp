@@ -0,0 +1,260 @@
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "streambuffer.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QOpenGLContext>
+
+// ARB_buffer_storage (core in 4.4) is not part of the 3.3 function set
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+namespace
+{
+    using BufferStorageFunction = void (QOPENGLF_APIENTRYP)(GLenum target, GLsizeiptr size, const void * data, GLbitfield flags);
+}
+
+StreamBuffer::~StreamBuffer()
+{
+    destroy();
+}
+
+const char * StreamBuffer::modeName(Mode mode)
+{
+    switch (mode)
+    {
+    case Mode::Auto: return "auto";
+    case Mode::PersistentMapped: return "persistent mapped";
+    case Mode::MapUnsynchronized: return "map unsynchronized";
+    case Mode::Orphaning: return "orphaning";
+    }
+    return "";
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Create
+///////////////////////////////////////////////////////////////////////////////
+
+bool StreamBuffer::create(GLsizeiptr segmentSize, int framesInFlight, Mode mode)
+{
+    destroy();
+    initializeOpenGLFunctions();
+
+    QOpenGLContext * context = QOpenGLContext::currentContext();
+    Q_ASSERT(context);
+
+    BufferStorageFunction bufferStorage = nullptr;
+    if (context->hasExtension("GL_ARB_buffer_storage") || context->format().version() >= qMakePair(4, 4))
+        bufferStorage = reinterpret_cast<BufferStorageFunction>(context->getProcAddress("glBufferStorage"));
+
+    if (mode == Mode::Auto)
+        mode = bufferStorage ? Mode::PersistentMapped : Mode::MapUnsynchronized;
+    if (mode == Mode::PersistentMapped && !bufferStorage)
+    {
+        qWarning() << "Stream buffer : ARB_buffer_storage not available, using unsynchronized mapping";
+        mode = Mode::MapUnsynchronized;
+    }
+
+    m_mode = mode;
+    // Keep every segment start aligned for glBindBufferRange (max. required alignment is 256)
+    m_segmentSize = (segmentSize + 255) / 256 * 256;
+    m_framesInFlight = qBound(1, framesInFlight, MAX_FRAMES_IN_FLIGHT);
+    m_segment = 0;
+    m_used = 0;
+
+    const GLsizeiptr totalSize = m_segmentSize * m_framesInFlight;
+    glGenBuffers(1, &m_buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_buffer);
+
+    if (m_mode == Mode::PersistentMapped)
+    {
+        // Immutable storage, mapped once and written directly by the CPU
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        bufferStorage(GL_COPY_WRITE_BUFFER, totalSize, nullptr, flags);
+        m_persistentData = static_cast<char *>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, totalSize, flags));
+        if (!m_persistentData)
+        {
+            qWarning() << "Stream buffer : persistent mapping FAILED";
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+            destroy();
+            return false;
+        }
+    }
+    else
+    {
+        glBufferData(GL_COPY_WRITE_BUFFER, totalSize, nullptr, GL_STREAM_DRAW);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    qInfo() << "Stream buffer : created" << modeName(m_mode) << m_framesInFlight << "x" << m_segmentSize << "bytes";
+    return true;
+}
+
+void StreamBuffer::destroy()
+{
+    if (!m_buffer)
+        return;
+
+    for (GLsync & fence : m_fences)
+    {
+        if (fence)
+            glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    if (m_persistentData || m_mappedData)
+    {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, m_buffer);
+        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+    m_persistentData = nullptr;
+    m_mappedData = nullptr;
+
+    glDeleteBuffers(1, &m_buffer);
+    m_buffer = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Per frame
+///////////////////////////////////////////////////////////////////////////////
+
+void StreamBuffer::beginFrame()
+{
+    if (!m_buffer)
+        return;
+
+    m_segment = (m_segment + 1) % m_framesInFlight;
+    m_used = 0;
+    m_statistics.frames++;
+
+    const GLintptr segmentOffset = GLintptr(m_segment) * m_segmentSize;
+    switch (m_mode)
+    {
+    case Mode::PersistentMapped:
+        waitForSegment(m_segment);
+        break;
+    case Mode::MapUnsynchronized:
+        // The fence tells us the GPU is done, so no implicit synchronization is needed
+        waitForSegment(m_segment);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, m_buffer);
+        m_mappedData = static_cast<char *>(glMapBufferRange(GL_COPY_WRITE_BUFFER, segmentOffset, m_segmentSize,
+                                                            GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT |
+                                                            GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_FLUSH_EXPLICIT_BIT));
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        break;
+    case Mode::Orphaning:
+        // No fences - give the old store to the driver when the ring wraps around
+        glBindBuffer(GL_COPY_WRITE_BUFFER, m_buffer);
+        if (m_segment == 0)
+        {
+            glBufferData(GL_COPY_WRITE_BUFFER, m_segmentSize * m_framesInFlight, nullptr, GL_STREAM_DRAW);
+            m_statistics.orphans++;
+        }
+        m_mappedData = static_cast<char *>(glMapBufferRange(GL_COPY_WRITE_BUFFER, segmentOffset, m_segmentSize,
+                                                            GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT |
+                                                            GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_FLUSH_EXPLICIT_BIT));
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        break;
+    case Mode::Auto:
+        break;
+    }
+}
+
+StreamBuffer::Allocation StreamBuffer::allocate(GLsizeiptr size, GLsizeiptr alignment)
+{
+    Allocation allocation;
+    char * segmentData = m_mode == Mode::PersistentMapped
+                             ? m_persistentData + GLintptr(m_segment) * m_segmentSize
+                             : m_mappedData;
+    if (!segmentData)
+        return allocation;
+
+    // Offsets must be aligned in the buffer, the segments start aligned
+    const GLsizeiptr offset = (m_used + alignment - 1) / alignment * alignment;
+    if (offset + size > m_segmentSize)
+    {
+        m_statistics.failedAllocations++;
+        return allocation;
+    }
+
+    m_used = offset + size;
+    m_statistics.bytesStreamed += quint64(size);
+
+    allocation.data = segmentData + offset;
+    allocation.offset = GLintptr(m_segment) * m_segmentSize + offset;
+    allocation.size = size;
+    return allocation;
+}
+
+void StreamBuffer::flush()
+{
+    if (!m_mappedData)
+        return;
+
+    // Only the written part needs to reach the GPU
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_buffer);
+    if (m_used > 0)
+        glFlushMappedBufferRange(GL_COPY_WRITE_BUFFER, 0, m_used);
+    glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    m_mappedData = nullptr;
+}
+
+void StreamBuffer::endFrame()
+{
+    if (!m_buffer)
+        return;
+
+    flush();
+
+    if (m_mode == Mode::Orphaning)
+        return;
+
+    // Mark the point after the last command reading this segment
+    if (m_fences[m_segment])
+        glDeleteSync(m_fences[m_segment]);
+    m_fences[m_segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void StreamBuffer::waitForSegment(int segment)
+{
+    GLsync fence = m_fences[segment];
+    if (!fence)
+        return;
+
+    // Check without waiting first, any wait at all is a stall
+    GLenum result = glClientWaitSync(fence, 0, 0);
+    if (result == GL_TIMEOUT_EXPIRED)
+    {
+        m_statistics.stalls++;
+        QElapsedTimer timer;
+        timer.start();
+        const GLuint64 oneMillisecond = 1000000;
+        do
+        {
+            result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, oneMillisecond);
+        } while (result == GL_TIMEOUT_EXPIRED);
+        m_statistics.stallNanoseconds += timer.nsecsElapsed();
+    }
+    if (result == GL_WAIT_FAILED)
+        qWarning() << "Stream buffer : fence wait FAILED";
+
+    glDeleteSync(fence);
+    m_fences[segment] = nullptr;
+}
@@ -0,0 +1,102 @@
+#pragma once
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include <QOpenGLFunctions_3_3_Core>
+
+///
+/// \brief The StreamBuffer class is a ring buffer for data that changes every
+/// frame (uniform blocks, instance data, debug lines ...).
+/// The buffer is split into one segment per frame in flight. A fence guards
+/// every segment, so the CPU only waits when the GPU is still reading the
+/// segment of a frame several frames ago.
+/// - PersistentMapped : ARB_buffer_storage, mapped once (coherent) for the lifetime
+/// - MapUnsynchronized : GL 3.3 fallback, the segment is mapped unsynchronized every frame
+/// - Orphaning : GL 3.3 fallback without fences, the store is orphaned when the ring wraps
+///
+/// Per frame: beginFrame(), allocate()..., flush() before the draw calls that
+/// read the data, endFrame() after them.
+/// Only call from the OpenGL thread with the context current.
+///
+class StreamBuffer : public QOpenGLFunctions_3_3_Core
+{
+public:
+    enum class Mode
+    {
+        Auto,               // best available
+        PersistentMapped,
+        MapUnsynchronized,
+        Orphaning
+    };
+
+    struct Allocation
+    {
+        void * data {nullptr};  // write only
+        GLintptr offset {0};    // offset in the buffer (e.g. for glBindBufferRange)
+        GLsizeiptr size {0};
+
+        bool isValid() const { return data != nullptr; }
+    };
+
+    struct Statistics
+    {
+        quint64 bytesStreamed {0};
+        quint64 frames {0};
+        quint64 stalls {0};         // the fence was not yet signaled, CPU had to wait
+        qint64 stallNanoseconds {0};
+        quint64 failedAllocations {0};
+        quint64 orphans {0};
+    };
+
+    StreamBuffer() = default;
+    ~StreamBuffer();
+
+    StreamBuffer(const StreamBuffer &) = delete;
+    StreamBuffer & operator=(const StreamBuffer &) = delete;
+
+    // segmentSize bytes are available per frame
+    bool create(GLsizeiptr segmentSize, int framesInFlight = 3, Mode mode = Mode::Auto);
+    void destroy();
+    bool isCreated() const { return m_buffer != 0; }
+
+    void beginFrame();
+    Allocation allocate(GLsizeiptr size, GLsizeiptr alignment = 16);
+    void flush();
+    void endFrame();
+
+    GLuint bufferId() const { return m_buffer; }
+    Mode mode() const { return m_mode; }
+    GLsizeiptr segmentSize() const { return m_segmentSize; }
+    // GPU memory of the buffer (all segments)
+    qint64 memoryBytes() const { return m_buffer ? qint64(m_segmentSize) * m_framesInFlight : 0; }
+
+    const Statistics & statistics() const { return m_statistics; }
+    void resetStatistics() { m_statistics = Statistics(); }
+
+    static const char * modeName(Mode mode);
+
+private:
+    static constexpr int MAX_FRAMES_IN_FLIGHT = 4;
+
+    void waitForSegment(int segment);
+
+    GLuint m_buffer {0};
+    Mode m_mode {Mode::Auto};
+    GLsizeiptr m_segmentSize {0};
+    int m_framesInFlight {0};
+    int m_segment {0};
+    GLsizeiptr m_used {0};
+    char * m_persistentData {nullptr};
+    char * m_mappedData {nullptr};
+    GLsync m_fences[MAX_FRAMES_IN_FLIGHT] {};
+    Statistics m_statistics;
+};
@@ -0,0 +1,154 @@
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "benchmarkresults.h"
+
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <vector>
+
+class TestBenchmarkResults : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void median();
+    void equalSamplesDoNotDiffer();
+    void separatedSamplesDiffer();
+    void interleavedSamplesDoNotDiffer();
+    void detectsRegression();
+    void ignoresNoise();
+    void fewSamplesUseTheThreshold();
+    void metricThreshold();
+    void saveAndLoad();
+};
+
+namespace
+{
+    // count samples from first, step apart
+    std::vector<double> series(double first, double step, int count)
+    {
+        std::vector<double> samples;
+        for (int ii = 0; ii < count; ++ii)
+            samples.push_back(first + step * ii);
+        return samples;
+    }
+
+    BenchmarkResults::Comparison compareOne(const std::vector<double> & before, const std::vector<double> & after,
+                                            const BenchmarkResults::Thresholds & thresholds = BenchmarkResults::Thresholds())
+    {
+        BenchmarkResults baseline;
+        BenchmarkResults current;
+        baseline.add("frame", "ms", before);
+        current.add("frame", "ms", after);
+        const std::vector<BenchmarkResults::Comparison> comparisons = BenchmarkResults::compare(baseline, current, thresholds);
+        return comparisons.empty() ? BenchmarkResults::Comparison() : comparisons.front();
+    }
+}
+
+void TestBenchmarkResults::median()
+{
+    QCOMPARE(BenchmarkResults::median({}), 0.0);
+    QCOMPARE(BenchmarkResults::median({ 3.0, 1.0, 2.0 }), 2.0);
+    QCOMPARE(BenchmarkResults::median({ 4.0, 1.0, 3.0, 2.0 }), 2.5);
+}
+
+void TestBenchmarkResults::equalSamplesDoNotDiffer()
+{
+    const std::vector<double> samples(10, 5.0);
+    QCOMPARE(BenchmarkResults::mannWhitneyPValue(samples, samples), 1.0);
+    QCOMPARE(BenchmarkResults::mannWhitneyPValue({}, samples), 1.0);
+}
+
+void TestBenchmarkResults::separatedSamplesDiffer()
+{
+    // U = 0 for 20 against 20: z is about 5.4
+    const std::vector<double> low = series(1.0, 1.0, 20);
+    const std::vector<double> high = series(101.0, 1.0, 20);
+    const double p = BenchmarkResults::mannWhitneyPValue(low, high);
+    QVERIFY(p < 1e-6);
+    QVERIFY(p > 0.0);
+    QVERIFY(qFuzzyCompare(p, BenchmarkResults::mannWhitneyPValue(high, low)));
+}
+
+void TestBenchmarkResults::interleavedSamplesDoNotDiffer()
+{
+    // 1, 3 ... 39 against 2, 4 ... 40: p is about 0.8
+    const double p = BenchmarkResults::mannWhitneyPValue(series(1.0, 2.0, 20), series(2.0, 2.0, 20));
+    QVERIFY(p > 0.5);
+    QVERIFY(p <= 1.0);
+}
+
+void TestBenchmarkResults::detectsRegression()
+{
+    const BenchmarkResults::Comparison slower = compareOne(series(10.0, 0.01, 20), series(12.0, 0.01, 20));
+    QCOMPARE(slower.name, QString("frame"));
+    QVERIFY(slower.changePercent > 19.0 && slower.changePercent < 21.0);
+    QVERIFY(slower.pValue >= 0.0 && slower.pValue < 0.01);
+    QVERIFY(slower.regression);
+    QVERIFY(!slower.improvement);
+
+    const BenchmarkResults::Comparison faster = compareOne(series(10.0, 0.01, 20), series(8.0, 0.01, 20));
+    QVERIFY(!faster.regression);
+    QVERIFY(faster.improvement);
+}
+
+void TestBenchmarkResults::ignoresNoise()
+{
+    // Far below the 5 % threshold
+    const BenchmarkResults::Comparison comparison = compareOne(series(10.0, 0.01, 20), series(10.005, 0.01, 20));
+    QVERIFY(!comparison.regression);
+    QVERIFY(!comparison.improvement);
+}
+
+void TestBenchmarkResults::fewSamplesUseTheThreshold()
+{
+    const BenchmarkResults::Comparison comparison = compareOne({ 10.0, 10.0, 10.0 }, { 11.0, 11.0, 11.0 });
+    QVERIFY(comparison.pValue < 0.0);
+    QVERIFY(comparison.regression);
+}
+
+void TestBenchmarkResults::metricThreshold()
+{
+    BenchmarkResults::Thresholds thresholds;
+    thresholds.metricPercent["frame"] = 50.0;
+    QCOMPARE(thresholds.percentFor("frame"), 50.0);
+    QCOMPARE(thresholds.percentFor("other"), thresholds.percent);
+    QVERIFY(!compareOne(series(10.0, 0.01, 20), series(12.0, 0.01, 20), thresholds).regression);
+}
+
+void TestBenchmarkResults::saveAndLoad()
+{
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+    const QString fileName = directory.filePath("results.json");
+
+    BenchmarkResults results;
+    results.add("scenes/grid/gpu_ms", "ms", { 1.5, 2.5 });
+    results.add("memory", "MB", 64.0);
+    QVERIFY(results.save(fileName));
+
+    BenchmarkResults loaded;
+    QVERIFY(loaded.load(fileName));
+    QCOMPARE(loaded.metrics().size(), size_t(2));
+    const BenchmarkResults::Metric & metric = loaded.metrics().at("scenes/grid/gpu_ms");
+    QCOMPARE(metric.unit, QString("ms"));
+    QCOMPARE(metric.samples, (std::vector<double>{ 1.5, 2.5 }));
+
+    // Repeated runs add their samples
+    loaded.merge(results);
+    QCOMPARE(loaded.metrics().at("memory").samples.size(), size_t(2));
+}
+
+QTEST_GUILESS_MAIN(TestBenchmarkResults)
+#include "tst_benchmarkresults.moc"
@@ -0,0 +1,169 @@
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "entityregistry.h"
+
+#include <QTest>
+
+#include <vector>
+
+class TestEntityRegistry : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void createAndDestroy();
+    void staleIdsStayInvalid();
+    void retiresSlotsBeforeWrapping();
+    void componentsStayPacked();
+    void eachVisitsEntitiesWithAllComponents();
+    void destroyRemovesComponents();
+};
+
+namespace
+{
+    struct Position
+    {
+        int x {0};
+    };
+
+    struct Speed
+    {
+        int dx {0};
+    };
+}
+
+void TestEntityRegistry::createAndDestroy()
+{
+    EntityRegistry registry;
+    const Entity first = registry.create();
+    const Entity second = registry.create();
+    QVERIFY(first != second);
+    QVERIFY(registry.isValid(first));
+    QVERIFY(registry.isValid(second));
+    QVERIFY(!registry.isValid(INVALID_ENTITY));
+    QCOMPARE(registry.aliveCount(), size_t(2));
+
+    registry.destroy(first);
+    QVERIFY(!registry.isValid(first));
+    QVERIFY(registry.isValid(second));
+    QCOMPARE(registry.aliveCount(), size_t(1));
+
+    // Twice is harmless
+    registry.destroy(first);
+    QCOMPARE(registry.aliveCount(), size_t(1));
+}
+
+void TestEntityRegistry::staleIdsStayInvalid()
+{
+    EntityRegistry registry;
+    const Entity old = registry.create();
+    registry.destroy(old);
+
+    // Same slot, next generation
+    const Entity reused = registry.create();
+    QCOMPARE(entityIndex(reused), entityIndex(old));
+    QCOMPARE(entityGeneration(reused), entityGeneration(old) + 1);
+    QVERIFY(registry.isValid(reused));
+    QVERIFY(!registry.isValid(old));
+}
+
+void TestEntityRegistry::retiresSlotsBeforeWrapping()
+{
+    EntityRegistry registry;
+    const Entity first = registry.create();
+    Entity entity = first;
+    std::vector<Entity> stale;
+    while (entityGeneration(entity) + 1 < ENTITY_RETIRED_GENERATION)
+    {
+        stale.push_back(entity);
+        registry.destroy(entity);
+        entity = registry.create();
+        QCOMPARE(entityIndex(entity), entityIndex(first));
+    }
+
+    // The last generation of the slot, afterwards a new slot is used
+    registry.destroy(entity);
+    const Entity next = registry.create();
+    QVERIFY(entityIndex(next) != entityIndex(first));
+    QVERIFY(registry.isValid(next));
+    QVERIFY(!registry.isValid(entity));
+    for (Entity id : stale)
+        QVERIFY(!registry.isValid(id));
+}
+
+void TestEntityRegistry::componentsStayPacked()
+{
+    EntityRegistry registry;
+    std::vector<Entity> entities;
+    for (int ii = 0; ii < 5; ++ii)
+    {
+        entities.push_back(registry.create());
+        registry.add<Position>(entities.back(), Position{ ii });
+    }
+
+    // The last one moves into the hole
+    registry.remove<Position>(entities[1]);
+    ComponentPool<Position> & positions = registry.pool<Position>();
+    QCOMPARE(positions.size(), size_t(4));
+    QVERIFY(!registry.has<Position>(entities[1]));
+    for (int ii : { 0, 2, 3, 4 })
+        QCOMPARE(registry.get<Position>(entities[size_t(ii)]).x, ii);
+    for (size_t ii = 0; ii < positions.size(); ++ii)
+        QCOMPARE(positions.get(positions.entities()[ii]).x, positions.data()[ii].x);
+
+    // Adding again replaces
+    registry.add<Position>(entities[0], Position{ 42 });
+    QCOMPARE(positions.size(), size_t(4));
+    QCOMPARE(registry.get<Position>(entities[0]).x, 42);
+}
+
+void TestEntityRegistry::eachVisitsEntitiesWithAllComponents()
+{
+    EntityRegistry registry;
+    std::vector<Entity> entities;
+    for (int ii = 0; ii < 6; ++ii)
+    {
+        entities.push_back(registry.create());
+        registry.add<Position>(entities.back(), Position{ ii });
+        if (ii % 2 == 0)
+            registry.add<Speed>(entities.back(), Speed{ 10 });
+    }
+
+    int visited = 0;
+    registry.each<Position, Speed>([&visited](Entity, Position & position, Speed & speed) {
+        position.x += speed.dx;
+        visited++;
+    });
+    QCOMPARE(visited, 3);
+    for (int ii = 0; ii < 6; ++ii)
+        QCOMPARE(registry.get<Position>(entities[size_t(ii)]).x, ii % 2 == 0 ? ii + 10 : ii);
+}
+
+void TestEntityRegistry::destroyRemovesComponents()
+{
+    EntityRegistry registry;
+    const Entity entity = registry.create();
+    registry.add<Position>(entity, Position{ 1 });
+    registry.add<Speed>(entity, Speed{ 2 });
+    registry.destroy(entity);
+    QCOMPARE(registry.pool<Position>().size(), size_t(0));
+    QCOMPARE(registry.pool<Speed>().size(), size_t(0));
+
+    // A new entity in the same slot does not see the old components
+    const Entity reused = registry.create();
+    QCOMPARE(entityIndex(reused), entityIndex(entity));
+    QVERIFY(!registry.has<Position>(reused));
+}
+
+QTEST_GUILESS_MAIN(TestEntityRegistry)
+#include "tst_entityregistry.moc"
@@ -0,0 +1,161 @@
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "heapallocationcounter.h"
+#include "jobsystem.h"
+
+#include <QByteArray>
+#include <QTest>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+///
+/// Always built with LEARNOPENGL_COUNT_ALLOCATIONS (see tests/CMakeLists.txt),
+/// so the counter behind the steady state frame check is exercised by ctest.
+///
+class TestHeapAllocationCounter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void enabled();
+    void nothingAllocated();
+    void countsOperatorNew();
+    void countsQtContainers();
+    void ignoresOtherThreads();
+    void countsFrameJobs();
+    void ignoresBackgroundJobs();
+};
+
+namespace
+{
+    // Keeps the compiler from removing an allocation that is freed right away
+    std::atomic<void *> s_sink {nullptr};
+
+    void allocateJob(void *, int begin, int end)
+    {
+        for (int ii = begin; ii < end; ++ii)
+        {
+            std::unique_ptr<int> value = std::make_unique<int>(ii);
+            s_sink.store(value.get());
+        }
+    }
+
+    struct GatedJob
+    {
+        std::atomic<bool> open {false};
+    };
+
+    void gatedAllocateJob(void * data, int begin, int end)
+    {
+        GatedJob * gate = static_cast<GatedJob *>(data);
+        while (!gate->open.load())
+            std::this_thread::yield();
+        allocateJob(nullptr, begin, end);
+    }
+}
+
+void TestHeapAllocationCounter::enabled()
+{
+    QVERIFY(HeapAllocationCounter::isEnabled());
+}
+
+void TestHeapAllocationCounter::nothingAllocated()
+{
+    int values[16] = {};
+    HeapAllocationCounter::begin();
+    for (int ii = 0; ii < 16; ++ii)
+        values[ii] = ii * ii;
+    QCOMPARE(HeapAllocationCounter::end(), quint64(0));
+    QCOMPARE(values[15], 225);
+}
+
+void TestHeapAllocationCounter::countsOperatorNew()
+{
+    HeapAllocationCounter::begin();
+    allocateJob(nullptr, 0, 3);
+    QCOMPARE(HeapAllocationCounter::end(), quint64(3));
+
+    // Not counting after end()
+    allocateJob(nullptr, 0, 3);
+    HeapAllocationCounter::begin();
+    QCOMPARE(HeapAllocationCounter::end(), quint64(0));
+}
+
+void TestHeapAllocationCounter::countsQtContainers()
+{
+    if (!HeapAllocationCounter::countsMalloc())
+        QSKIP("malloc is only counted with glibc");
+
+    // QArrayData allocates with malloc, not operator new
+    HeapAllocationCounter::begin();
+    QByteArray bytes(1000, 'x');
+    s_sink.store(bytes.data());
+    const quint64 allocations = HeapAllocationCounter::end();
+    QVERIFY(allocations >= 1);
+}
+
+void TestHeapAllocationCounter::ignoresOtherThreads()
+{
+    std::atomic<bool> go {false};
+    std::thread other([&go]() {
+        while (!go.load())
+            std::this_thread::yield();
+        allocateJob(nullptr, 0, 5);
+    });
+    HeapAllocationCounter::begin();
+    go.store(true);
+    other.join();
+    QCOMPARE(HeapAllocationCounter::end(), quint64(0));
+}
+
+void TestHeapAllocationCounter::countsFrameJobs()
+{
+    JobSystem jobs(2);
+    JobCounter counter;
+    Job job;
+    job.function = &allocateJob;
+    job.begin = 0;
+    job.end = 4;
+    job.counter = &counter;
+
+    HeapAllocationCounter::begin();
+    for (int ii = 0; ii < 8; ++ii)
+        jobs.submit(job);
+    jobs.wait(counter);
+    QCOMPARE(HeapAllocationCounter::end(), quint64(8 * 4));
+}
+
+void TestHeapAllocationCounter::ignoresBackgroundJobs()
+{
+    JobSystem jobs(2);
+    GatedJob gate;
+    JobCounter counter;
+    Job job;
+    job.function = &gatedAllocateJob;
+    job.data = &gate;
+    job.begin = 0;
+    job.end = 4;
+    job.counter = &counter;
+    jobs.submitBackground(job);
+
+    // Runs on a worker during the frame, the waiting thread does not pick it up
+    HeapAllocationCounter::begin();
+    gate.open.store(true);
+    jobs.wait(counter);
+    QCOMPARE(HeapAllocationCounter::end(), quint64(0));
+}
+
+QTEST_GUILESS_MAIN(TestHeapAllocationCounter)
+#include "tst_heapallocationcounter.moc"
@@ -0,0 +1,183 @@
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "mipmapbuilder.h"
+#include "jobsystem.h"
+
+#include <QImage>
+#include <QTest>
+
+#include <vector>
+
+class TestMipmapBuilder : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void levelCount();
+    void levelSizes();
+    void boxKeepsLastColumnOfOddWidth();
+    void boxWeighsOddSizesEvenly();
+    void boxKeepsLastRowOfOddHeight();
+    void constantStaysConstant();
+    void transparentTexelsDoNotBleed();
+    void jobsGiveTheSameLevels();
+};
+
+namespace
+{
+    QImage solidImage(int width, int height, uchar red, uchar green, uchar blue, uchar alpha)
+    {
+        QImage image(width, height, QImage::Format_RGBA8888);
+        for (int yy = 0; yy < height; ++yy)
+        {
+            uchar * texels = image.scanLine(yy);
+            for (int xx = 0; xx < width; ++xx)
+            {
+                texels[xx * 4 + 0] = red;
+                texels[xx * 4 + 1] = green;
+                texels[xx * 4 + 2] = blue;
+                texels[xx * 4 + 3] = alpha;
+            }
+        }
+        return image;
+    }
+
+    uchar * texel(QImage & image, int x, int y) { return image.scanLine(y) + x * 4; }
+    const uchar * texel(const QImage & image, int x, int y) { return image.constScanLine(y) + x * 4; }
+
+    // Plain averages, no sRGB decoding and no wrap around
+    MipmapBuilder::Options boxOptions()
+    {
+        MipmapBuilder::Options options;
+        options.filter = MipmapBuilder::Filter::Box;
+        options.srgb = false;
+        options.wrap = false;
+        return options;
+    }
+}
+
+void TestMipmapBuilder::levelCount()
+{
+    QCOMPARE(MipmapBuilder::levelCount(QSize(1, 1)), 1);
+    QCOMPARE(MipmapBuilder::levelCount(QSize(8, 3)), 4);
+    QCOMPARE(MipmapBuilder::levelCount(QSize(5, 5)), 3);
+    QCOMPARE(MipmapBuilder::levelCount(QSize(256, 1)), 9);
+}
+
+void TestMipmapBuilder::levelSizes()
+{
+    const std::vector<QImage> levels = MipmapBuilder::build(solidImage(5, 3, 10, 20, 30, 255), MipmapBuilder::Options());
+    QCOMPARE(int(levels.size()), MipmapBuilder::levelCount(QSize(5, 3)));
+    QCOMPARE(levels[0].size(), QSize(5, 3));
+    QCOMPARE(levels[1].size(), QSize(2, 1));
+    QCOMPARE(levels[2].size(), QSize(1, 1));
+    for (const QImage & level : levels)
+        QCOMPARE(level.format(), QImage::Format_RGBA8888);
+}
+
+void TestMipmapBuilder::boxKeepsLastColumnOfOddWidth()
+{
+    // A 2x2 box would average the first two texels only
+    QImage image = solidImage(3, 1, 0, 0, 0, 255);
+    texel(image, 2, 0)[0] = 255;
+    const QImage level = MipmapBuilder::downsample(image, boxOptions());
+    QCOMPARE(level.size(), QSize(1, 1));
+    QCOMPARE(int(texel(level, 0, 0)[0]), 85);
+    QCOMPARE(int(texel(level, 0, 0)[3]), 255);
+}
+
+void TestMipmapBuilder::boxWeighsOddSizesEvenly()
+{
+    // 5 into 2: weights 2/5 2/5 1/5 and 1/5 2/5 2/5, the middle texel is in both
+    QImage image = solidImage(5, 1, 0, 0, 0, 255);
+    texel(image, 2, 0)[0] = 255;
+    const QImage level = MipmapBuilder::downsample(image, boxOptions());
+    QCOMPARE(level.size(), QSize(2, 1));
+    QCOMPARE(int(texel(level, 0, 0)[0]), 51);
+    QCOMPARE(int(texel(level, 1, 0)[0]), 51);
+}
+
+void TestMipmapBuilder::boxKeepsLastRowOfOddHeight()
+{
+    QImage image = solidImage(1, 3, 0, 0, 0, 255);
+    texel(image, 0, 2)[1] = 255;
+    const QImage level = MipmapBuilder::downsample(image, boxOptions());
+    QCOMPARE(level.size(), QSize(1, 1));
+    QCOMPARE(int(texel(level, 0, 0)[1]), 85);
+}
+
+void TestMipmapBuilder::constantStaysConstant()
+{
+    // The weights of both filters add up to 1, sRGB is decoded and encoded again
+    for (MipmapBuilder::Filter filter : { MipmapBuilder::Filter::Box, MipmapBuilder::Filter::Kaiser })
+    {
+        MipmapBuilder::Options options;
+        options.filter = filter;
+        const std::vector<QImage> levels = MipmapBuilder::build(solidImage(7, 5, 100, 150, 200, 255), options);
+        for (const QImage & level : levels)
+        {
+            for (int yy = 0; yy < level.height(); ++yy)
+            {
+                for (int xx = 0; xx < level.width(); ++xx)
+                {
+                    const uchar * rgba = texel(level, xx, yy);
+                    QVERIFY(qAbs(int(rgba[0]) - 100) <= 1);
+                    QVERIFY(qAbs(int(rgba[1]) - 150) <= 1);
+                    QVERIFY(qAbs(int(rgba[2]) - 200) <= 1);
+                    QCOMPARE(int(rgba[3]), 255);
+                }
+            }
+        }
+    }
+}
+
+void TestMipmapBuilder::transparentTexelsDoNotBleed()
+{
+    // Premultiplied: the green of the transparent texel has no weight
+    QImage image = solidImage(2, 1, 255, 0, 0, 255);
+    uchar * transparent = texel(image, 1, 0);
+    transparent[0] = 0;
+    transparent[1] = 255;
+    transparent[3] = 0;
+    const QImage level = MipmapBuilder::downsample(image, boxOptions());
+    QCOMPARE(int(texel(level, 0, 0)[0]), 255);
+    QCOMPARE(int(texel(level, 0, 0)[1]), 0);
+    QCOMPARE(int(texel(level, 0, 0)[3]), 128);
+}
+
+void TestMipmapBuilder::jobsGiveTheSameLevels()
+{
+    // More rows than one band, so the jobs split the level
+    QImage image(96, 80, QImage::Format_RGBA8888);
+    for (int yy = 0; yy < image.height(); ++yy)
+    {
+        for (int xx = 0; xx < image.width(); ++xx)
+        {
+            uchar * rgba = texel(image, xx, yy);
+            rgba[0] = uchar(xx * 3);
+            rgba[1] = uchar(yy * 5);
+            rgba[2] = uchar((xx + yy) * 7);
+            rgba[3] = 255;
+        }
+    }
+
+    JobSystem jobs(2);
+    const std::vector<QImage> single = MipmapBuilder::build(image, MipmapBuilder::Options());
+    const std::vector<QImage> parallel = MipmapBuilder::build(image, MipmapBuilder::Options(), &jobs);
+    QCOMPARE(parallel.size(), single.size());
+    for (size_t ii = 0; ii < single.size(); ++ii)
+        QVERIFY(parallel[ii] == single[ii]);
+}
+
+QTEST_GUILESS_MAIN(TestMipmapBuilder)
+#include "tst_mipmapbuilder.moc"
@@ -0,0 +1,142 @@
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "occlusionculler.h"
+#include "jobsystem.h"
+
+#include <QMatrix4x4>
+#include <QTest>
+#include <QVector3D>
+
+#include <algorithm>
+#include <vector>
+
+class TestOcclusionCuller : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void nothingHiddenWithoutOccluders();
+    void hidesBoxBehindOccluder();
+    void keepsBoxInFrontOfOccluder();
+    void keepsBoxBesideOccluder();
+    void ignoresBackFaces();
+    void jobsGiveTheSameDepth();
+};
+
+namespace
+{
+    // Wall at z = 0 from -3 to 3, counter clockwise seen from +z
+    const float WALL_VERTICES[] = {
+        -3.0f, -3.0f, 0.0f,
+         3.0f, -3.0f, 0.0f,
+         3.0f,  3.0f, 0.0f,
+        -3.0f,  3.0f, 0.0f,
+    };
+    const quint16 FRONT_INDICES[] = { 0, 1, 2, 0, 2, 3 };
+    const quint16 BACK_INDICES[] = { 0, 2, 1, 0, 3, 2 };
+
+    OccluderMesh wall(const quint16 * indices)
+    {
+        OccluderMesh mesh;
+        mesh.vertices = WALL_VERTICES;
+        mesh.vertexCount = 4;
+        mesh.indices = indices;
+        mesh.indexCount = 6;
+        return mesh;
+    }
+
+    // Camera at z = 5 looking down -z
+    QMatrix4x4 viewProjection()
+    {
+        QMatrix4x4 projection;
+        projection.perspective(60.0f, 2.0f, 0.1f, 100.0f);
+        QMatrix4x4 view;
+        view.lookAt(QVector3D(0.0f, 0.0f, 5.0f), QVector3D(0.0f, 0.0f, 0.0f), QVector3D(0.0f, 1.0f, 0.0f));
+        return projection * view;
+    }
+
+    void renderWall(OcclusionCuller & culler, const quint16 * indices)
+    {
+        culler.beginFrame(viewProjection());
+        culler.addOccluder(wall(indices), QMatrix4x4());
+        culler.rasterizeTiles(0, culler.tileCount());
+    }
+
+    const QVector3D BOX_EXTENTS(0.5f, 0.5f, 0.5f);
+}
+
+void TestOcclusionCuller::nothingHiddenWithoutOccluders()
+{
+    OcclusionCuller culler;
+    culler.beginFrame(viewProjection());
+    culler.rasterizeTiles(0, culler.tileCount());
+    QVERIFY(culler.isVisible(QVector3D(0.0f, 0.0f, -5.0f), BOX_EXTENTS));
+    QVERIFY(culler.isVisible(QVector3D(0.0f, 0.0f, -50.0f), BOX_EXTENTS));
+    QCOMPARE(culler.statistics().occluders, 0);
+}
+
+void TestOcclusionCuller::hidesBoxBehindOccluder()
+{
+    OcclusionCuller culler;
+    renderWall(culler, FRONT_INDICES);
+    QCOMPARE(culler.statistics().occluders, 1);
+    QCOMPARE(culler.statistics().triangles, 2);
+    QVERIFY(!culler.isVisible(QVector3D(0.0f, 0.0f, -5.0f), BOX_EXTENTS));
+    QVERIFY(!culler.isVisible(QVector3D(1.0f, -1.0f, -20.0f), BOX_EXTENTS));
+}
+
+void TestOcclusionCuller::keepsBoxInFrontOfOccluder()
+{
+    OcclusionCuller culler;
+    renderWall(culler, FRONT_INDICES);
+    QVERIFY(culler.isVisible(QVector3D(0.0f, 0.0f, 2.0f), BOX_EXTENTS));
+    // Partly in front, partly behind
+    QVERIFY(culler.isVisible(QVector3D(0.0f, 0.0f, 0.0f), BOX_EXTENTS));
+}
+
+void TestOcclusionCuller::keepsBoxBesideOccluder()
+{
+    // At z = -5 the wall covers x from -6 to 6 on screen
+    OcclusionCuller culler;
+    renderWall(culler, FRONT_INDICES);
+    QVERIFY(culler.isVisible(QVector3D(8.0f, 0.0f, -5.0f), BOX_EXTENTS));
+    QVERIFY(culler.isVisible(QVector3D(0.0f, 8.0f, -5.0f), BOX_EXTENTS));
+}
+
+void TestOcclusionCuller::ignoresBackFaces()
+{
+    OcclusionCuller culler;
+    renderWall(culler, BACK_INDICES);
+    QCOMPARE(culler.statistics().triangles, 0);
+    QVERIFY(culler.isVisible(QVector3D(0.0f, 0.0f, -5.0f), BOX_EXTENTS));
+}
+
+void TestOcclusionCuller::jobsGiveTheSameDepth()
+{
+    OcclusionCuller single;
+    renderWall(single, FRONT_INDICES);
+
+    JobSystem jobs(2);
+    JobCounter counter;
+    OcclusionCuller parallel;
+    parallel.beginFrame(viewProjection());
+    parallel.addOccluder(wall(FRONT_INDICES), QMatrix4x4());
+    parallel.rasterize(jobs, counter);
+    jobs.wait(counter);
+
+    const int pixels = single.width() * single.height();
+    QVERIFY(std::equal(single.depth(), single.depth() + pixels, parallel.depth()));
+}
+
+QTEST_GUILESS_MAIN(TestOcclusionCuller)
+#include "tst_occlusionculler.moc"
@@ -0,0 +1,180 @@
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "pixelconversion.h"
+
+#include <QImage>
+#include <QTest>
+
+#include <cstring>
+#include <vector>
+
+class TestPixelConversion : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void bgraToRgba();
+    void rgbToRgba();
+    void premultiply();
+    void flipVertical();
+    void flipWideRows();
+    void toRgba8888();
+    void prepareUploadKeepsNativeFormat();
+    void prepareUploadExpandsRgb();
+};
+
+namespace
+{
+    // Row yy filled with the byte yy, so the order of the rows shows
+    QImage numberedRows(int width, int height)
+    {
+        QImage image(width, height, QImage::Format_RGBA8888);
+        for (int yy = 0; yy < height; ++yy)
+            memset(image.scanLine(yy), yy, size_t(image.bytesPerLine()));
+        return image;
+    }
+}
+
+void TestPixelConversion::bgraToRgba()
+{
+    // 7 texels: 4 in the SIMD loop, 3 in the tail
+    std::vector<uchar> texels;
+    for (int ii = 0; ii < 7; ++ii)
+        texels.insert(texels.end(), { uchar(ii), uchar(100 + ii), uchar(200 + ii), uchar(50 + ii) });
+    std::vector<uchar> converted(texels.size());
+    PixelConversion::bgraToRgba(texels.data(), converted.data(), 7);
+    for (int ii = 0; ii < 7; ++ii)
+    {
+        QCOMPARE(converted[size_t(ii) * 4 + 0], uchar(200 + ii));
+        QCOMPARE(converted[size_t(ii) * 4 + 1], uchar(100 + ii));
+        QCOMPARE(converted[size_t(ii) * 4 + 2], uchar(ii));
+        QCOMPARE(converted[size_t(ii) * 4 + 3], uchar(50 + ii));
+    }
+
+    // In place gives the same
+    PixelConversion::bgraToRgba(texels.data(), texels.data(), 7);
+    QCOMPARE(texels, converted);
+}
+
+void TestPixelConversion::rgbToRgba()
+{
+    const int count = 11;
+    std::vector<uchar> rgb;
+    for (int ii = 0; ii < count * 3; ++ii)
+        rgb.push_back(uchar(ii * 7));
+    std::vector<uchar> rgba(size_t(count) * 4, 0);
+    PixelConversion::rgbToRgba(rgb.data(), rgba.data(), count);
+    for (int ii = 0; ii < count; ++ii)
+    {
+        for (int cc = 0; cc < 3; ++cc)
+            QCOMPARE(rgba[size_t(ii) * 4 + cc], rgb[size_t(ii) * 3 + cc]);
+        QCOMPARE(rgba[size_t(ii) * 4 + 3], uchar(255));
+    }
+}
+
+void TestPixelConversion::premultiply()
+{
+    // Every alpha with a few colors, against color * alpha / 255 rounded
+    std::vector<uchar> texels;
+    for (int alpha = 0; alpha < 256; ++alpha)
+        texels.insert(texels.end(), { 255, 128, uchar(alpha), uchar(alpha) });
+    const std::vector<uchar> original = texels;
+    PixelConversion::premultiply(texels.data(), 256);
+    for (size_t ii = 0; ii < texels.size(); ii += 4)
+    {
+        const int alpha = original[ii + 3];
+        for (size_t cc = 0; cc < 3; ++cc)
+            QCOMPARE(int(texels[ii + cc]), qRound(original[ii + cc] * alpha / 255.0));
+        QCOMPARE(int(texels[ii + 3]), alpha);
+    }
+}
+
+void TestPixelConversion::flipVertical()
+{
+    for (int height : { 1, 2, 5 })
+    {
+        QImage image = numberedRows(3, height);
+        PixelConversion::flipVertical(image);
+        for (int yy = 0; yy < height; ++yy)
+            QCOMPARE(int(image.constScanLine(yy)[0]), height - 1 - yy);
+    }
+}
+
+void TestPixelConversion::flipWideRows()
+{
+    // 1200 bytes per row, more than the stack chunk of one swap
+    QImage image = numberedRows(300, 4);
+    image.scanLine(0)[image.bytesPerLine() - 1] = 0xAA;
+    PixelConversion::flipVertical(image);
+    for (int yy = 0; yy < 4; ++yy)
+    {
+        const uchar * row = image.constScanLine(yy);
+        QCOMPARE(int(row[0]), 3 - yy);
+        QCOMPARE(int(row[1100]), 3 - yy);
+    }
+    QCOMPARE(int(image.constScanLine(3)[image.bytesPerLine() - 1]), 0xAA);
+}
+
+void TestPixelConversion::toRgba8888()
+{
+    QImage image(5, 2, QImage::Format_ARGB32);
+    image.fill(qRgba(0x10, 0x20, 0x30, 0x40));
+    qint64 bytesCopied = 0;
+    const QImage converted = PixelConversion::toRgba8888(std::move(image), &bytesCopied);
+    QCOMPARE(converted.format(), QImage::Format_RGBA8888);
+    QCOMPARE(converted.size(), QSize(5, 2));
+    const uchar * texel = converted.constScanLine(1) + 4 * 4;
+    QCOMPARE(int(texel[0]), 0x10);
+    QCOMPARE(int(texel[1]), 0x20);
+    QCOMPARE(int(texel[2]), 0x30);
+    QCOMPARE(int(texel[3]), 0x40);
+    QVERIFY(bytesCopied > 0);
+}
+
+void TestPixelConversion::prepareUploadKeepsNativeFormat()
+{
+    QImage image(4, 3, QImage::Format_ARGB32);
+    for (int yy = 0; yy < 3; ++yy)
+        image.setPixel(0, yy, qRgba(yy, 0, 0, 255));
+
+    PixelConversion::Options options;
+    const PixelConversion::Upload upload = PixelConversion::prepareUpload(std::move(image), options);
+    QCOMPARE(upload.image.format(), QImage::Format_ARGB32);
+    QCOMPARE(upload.pixelFormat, QOpenGLTexture::BGRA);
+    QCOMPARE(upload.pixelType, QOpenGLTexture::UInt32_RGBA8_Rev);
+    // Bottom row first
+    for (int yy = 0; yy < 3; ++yy)
+        QCOMPARE(qRed(upload.image.pixel(0, yy)), 2 - yy);
+}
+
+void TestPixelConversion::prepareUploadExpandsRgb()
+{
+    QImage image(3, 2, QImage::Format_RGB888);
+    image.fill(QColor(1, 2, 3));
+    image.setPixelColor(0, 0, QColor(9, 8, 7));
+
+    PixelConversion::Options options;
+    const PixelConversion::Upload upload = PixelConversion::prepareUpload(std::move(image), options);
+    QCOMPARE(upload.image.format(), QImage::Format_RGBA8888);
+    QCOMPARE(upload.pixelFormat, QOpenGLTexture::RGBA);
+    // The first row is the last after the flip
+    const uchar * moved = upload.image.constScanLine(1);
+    QCOMPARE(int(moved[0]), 9);
+    QCOMPARE(int(moved[1]), 8);
+    QCOMPARE(int(moved[2]), 7);
+    QCOMPARE(int(moved[3]), 255);
+    QCOMPARE(int(upload.image.constScanLine(0)[0]), 1);
+}
+
+QTEST_GUILESS_MAIN(TestPixelConversion)
+#include "tst_pixelconversion.moc"
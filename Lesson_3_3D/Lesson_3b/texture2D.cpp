@@ -10,13 +10,18 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 //-----------------------------------------------------------------------------
 #include "texture2D.h"
+#include "pixelconversion.h"
+#include "profiler.h"
 
+#include <QElapsedTimer>
 #include <QImage>
 #include <QImageReader>
 #include <QOpenGLTexture>
 
-Texture2D::Texture2D()
-    : QOpenGLTexture(QOpenGLTexture::Target2D)
+#include <cstring>
+
+Texture2D::Texture2D(QOpenGLTexture::Target target)
+    : QOpenGLTexture(target)
 {
 }
 
@@ -27,30 +32,177 @@ Texture2D::~Texture2D()
 
 bool Texture2D::loadTexture(const QString & texFile, bool generateMipMaps)
 {
+    PROFILE_FUNCTION();
     qInfo() << "Texture 2D : read texture file... ";
+    QElapsedTimer timer;
+    timer.start();
+    if (!loadTexture(readImage(texFile), generateMipMaps))
+        return false;
 
-    if (generateMipMaps)
+    const double megapixels = double(width()) * height() / 1e6;
+    qInfo() << "Texture 2D : load time" << double(timer.nsecsElapsed()) / 1e6 / qMax(megapixels, 1e-6) << "ms per megapixel";
+    return true;
+}
+
+QImage Texture2D::readImage(const QString & texFile)
+{
+    PROFILE_FUNCTION();
+    // Flipped in place for the OpenGL texture coordinates, no mirrored() copy
+    QImage image(texFile);
+    PixelConversion::flipVertical(image);
+    return image;
+}
+
+bool Texture2D::loadTexture(const QImage & image, bool generateMipMaps)
+{
+    PROFILE_FUNCTION();
+    if (image.isNull())
     {
-        setData(QImage(texFile).mirrored(), QOpenGLTexture::GenerateMipMaps);
-        Q_ASSERT(isAutoMipMapGenerationEnabled());
+        qWarning() << "Texture 2D : read texture file ... FAILED";
+        return false;
     }
-    else
+
+    // Uploaded in the decoded format where OpenGL can take it (BGRA for RGB32)
+    PixelConversion::Options options;
+    options.flip = false;
+    const PixelConversion::Upload upload = PixelConversion::prepareUpload(image, options);
+
+    setSize(upload.image.width(), upload.image.height());
+    setFormat(QOpenGLTexture::RGBA8_UNorm);
+    setMipLevels(generateMipMaps ? maximumMipLevels() : 1);
+    allocateStorage(upload.pixelFormat, upload.pixelType);
+    if (!isStorageAllocated())
     {
-        setData(QImage(texFile).mirrored(), QOpenGLTexture::DontGenerateMipMaps);
-        Q_ASSERT(!isAutoMipMapGenerationEnabled());
+        qWarning() << "Texture 2D : texture storage ... FAILED";
+        return false;
     }
+    setData(0, upload.pixelFormat, upload.pixelType, upload.image.constBits());
+    if (generateMipMaps)
+        QOpenGLTexture::generateMipMaps();
+
     setMinificationFilter(QOpenGLTexture::Linear);
     setMagnificationFilter(QOpenGLTexture::Linear);
     setWrapMode(QOpenGLTexture::Repeat);
 
-    bool result = create();
+    qInfo() << "Texture 2D : texture file loaded ... " << format() << width() << height() << depth() << levelOfDetailRange()
+            << image.format() << upload.bytesCopied << "bytes copied";
+	return true;
+}
+
+bool Texture2D::loadTexture(const QImage & image, const MipmapBuilder::Options & options, JobSystem * jobs)
+{
+    return loadTextureLevels(MipmapBuilder::build(image, options, jobs));
+}
 
-    if (!result)
+bool Texture2D::loadTextureLevels(const std::vector<QImage> & levels)
+{
+    PROFILE_FUNCTION();
+    Q_ASSERT(target() == QOpenGLTexture::Target2D);
+    if (levels.empty() || levels.front().isNull())
     {
-        qWarning() << "Texture 2D : read texture file ... FAILED";
+        qWarning() << "Texture 2D : no mip levels ... FAILED";
         return false;
     }
-    Q_ASSERT(isStorageAllocated());
-    qInfo() << "Texture 2D : texture file loaded ... " << format() << width() << height()<< depth() << levelOfDetailRange();
-	return true;
+
+    setSize(levels.front().width(), levels.front().height());
+    setFormat(QOpenGLTexture::RGBA8_UNorm);
+    setMipLevels(int(levels.size()));
+    allocateStorage(QOpenGLTexture::RGBA, QOpenGLTexture::UInt8);
+    if (!isStorageAllocated())
+    {
+        qWarning() << "Texture 2D : mip level storage ... FAILED";
+        return false;
+    }
+
+    for (int level = 0; level < int(levels.size()); ++level)
+    {
+        const QImage rgba = levels[level].convertToFormat(QImage::Format_RGBA8888);
+        setData(level, QOpenGLTexture::RGBA, QOpenGLTexture::UInt8, rgba.constBits());
+    }
+    setMinificationFilter(QOpenGLTexture::LinearMipMapLinear);
+    setMagnificationFilter(QOpenGLTexture::Linear);
+    setWrapMode(QOpenGLTexture::Repeat);
+
+    qInfo() << "Texture 2D : mip levels loaded ... " << format() << width() << height() << levels.size() << "levels";
+    return true;
+}
+
+bool Texture2D::loadTextureArray(const QList<QImage> & images, LayerFit fit, bool generateMipMaps, const QSize & layerSize)
+{
+    PROFILE_FUNCTION();
+    Q_ASSERT(target() == QOpenGLTexture::Target2DArray);
+    if (images.isEmpty())
+    {
+        qWarning() << "Texture 2D : no images for the texture array ... FAILED";
+        return false;
+    }
+
+    QSize size = layerSize;
+    if (!size.isValid())
+    {
+        for (const QImage & image : images)
+            size = size.expandedTo(image.size());
+    }
+
+    // Immutable storage for all layers and mip levels, then fill layer by layer
+    setSize(size.width(), size.height());
+    setLayers(int(images.size()));
+    setFormat(QOpenGLTexture::RGBA8_UNorm);
+    setMipLevels(generateMipMaps ? maximumMipLevels() : 1);
+    allocateStorage(QOpenGLTexture::RGBA, QOpenGLTexture::UInt8);
+    if (!isStorageAllocated())
+    {
+        qWarning() << "Texture 2D : texture array storage ... FAILED";
+        return false;
+    }
+
+    m_layerScale.clear();
+    for (int layer = 0; layer < int(images.size()); ++layer)
+    {
+        const QImage & image = images[layer];
+        const QImage layerImage = fitToLayer(image, size, fit);
+        setData(0, layer, QOpenGLTexture::RGBA, QOpenGLTexture::UInt8, layerImage.constBits());
+
+        if (fit == LayerFit::Pad)
+            m_layerScale.append(QVector2D(qMin(1.0f, float(image.width()) / size.width()),
+                                          qMin(1.0f, float(image.height()) / size.height())));
+        else
+            m_layerScale.append(QVector2D(1.0f, 1.0f));
+    }
+
+    if (generateMipMaps)
+        QOpenGLTexture::generateMipMaps();
+    setMinificationFilter(QOpenGLTexture::Linear);
+    setMagnificationFilter(QOpenGLTexture::Linear);
+    setWrapMode(QOpenGLTexture::Repeat);
+
+    qInfo() << "Texture 2D : texture array loaded ... " << format() << width() << height() << layers() << "layers";
+    return true;
+}
+
+QVector2D Texture2D::layerScale(int layer) const
+{
+    if (layer < 0 || layer >= int(m_layerScale.size()))
+        return QVector2D(1.0f, 1.0f);
+    return m_layerScale[layer];
+}
+
+// Same size and pixel layout for every layer
+QImage Texture2D::fitToLayer(const QImage & image, const QSize & layerSize, LayerFit fit)
+{
+    QImage rgba = PixelConversion::toRgba8888(image);
+    if (rgba.size() == layerSize)
+        return rgba;
+
+    if (fit == LayerFit::Scale)
+        return rgba.scaled(layerSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+
+    // Copy into the bottom left corner (the images are already mirrored for OpenGL)
+    QImage padded(layerSize, QImage::Format_RGBA8888);
+    padded.fill(Qt::transparent);
+    const int rows = qMin(rgba.height(), layerSize.height());
+    const int rowBytes = qMin(rgba.width(), layerSize.width()) * 4;
+    for (int yy = 0; yy < rows; ++yy)
+        memcpy(padded.scanLine(yy), rgba.constScanLine(yy), rowBytes);
+    return padded;
 }
@@ -11,16 +11,59 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 //-----------------------------------------------------------------------------
 
+#include "mipmapbuilder.h"
+
 #include <QOpenGLTexture>
+#include <QImage>
+#include <QList>
+#include <QVector2D>
+
+#include <vector>
 
+///
+/// \brief The Texture2D class is a 2D texture (Target2D) or a 2D array texture
+/// (Target2DArray). An array texture holds several same sized images as layers,
+/// so differently textured objects can share one bind and one draw call.
+///
 class Texture2D : public QOpenGLTexture
 {
 public:
-	Texture2D();
+    // How an image of another size is fitted into an array layer
+    enum class LayerFit
+    {
+        Scale,  // stretch to the layer size
+        Pad     // keep the size, fill the rest with transparent black (see layerScale)
+    };
+
+    explicit Texture2D(QOpenGLTexture::Target target = QOpenGLTexture::Target2D);
 	virtual ~Texture2D();
 
     bool loadTexture(const QString & fileName, bool generateMipMaps = true);
 
+    // Upload an already decoded image (see readImage), OpenGL thread only
+    bool loadTexture(const QImage & image, bool generateMipMaps = true);
+
+    // Mip levels filtered on the CPU (see MipmapBuilder) instead of by the driver
+    bool loadTexture(const QImage & image, const MipmapBuilder::Options & options, JobSystem * jobs = nullptr);
+    // Upload a complete mip chain (level 0 first, RGBA8888), level by level
+    bool loadTextureLevels(const std::vector<QImage> & levels);
+
+    // Decode the image file ready for upload, can be called from any thread
+    static QImage readImage(const QString & fileName);
+
+    // Target2DArray only: one layer per image, an invalid layerSize means the largest image
+    bool loadTextureArray(const QList<QImage> & images, LayerFit fit = LayerFit::Scale,
+                          bool generateMipMaps = true, const QSize & layerSize = QSize());
+
+    // Part of the layer covered by the image, multiply the texture coordinates with it
+    QVector2D layerScale(int layer) const;
+
+    // RGBA8888 image of layerSize, any thread (also used for the streamed levels)
+    static QImage fitToLayer(const QImage & image, const QSize & layerSize, LayerFit fit);
+
     // Use QOpenGLTexture::bind
     // Release QOpenGLTexture::release
+
+private:
+    QList<QVector2D> m_layerScale;
 };
@@ -0,0 +1,104 @@
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "texturecache.h"
+#include "texture2D.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+
+TextureCache::TextureCache(GpuMemory & memory)
+    : m_memory(memory)
+{
+}
+
+TextureCache::~TextureCache()
+{
+    clear();
+}
+
+Texture2D * TextureCache::texture(const QString & fileName)
+{
+    auto found = m_index.constFind(fileName);
+    int index = -1;
+    if (found != m_index.constEnd())
+    {
+        index = found.value();
+    }
+    else
+    {
+        index = int(m_entries.size());
+        Entry entry;
+        entry.fileName = fileName;
+        entry.texture = std::make_unique<Texture2D>();
+        m_entries.push_back(std::move(entry));
+        m_index.insert(fileName, index);
+    }
+
+    Entry & entry = m_entries[index];
+    if (entry.handle)
+    {
+        m_statistics.hits++;
+        m_memory.touch(entry.handle);
+        return entry.texture.get();
+    }
+
+    // Not resident (never loaded or evicted)
+    m_statistics.misses++;
+    QElapsedTimer timer;
+    timer.start();
+    if (!entry.texture->loadTexture(fileName, true))
+    {
+        entry.texture->destroy();
+        return nullptr;
+    }
+    m_statistics.loadNanoseconds += timer.nsecsElapsed();
+
+    entry.handle = m_memory.add(GpuMemory::Category::Texture, fileName, GpuMemory::textureBytes(*entry.texture),
+                                &TextureCache::evict, this, quintptr(index));
+
+    // Make room for it, the textures of this frame stay
+    m_memory.enforceBudget();
+    return entry.texture.get();
+}
+
+void TextureCache::evict(void * owner, quintptr key)
+{
+    TextureCache * cache = static_cast<TextureCache *>(owner);
+    Entry & entry = cache->m_entries[size_t(key)];
+    entry.texture->destroy();
+    entry.handle = 0;
+    cache->m_statistics.evictions++;
+}
+
+void TextureCache::clear()
+{
+    for (Entry & entry : m_entries)
+    {
+        m_memory.remove(entry.handle);
+        entry.texture->destroy();
+    }
+    m_entries.clear();
+    m_index.clear();
+}
+
+TextureCache::Statistics TextureCache::statistics() const
+{
+    Statistics statistics = m_statistics;
+    statistics.textures = int(m_entries.size());
+    for (const Entry & entry : m_entries)
+    {
+        if (entry.handle)
+            statistics.resident++;
+    }
+    return statistics;
+}
@@ -0,0 +1,72 @@
+#pragma once
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "gpumemory.h"
+
+#include <QHash>
+#include <QString>
+
+#include <memory>
+#include <vector>
+
+class Texture2D;
+
+///
+/// \brief The TextureCache loads 2D textures by file name and accounts them in
+/// the GpuMemory. They can always be loaded again from their file, so the
+/// GpuMemory may evict them when it is over budget; the next texture() call
+/// loads the texture again (a miss).
+/// The Texture2D objects stay valid until clear(), only their storage is freed.
+/// Only call from the OpenGL thread with the context current.
+///
+class TextureCache
+{
+public:
+    struct Statistics
+    {
+        int textures {0};
+        int resident {0};
+        quint64 hits {0};
+        quint64 misses {0};         // first loads and loads after an eviction
+        quint64 evictions {0};
+        qint64 loadNanoseconds {0};
+    };
+
+    explicit TextureCache(GpuMemory & memory);
+    ~TextureCache();
+
+    TextureCache(const TextureCache &) = delete;
+    TextureCache & operator=(const TextureCache &) = delete;
+
+    // Resident texture of the file (marked as used in this frame), null if it can not be loaded
+    Texture2D * texture(const QString & fileName);
+
+    void clear();
+
+    Statistics statistics() const;
+
+private:
+    struct Entry
+    {
+        QString fileName;
+        std::unique_ptr<Texture2D> texture;
+        GpuMemory::Handle handle {0};
+    };
+
+    static void evict(void * owner, quintptr key);
+
+    GpuMemory & m_memory;
+    std::vector<Entry> m_entries;
+    QHash<QString, int> m_index;
+    Statistics m_statistics;
+};
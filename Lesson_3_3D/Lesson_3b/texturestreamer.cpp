@@ -0,0 +1,443 @@
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "texturestreamer.h"
+#include "texture2D.h"
+#include "mipmapbuilder.h"
+#include "profiler.h"
+
+#include <QDebug>
+#include <QImageReader>
+
+#include <cmath>
+
+namespace
+{
+    QSize levelSize(const QSize & size, int level)
+    {
+        return QSize(qMax(1, size.width() >> level), qMax(1, size.height() >> level));
+    }
+}
+
+TextureStreamer::~TextureStreamer()
+{
+    destroy();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Create
+///////////////////////////////////////////////////////////////////////////////
+
+void TextureStreamer::create(JobSystem & jobs, qint64 budgetBytes)
+{
+    destroy();
+    initializeOpenGLFunctions();
+    m_jobs = &jobs;
+    m_budget = budgetBytes;
+    m_statistics = Statistics();
+}
+
+void TextureStreamer::destroy()
+{
+    if (!m_jobs)
+        return;
+
+    // The jobs write into the entries, the textures belong to the caller
+    for (auto & entry : m_entries)
+    {
+        if (entry->loading)
+            m_jobs->wait(entry->loaded);
+    }
+    m_entries.clear();
+    m_jobs = nullptr;
+}
+
+void TextureStreamer::setBudget(qint64 budgetBytes)
+{
+    m_budget = budgetBytes;
+    qInfo() << "Texture streamer : budget" << double(m_budget) / (1024.0 * 1024.0) << "MB";
+}
+
+bool TextureStreamer::add(Texture2D * texture, const QStringList & fileNames, int residentSize)
+{
+    Q_ASSERT(m_jobs);
+    const bool isArray = texture->target() == QOpenGLTexture::Target2DArray;
+    if (fileNames.isEmpty() || (!isArray && fileNames.size() != 1) ||
+        (!isArray && texture->target() != QOpenGLTexture::Target2D))
+    {
+        qWarning() << "Texture streamer : only 2D (one file) and 2D array textures ... FAILED";
+        return false;
+    }
+
+    // The size from the file headers, the images are decoded by the jobs
+    QSize size;
+    for (const QString & fileName : fileNames)
+    {
+        const QSize imageSize = QImageReader(fileName).size();
+        if (!imageSize.isValid())
+        {
+            qWarning() << "Texture streamer : can not read" << fileName << "... FAILED";
+            return false;
+        }
+        size = size.expandedTo(imageSize);
+    }
+
+    if (!texture->isCreated() && !texture->create())
+    {
+        qWarning() << "Texture streamer : texture create ... FAILED";
+        return false;
+    }
+
+    auto entry = std::make_unique<Entry>();
+    entry->texture = texture;
+    entry->target = GLenum(texture->target());
+    entry->fileNames = fileNames;
+    entry->size = size;
+    entry->layers = int(fileNames.size());
+    entry->levels = int(std::log2(double(qMax(size.width(), size.height())))) + 1;
+    entry->tailLevel = entry->levels - 1;
+    while (entry->tailLevel > 0 && qMax(size.width(), size.height()) >> (entry->tailLevel - 1) <= residentSize)
+        entry->tailLevel--;
+    entry->residentLevel = entry->levels;
+    entry->wantedLevel = entry->tailLevel;
+    entry->targetLevel = entry->tailLevel;
+    entry->images.resize(size_t(entry->levels) * size_t(entry->layers));
+
+    // Levels below the base level are not defined yet, that is fine for completeness
+    const GLuint textureId = texture->textureId();
+    glBindTexture(entry->target, textureId);
+    glTexParameteri(entry->target, GL_TEXTURE_MAX_LEVEL, entry->levels - 1);
+    glTexParameteri(entry->target, GL_TEXTURE_BASE_LEVEL, entry->tailLevel);
+    glTexParameteri(entry->target, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(entry->target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(entry->target, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(entry->target, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glBindTexture(entry->target, 0);
+
+    qInfo() << "Texture streamer : added" << fileNames << size << entry->levels << "levels, resident from level" << entry->tailLevel;
+    startLoad(*entry, entry->tailLevel, entry->levels);
+    m_entries.push_back(std::move(entry));
+    return true;
+}
+
+void TextureStreamer::remove(const Texture2D * texture)
+{
+    for (auto it = m_entries.begin(); it != m_entries.end(); ++it)
+    {
+        Entry & entry = **it;
+        if (entry.texture != texture)
+            continue;
+        if (entry.loading)
+            m_jobs->wait(entry.loaded);
+        m_entries.erase(it);
+        return;
+    }
+}
+
+void TextureStreamer::waitForLoads()
+{
+    for (auto & entry : m_entries)
+    {
+        if (!entry->loading)
+            continue;
+        m_jobs->wait(entry->loaded);
+        finishLoad(*entry);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Per frame
+///////////////////////////////////////////////////////////////////////////////
+
+void TextureStreamer::beginFrame()
+{
+    for (auto & entry : m_entries)
+        entry->wantedLevel = entry->tailLevel;
+}
+
+void TextureStreamer::request(const Texture2D * texture, float screenPixels)
+{
+    Entry * entry = find(texture);
+    if (!entry || screenPixels <= 0.0f)
+        return;
+
+    // One texel per pixel: each level halves the texels across the object
+    const float texels = float(qMax(entry->size.width(), entry->size.height()));
+    const int level = qBound(0, int(std::floor(std::log2(texels / screenPixels))), entry->tailLevel);
+    entry->wantedLevel = qMin(entry->wantedLevel, level);
+}
+
+void TextureStreamer::update()
+{
+    PROFILE_FUNCTION();
+    // Uploads of the finished jobs first, the budget sees them resident
+    for (auto & entry : m_entries)
+    {
+        if (entry->loading && entry->loaded.isDone())
+            finishLoad(*entry);
+    }
+
+    applyBudget();
+
+    for (auto & entry : m_entries)
+    {
+        if (!entry->failed && !entry->loading)
+        {
+            if (entry->targetLevel > entry->residentLevel)
+                dropLevels(*entry, entry->targetLevel);
+            else if (entry->targetLevel < entry->residentLevel)
+                startLoad(*entry, entry->targetLevel, entry->residentLevel);
+        }
+
+        // Fade the last streamed level in
+        if (entry->minLod > 0.0f)
+        {
+            entry->minLod = qMax(0.0f, entry->minLod - 1.0f / FADE_FRAMES);
+            glBindTexture(entry->target, entry->texture->textureId());
+            glTexParameterf(entry->target, GL_TEXTURE_MIN_LOD, entry->minLod);
+            glBindTexture(entry->target, 0);
+        }
+    }
+}
+
+void TextureStreamer::applyBudget()
+{
+    // Without pressure a level is kept a while after the last request,
+    // so moving back and forth does not load it again
+    qint64 total = 0;
+    for (auto & entry : m_entries)
+    {
+        Entry & e = *entry;
+        int target = e.wantedLevel;
+        if (e.wantedLevel > e.residentLevel)
+        {
+            e.unusedFrames++;
+            if (e.unusedFrames <= KEEP_FRAMES)
+                target = e.residentLevel;
+        }
+        else
+        {
+            e.unusedFrames = 0;
+        }
+        // A load in flight is uploaded anyway
+        if (e.loading)
+            target = qMin(target, e.loadFirst);
+        e.targetLevel = qMin(target, e.tailLevel);
+        total += bytesFrom(e, e.targetLevel);
+    }
+
+    // Over budget: the finest levels (largest on screen) are given up first
+    while (total > m_budget)
+    {
+        Entry * coarsen = nullptr;
+        for (auto & entry : m_entries)
+        {
+            Entry & e = *entry;
+            if (e.targetLevel >= e.tailLevel)
+                continue;
+            if (!coarsen || e.targetLevel < coarsen->targetLevel ||
+                (e.targetLevel == coarsen->targetLevel && levelBytes(e, e.targetLevel) > levelBytes(*coarsen, coarsen->targetLevel)))
+                coarsen = &e;
+        }
+        if (!coarsen)
+            break; // only the tails left
+        total -= levelBytes(*coarsen, coarsen->targetLevel);
+        coarsen->targetLevel++;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Stream in and out
+///////////////////////////////////////////////////////////////////////////////
+
+void TextureStreamer::startLoad(Entry & entry, int firstLevel, int endLevel)
+{
+    entry.loading = true;
+    entry.loadFirst = firstLevel;
+    entry.loadEnd = endLevel;
+    entry.requested.start();
+
+    // Plain job, submitting does not allocate. Decoding is background work,
+    // a widget waiting for its frame jobs does not pick it up
+    Job job;
+    job.function = &TextureStreamer::loadJob;
+    job.data = &entry;
+    job.begin = firstLevel;
+    job.end = endLevel;
+    job.counter = &entry.loaded;
+    m_jobs->submitBackground(job);
+}
+
+void TextureStreamer::loadJob(void * data, int begin, int end)
+{
+    PROFILE_FUNCTION();
+    Entry * entry = static_cast<Entry *>(data);
+
+    // Files are read again for every load, only the GPU keeps the levels
+    for (int layer = 0; layer < entry->layers; ++layer)
+    {
+        const QImage source = Texture2D::readImage(entry->fileNames.at(layer));
+        if (source.isNull())
+            continue; // finishLoad sees the missing levels
+
+        // Scaled from the source to the first level, then halved level by level
+        // (gamma correct, see MipmapBuilder; the loads of the textures already run in parallel)
+        QImage level = Texture2D::fitToLayer(source, levelSize(entry->size, begin), Texture2D::LayerFit::Scale);
+        for (int ll = begin; ll < end; ++ll)
+        {
+            if (ll > begin)
+                level = MipmapBuilder::downsample(level, MipmapBuilder::Options());
+            entry->images[size_t(ll) * entry->layers + layer] = level;
+        }
+    }
+}
+
+void TextureStreamer::finishLoad(Entry & entry)
+{
+    entry.loading = false;
+
+    bool complete = true;
+    for (int ll = entry.loadFirst; ll < entry.loadEnd && complete; ++ll)
+    {
+        for (int layer = 0; layer < entry.layers; ++layer)
+            complete = complete && !entry.images[size_t(ll) * entry.layers + layer].isNull();
+    }
+    if (!complete)
+    {
+        qWarning() << "Texture streamer : reading" << entry.fileNames << "... FAILED";
+        entry.failed = true;
+        for (QImage & image : entry.images)
+            image = QImage();
+        return;
+    }
+
+    glBindTexture(entry.target, entry.texture->textureId());
+    for (int ll = entry.loadFirst; ll < entry.loadEnd; ++ll)
+    {
+        const QSize size = levelSize(entry.size, ll);
+        QImage * images = &entry.images[size_t(ll) * entry.layers];
+        if (entry.target == GL_TEXTURE_2D)
+        {
+            glTexImage2D(GL_TEXTURE_2D, ll, GL_RGBA8, size.width(), size.height(), 0,
+                         GL_RGBA, GL_UNSIGNED_BYTE, images[0].constBits());
+        }
+        else
+        {
+            glTexImage3D(entry.target, ll, GL_RGBA8, size.width(), size.height(), entry.layers, 0,
+                         GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            for (int layer = 0; layer < entry.layers; ++layer)
+                glTexSubImage3D(entry.target, ll, 0, 0, layer, size.width(), size.height(), 1,
+                                GL_RGBA, GL_UNSIGNED_BYTE, images[layer].constBits());
+        }
+        for (int layer = 0; layer < entry.layers; ++layer)
+            images[layer] = QImage();
+    }
+
+    // Sample from the old finest level first (the min LOD is relative to the
+    // base level) and fade down to the new one
+    if (entry.residentLevel < entry.levels)
+        entry.minLod += float(entry.residentLevel - entry.loadFirst);
+    glTexParameteri(entry.target, GL_TEXTURE_BASE_LEVEL, entry.loadFirst);
+    glTexParameterf(entry.target, GL_TEXTURE_MIN_LOD, entry.minLod);
+    glBindTexture(entry.target, 0);
+
+    const int newLevels = qMin(entry.loadEnd, entry.levels) - entry.loadFirst;
+    entry.residentLevel = entry.loadFirst;
+
+    const qint64 latency = entry.requested.nsecsElapsed();
+    m_statistics.levelsStreamedIn += quint64(newLevels);
+    m_statistics.loads++;
+    m_statistics.lastLatencyNanoseconds = latency;
+    m_statistics.maxLatencyNanoseconds = qMax(m_statistics.maxLatencyNanoseconds, latency);
+    m_statistics.totalLatencyNanoseconds += latency;
+}
+
+void TextureStreamer::dropLevels(Entry & entry, int newResidentLevel)
+{
+    glBindTexture(entry.target, entry.texture->textureId());
+    glTexParameteri(entry.target, GL_TEXTURE_BASE_LEVEL, newResidentLevel);
+    entry.minLod = qMax(0.0f, entry.minLod - float(newResidentLevel - entry.residentLevel));
+    glTexParameterf(entry.target, GL_TEXTURE_MIN_LOD, entry.minLod);
+
+    // A level of size 0 gives its memory back
+    for (int ll = entry.residentLevel; ll < newResidentLevel; ++ll)
+    {
+        if (entry.target == GL_TEXTURE_2D)
+            glTexImage2D(GL_TEXTURE_2D, ll, GL_RGBA8, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        else
+            glTexImage3D(entry.target, ll, GL_RGBA8, 0, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    }
+    glBindTexture(entry.target, 0);
+
+    m_statistics.levelsStreamedOut += quint64(newResidentLevel - entry.residentLevel);
+    entry.residentLevel = newResidentLevel;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// Information
+///////////////////////////////////////////////////////////////////////////////
+
+TextureStreamer::Entry * TextureStreamer::find(const Texture2D * texture) const
+{
+    for (const auto & entry : m_entries)
+    {
+        if (entry->texture == texture)
+            return entry.get();
+    }
+    return nullptr;
+}
+
+int TextureStreamer::residentLevel(const Texture2D * texture) const
+{
+    const Entry * entry = find(texture);
+    return entry ? entry->residentLevel : -1;
+}
+
+int TextureStreamer::levelCount(const Texture2D * texture) const
+{
+    const Entry * entry = find(texture);
+    return entry ? entry->levels : 0;
+}
+
+qint64 TextureStreamer::residentBytes(const Texture2D * texture) const
+{
+    const Entry * entry = find(texture);
+    return entry ? bytesFrom(*entry, entry->residentLevel) : 0;
+}
+
+qint64 TextureStreamer::levelBytes(const Entry & entry, int level)
+{
+    const QSize size = levelSize(entry.size, level);
+    return qint64(size.width()) * size.height() * entry.layers * 4;
+}
+
+qint64 TextureStreamer::bytesFrom(const Entry & entry, int firstLevel)
+{
+    qint64 bytes = 0;
+    for (int ll = firstLevel; ll < entry.levels; ++ll)
+        bytes += levelBytes(entry, ll);
+    return bytes;
+}
+
+TextureStreamer::Statistics TextureStreamer::statistics() const
+{
+    Statistics statistics = m_statistics;
+    statistics.textures = int(m_entries.size());
+    statistics.budgetBytes = m_budget;
+    for (const auto & entry : m_entries)
+    {
+        statistics.residentBytes += bytesFrom(*entry, entry->residentLevel);
+        if (entry->loading)
+            statistics.loading++;
+    }
+    return statistics;
+}
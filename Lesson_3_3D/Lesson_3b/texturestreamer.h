@@ -0,0 +1,148 @@
+#pragma once
+//-----------------------------------------------------------------------------
+// Author: Neil Parker
+// Date: 12/2023
+//
+// Acklowledgement: I am only learning OpenGL and its usage with Qt
+// 1) Code is based on the Udemy course from
+//    Steve Jones at the Game Institute
+// 2) The project start is based on one the many Qt OpenGL example
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+//-----------------------------------------------------------------------------
+
+#include "jobsystem.h"
+
+#include <QOpenGLFunctions_3_3_Core>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QSize>
+#include <QStringList>
+
+#include <memory>
+#include <vector>
+
+class Texture2D;
+
+///
+/// \brief The TextureStreamer keeps only the mip levels of its textures on the
+/// GPU that the objects on screen need.
+/// At the start only the small levels (the "tail", up to residentSize texels)
+/// are uploaded. Every frame the objects request a level from their size on
+/// screen (request()), update() then
+/// - streams in finer levels: decoded and down sampled by a job, uploaded here,
+///   GL_TEXTURE_BASE_LEVEL moves down and GL_TEXTURE_MIN_LOD fades the new
+///   level in over a few frames (no pop)
+/// - streams out levels that have not been needed for a while, or at once
+///   when the budget is exceeded (levels redefined with size 0 to free them)
+/// - keeps the resident levels of all textures within the memory budget, the
+///   textures needing the finest levels give up a level first
+///
+/// The textures use mutable storage (glTexImage), immutable storage could not
+/// give the memory of single levels back.
+/// Only call from the OpenGL thread with the context current.
+///
+class TextureStreamer : protected QOpenGLFunctions_3_3_Core
+{
+public:
+    struct Statistics
+    {
+        int textures {0};
+        int loading {0};                // loads in flight
+        qint64 residentBytes {0};
+        qint64 budgetBytes {0};
+        quint64 levelsStreamedIn {0};
+        quint64 levelsStreamedOut {0};
+        quint64 loads {0};
+        qint64 lastLatencyNanoseconds {0};  // request until the level is used
+        qint64 maxLatencyNanoseconds {0};
+        qint64 totalLatencyNanoseconds {0};
+    };
+
+    TextureStreamer() = default;
+    ~TextureStreamer();
+
+    TextureStreamer(const TextureStreamer &) = delete;
+    TextureStreamer & operator=(const TextureStreamer &) = delete;
+
+    // The jobs decode and down sample the levels
+    void create(JobSystem & jobs, qint64 budgetBytes);
+    void destroy();
+    bool isCreated() const { return m_jobs != nullptr; }
+
+    void setBudget(qint64 budgetBytes);
+    qint64 budget() const { return m_budget; }
+
+    // Target2D: one file, Target2DArray: one layer per file (scaled to the largest).
+    // Starts loading the tail, the texture is usable after the next update() or waitForLoads().
+    bool add(Texture2D * texture, const QStringList & fileNames, int residentSize = 64);
+    // Stop streaming the texture (waits for its load), the levels stay as they are
+    void remove(const Texture2D * texture);
+    bool isEmpty() const { return m_entries.empty(); }
+
+    // Finish all loads in flight (e.g. at the start, before the first frame)
+    void waitForLoads();
+
+    // Per frame: beginFrame(), request()... for every visible object, update().
+    // Once per frame for all users, see ResourceManager::endTextureRequests.
+    void beginFrame();
+    // screenPixels: size of the object on screen (the texture is mapped once across it)
+    void request(const Texture2D * texture, float screenPixels);
+    void update();
+
+    // Finest level on the GPU, -1 for an unknown texture
+    int residentLevel(const Texture2D * texture) const;
+    int levelCount(const Texture2D * texture) const;
+    // Memory of the levels on the GPU, 0 for an unknown texture
+    qint64 residentBytes(const Texture2D * texture) const;
+
+    Statistics statistics() const;
+
+private:
+    // Frames a level is kept after the last request (unless over budget)
+    static constexpr int KEEP_FRAMES = 120;
+    // Frames to fade a new level in with GL_TEXTURE_MIN_LOD
+    static constexpr int FADE_FRAMES = 16;
+
+    struct Entry
+    {
+        Texture2D * texture {nullptr};
+        GLenum target {0};
+        QStringList fileNames;
+        QSize size;                 // level 0 (of a layer)
+        int layers {1};
+        int levels {0};
+        int tailLevel {0};          // always resident from here on
+        int residentLevel {0};      // finest level on the GPU, levels = nothing yet
+
+        int wantedLevel {0};        // this frame's requests
+        int targetLevel {0};        // after the budget
+        int unusedFrames {0};       // resident levels finer than wanted since
+
+        float minLod {0.0f};        // fade in, relative to the base level
+        bool failed {false};        // a file could not be read, no more loads
+
+        // Load [loadFirst, loadEnd) in flight, images[level * layers + layer]
+        bool loading {false};
+        int loadFirst {0};
+        int loadEnd {0};
+        std::vector<QImage> images;
+        QElapsedTimer requested;
+        JobCounter loaded;
+    };
+
+    static void loadJob(void * data, int begin, int end);
+
+    Entry * find(const Texture2D * texture) const;
+    void startLoad(Entry & entry, int firstLevel, int endLevel);
+    void finishLoad(Entry & entry);
+    void dropLevels(Entry & entry, int newResidentLevel);
+    void applyBudget();
+    static qint64 levelBytes(const Entry & entry, int level);
+    static qint64 bytesFrom(const Entry & entry, int firstLevel);
+
+    JobSystem * m_jobs {nullptr};
+    qint64 m_budget {0};
+    std::vector<std::unique_ptr<Entry>> m_entries;
+    Statistics m_statistics;
+};